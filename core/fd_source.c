@@ -0,0 +1,423 @@
+/*************
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************/
+
+/**
+ * @file fd_source.c
+ * @brief File descriptors as sources of physical actions. See fd_source.h.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "enclave.h"
+#include "fd_source.h"
+#include "platform.h"
+#include "reactor.h"
+#include "reactor_common.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <unistd.h>
+#ifdef NUMBER_OF_WORKERS
+#include <sys/eventfd.h>
+#endif
+
+/** The maximum number of readable file descriptors that one wait collects. */
+#define LF_FD_BATCH_SIZE 16
+
+/**
+ * A registered file descriptor.
+ */
+typedef struct lf_fd_source_t {
+    int fd;
+    void* action;
+    lf_fd_handler_t handler;               // NULL for the default handler.
+    void* user_data;
+} lf_fd_source_t;
+
+/**
+ * The file descriptors registered with an instance.
+ */
+typedef struct lf_fd_sources_t {
+    int epoll_fd;
+    lf_fd_source_t* sources;               // Unordered. Unregistering moves the last one.
+    size_t size;
+    size_t capacity;
+#ifdef NUMBER_OF_WORKERS
+    lf_instance_t* instance;               // The instance that the thread binds to.
+    lf_mutex_t mutex;                      // Protects the sources. Held while handlers run.
+    lf_thread_t thread;                    // The thread that waits for the file descriptors.
+    int wakeup_fd;                         // An eventfd that wakes up the thread to make it exit.
+    volatile bool stop;                    // Whether the thread should exit.
+#endif
+} lf_fd_sources_t;
+
+#ifdef NUMBER_OF_WORKERS
+/**
+ * Whether the calling thread waits for file descriptors. That thread already
+ * holds the mutex of the sources while handlers run, which may call
+ * lf_register_fd() or lf_unregister_fd().
+ */
+static LF_THREAD_LOCAL bool _lf_fd_is_waiting_thread = false;
+
+static void _lf_fd_lock(lf_fd_sources_t* sources) {
+    if (!_lf_fd_is_waiting_thread) {
+        lf_mutex_lock(&sources->mutex);
+    }
+}
+
+static void _lf_fd_unlock(lf_fd_sources_t* sources) {
+    if (!_lf_fd_is_waiting_thread) {
+        lf_mutex_unlock(&sources->mutex);
+    }
+}
+#else
+#define _lf_fd_lock(sources)
+#define _lf_fd_unlock(sources)
+#endif
+
+/**
+ * Return the registered source with the specified file descriptor, or NULL
+ * if there is none.
+ */
+static lf_fd_source_t* _lf_fd_find(lf_fd_sources_t* sources, int fd) {
+    for (size_t i = 0; i < sources->size; i++) {
+        if (sources->sources[i].fd == fd) {
+            return &sources->sources[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * The handler of a file descriptor that was registered without one.
+ * Read from the file descriptor and schedule the action with what was read.
+ */
+static void _lf_fd_read_and_schedule(int fd, void* action) {
+    char buffer[LF_FD_READ_SIZE];
+    ssize_t bytes = read(fd, buffer, sizeof(buffer));
+    if (bytes < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return;
+        }
+        lf_print_error("Failed to read from file descriptor %d: %s. No longer watching it.",
+                fd, strerror(errno));
+        lf_unregister_fd(fd);
+        return;
+    }
+    if (bytes == 0) {
+        LF_PRINT_LOG("End of file on file descriptor %d.", fd);
+        lf_unregister_fd(fd);
+        _lf_schedule_token(action, 0, NULL);
+        return;
+    }
+    size_t element_size = _lf_action_to_trigger(action)->element_size;
+    if (element_size == 0) {
+        _lf_schedule_token(action, 0, NULL);
+        return;
+    }
+    if (bytes % element_size != 0) {
+        lf_print_warning("Dropping %zu bytes read from file descriptor %d, which do not make up a whole element.",
+                bytes % element_size, fd);
+    }
+    _lf_schedule_copy(action, 0, buffer, bytes / element_size);
+}
+
+/**
+ * Wait for at most the specified time for registered file descriptors to
+ * become readable, and call the handlers of those that do.
+ * @param sources The sources of the calling instance.
+ * @param timeout_ms The time to wait, in milliseconds, or -1 to wait indefinitely.
+ * @return The number of file descriptors that became readable, or -1 with
+ *  errno set if the wait failed.
+ */
+static int _lf_fd_wait(lf_fd_sources_t* sources, int timeout_ms) {
+    struct epoll_event events[LF_FD_BATCH_SIZE];
+    int count = epoll_wait(sources->epoll_fd, events, LF_FD_BATCH_SIZE, timeout_ms);
+    if (count <= 0) {
+        return count;
+    }
+    // Handle the whole batch under one acquisition of the lock.
+    _lf_fd_lock(sources);
+    for (int i = 0; i < count; i++) {
+        int fd = events[i].data.fd;
+        // The source may have been unregistered since the wait returned.
+        // Copy it, since its handler may register or unregister sources.
+        lf_fd_source_t* found = _lf_fd_find(sources, fd);
+        if (found == NULL) {
+            continue;
+        }
+        lf_fd_source_t source = *found;
+        if (source.handler != NULL) {
+            source.handler(fd, source.action, source.user_data);
+        } else {
+            _lf_fd_read_and_schedule(fd, source.action);
+        }
+    }
+    _lf_fd_unlock(sources);
+    return count;
+}
+
+#ifdef NUMBER_OF_WORKERS
+/**
+ * The function of the thread that waits for the file descriptors of an instance.
+ * @param arguments The sources of the instance.
+ */
+static void* _lf_fd_thread(void* arguments) {
+    lf_fd_sources_t* sources = (lf_fd_sources_t*)arguments;
+    lf_instance_bind(sources->instance);
+    _lf_fd_is_waiting_thread = true;
+    _lf_initialize_thread(LF_IO_THREAD);
+    while (!sources->stop) {
+        if (_lf_fd_wait(sources, -1) < 0 && errno != EINTR) {
+            lf_print_error("Failed to wait for file descriptors: %s.", strerror(errno));
+            break;
+        }
+    }
+    return NULL;
+}
+#endif
+
+/**
+ * Make room for one more source.
+ * @return 0 on success, or -1 with errno set if memory ran out.
+ */
+static int _lf_fd_reserve(lf_fd_sources_t* sources) {
+    if (sources->size < sources->capacity) {
+        return 0;
+    }
+    size_t capacity = (sources->capacity == 0) ? 4 : 2 * sources->capacity;
+    lf_fd_source_t* grown = (lf_fd_source_t*)realloc(sources->sources, capacity * sizeof(lf_fd_source_t));
+    if (grown == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    sources->sources = grown;
+    sources->capacity = capacity;
+    return 0;
+}
+
+#ifdef NUMBER_OF_WORKERS
+/**
+ * Start the thread that waits for the file descriptors of new sources,
+ * along with the eventfd that makes it exit.
+ * @return 0 on success, or -1 with errno set on failure.
+ */
+static int _lf_fd_start_thread(lf_fd_sources_t* sources) {
+    sources->instance = _lf_instance;
+    sources->wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (sources->wakeup_fd < 0) {
+        return -1;
+    }
+    struct epoll_event event = {.events = EPOLLIN, .data.fd = sources->wakeup_fd};
+    lf_mutex_init(&sources->mutex);
+    int result = epoll_ctl(sources->epoll_fd, EPOLL_CTL_ADD, sources->wakeup_fd, &event);
+    if (result == 0 && (result = lf_thread_create(&sources->thread, _lf_fd_thread, sources)) != 0) {
+        errno = result;
+        result = -1;
+    }
+    if (result != 0) {
+        close(sources->wakeup_fd);
+    }
+    return result;
+}
+#endif
+
+/**
+ * Return the sources of the instance that the calling thread is bound to,
+ * creating them, and in the threaded runtime the thread that waits for
+ * them, if this is the first registration.
+ * @return The sources, or NULL with errno set on failure.
+ */
+static lf_fd_sources_t* _lf_fd_sources_get() {
+#ifdef NUMBER_OF_WORKERS
+    lf_mutex_lock(&_lf_main_enclave.mutex);
+#endif
+    lf_fd_sources_t* sources = _lf_instance->fd_sources;
+    if (sources == NULL) {
+        sources = (lf_fd_sources_t*)calloc(1, sizeof(lf_fd_sources_t));
+        if (sources == NULL || (sources->epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+            free(sources);
+            sources = NULL;
+        }
+#ifdef NUMBER_OF_WORKERS
+        else if (_lf_fd_start_thread(sources) != 0) {
+            close(sources->epoll_fd);
+            free(sources);
+            sources = NULL;
+        }
+#endif
+        _lf_instance->fd_sources = sources;
+    }
+#ifdef NUMBER_OF_WORKERS
+    lf_mutex_unlock(&_lf_main_enclave.mutex);
+#endif
+    return sources;
+}
+
+int lf_register_fd(int fd, void* action, lf_fd_handler_t handler, void* user_data) {
+    trigger_t* trigger = _lf_action_to_trigger(action);
+    if (trigger == NULL || !trigger->is_physical) {
+        lf_print_error("lf_register_fd: The action for file descriptor %d is not a physical action.", fd);
+        errno = EINVAL;
+        return -1;
+    }
+    // Registering allocates, which a reaction may be forbidden to do in
+    // static-memory mode. It is a one-time cost, so allow it.
+    int forbidden = lf_forbid_heap_allocation(false);
+    int result = -1;
+    lf_fd_sources_t* sources = _lf_fd_sources_get();
+    if (sources != NULL) {
+        _lf_fd_lock(sources);
+        if (_lf_fd_find(sources, fd) != NULL) {
+            errno = EEXIST;
+        } else if (_lf_fd_reserve(sources) == 0) {
+            struct epoll_event event = {.events = EPOLLIN, .data.fd = fd};
+            if (epoll_ctl(sources->epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0) {
+                sources->sources[sources->size++] = (lf_fd_source_t) {
+                    .fd = fd, .action = action, .handler = handler, .user_data = user_data
+                };
+                result = 0;
+            }
+        }
+        _lf_fd_unlock(sources);
+    }
+    if (forbidden == 1) {
+        lf_forbid_heap_allocation(true);
+    }
+    if (result != 0) {
+        lf_print_error("Failed to register file descriptor %d: %s.", fd, strerror(errno));
+    }
+    return result;
+}
+
+int lf_unregister_fd(int fd) {
+    lf_fd_sources_t* sources = _lf_instance->fd_sources;
+    if (sources == NULL) {
+        return -1;
+    }
+    int result = -1;
+    _lf_fd_lock(sources);
+    lf_fd_source_t* source = _lf_fd_find(sources, fd);
+    if (source != NULL) {
+        // This fails if the file descriptor has already been closed, in
+        // which case epoll has already forgotten it.
+        epoll_ctl(sources->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+        *source = sources->sources[--sources->size];
+        result = 0;
+    }
+    _lf_fd_unlock(sources);
+    return result;
+}
+
+#ifndef NUMBER_OF_WORKERS
+int _lf_fd_sleep_until(instant_t wakeup_time) {
+    lf_fd_sources_t* sources = _lf_instance->fd_sources;
+    while (sources != NULL && sources->size > 0) {
+        int timeout_ms = -1;
+        if (wakeup_time != FOREVER) {
+            instant_t now;
+            if (lf_clock_gettime(&now) != 0) {
+                return -1;
+            }
+            interval_t remaining = wakeup_time - now;
+            if (remaining < MSEC(1)) {
+                // epoll cannot time a wait this short.
+                break;
+            }
+            timeout_ms = (remaining / MSEC(1) < INT_MAX) ? (int)(remaining / MSEC(1)) : INT_MAX;
+        }
+        int count = _lf_fd_wait(sources, timeout_ms);
+        if (count > 0) {
+            errno = EINTR;
+            return -1;
+        } else if (count < 0 && errno != EINTR) {
+            return -1;
+        }
+    }
+    return lf_sleep_until(wakeup_time);
+}
+
+int _lf_fd_poll(bool wait) {
+    lf_fd_sources_t* sources = _lf_instance->fd_sources;
+    if (sources == NULL || sources->size == 0) {
+        return 0;
+    }
+    int count = _lf_fd_wait(sources, wait ? -1 : 0);
+    return (count > 0) ? count : 0;
+}
+#endif
+
+void _lf_fd_sources_free() {
+    lf_fd_sources_t* sources = _lf_instance->fd_sources;
+    if (sources == NULL) {
+        return;
+    }
+#ifdef NUMBER_OF_WORKERS
+    if (_lf_fd_is_waiting_thread) {
+        // A handler has called exit(). The thread cannot join itself, and the
+        // process is exiting anyway.
+        return;
+    }
+    sources->stop = true;
+    uint64_t one = 1;
+    if (write(sources->wakeup_fd, &one, sizeof(one)) == sizeof(one)) {
+        lf_thread_join(sources->thread, NULL);
+    }
+    close(sources->wakeup_fd);
+#endif
+    close(sources->epoll_fd);
+    free(sources->sources);
+    free(sources);
+    _lf_instance->fd_sources = NULL;
+}
+
+#else // __linux__
+
+int lf_register_fd(int fd, void* action, lf_fd_handler_t handler, void* user_data) {
+    lf_print_error("File descriptor sources are not supported on this platform.");
+    errno = ENOTSUP;
+    return -1;
+}
+
+int lf_unregister_fd(int fd) {
+    return -1;
+}
+
+#ifndef NUMBER_OF_WORKERS
+int _lf_fd_sleep_until(instant_t wakeup_time) {
+    return lf_sleep_until(wakeup_time);
+}
+
+int _lf_fd_poll(bool wait) {
+    return 0;
+}
+#endif
+
+void _lf_fd_sources_free() {
+}
+
+#endif // __linux__
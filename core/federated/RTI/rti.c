@@ -274,7 +274,7 @@ void send_tag_advance_grant(federate_t* fed, tag_t tag) {
     } else {
         fed->last_granted = tag;
         LF_PRINT_LOG("RTI sent to federate %d the Time Advance Grant (TAG) (%lld, %u).",
-                fed->id, tag.time - start_time, tag.microstep);
+                fed->id, tag.time - _lf_instance->start_time, tag.microstep);
     }
 }
 
@@ -316,9 +316,9 @@ tag_t transitive_next_event(federate_t* fed, tag_t candidate, bool visited[]) {
     }
 
     // The result cannot be earlier than the start time.
-    if (result.time < start_time) {
+    if (result.time < _lf_instance->start_time) {
         // Earliest next event cannot be before the start time.
-        result = (tag_t){.time = start_time, .microstep = 0u};
+        result = (tag_t){.time = _lf_instance->start_time, .microstep = 0u};
     }
 
     // Check upstream federates to see whether any of them might send
@@ -385,7 +385,7 @@ void send_provisional_tag_advance_grant(federate_t* fed, tag_t tag) {
     } else {
         fed->last_provisionally_granted = tag;
         LF_PRINT_LOG("RTI sent to federate %d the Provisional Tag Advance Grant (PTAG) (%lld, %u).",
-                fed->id, tag.time - start_time, tag.microstep);
+                fed->id, tag.time - _lf_instance->start_time, tag.microstep);
 
         // Send PTAG to all upstream federates, if they have not had
         // a later or equal PTAG or TAG sent previously and if their transitive
@@ -468,7 +468,7 @@ bool send_advance_grant_if_safe(federate_t* fed) {
     LF_PRINT_LOG("Minimum upstream LTC for fed %d is (%lld, %u) "
             "(adjusted by after delay).",
             fed->id,
-            min_upstream_completed.time - start_time, min_upstream_completed.microstep);
+            min_upstream_completed.time - _lf_instance->start_time, min_upstream_completed.microstep);
     if (lf_tag_compare(min_upstream_completed, fed->last_granted) > 0) {
         send_tag_advance_grant(fed, min_upstream_completed);
         return true;
@@ -489,8 +489,8 @@ bool send_advance_grant_if_safe(federate_t* fed) {
     // upstream federates.
     tag_t t_d = FOREVER_TAG;
     LF_PRINT_DEBUG("NOTE: FOREVER is displayed as (%lld, %u) and NEVER as (%lld, %u)",
-            FOREVER_TAG.time - start_time, FOREVER_TAG.microstep,
-            NEVER - start_time, 0u);
+            FOREVER_TAG.time - _lf_instance->start_time, FOREVER_TAG.microstep,
+            NEVER - _lf_instance->start_time, 0u);
 
     for (int j = 0; j < fed->num_upstream; j++) {
         federate_t* upstream = &_RTI.federates[fed->upstream[j]];
@@ -505,7 +505,7 @@ bool send_advance_grant_if_safe(federate_t* fed) {
         LF_PRINT_DEBUG("Earliest next event upstream of fed %d at fed %d has tag (%lld, %u).",
                 fed->id,
                 upstream->id,
-                upstream_next_event.time - start_time, upstream_next_event.microstep);
+                upstream_next_event.time - _lf_instance->start_time, upstream_next_event.microstep);
 
         // Adjust by the "after" delay.
         // Note that "no delay" is encoded as NEVER,
@@ -519,7 +519,7 @@ bool send_advance_grant_if_safe(federate_t* fed) {
     free(visited);
 
     LF_PRINT_LOG("Earliest next event upstream has tag (%lld, %u).",
-            t_d.time - start_time, t_d.microstep);
+            t_d.time - _lf_instance->start_time, t_d.microstep);
 
     if (
         lf_tag_compare(t_d, fed->next_event) > 0       // The federate has something to do.
@@ -546,7 +546,7 @@ bool send_advance_grant_if_safe(federate_t* fed) {
         LF_PRINT_LOG("Earliest upstream message time for fed %d is (%lld, %u) "
             "(adjusted by after delay). Granting provisional tag advance.",
             fed->id,
-            t_d.time - start_time, t_d.microstep);
+            t_d.time - _lf_instance->start_time, t_d.microstep);
 
         send_provisional_tag_advance_grant(fed, t_d);
     }
@@ -650,13 +650,13 @@ void handle_port_absent_message(federate_t* sending_federate, unsigned char* buf
                 "completed (%lld, %d), "
                 "last_granted (%lld, %d), "
                 "last_provisionally_granted (%lld, %d).",
-                _RTI.federates[federate_id].next_event.time - start_time,
+                _RTI.federates[federate_id].next_event.time - _lf_instance->start_time,
                 _RTI.federates[federate_id].next_event.microstep,
-                _RTI.federates[federate_id].completed.time - start_time,
+                _RTI.federates[federate_id].completed.time - _lf_instance->start_time,
                 _RTI.federates[federate_id].completed.microstep,
-                _RTI.federates[federate_id].last_granted.time - start_time,
+                _RTI.federates[federate_id].last_granted.time - _lf_instance->start_time,
                 _RTI.federates[federate_id].last_granted.microstep,
-                _RTI.federates[federate_id].last_provisionally_granted.time - start_time,
+                _RTI.federates[federate_id].last_provisionally_granted.time - _lf_instance->start_time,
                 _RTI.federates[federate_id].last_provisionally_granted.microstep
         );
         return;
@@ -740,13 +740,13 @@ void handle_timed_message(federate_t* sending_federate, unsigned char* buffer) {
                 "completed (%lld, %d), "
                 "last_granted (%lld, %d), "
                 "last_provisionally_granted (%lld, %d).",
-                _RTI.federates[federate_id].next_event.time - start_time,
+                _RTI.federates[federate_id].next_event.time - _lf_instance->start_time,
                 _RTI.federates[federate_id].next_event.microstep,
-                _RTI.federates[federate_id].completed.time - start_time,
+                _RTI.federates[federate_id].completed.time - _lf_instance->start_time,
                 _RTI.federates[federate_id].completed.microstep,
-                _RTI.federates[federate_id].last_granted.time - start_time,
+                _RTI.federates[federate_id].last_granted.time - _lf_instance->start_time,
                 _RTI.federates[federate_id].last_granted.microstep,
-                _RTI.federates[federate_id].last_provisionally_granted.time - start_time,
+                _RTI.federates[federate_id].last_provisionally_granted.time - _lf_instance->start_time,
                 _RTI.federates[federate_id].last_provisionally_granted.microstep
         );
         return;
@@ -846,7 +846,7 @@ void handle_logical_tag_complete(federate_t* fed) {
     fed->completed = extract_tag(buffer);
 
     LF_PRINT_LOG("RTI received from federate %d the Logical Tag Complete (LTC) (%lld, %u).",
-                fed->id, fed->completed.time - start_time, fed->completed.microstep);
+                fed->id, fed->completed.time - _lf_instance->start_time, fed->completed.microstep);
 
     // See if we can remove any of the recorded in-transit messages for this.
     clean_in_transit_message_record_up_to_tag(fed->in_transit_message_tags, fed->completed);
@@ -885,7 +885,7 @@ void handle_next_event_tag(federate_t* fed) {
 
     tag_t intended_tag = extract_tag(buffer);
     LF_PRINT_LOG("RTI received from federate %d the Next Event Tag (NET) (%ld, %u).",
-        fed->id, fed->next_event.time - start_time,
+        fed->id, fed->next_event.time - _lf_instance->start_time,
         fed->next_event.microstep);
     update_federate_next_event_tag_locked(
         fed->id,
@@ -931,7 +931,7 @@ void _lf_rti_broadcast_stop_time_to_federates_already_locked() {
     }
 
     LF_PRINT_LOG("RTI sent to federates MSG_TYPE_STOP_GRANTED with tag (%lld, %u).",
-                _RTI.max_stop_tag.time - start_time,
+                _RTI.max_stop_tag.time - _lf_instance->start_time,
                 _RTI.max_stop_tag.microstep);
     _lf_rti_stop_granted_already_sent_to_federates = true;
 }
@@ -997,7 +997,7 @@ void handle_stop_request_message(federate_t* fed) {
     }
 
     LF_PRINT_LOG("RTI received from federate %d a MSG_TYPE_STOP_REQUEST message with tag (%lld, %u).",
-            fed->id, proposed_stop_tag.time - start_time, proposed_stop_tag.microstep);
+            fed->id, proposed_stop_tag.time - _lf_instance->start_time, proposed_stop_tag.microstep);
 
     // If this federate has not already asked
     // for a stop, add it to the tally.
@@ -1028,7 +1028,7 @@ void handle_stop_request_message(federate_t* fed) {
         }
     }
     LF_PRINT_LOG("RTI forwarded to federates MSG_TYPE_STOP_REQUEST with tag (%lld, %u).",
-                _RTI.max_stop_tag.time - start_time,
+                _RTI.max_stop_tag.time - _lf_instance->start_time,
                 _RTI.max_stop_tag.microstep);
     pthread_mutex_unlock(&_RTI.rti_mutex);
 }
@@ -1049,7 +1049,7 @@ void handle_stop_request_reply(federate_t* fed) {
     tag_t federate_stop_tag = extract_tag(buffer_stop_time);
 
     LF_PRINT_LOG("RTI received from federate %d STOP reply tag (%lld, %u).", fed->id,
-            federate_stop_tag.time - start_time,
+            federate_stop_tag.time - _lf_instance->start_time,
             federate_stop_tag.microstep);
 
     // Acquire the mutex lock so that we can change the state of the RTI
@@ -1185,8 +1185,8 @@ void handle_timestamp(federate_t *my_fed) {
     unsigned char start_time_buffer[MSG_TYPE_TIMESTAMP_LENGTH];
     start_time_buffer[0] = MSG_TYPE_TIMESTAMP;
     // Add an offset to this start time to get everyone starting together.
-    start_time = _RTI.max_start_time + DELAY_START;
-    encode_int64(swap_bytes_if_big_endian_int64(start_time), &start_time_buffer[1]);
+    _lf_instance->start_time = _RTI.max_start_time + DELAY_START;
+    encode_int64(swap_bytes_if_big_endian_int64(_lf_instance->start_time), &start_time_buffer[1]);
 
     ssize_t bytes_written = write_to_socket(
         my_fed->socket, MSG_TYPE_TIMESTAMP_LENGTH,
@@ -1203,7 +1203,7 @@ void handle_timestamp(federate_t *my_fed) {
     my_fed->state = GRANTED;
     // FIXME: re-acquire the lock.
     pthread_cond_broadcast(&_RTI.sent_start_time);
-    LF_PRINT_LOG("RTI sent start time %lld to federate %d.", start_time, my_fed->id);
+    LF_PRINT_LOG("RTI sent start time %lld to federate %d.", _lf_instance->start_time, my_fed->id);
     pthread_mutex_unlock(&_RTI.rti_mutex);
 }
 
@@ -1302,7 +1302,7 @@ void* clock_synchronization_thread(void* noargs) {
 
     // Wait until the start time before starting clock synchronization.
     // The above wait ensures that start_time has been set.
-    interval_t ns_to_wait = start_time - lf_time_physical();
+    interval_t ns_to_wait = _lf_instance->start_time - lf_time_physical();
 
     if (ns_to_wait > 0LL) {
         struct timespec wait_time = {ns_to_wait / BILLION, ns_to_wait % BILLION};
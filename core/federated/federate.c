@@ -646,6 +646,8 @@ void _lf_close_outbound_socket(int fed_id) {
  * closed.
  */
 void* listen_for_upstream_messages_from_downstream_federates(void* fed_id_ptr) {
+    _lf_initialize_thread(LF_NETWORK_THREAD);
+
     uint16_t fed_id = *((uint16_t*)fed_id_ptr);
     unsigned char message;
 
@@ -1491,6 +1493,7 @@ void wait_until_port_status_known(int port_ID, interval_t STAA) {
  * It is also responsible for setting the intended tag of the
  * network message based on the calculated delay.
  * This function assumes that the caller holds the mutex lock.
+ * It acquires event_q_mutex.
  *
  * This is used for handling incoming timed messages to a federate.
  *
@@ -1507,6 +1510,7 @@ trigger_handle_t schedule_message_received_from_network_already_locked(
         lf_token_t* token) {
     // Return value of the function
     int return_value = 0;
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
 
     // Indicates whether or not the intended tag
     // of the message (timestamp, microstep) is
@@ -1549,6 +1553,7 @@ trigger_handle_t schedule_message_received_from_network_already_locked(
     // Notify the main thread in case it is waiting for physical time to elapse.
     LF_PRINT_DEBUG("Broadcasting notification that event queue changed.");
     lf_cond_broadcast(&event_q_changed);
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
     return return_value;
 }
 
@@ -1689,7 +1694,7 @@ void handle_message(int socket, int fed_id) {
 
     // Read the payload.
     // Allocate memory for the message contents.
-    unsigned char* message_contents = (unsigned char*)malloc(length);
+    unsigned char* message_contents = (unsigned char*)_lf_allocate_payload(length);
     read_from_socket_errexit(socket, length, message_contents,
             "Failed to read message body.");
 
@@ -1706,7 +1711,7 @@ void handle_message(int socket, int fed_id) {
  * and calculate an offset to pass to the schedule function.
  * This function assumes the caller does not hold the mutex lock.
  * Instead of holding the mutex lock, this function calls
- * _lf_increment_global_tag_barrier with the tag carried in
+ * _lf_raise_global_tag_barrier with the tag carried in
  * the message header as an argument. This ensures that the current tag
  * will not advance to the tag of the message if it is in the future, or
  * the tag will not advance at all if the tag of the message is
@@ -1738,7 +1743,7 @@ void handle_tagged_message(int socket, int fed_id) {
     trigger_t* action = _lf_action_for_port(port_id);
 
     // Record the physical time of arrival of the message
-    action->physical_time_of_arrival = lf_time_physical();
+    action->physical_time_of_arrival = lf_time_physical_fast();
 
     if (action->is_physical) {
         // Messages sent on physical connections should be handled via handle_message().
@@ -1754,7 +1759,7 @@ void handle_tagged_message(int socket, int fed_id) {
     // by the message. If this tag is in the past, the function will cause
     // the tag to freeze at the current level.
     // If something happens, make sure to release the barrier.
-    _lf_increment_global_tag_barrier(intended_tag);
+    _lf_raise_global_tag_barrier(intended_tag);
 #endif
     LF_PRINT_LOG("Received message with tag: " PRINTF_TAG ", Current tag: " PRINTF_TAG ".",
             intended_tag.time - start_time, intended_tag.microstep,
@@ -1762,7 +1767,7 @@ void handle_tagged_message(int socket, int fed_id) {
 
     // Read the payload.
     // Allocate memory for the message contents.
-    unsigned char* message_contents = (unsigned char*)malloc(length);
+    unsigned char* message_contents = (unsigned char*)_lf_allocate_payload(length);
     read_from_socket_errexit(socket, length, message_contents,
             "Failed to read message body.");
 
@@ -1770,6 +1775,8 @@ void handle_tagged_message(int socket, int fed_id) {
     // LF_PRINT_DEBUG("Message received: %s.", message_contents);
 
     lf_mutex_lock(&mutex);
+    // The token and the reactions or event created below belong to the event queue.
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
 
     // Create a token for the message
     lf_token_t* message_token = create_token(action->element_size);
@@ -1849,6 +1856,7 @@ void handle_tagged_message(int socket, int fed_id) {
         // Before that, if the current time >= stop time, discard the message.
         // But only if the stop time is not equal to the start time!
         if (lf_tag_compare(lf_tag(), stop_tag) >= 0) {
+            lf_mutex_unlock(&_lf_enclave->event_q_mutex);
             lf_mutex_unlock(&mutex);
             lf_print_error("Received message too late. Already at stop tag.\n"
             		"Current tag is " PRINTF_TAG " and intended tag is " PRINTF_TAG ".\n"
@@ -1863,17 +1871,16 @@ void handle_tagged_message(int socket, int fed_id) {
     }
 
 
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+    lf_mutex_unlock(&mutex);
+
 #ifdef FEDERATED_DECENTRALIZED // Only applicable for federated programs with decentralized coordination
     // Finally, decrement the barrier to allow the execution to continue
-    // past the raised barrier
-    _lf_decrement_global_tag_barrier_locked();
+    // past the raised barrier. The barrier does not need the mutex, so
+    // this is done after releasing it so that the thread waiting on the
+    // barrier can acquire the mutex as soon as it wakes up.
+    _lf_lower_global_tag_barrier();
 #endif
-
-    // The mutex is unlocked here after the barrier on
-    // logical time has been removed to avoid
-    // the need for unecessary lock and unlock
-    // operations.
-    lf_mutex_unlock(&mutex);
 }
 
 /**
@@ -1926,7 +1933,9 @@ void handle_tag_advance_grant() {
 
     _fed.waiting_for_TAG = false;
     // Notify everything that is blocked.
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
     lf_cond_broadcast(&event_q_changed);
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
 
     lf_mutex_unlock(&mutex);
 }
@@ -2000,7 +2009,9 @@ void handle_provisional_tag_advance_grant() {
 
     // Even if we don't modify the event queue, we need to broadcast a change
     // because we do not need to continue to wait for a TAG.
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
     lf_cond_broadcast(&event_q_changed);
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
     // Notify control reactions that are blocked.
     // Check here whether there is any control reaction waiting
     // before broadcasting to avoid an unnecessary broadcast.
@@ -2014,9 +2025,6 @@ void handle_provisional_tag_advance_grant() {
     // (which it should be). Do not do this if the federate has not fully
     // started yet.
 
-    instant_t dummy_event_time = PTAG.time;
-    microstep_t dummy_event_relative_microstep = PTAG.microstep;
-
     if (lf_tag_compare(current_tag, PTAG) == 0) {
         // The current tag can equal the PTAG if we are at the start time
         // or if this federate has been able to advance time to the current
@@ -2040,23 +2048,20 @@ void handle_provisional_tag_advance_grant() {
         // Nothing more to do.
            lf_mutex_unlock(&mutex);
         return;
-    } else if (PTAG.time == current_tag.time) {
-        // We now know current_tag < PTAG, but the times are equal.
-        // Adjust the microstep for scheduling the dummy event.
-        dummy_event_relative_microstep -= current_tag.microstep;
     }
     // We now know current_tag < PTAG.
 
-    if (dummy_event_time != FOREVER) {
-        // Schedule a dummy event at the specified time and (relative) microstep.
+    if (PTAG.time != FOREVER) {
+        // Schedule a dummy event at the PTAG.
         LF_PRINT_DEBUG("At tag " PRINTF_TAG ", inserting into the event queue a dummy event "
-               "with time " PRINTF_TIME " and (relative) microstep " PRINTF_MICROSTEP ".",
+               "with tag " PRINTF_TAG ".",
         current_tag.time - start_time, current_tag.microstep,
-        dummy_event_time - start_time, dummy_event_relative_microstep);
-        // Dummy event points to a NULL trigger and NULL real event.
-        event_t* dummy = _lf_create_dummy_events(
-                NULL, dummy_event_time, NULL, dummy_event_relative_microstep);
+        PTAG.time - start_time, PTAG.microstep);
+        // Dummy event points to a NULL trigger.
+        lf_mutex_lock(&_lf_enclave->event_q_mutex);
+        event_t* dummy = _lf_create_dummy_event(PTAG);
         pqueue_insert(event_q, dummy);
+        lf_mutex_unlock(&_lf_enclave->event_q_mutex);
     }
 
     lf_mutex_unlock(&mutex);
@@ -2078,7 +2083,7 @@ void _lf_fd_send_stop_request_to_rti() {
     }
     LF_PRINT_LOG("Requesting the whole program to stop.");
     // Raise a logical time barrier at the current tag.
-    _lf_increment_global_tag_barrier_already_locked(current_tag);
+    _lf_raise_global_tag_barrier(current_tag);
 
     // Send a stop request with the current tag to the RTI
     unsigned char buffer[MSG_TYPE_STOP_REQUEST_LENGTH];
@@ -2124,25 +2129,27 @@ void handle_stop_granted_message() {
             received_stop_tag.time - start_time, received_stop_tag.microstep);
 
     // Sanity check.
-    tag_t current_tag = lf_tag();
-    if (lf_tag_compare(received_stop_tag, current_tag) <= 0) {
+    tag_t current_logical_tag = lf_tag();
+    if (lf_tag_compare(received_stop_tag, current_logical_tag) <= 0) {
         lf_print_error("RTI granted a MSG_TYPE_STOP_GRANTED tag that is equal to or less than this federate's current tag " PRINTF_TAG ". "
                 "Stopping at the next microstep instead.",
-                current_tag.time - start_time, current_tag.microstep);
-        received_stop_tag = current_tag;
+                current_logical_tag.time - start_time, current_logical_tag.microstep);
+        received_stop_tag = current_logical_tag;
         received_stop_tag.microstep++;
     }
 
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
     stop_tag = received_stop_tag;
     LF_PRINT_DEBUG("Setting the stop tag to " PRINTF_TAG ".",
                 stop_tag.time - start_time,
                 stop_tag.microstep);
 
-    _lf_decrement_global_tag_barrier_locked();
+    _lf_lower_global_tag_barrier();
     // We signal instead of broadcast under the assumption that only
     // one worker thread can call wait_until at a given time because
     // the call to wait_until is protected by a mutex lock
     lf_cond_signal(&event_q_changed);
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
     lf_mutex_unlock(&mutex);
 }
 
@@ -2201,7 +2208,7 @@ void handle_stop_request_message() {
 
     // Raise a barrier at current tag
     // because we are sending it to the RTI
-    _lf_increment_global_tag_barrier_already_locked(tag_to_stop);
+    _lf_raise_global_tag_barrier(tag_to_stop);
 
     // A subsequent call to lf_request_stop will be a no-op.
     _fed.sent_a_stop_request_to_rti = true;
@@ -2284,6 +2291,7 @@ void terminate_execution() {
  *  This procedure frees the memory pointed to before returning.
  */
 void* listen_to_federates(void* fed_id_ptr) {
+    _lf_initialize_thread(LF_NETWORK_THREAD);
 
     uint16_t fed_id = *((uint16_t*)fed_id_ptr);
 
@@ -2345,6 +2353,8 @@ void* listen_to_federates(void* fed_id_ptr) {
  *  When a physical message arrives, this calls schedule.
  */
 void* listen_to_rti_TCP(void* args) {
+    _lf_initialize_thread(LF_NETWORK_THREAD);
+
     // Buffer for incoming messages.
     // This does not constrain the message size
     // because the message will be put into malloc'd memory.
@@ -2640,7 +2650,7 @@ tag_t _lf_send_next_event_tag(tag_t tag, bool wait_for_reply) {
                 // Wait until either something changes on the event queue or
                 // the RTI has responded with a TAG.
                 LF_PRINT_DEBUG("Waiting for a TAG from the RTI.");
-                if (lf_cond_wait(&event_q_changed, &mutex) != 0) {
+                if (_lf_wait_on_event_q_changed(_fed.last_sent_NET, FOREVER) != 0) {
                     lf_print_error("Wait error.");
                 }
                 // Either a TAG or PTAG arrived or something appeared on the event queue.
@@ -2660,11 +2670,22 @@ tag_t _lf_send_next_event_tag(tag_t tag, bool wait_for_reply) {
             }
         }
 
+        // The earliest tag on the event queue, as far as this thread knows.
+        tag_t expected_tag = original_tag;
         if (tag.time != FOREVER) {
             // Create a dummy event that will force this federate to advance time and subsequently enable progress for
             // downstream federates.
-            event_t* dummy = _lf_create_dummy_events(NULL, tag.time, NULL, 0);
+            // The tag may have been bounded by physical time to a tag that is
+            // not in the future, in which case the dummy event goes to the next microstep.
+            tag_t dummy_tag = tag;
+            if (lf_tag_compare(dummy_tag, current_tag) <= 0) {
+                dummy_tag = (tag_t) {.time = current_tag.time, .microstep = current_tag.microstep + 1};
+            }
+            lf_mutex_lock(&_lf_enclave->event_q_mutex);
+            event_t* dummy = _lf_create_dummy_event(dummy_tag);
             pqueue_insert(event_q, dummy);
+            lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+            expected_tag = dummy_tag;
         }
 
         LF_PRINT_DEBUG("Inserted a dummy event for logical time " PRINTF_TIME ".",
@@ -2694,7 +2715,7 @@ tag_t _lf_send_next_event_tag(tag_t tag, bool wait_for_reply) {
             wait_until_time_ns = original_tag.time;
         }
 
-        lf_cond_timedwait(&event_q_changed, &mutex, wait_until_time_ns);
+        _lf_wait_on_event_q_changed(expected_tag, wait_until_time_ns);
 
         LF_PRINT_DEBUG("Wait finished or interrupted.");
 
@@ -158,7 +158,7 @@ ssize_t read_from_socket(int socket, size_t num_bytes, unsigned char* buffer) {
  * @param socket The socket ID.
  * @param num_bytes The number of bytes to write.
  * @param buffer The buffer from which to get the bytes.
- * @param mutex If non-NULL, the mutex to unlock before exiting.
+ * @param lock If non-NULL, the mutex to unlock before exiting.
  * @param format A format string for error messages, followed by any number of
  *  fields that will be used to fill the format string as in printf, or NULL
  *  to prevent exit on error.
@@ -169,7 +169,7 @@ ssize_t write_to_socket_errexit_with_mutex(
 		int socket,
 		size_t num_bytes,
 		unsigned char* buffer,
-		lf_mutex_t* mutex,
+		lf_mutex_t* lock,
 		char* format, ...) {
     ssize_t bytes_written = 0;
     va_list args;
@@ -184,8 +184,8 @@ ssize_t write_to_socket_errexit_with_mutex(
             if (format != NULL) {
                 shutdown(socket, SHUT_RDWR);
             	close(socket);
-            	if (mutex != NULL) {
-            		lf_mutex_unlock(mutex);
+            	if (lock != NULL) {
+            		lf_mutex_unlock(lock);
             	}
                 lf_print_error(format, args);
                 lf_print_error_and_exit("Code %d: %s.", errno, strerror(errno));
@@ -87,3 +87,107 @@ int mixed_radix_to_int(mixed_radix_int_t* mixed) {
 	return mixed_radix_parent(mixed, 0);
 }
 
+
+/**
+ * Initialize an iterator that starts at the current value of the
+ * given mixed-radix number and increments it.
+ * @param it The iterator to initialize.
+ * @param mixed A pointer to the mixed-radix number, which must not
+ *  be modified other than through the iterator while it is in use.
+ * @param strides An array of mixed->size ints that the iterator uses
+ *  and that must remain valid while it is in use.
+ */
+void mixed_radix_iterator_init(mixed_radix_iterator_t* it, mixed_radix_int_t* mixed, int* strides) {
+	assert(it != NULL);
+	assert(mixed != NULL);
+	assert(mixed->size > 0);
+	it->mixed = mixed;
+	it->strides = strides;
+	it->value = 0;
+	int factor = 1;
+	for (int i = 0; i < mixed->size; i++) {
+		strides[i] = factor;
+		it->value += factor * mixed->digits[i];
+		factor *= mixed->radixes[i];
+	}
+}
+
+/**
+ * Increment the mixed-radix number of an iterator by one according
+ * to the permutation matrix, as mixed_radix_incr() does.
+ * @param it The iterator.
+ */
+void mixed_radix_iterator_incr(mixed_radix_iterator_t* it) {
+	mixed_radix_int_t* mixed = it->mixed;
+	for (int i = 0; i < mixed->size; i++) {
+		int digit_to_increment = mixed->permutation[i];
+		int stride = it->strides[digit_to_increment];
+		if (++mixed->digits[digit_to_increment] < mixed->radixes[digit_to_increment]) {
+			it->value += stride;
+			return; // All done.
+		}
+		// The digit overflows. Its contribution to the value goes back to 0.
+		it->value -= (mixed->radixes[digit_to_increment] - 1) * stride;
+		mixed->digits[digit_to_increment] = 0;
+	}
+	// If we get here, the number has overflowed and all digits are 0.
+}
+
+/**
+ * Return the int value of the mixed-radix number of an iterator.
+ * @param it The iterator.
+ */
+int mixed_radix_iterator_to_int(mixed_radix_iterator_t* it) {
+	return it->value;
+}
+
+/**
+ * Return the int value of the mixed-radix number of an iterator after
+ * dropping the first n digits, as mixed_radix_parent() does.
+ * @param it The iterator.
+ * @param n The number of digits to drop, which is assumed to
+ *  be greater than or equal to 0.
+ */
+int mixed_radix_iterator_parent(mixed_radix_iterator_t* it, int n) {
+	assert(n >= 0);
+	if (n >= it->mixed->size) {
+		return 0;
+	}
+	// The dropped digits contribute less than the stride of digit n.
+	return it->value / it->strides[n];
+}
+
+/**
+ * Write the int values of the mixed-radix number of an iterator and
+ * of the next count - 1 numbers that incrementing it yields to the
+ * given array, and leave the iterator at the number after those.
+ * Runs of increments that change only the first digit in the
+ * permutation are written without looking at the other digits.
+ * @param it The iterator.
+ * @param values An array of at least count ints.
+ * @param count The number of values to write.
+ */
+void mixed_radix_iterator_fill(mixed_radix_iterator_t* it, int* values, int count) {
+	mixed_radix_int_t* mixed = it->mixed;
+	int first = mixed->permutation[0];
+	int stride = it->strides[first];
+	int radix = mixed->radixes[first];
+	while (count > 0) {
+		// The first digit runs up to its radix before it carries.
+		int run = radix - mixed->digits[first];
+		if (run > count) {
+			run = count;
+		}
+		int value = it->value;
+		for (int i = 0; i < run; i++) {
+			values[i] = value;
+			value += stride;
+		}
+		values += run;
+		count -= run;
+		// Leave the iterator at the last value of the run and increment it from there.
+		mixed->digits[first] += run - 1;
+		it->value = value - stride;
+		mixed_radix_iterator_incr(it);
+	}
+}
@@ -39,6 +39,7 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <string.h>
 
+#include "enclave.h"
 #include "lf_types.h"
 #include "modes.h"
 #include "reactor_common.h"
@@ -53,8 +54,7 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 // Forward declaration of functions and variables supplied by reactor_common.c
 void _lf_trigger_reaction(reaction_t* reaction, int worker_number);
-event_t* _lf_create_dummy_events(trigger_t* trigger, instant_t time, event_t* next, microstep_t offset);
-extern pqueue_t* event_q;
+event_t* _lf_create_dummy_event(tag_t tag);
 
 // ----------------------------------------------------------------------------
 
@@ -72,6 +72,45 @@ _lf_suspended_event_t* _lf_suspended_events_head = NULL; // Start of linked coll
 int _lf_suspended_events_num = 0; // Number of suspended events (managed automatically!)
 _lf_suspended_event_t* _lf_unsused_suspended_events_head = NULL; // Internal collection of reusable list elements (managed automatically!)
 
+#ifdef LF_STATIC_MEMORY
+// In static-memory mode, the list elements and the buffer used to retract
+// events at a mode change are allocated at startup. Every suspended event
+// is an event, so there need to be no more of either than there are events.
+static _lf_suspended_event_t* _lf_preallocated_suspended_events = NULL;
+static event_t** _lf_delayed_removal_buffer = NULL;
+static size_t _lf_preallocated_capacity = 0;
+
+/**
+ * Allocate the list elements for suspended events and the buffer used to
+ * retract events at a mode change for the given number of events.
+ */
+void _lf_preallocate_suspended_events(size_t capacity) {
+    _lf_preallocated_suspended_events = (_lf_suspended_event_t*)calloc(capacity, sizeof(_lf_suspended_event_t));
+    _lf_delayed_removal_buffer = (event_t**)calloc(capacity, sizeof(event_t*));
+    if (_lf_preallocated_suspended_events == NULL || _lf_delayed_removal_buffer == NULL) {
+        lf_print_error_and_exit("Out of memory!");
+    }
+    _lf_preallocated_capacity = capacity;
+    for (size_t i = 0; i < capacity; i++) {
+        _lf_preallocated_suspended_events[i].next = _lf_unsused_suspended_events_head;
+        _lf_unsused_suspended_events_head = &_lf_preallocated_suspended_events[i];
+    }
+}
+#endif
+
+/**
+ * Free a list element for suspended events unless it was preallocated.
+ */
+static void _lf_free_suspended_event(_lf_suspended_event_t* suspended_event) {
+#ifdef LF_STATIC_MEMORY
+    if (suspended_event >= _lf_preallocated_suspended_events
+            && suspended_event < _lf_preallocated_suspended_events + _lf_preallocated_capacity) {
+        return;
+    }
+#endif
+    free(suspended_event);
+}
+
 /**
  * Save the given event as suspended.
  */
@@ -414,24 +453,18 @@ void _lf_process_mode_changes(
                             // No further processing; drops all events upon reset (timer event was recreated by schedule and original can be removed here)
                         } else if (state->next_mode != state->current_mode && event->trigger != NULL) { // History transition to a different mode
                             // Remaining time that the event would have been waiting before mode was left
-                            instant_t local_remaining_delay = event->time - (state->next_mode->deactivation_time != 0 ? state->next_mode->deactivation_time : lf_time_start());
+                            instant_t local_remaining_delay = event->tag.time - (state->next_mode->deactivation_time != 0 ? state->next_mode->deactivation_time : lf_time_start());
                             tag_t current_logical_tag = lf_tag();
 
                             // Reschedule event with original local delay
                             LF_PRINT_DEBUG("Modes: Re-enqueuing event with a suspended delay of " PRINTF_TIME
                             		" (previous TTH: " PRINTF_TIME ", Mode suspended at: " PRINTF_TIME ").",
-                            		local_remaining_delay, event->time, state->next_mode->deactivation_time);
-                            tag_t schedule_tag = {.time = current_logical_tag.time + local_remaining_delay, .microstep = (local_remaining_delay == 0 ? current_logical_tag.microstep + 1 : 0)};
+                            		local_remaining_delay, event->tag.time, state->next_mode->deactivation_time);
+                            // Events stacked up in super dense time are suspended individually.
+                            // Keep their microstep so that they are resumed in the same order.
+                            tag_t schedule_tag = {.time = current_logical_tag.time + local_remaining_delay,
+                                    .microstep = (local_remaining_delay == 0 ? current_logical_tag.microstep + 1 : event->tag.microstep)};
                             _lf_schedule_at_tag(event->trigger, schedule_tag, event->token);
-
-                            if (event->next != NULL) {
-                                // The event has more events stacked up in super dense time, attach them to the newly created event.
-                                if (event->trigger->last->next == NULL) {
-                                    event->trigger->last->next = event->next;
-                                } else {
-                                    lf_print_error("Modes: Cannot attach events stacked up in super dense to the just unsuspended root event.");
-                                }
-                            }
                         }
                         // A fresh event was created by schedule, hence, recycle old one
                         _lf_recycle_event(event);
@@ -499,15 +532,20 @@ void _lf_process_mode_changes(
         }
 
         // Retract all events from the event queue that are associated with now inactive modes
-        if (event_q != NULL) {
-            size_t q_size = pqueue_size(event_q);
+        if (_lf_enclave->event_q != NULL) {
+            size_t q_size = pqueue_size(_lf_enclave->event_q);
             if (q_size > 0) {
+#ifdef LF_STATIC_MEMORY
+                event_t** delayed_removal = q_size <= _lf_preallocated_capacity ?
+                        _lf_delayed_removal_buffer : (event_t**) calloc(q_size, sizeof(event_t*));
+#else
                 event_t** delayed_removal = (event_t**) calloc(q_size, sizeof(event_t*));
+#endif
                 size_t delayed_removal_count = 0;
 
                 // Find events
                 for (size_t i = 0; i < q_size; i++) {
-                    event_t* event = (event_t*)event_q->d[i + 1]; // internal queue data structure omits index 0
+                    event_t* event = (event_t*)_lf_enclave->event_q->d[i + 1]; // internal queue data structure omits index 0
                     if (event != NULL && event->trigger != NULL && !_lf_mode_is_active(event->trigger->mode)) {
                         delayed_removal[delayed_removal_count++] = event;
                         // This will store the event including possibly those chained up in super dense time
@@ -519,9 +557,16 @@ void _lf_process_mode_changes(
                 LF_PRINT_DEBUG("Modes: Pulling %zu events from the event queue to suspend them. %d events are now suspended.",
                 		delayed_removal_count, _lf_suspended_events_num);
                 for (size_t i = 0; i < delayed_removal_count; i++) {
-                    pqueue_remove(event_q, delayed_removal[i]);
+                    pqueue_remove(_lf_enclave->event_q, delayed_removal[i]);
+                    // All events of the trigger have left the event queue.
+                    delayed_removal[i]->trigger->last_tag = NEVER_TAG;
                 }
 
+#ifdef LF_STATIC_MEMORY
+                if (delayed_removal == _lf_delayed_removal_buffer) {
+                    delayed_removal = NULL;
+                }
+#endif
                 free(delayed_removal);
             }
         }
@@ -529,7 +574,8 @@ void _lf_process_mode_changes(
         if (_lf_mode_triggered_reactions_request) {
             // Insert a dummy event in the event queue for the next microstep to make
             // sure startup/reset reactions (if any) are triggered as soon as possible.
-            pqueue_insert(event_q, _lf_create_dummy_events(NULL, current_tag.time, NULL, 1));
+            pqueue_insert(_lf_enclave->event_q, _lf_create_dummy_event(
+                    (tag_t) {.time = _lf_enclave->current_tag.time, .microstep = _lf_enclave->current_tag.microstep + 1}));
         }
     }
 }
@@ -543,7 +589,7 @@ void _lf_terminate_modal_reactors() {
     while(suspended_event != NULL) {
         _lf_recycle_event(suspended_event->event);
         _lf_suspended_event_t* next = suspended_event->next;
-        free(suspended_event);
+        _lf_free_suspended_event(suspended_event);
         suspended_event = next;
     }
     _lf_suspended_events_head = NULL;
@@ -553,9 +599,16 @@ void _lf_terminate_modal_reactors() {
     suspended_event = _lf_unsused_suspended_events_head;
     while(suspended_event != NULL) {
         _lf_suspended_event_t* next = suspended_event->next;
-        free(suspended_event);
+        _lf_free_suspended_event(suspended_event);
         suspended_event = next;
     }
     _lf_unsused_suspended_events_head = NULL;
+#ifdef LF_STATIC_MEMORY
+    free(_lf_preallocated_suspended_events);
+    free(_lf_delayed_removal_buffer);
+    _lf_preallocated_suspended_events = NULL;
+    _lf_delayed_removal_buffer = NULL;
+    _lf_preallocated_capacity = 0;
+#endif
 }
 #endif
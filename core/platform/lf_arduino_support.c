@@ -80,3 +80,75 @@ int lf_clock_gettime(instant_t* t) {
     *t = micros();
     return 0;
 }
+
+/**
+ * Pause execution until the physical clock reaches the specified time.
+ *
+ * There is no absolute sleep on this platform, so this computes the remaining
+ * time and uses lf_nanosleep().
+ *
+ * @return 0 for success, or -1 for failure.
+ */
+int lf_sleep_until(instant_t wakeup_time) {
+    instant_t now;
+    if (lf_clock_gettime(&now) != 0) {
+        return -1;
+    }
+    if (wakeup_time <= now) {
+        return 0;
+    }
+    return lf_nanosleep(wakeup_time - now);
+}
+
+/**
+ * Set the scheduling policy of the calling thread. Only LF_SCHED_FAIR,
+ * which is the default, is supported on this platform.
+ *
+ * @return 0 for LF_SCHED_FAIR, -1 otherwise.
+ */
+int lf_thread_set_scheduling_policy(lf_scheduling_policy_t* policy) {
+    if (policy->policy == LF_SCHED_FAIR) {
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ * Locking memory is not supported on this platform.
+ *
+ * @return -1 always.
+ */
+int lf_lock_memory(void) {
+    return -1;
+}
+
+/**
+ * The stack size of threads is not known on this platform.
+ */
+size_t lf_thread_stack_size(void) {
+    return 0;
+}
+
+/**
+ * Prefaulting the stack is not supported on this platform, so this does nothing.
+ */
+void lf_prefault_stack(size_t size) {}
+
+/**
+ * Intercepting heap allocations is not supported on this platform.
+ */
+int lf_forbid_heap_allocation(bool forbidden) {
+    (void)forbidden;
+    errno = ENOTSUP;
+    return -1;
+}
+
+/**
+ * There is no cheaper clock on this platform, so this is equivalent to
+ * lf_clock_gettime().
+ *
+ * @return 0 for success, or -1 for failure.
+ */
+int lf_clock_gettime_fast(instant_t* t, interval_t tolerance) {
+    return lf_clock_gettime(t);
+}
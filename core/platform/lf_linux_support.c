@@ -29,6 +29,10 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *  @author{Soroush Bateni <soroush@utdallas.edu>}
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // For pthread_getattr_np().
+#endif
+
 #include "lf_linux_support.h"
 #include "platform.h"
 
@@ -38,10 +42,140 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #else
 #include "lf_C11_threads_support.h"
 #endif
+#include <pthread.h>
 #endif
 
 #include "lf_unix_clock_support.h"
 
+#include <alloca.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "util.h"
+
+/**
+ * The number of bytes of the stack of a thread that lf_prefault_stack()
+ * leaves untouched.
+ */
+#define LF_PREFAULT_STACK_MARGIN (64 * 1024)
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+
+/**
+ * The maximum error of the TSC-based clock relative to _LF_CLOCK. The
+ * calibration below keeps the error to the order of the jitter of reading
+ * _LF_CLOCK, which is well below this.
+ */
+#define TSC_CLOCK_MAX_ERROR USEC(1)
+
+/**
+ * The minimum time over which the TSC frequency is measured before the
+ * TSC is used, and the maximum time between recalibrations.
+ */
+#define TSC_CLOCK_MIN_BASELINE MSEC(1)
+#define TSC_CLOCK_MAX_INTERVAL MSEC(100)
+
+/**
+ * State of the TSC-based clock of one thread. Each thread calibrates its
+ * own state, so reading the clock requires no synchronization.
+ */
+typedef struct _lf_tsc_clock_t {
+    uint64_t tsc_base;     // TSC at the last calibration.
+    instant_t time_base;   // Time reported by lf_clock_gettime() at the last calibration.
+    uint64_t ns_per_tick;  // Nanoseconds per tick in 32.32 fixed point, or 0 if not yet known.
+    interval_t interval;   // Time after the last calibration at which to calibrate again.
+} _lf_tsc_clock_t;
+
+static _Thread_local _lf_tsc_clock_t _lf_tsc_clock;
+
+/**
+ * Whether the TSC runs at a constant rate in all power states (-1 if not yet known).
+ */
+static int _lf_tsc_is_invariant = -1;
+
+/**
+ * Estimate _LF_CLOCK (in epoch time) from the TSC.
+ *
+ * The TSC frequency is measured against lf_clock_gettime() over the
+ * interval since the previous calibration. The next calibration is due
+ * after as long as that baseline, which is at least the previous interval,
+ * so intervals grow, up to TSC_CLOCK_MAX_INTERVAL. Because an interval is
+ * never longer than the baseline its frequency was measured over, the error
+ * accumulated by the end of an interval stays on the order of the jitter of
+ * a single reading of _LF_CLOCK.
+ */
+static int _lf_clock_gettime_tsc(instant_t* t) {
+    _lf_tsc_clock_t* clock = &_lf_tsc_clock;
+    if (clock->ns_per_tick != 0) {
+        uint64_t ticks = __rdtsc() - clock->tsc_base;
+        interval_t elapsed = (interval_t)(((unsigned __int128)ticks * clock->ns_per_tick) >> 32);
+        if (elapsed < clock->interval) {
+            *t = clock->time_base + elapsed;
+            return 0;
+        }
+    }
+    // Read the precise clock and recalibrate.
+    instant_t now;
+    if (lf_clock_gettime(&now) != 0) {
+        return -1;
+    }
+    uint64_t tsc = __rdtsc();
+    interval_t baseline = now - clock->time_base;
+    if (clock->time_base == 0LL || baseline < 0LL) {
+        clock->tsc_base = tsc;
+        clock->time_base = now;
+    } else if (baseline >= TSC_CLOCK_MIN_BASELINE && tsc > clock->tsc_base) {
+        clock->ns_per_tick = (uint64_t)(((unsigned __int128)baseline << 32) / (tsc - clock->tsc_base));
+        clock->interval = baseline < TSC_CLOCK_MAX_INTERVAL ? baseline : TSC_CLOCK_MAX_INTERVAL;
+        clock->tsc_base = tsc;
+        clock->time_base = now;
+    }
+    *t = now;
+    return 0;
+}
+
+/**
+ * Return whether the TSC can be used as a clock, which requires that
+ * it be invariant.
+ */
+static bool _lf_tsc_is_usable() {
+    if (_lf_tsc_is_invariant < 0) {
+        unsigned int eax, ebx, ecx, edx;
+        _lf_tsc_is_invariant = __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8));
+    }
+    return _lf_tsc_is_invariant;
+}
+#endif // __x86_64__
+
+/**
+ * The resolution of CLOCK_MONOTONIC_COARSE (0 if not yet known).
+ */
+static interval_t _lf_coarse_clock_resolution = 0LL;
+
+/**
+ * The argument of the sched_setattr system call, which glibc does not wrap.
+ * See `man 2 sched_setattr`.
+ */
+struct _lf_sched_attr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
 /**
  * Pause execution for a number of nanoseconds.
  *
@@ -56,3 +190,265 @@ int lf_nanosleep(instant_t requested_time) {
     struct timespec remaining;
     return clock_nanosleep(_LF_CLOCK, 0, (const struct timespec*)&tp, (struct timespec*)&remaining);
 }
+
+/**
+ * Pause execution until the physical clock reaches the specified time.
+ *
+ * The wakeup time is converted back from epoch time to _LF_CLOCK, and the
+ * wait is an absolute clock_nanosleep on that clock, so it is not affected
+ * by adjustments to the realtime clock or by the time spent setting it up.
+ *
+ * @return 0 for success, or -1 for failure. In case of failure, errno will be
+ *  set appropriately (see `man 2 clock_nanosleep`).
+ */
+int lf_sleep_until(instant_t wakeup_time) {
+    const struct timespec tp = convert_ns_to_timespec(wakeup_time - _lf_time_epoch_offset);
+    int result = clock_nanosleep(_LF_CLOCK, TIMER_ABSTIME, &tp, NULL);
+    if (result != 0) {
+        errno = result;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Fetch a cheaper estimate of the clock read by lf_clock_gettime().
+ *
+ * On x86-64 processors with an invariant TSC, if the tolerance is at least
+ * TSC_CLOCK_MAX_ERROR, this estimates the time from the TSC without a system
+ * call or a vDSO clock read. Otherwise, if the tolerance is at least the
+ * resolution of CLOCK_MONOTONIC_COARSE (typically a few milliseconds),
+ * this reads that clock, which is cheaper than CLOCK_MONOTONIC. Otherwise,
+ * this is equivalent to lf_clock_gettime().
+ *
+ * @return 0 for success, or -1 for failure.
+ */
+int lf_clock_gettime_fast(instant_t* t, interval_t tolerance) {
+#if defined(__x86_64__)
+    if (tolerance >= TSC_CLOCK_MAX_ERROR && _lf_tsc_is_usable()) {
+        return _lf_clock_gettime_tsc(t);
+    }
+#endif
+    if (_LF_CLOCK == CLOCK_MONOTONIC && tolerance > 0LL) {
+        if (_lf_coarse_clock_resolution == 0LL) {
+            struct timespec resolution;
+            _lf_coarse_clock_resolution = (clock_getres(CLOCK_MONOTONIC_COARSE, &resolution) == 0)
+                    ? convert_timespec_to_ns(resolution) : FOREVER;
+        }
+        if (tolerance >= _lf_coarse_clock_resolution) {
+            struct timespec tp;
+            if (clock_gettime(CLOCK_MONOTONIC_COARSE, &tp) != 0) {
+                return -1;
+            }
+            *t = convert_timespec_to_ns(tp) + _lf_time_epoch_offset;
+            return 0;
+        }
+    }
+    return lf_clock_gettime(t);
+}
+
+/**
+ * Set the scheduling policy of the calling thread.
+ *
+ * LF_SCHED_FAIR, LF_SCHED_TIMESLICE, and LF_SCHED_PRIORITY map to SCHED_OTHER,
+ * SCHED_RR, and SCHED_FIFO. LF_SCHED_DEADLINE maps to SCHED_DEADLINE with a
+ * relative deadline equal to the period. On Linux, these apply to the calling
+ * thread only.
+ *
+ * @return 0 for success, or -1 for failure. In case of failure, errno will be
+ *  set appropriately (see `man 2 sched_setscheduler` and `man 2 sched_setattr`).
+ */
+int lf_thread_set_scheduling_policy(lf_scheduling_policy_t* policy) {
+    struct sched_param param = { .sched_priority = 0 };
+    switch (policy->policy) {
+        case LF_SCHED_FAIR:
+            return sched_setscheduler(0, SCHED_OTHER, &param);
+        case LF_SCHED_TIMESLICE:
+            param.sched_priority = policy->priority;
+            return sched_setscheduler(0, SCHED_RR, &param);
+        case LF_SCHED_PRIORITY:
+            param.sched_priority = policy->priority;
+            return sched_setscheduler(0, SCHED_FIFO, &param);
+        case LF_SCHED_DEADLINE: {
+            struct _lf_sched_attr attr = {
+                .size = sizeof(struct _lf_sched_attr),
+                .sched_policy = SCHED_DEADLINE,
+                .sched_runtime = (uint64_t)policy->runtime,
+                .sched_deadline = (uint64_t)policy->period,
+                .sched_period = (uint64_t)policy->period
+            };
+            return (int)syscall(SYS_sched_setattr, 0, &attr, 0);
+        }
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+}
+
+/**
+ * Lock all current and future memory of the process into RAM.
+ *
+ * @return 0 for success, or -1 for failure. In case of failure, errno will be
+ *  set appropriately (see `man 2 mlockall`).
+ */
+int lf_lock_memory(void) {
+    return mlockall(MCL_CURRENT | MCL_FUTURE);
+}
+
+/**
+ * Return the size of the stack of the calling thread. Threads get theirs from
+ * the attributes they were created with. The stack of the main thread grows
+ * up to the stack size limit of the process.
+ *
+ * @return The size in bytes, or 0 if it is unknown or unlimited.
+ */
+size_t lf_thread_stack_size(void) {
+    size_t size = 0;
+#if defined NUMBER_OF_WORKERS || defined LINGUA_FRANCA_TRACE
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        if (pthread_attr_getstacksize(&attr, &size) != 0) {
+            size = 0;
+        }
+        pthread_attr_destroy(&attr);
+    }
+#else
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        size = (size_t)limit.rlim_cur;
+    }
+#endif
+    return size;
+}
+
+/**
+ * Touch the specified number of bytes of the calling thread's stack, one
+ * page at a time, so that the pages are mapped (and, after lf_lock_memory(),
+ * locked) before they are needed. The size is limited to the stack size of
+ * the thread less LF_PREFAULT_STACK_MARGIN, which leaves room for the frames
+ * of the caller and the functions called while touching the pages.
+ */
+void lf_prefault_stack(size_t size) {
+    size_t stack_size = lf_thread_stack_size();
+    if (stack_size > 0) {
+        size_t limit = stack_size > LF_PREFAULT_STACK_MARGIN ? stack_size - LF_PREFAULT_STACK_MARGIN : 0;
+        if (size > limit) {
+            lf_print_warning("Cannot prefault %zu bytes of a stack of %zu bytes. Prefaulting %zu bytes.",
+                    size, stack_size, limit);
+            size = limit;
+        }
+    }
+    if (size == 0) {
+        return;
+    }
+    volatile unsigned char* stack = (volatile unsigned char*)alloca(size);
+    long page_size = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < size; i += (size_t)page_size) {
+        stack[i] = 0;
+    }
+}
+
+#if defined(LF_STATIC_MEMORY) && defined(__GLIBC__)
+
+// The allocation functions of glibc, which the ones below forward to.
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* pointer, size_t size);
+
+/** Whether the calling thread may not allocate memory from the heap. */
+#ifdef NUMBER_OF_WORKERS
+static LF_THREAD_LOCAL bool _lf_heap_allocation_forbidden = false;
+#else
+static bool _lf_heap_allocation_forbidden = false;
+#endif
+
+/**
+ * Report a heap allocation by a thread that may not allocate and exit.
+ * Allocation is allowed again first, so that reporting may allocate.
+ */
+static void _lf_heap_allocation_failed(const char* function, size_t size) {
+    _lf_heap_allocation_forbidden = false;
+    lf_print_error_and_exit("Static-memory mode: %s() of %zu bytes after startup.", function, size);
+}
+
+// The functions below replace those of glibc for the whole program, which
+// glibc supports. They are only compiled in static-memory mode.
+
+void* malloc(size_t size) {
+    if (_lf_heap_allocation_forbidden) {
+        _lf_heap_allocation_failed("malloc", size);
+    }
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    if (_lf_heap_allocation_forbidden) {
+        _lf_heap_allocation_failed("calloc", count * size);
+    }
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+    if (_lf_heap_allocation_forbidden) {
+        _lf_heap_allocation_failed("realloc", size);
+    }
+    return __libc_realloc(pointer, size);
+}
+
+/**
+ * Forbid or allow heap allocation by the calling thread.
+ * @return Whether it was forbidden before.
+ */
+int lf_forbid_heap_allocation(bool forbidden) {
+    int previous = _lf_heap_allocation_forbidden;
+    _lf_heap_allocation_forbidden = forbidden;
+    return previous;
+}
+#else
+/**
+ * Heap allocations are only intercepted in static-memory mode with glibc.
+ */
+int lf_forbid_heap_allocation(bool forbidden) {
+    (void)forbidden;
+    errno = ENOTSUP;
+    return -1;
+}
+#endif // LF_STATIC_MEMORY && __GLIBC__
+
+#ifdef NUMBER_OF_WORKERS
+#include <limits.h>
+#include <linux/futex.h>
+
+/**
+ * Block while the word at address holds expected, using the futex system call.
+ *
+ * @return 0 for success, or -1 for failure. A change of the word before the
+ *  call, a wakeup by a signal, and a spurious wakeup all count as success.
+ */
+int lf_futex_wait(volatile int32_t* address, int32_t expected) {
+    if (syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0) != 0
+            && errno != EAGAIN && errno != EINTR) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Wake all threads waiting on the word at address using the futex system call.
+ *
+ * @return 0 for success, or -1 for failure.
+ */
+int lf_futex_wake(volatile int32_t* address) {
+    return lf_futex_wake_n(address, INT_MAX);
+}
+
+/**
+ * Wake at most count threads waiting on the word at address using the futex
+ * system call.
+ *
+ * @return 0 for success, or -1 for failure.
+ */
+int lf_futex_wake_n(volatile int32_t* address, int32_t count) {
+    return syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0) < 0 ? -1 : 0;
+}
+#endif
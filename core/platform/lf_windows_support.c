@@ -42,6 +42,10 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "util.h"
 #include <time.h>
 
+// This file defines lf_mutex_lock(), so it must not be redirected
+// to the lock profiler.
+#undef lf_mutex_lock
+
 /**
  * Indicate whether or not the underlying hardware
  * supports Windows' high-resolution counter. It should
@@ -335,3 +339,126 @@ int lf_nanosleep(instant_t requested_time) {
     /* Slept without problems */
     return TRUE;
 }
+
+/**
+ * Pause execution until the physical clock reaches the specified time.
+ *
+ * There is no absolute sleep on this platform, so this computes the remaining
+ * time and uses lf_nanosleep().
+ *
+ * @return 0 for success, or -1 for failure.
+ */
+int lf_sleep_until(instant_t wakeup_time) {
+    instant_t now;
+    if (lf_clock_gettime(&now) != 0) {
+        return -1;
+    }
+    if (wakeup_time <= now) {
+        return 0;
+    }
+    // lf_nanosleep() returns TRUE on success on this platform.
+    return lf_nanosleep(wakeup_time - now) ? 0 : -1;
+}
+
+/**
+ * Set the scheduling policy of the calling thread. Only LF_SCHED_FAIR,
+ * which is the default, is supported on this platform.
+ *
+ * @return 0 for LF_SCHED_FAIR, -1 otherwise.
+ */
+int lf_thread_set_scheduling_policy(lf_scheduling_policy_t* policy) {
+    if (policy->policy == LF_SCHED_FAIR) {
+        return 0;
+    }
+    errno = ENOTSUP;
+    return -1;
+}
+
+/**
+ * Locking memory is not supported on this platform.
+ *
+ * @return -1 always.
+ */
+int lf_lock_memory(void) {
+    errno = ENOTSUP;
+    return -1;
+}
+
+/**
+ * The stack size of threads is not known on this platform.
+ */
+size_t lf_thread_stack_size(void) {
+    return 0;
+}
+
+/**
+ * Prefaulting the stack is not supported on this platform, so this does nothing.
+ */
+void lf_prefault_stack(size_t size) {}
+
+/**
+ * Intercepting heap allocations is not supported on this platform.
+ */
+int lf_forbid_heap_allocation(bool forbidden) {
+    (void)forbidden;
+    errno = ENOTSUP;
+    return -1;
+}
+
+/**
+ * There is no cheaper clock on this platform, so this is equivalent to
+ * lf_clock_gettime().
+ *
+ * @return 0 for success, or -1 for failure.
+ */
+int lf_clock_gettime_fast(instant_t* t, interval_t tolerance) {
+    return lf_clock_gettime(t);
+}
+
+#ifdef NUMBER_OF_WORKERS
+/**
+ * WaitOnAddress() requires linking an extra system library, so waiting on an
+ * address is emulated with one condition variable shared by all addresses.
+ * Wakers broadcast on it, and each waiter re-checks its own word.
+ */
+static SRWLOCK _lf_futex_lock = SRWLOCK_INIT;
+static CONDITION_VARIABLE _lf_futex_cond = CONDITION_VARIABLE_INIT;
+
+/**
+ * Block while the word at address holds expected.
+ *
+ * @return 0 for success, or 1 on failure.
+ */
+int lf_futex_wait(volatile int32_t* address, int32_t expected) {
+    int result = 0;
+    AcquireSRWLockExclusive(&_lf_futex_lock);
+    if (*address == expected
+            && !SleepConditionVariableSRW(&_lf_futex_cond, &_lf_futex_lock, INFINITE, 0)) {
+        result = 1;
+    }
+    ReleaseSRWLockExclusive(&_lf_futex_lock);
+    return result;
+}
+
+/**
+ * Wake all threads waiting in lf_futex_wait().
+ *
+ * @return 0 always.
+ */
+int lf_futex_wake(volatile int32_t* address) {
+    AcquireSRWLockExclusive(&_lf_futex_lock);
+    WakeAllConditionVariable(&_lf_futex_cond);
+    ReleaseSRWLockExclusive(&_lf_futex_lock);
+    return 0;
+}
+
+/**
+ * Wake all threads waiting in lf_futex_wait(), since they all wait on the
+ * same condition variable.
+ *
+ * @return The result of lf_futex_wake().
+ */
+int lf_futex_wake_n(volatile int32_t* address, int32_t count) {
+    return lf_futex_wake(address);
+}
+#endif
@@ -39,6 +39,9 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "lf_types.h"
 #include "platform.h"
 #include "reactor_common.h"
+#ifdef LF_CACHED_SCHEDULES
+#include "schedule_cache.h"
+#endif
 
 /**
  * @brief Queue of triggered reactions at the current tag.
@@ -136,13 +139,24 @@ void _lf_set_present(lf_port_base_t* port) {
  * was not given, then wait until physical time matches or exceeds the start time of
  * execution plus the current_tag.time plus the specified logical time.  If this is not
  * interrupted, then advance current_tag.time by the specified logical_delay.
+ * If a spin margin has been given with --spin-margin, then the last part
+ * of the wait spins on the physical clock instead of sleeping.
+ * While waiting, this handles the file descriptors registered with
+ * lf_register_fd(), whose handlers may schedule physical actions, and the
+ * wait is interrupted when it does so.
  * Return 0 if time advanced to the time of the event and -1 if the wait
  * was interrupted or if the timeout time was reached.
  */
 int wait_until(instant_t logical_time_ns) {
     int return_value = 0;
-    if (!fast) {
-        LF_PRINT_LOG("Waiting for elapsed logical time " PRINTF_TIME ".", logical_time_ns - start_time);
+    if (_lf_instance->fast) {
+        // Logical time does not wait for physical time, but it does wait for
+        // input if there is nothing else to do.
+        if (_lf_fd_poll(logical_time_ns == FOREVER) > 0) {
+            return -1;
+        }
+    } else {
+        LF_PRINT_LOG("Waiting for elapsed logical time " PRINTF_TIME ".", logical_time_ns - _lf_instance->start_time);
         interval_t ns_to_wait = logical_time_ns - lf_time_physical();
 
         if (ns_to_wait < MIN_WAIT_TIME) {
@@ -151,7 +165,24 @@ int wait_until(instant_t logical_time_ns) {
             return return_value;
         }
 
-        return_value = lf_nanosleep(ns_to_wait);
+        // Sleep until the spin margin before the target time. Since
+        // lf_sleep_until() uses the unadjusted platform clock, compute the
+        // wakeup time from the clock reading that lf_time_physical() used.
+        // Note that the addition could overflow if logical_time_ns == FOREVER.
+        if (ns_to_wait > _lf_spin_margin) {
+            interval_t ns_to_sleep = ns_to_wait - _lf_spin_margin;
+            instant_t wakeup_time = FOREVER;
+            if (FOREVER - _lf_last_reported_unadjusted_physical_time_ns > ns_to_sleep) {
+                wakeup_time = _lf_last_reported_unadjusted_physical_time_ns + ns_to_sleep;
+            }
+            return_value = _lf_fd_sleep_until(wakeup_time);
+        }
+        if (return_value == 0) {
+            if (_lf_spin_margin > 0LL) {
+                _lf_spin_until(logical_time_ns);
+            }
+            _lf_record_wait_lag(lf_time_physical() - logical_time_ns);
+        }
     }
     return return_value;
 }
@@ -186,10 +217,36 @@ void _lf_trigger_reaction(reaction_t* reaction, int worker_number) {
         LF_PRINT_DEBUG("Enqueing downstream reaction %s, which has level %lld.",
         		reaction->name, reaction->index & 0xffffLL);
         reaction->status = queued;
+#ifdef LF_CACHED_SCHEDULES
+        if (_lf_schedule_cache_trigger(reaction)) {
+            return;
+        }
+#endif
         pqueue_insert(reaction_q, reaction);
     }
 }
 
+/**
+ * Return the next reaction to execute at the current tag.
+ * @return The reaction, or NULL if there are no more reactions to execute.
+ */
+static reaction_t* _lf_next_reaction(void) {
+    reaction_t* reaction;
+#ifdef LF_CACHED_SCHEDULES
+    if ((reaction = _lf_schedule_cache_next()) != NULL) {
+        return reaction;
+    }
+#endif
+    if (pqueue_size(reaction_q) == 0) {
+        return NULL;
+    }
+    reaction = (reaction_t*)pqueue_pop(reaction_q);
+#ifdef LF_CACHED_SCHEDULES
+    _lf_schedule_cache_record(reaction);
+#endif
+    return reaction;
+}
+
 /**
  * Execute all the reactions in the reaction queue at the current tag.
  *
@@ -197,15 +254,18 @@ void _lf_trigger_reaction(reaction_t* reaction, int worker_number) {
  *  should stop.
  */
 int _lf_do_step(void) {
+#ifdef LF_CACHED_SCHEDULES
+    _lf_schedule_cache_start_step();
+#endif
     // Invoke reactions.
-    while(pqueue_size(reaction_q) > 0) {
+    reaction_t* reaction;
+    while((reaction = _lf_next_reaction()) != NULL) {
         // lf_print_snapshot();
-        reaction_t* reaction = (reaction_t*)pqueue_pop(reaction_q);
         reaction->status = running;
 
         LF_PRINT_LOG("Invoking reaction %s at elapsed logical tag " PRINTF_TAG ".",
         		reaction->name,
-                current_tag.time - start_time, current_tag.microstep);
+                _lf_enclave->current_tag.time - _lf_instance->start_time, _lf_enclave->current_tag.microstep);
 
         bool violation = false;
 
@@ -218,7 +278,7 @@ int _lf_do_step(void) {
         // then the reaction will be invoked and the violation reaction will not be invoked again.
         if (reaction->deadline >= 0LL) {
             // Get the current physical time.
-            instant_t physical_time = lf_time_physical();
+            instant_t physical_time = lf_time_physical_fast();
             // FIXME: These comments look outdated. We may need to update them.
             // Check for deadline violation.
             // There are currently two distinct deadline mechanisms:
@@ -226,7 +286,7 @@ int _lf_do_step(void) {
             // container deadlines are defined in the container.
             // They can have different deadlines, so we have to check both.
             // Handle the local deadline first.
-            if (reaction->deadline == 0 || physical_time > current_tag.time + reaction->deadline) {
+            if (reaction->deadline == 0 || physical_time > _lf_enclave->current_tag.time + reaction->deadline) {
                 LF_PRINT_LOG("Deadline violation. Invoking deadline handler.");
                 // Deadline violation has occurred.
                 violation = true;
@@ -244,6 +304,7 @@ int _lf_do_step(void) {
         if (!violation) {
             // Invoke the reaction function.
             _lf_invoke_reaction(reaction, 0);   // 0 indicates unthreaded.
+            _lf_release_suspended_reaction(reaction, 0);
 
             // If the reaction produced outputs, put the resulting triggered
             // reactions into the queue.
@@ -253,13 +314,16 @@ int _lf_do_step(void) {
         //  current tag, so it is safe to conclude that it is now inactive.
         reaction->status = inactive;
     }
+#ifdef LF_CACHED_SCHEDULES
+    _lf_schedule_cache_end_step();
+#endif
 
 #ifdef MODAL_REACTORS
     // At the end of the step, perform mode transitions
     _lf_handle_mode_changes();
 #endif
 
-    if (lf_tag_compare(current_tag, stop_tag) >= 0) {
+    if (lf_tag_compare(_lf_enclave->current_tag, _lf_enclave->stop_tag) >= 0) {
         return 0;
     }
 
@@ -282,7 +346,7 @@ int _lf_do_step(void) {
 // the keepalive command-line option has not been given.
 // Otherwise, return 1.
 int next(void) {
-    event_t* event = (event_t*)pqueue_peek(event_q);
+    event_t* event = (event_t*)pqueue_peek(_lf_enclave->event_q);
     //pqueue_dump(event_q, event_q->prt);
     // If there is no next event and -keepalive has been specified
     // on the command line, then we will wait the maximum time possible.
@@ -294,46 +358,35 @@ int next(void) {
     #endif
     if (event == NULL) {
         // No event in the queue.
-        if (!keepalive_specified) { // FIXME: validator should issue a warning for unthreaded implementation
+        if (!_lf_instance->keepalive_specified) { // FIXME: validator should issue a warning for unthreaded implementation
                                     // schedule is not thread-safe
-            _lf_set_stop_tag((tag_t){.time=current_tag.time,.microstep=current_tag.microstep+1});
+            _lf_set_stop_tag((tag_t){.time=_lf_enclave->current_tag.time,.microstep=_lf_enclave->current_tag.microstep+1});
         }
     } else {
-        next_tag.time = event->time;
-        // Deduce the microstep
-        if (next_tag.time == current_tag.time) {
-            next_tag.microstep = lf_tag().microstep + 1;
-        } else {
-            next_tag.microstep = 0;
-        }
+        next_tag = event->tag;
     }
 
     if (_lf_is_tag_after_stop_tag(next_tag)) {
         // Cannot process events after the stop tag.
-        next_tag = stop_tag;
+        next_tag = _lf_enclave->stop_tag;
     }
 
-    LF_PRINT_LOG("Next event (elapsed) time is " PRINTF_TIME ".", next_tag.time - start_time);
+    LF_PRINT_LOG("Next event (elapsed) time is " PRINTF_TIME ".", next_tag.time - _lf_instance->start_time);
     // Wait until physical time >= event.time.
     // The wait_until function will advance current_tag.time.
     if (wait_until(next_tag.time) != 0) {
         LF_PRINT_DEBUG("***** wait_until was interrupted.");
-        // Sleep was interrupted.
-        // FIXME: It is unclear what would cause this to occur in this unthreaded
-        // runtime since lf_schedule() is not thread safe here and should not
-        // be called asynchronously. Perhaps in some runtime such as for a
-        // PRET machine this will be supported, so here we handle this as
-        // if an asynchronous call to schedule has occurred. In that case,
-        // we should return 1 to let the runtime loop around to see what
-        // is on the event queue.
+        // Sleep was interrupted. This occurs when the handler of a file
+        // descriptor has scheduled a physical action, so return 1 to let
+        // the runtime loop around to see what is on the event queue.
         return 1;
     }
 
     // At this point, finally, we have an event to process.
     // Advance current time to match that of the first event on the queue.
-    _lf_advance_logical_time(next_tag.time);
+    _lf_advance_logical_time(next_tag);
 
-    if (lf_tag_compare(current_tag, stop_tag) >= 0) {
+    if (lf_tag_compare(_lf_enclave->current_tag, _lf_enclave->stop_tag) >= 0) {
         _lf_trigger_shutdown_reactions();
     }
 
@@ -341,7 +394,7 @@ int next(void) {
     // such as initializing outputs to be absent.
     _lf_start_time_step();
 
-    // Pop all events from event_q with timestamp equal to current_tag.time,
+    // Pop all events from event_q with tag equal to current_tag,
     // extract all the reactions triggered by these events, and
     // stick them into the reaction queue.
     _lf_pop_events();
@@ -354,11 +407,66 @@ int next(void) {
  */
 void lf_request_stop() {
 	tag_t new_stop_tag;
-	new_stop_tag.time = current_tag.time;
-	new_stop_tag.microstep = current_tag.microstep + 1;
+	new_stop_tag.time = _lf_enclave->current_tag.time;
+	new_stop_tag.microstep = _lf_enclave->current_tag.microstep + 1;
 	_lf_set_stop_tag(new_stop_tag);
 }
 
+/**
+ * Execute a loop given to lf_parallel_for(). Without worker threads, there
+ * is no one to share it with.
+ */
+void lf_parallel_for(size_t start, size_t end, size_t grain, lf_parallel_for_body_t body, void* arg) {
+    (void)grain;
+    if (start < end) {
+        body(start, end, arg);
+    }
+}
+
+/**
+ * How often the main thread checks whether a suspended reaction has been
+ * resumed, by another thread or by the handler of a file descriptor.
+ */
+#define SUSPENSION_POLL_INTERVAL MSEC(1)
+
+/**
+ * Resume a suspended reaction. See reactor.h for documentation.
+ */
+void lf_reaction_resume(void* handle) {
+    reaction_t* reaction = (reaction_t*)handle;
+    if (reaction->suspension.state != reaction_suspending) {
+        lf_print_error_and_exit("lf_reaction_resume() was called for reaction %s, which is not suspended.",
+                reaction->name);
+    }
+    reaction->suspension.state = reaction_resumed;
+}
+
+/**
+ * If the given reaction has suspended itself, wait until it is resumed and
+ * execute its continuation, repeatedly if the continuation suspends it again.
+ * Without worker threads, there is nothing else to do meanwhile but to handle
+ * the file descriptors registered with lf_register_fd().
+ * @param reaction The reaction that has just executed.
+ * @param worker 0, since the execution is unthreaded.
+ * @return false, since the reaction is done when this returns.
+ */
+bool _lf_release_suspended_reaction(reaction_t* reaction, int worker) {
+    while (reaction->suspension.state != reaction_not_suspended) {
+        while (reaction->suspension.state == reaction_suspending) {
+            // _lf_fd_sleep_until() does not wait for the file descriptors
+            // for as short a time as this, so handle those that are readable
+            // first.
+            if (_lf_fd_poll(false) == 0) {
+                instant_t now;
+                lf_clock_gettime(&now);
+                lf_sleep_until(now + SUSPENSION_POLL_INTERVAL);
+            }
+        }
+        _lf_invoke_continuation(reaction, worker);
+    }
+    return false;
+}
+
 /**
  * Return false.
  * @param reaction The reaction.
@@ -401,6 +509,8 @@ int lf_reactor_c_main(int argc, const char* argv[]) {
         
         LF_PRINT_DEBUG("Initializing.");
         initialize(); // Sets start_time.
+        // In the unthreaded runtime, the main thread executes the reactions.
+        _lf_initialize_thread(LF_WORKER_THREAD);
 #ifdef MODAL_REACTORS
         // Set up modal infrastructure
         _lf_initialize_modes();
@@ -409,17 +519,20 @@ int lf_reactor_c_main(int argc, const char* argv[]) {
         // Reaction queue ordered first by deadline, then by level.
         // The index of the reaction holds the deadline in the 48 most significant bits,
         // the level in the 16 least significant bits.
-        reaction_q = pqueue_init(INITIAL_REACT_QUEUE_SIZE, in_reverse_order, get_reaction_index,
+        reaction_q = pqueue_init(_lf_reaction_queue_capacity(), in_reverse_order, get_reaction_index,
                 get_reaction_position, set_reaction_position, reaction_matches, print_reaction);
 
-        current_tag = (tag_t){.time = start_time, .microstep = 0u};
-        _lf_execution_started = true;
+        // In static-memory mode, everything has been allocated by now.
+        _lf_forbid_heap_allocation(true);
+
+        _lf_enclave->current_tag = (tag_t){.time = _lf_instance->start_time, .microstep = 0u};
+        _lf_instance->execution_started = true;
         _lf_trigger_startup_reactions();
         _lf_initialize_timers();
         // If the stop_tag is (0,0), also insert the shutdown
         // reactions. This can only happen if the timeout time
         // was set to 0.
-        if (lf_tag_compare(current_tag, stop_tag) >= 0) {
+        if (lf_tag_compare(_lf_enclave->current_tag, _lf_enclave->stop_tag) >= 0) {
             _lf_trigger_shutdown_reactions();
         }
         LF_PRINT_DEBUG("Running the program's main loop.");
@@ -427,6 +540,7 @@ int lf_reactor_c_main(int argc, const char* argv[]) {
         if (_lf_do_step()) {
             while (next() != 0);
         }
+        _lf_forbid_heap_allocation(false);
         // pqueue_free(reaction_q); FIXME: This might be causing weird memory errors
         return 0;
     } else {
@@ -36,9 +36,11 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *  @author{Alexander Schulz-Rosengarten <als@informatik.uni-kiel.de>}
  */
 #include <assert.h>
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "enclave.h"
 #include "lf_types.h"
 #ifdef MODAL_REACTORS
 #include "modes.h"
@@ -71,83 +73,46 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ////////////////////////////////////////////////////////////
 //// Global variables :(
 
-/**
- * Indicator of whether to wait for physical time to match logical time.
- * By default, execution will wait. The command-line argument -fast will
- * eliminate the wait and allow logical time to exceed physical time.
+/*
+ * The tables that the code generator fills in to reset is_present fields
+ * and reference counts at the start of each time step (_lf_is_present_fields
+ * and so on, see reactor_common.h) are fields of the enclave.
+ * _lf_is_present_fields_abbreviated lists the is_present fields that have
+ * been set to true during the execution of a tag so that, usually, fewer
+ * fields have to be reset. If a port is set more than once at a tag, it
+ * can have more records than _lf_is_present_fields, in which case all
+ * is_present fields are reset instead. _lf_more_tokens_with_ref_count
+ * lists copies of tokens made for mutable inputs, and
+ * _lf_sparse_io_record_sizes points to the size fields of instances of
+ * lf_sparse_io_record_t, which are set to 0 between iterations.
  */
-bool fast = false;
 
 /**
- * The number of worker threads for threaded execution.
- * By default, execution is not threaded and this variable will have value 0.
- *
- * If the execution is threaded, a value of 0 indicates that the runtime should
- * decide on the number of workers (which will be decided based on the number of
- * available cores on the host machine).
+ * The amount of time before the target time at which a wait for physical
+ * time to match logical time stops sleeping and starts spinning on the
+ * physical clock. Sleeping typically wakes up tens of microseconds late,
+ * so a small margin here trades CPU time for lower lag at each tag.
+ * A value of 0 (the default) disables spinning. This is set with the
+ * --spin-margin command-line option.
  */
-unsigned int _lf_number_of_workers = 0u;
+interval_t _lf_spin_margin = 0LL;
 
 /**
- * The logical time to elapse during execution, or -1 if no timeout time has
- * been given. When the logical equal to start_time + duration has been
- * reached, execution will terminate.
+ * The scheduling policy requested with --thread-policy for each class of
+ * threads, and whether one was requested at all. Threads of classes for
+ * which no policy was requested keep the default policy of the platform.
  */
-instant_t duration = -1LL;
+static lf_scheduling_policy_t _lf_thread_policies[LF_NUMBER_OF_THREAD_CLASSES];
+static bool _lf_thread_policy_specified[LF_NUMBER_OF_THREAD_CLASSES];
 
-/**
- * Indicates whether or not the execution
- * has started.
- */
-bool _lf_execution_started = false;
+/** Indicator of whether the --lock-memory command-line option was given. */
+bool _lf_lock_memory_specified = false;
 
 /**
- * The tag at which the Lingua Franca program should stop.
- * It will be initially set to timeout if it is set. However,
- * starvation or calling lf_request_stop() can also alter the stop_tag by moving it
- * earlier.
- *
- * FIXME: This variable might need to be volatile
- */
-tag_t stop_tag = FOREVER_TAG_INITIALIZER;
-
-/** Indicator of whether the keepalive command-line option was given. */
-bool keepalive_specified = false;
-
-// Define the array of pointers to the _is_present fields of all the
-// self structs that need to be reinitialized at the start of each time step.
-// NOTE: This may have to be resized for a mutation.
-bool** _lf_is_present_fields = NULL;
-int _lf_is_present_fields_size = 0;
-
-// Define an array of pointers to the _is_present fields
-// that have been set to true during the execution of a tag
-// so that at the conclusion of the tag, these fields can be reset to
-// false. Usually, this list will have fewer records than will
-// _lf_is_present_fields, allowing for some time to be saved.
-// However, it is possible for it to have more records if some ports
-// are set multiple times at the same tag. In such cases, we fall back
-// to resetting all is_present fields at the start of the next time
-// step.
-bool** _lf_is_present_fields_abbreviated = NULL;
-int _lf_is_present_fields_abbreviated_size = 0;
-
-// Define the array of pointers to the intended_tag fields of all
-// ports and actions that need to be reinitialized at the start
-// of each time step.
-tag_t** _lf_intended_tag_fields = NULL;
-int _lf_intended_tag_fields_size = 0;
-
-// Define the array of pointers to the token fields of all the
-// actions and inputs that need to have their reference counts
-// decremented at the start of each time step.
-// NOTE: This may have to be resized for a mutation.
-token_present_t* _lf_tokens_with_ref_count = NULL;
-// Dynamically created list of tokens that are copies made
-// as a result of mutable inputs. These need to also have
-// _lf_done_using() called on them at the start of the next time step.
-lf_token_t* _lf_more_tokens_with_ref_count = NULL;
-int _lf_tokens_with_ref_count_size = 0;
+ * The number of bytes of stack that each runtime thread touches when it
+ * starts, as given by the --prefault-stack command-line option, or 0.
+ */
+size_t _lf_prefault_stack_size = 0;
 
 /**
  * Global STP offset uniformly applied to advancement of each
@@ -157,19 +122,6 @@ int _lf_tokens_with_ref_count_size = 0;
  */
 interval_t _lf_fed_STA_offset = 0LL;
 
-/**
- * A vector of pointers to the size fields of instances of
- * lf_sparse_io_record_t so that these can be set to 0 between iterations.
- * The start field of this struct will be NULL initially, so calling
- * vector_new(_lf_sparse_io_record_sizes) will be necessary to use this.
- */
-// FIXME: The original call to vector_new appears to never have been implemented.
-// Fortunately if it is initialized to all zeros, we avoid undefined behavior.
-// This is a bit of a hack.
-vector_t _lf_sparse_io_record_sizes = {
-    NULL, NULL, NULL, 0, 0
-};
-
 /**
  * Allocate memory using calloc (so the allocated memory is zeroed out)
  * and record the allocated memory on the specified self struct so that
@@ -195,12 +147,6 @@ void* _lf_allocate(
     return mem;
 }
 
-/**
- * Head of a list of pointers to dynamically generated reactor
- * self structs to be freed in terminate().
- */
-struct allocation_record_t* _lf_reactors_to_free = NULL;
-
 /**
  * Allocate memory for a new runtime instance of a reactor.
  * This records the reactor on the list of reactors to be freed at
@@ -209,7 +155,7 @@ struct allocation_record_t* _lf_reactors_to_free = NULL;
  * @param size The size of the self struct, obtained with sizeof().
  */
 void* _lf_new_reactor(size_t size) {
-    return _lf_allocate(1, size, &_lf_reactors_to_free);
+    return _lf_allocate(1, size, &_lf_instance->reactors_to_free);
 }
 
 /**
@@ -246,14 +192,196 @@ void _lf_free_reactor(struct self_base_t *self) {
  * {@link #_lf_new_reactor(size_t)}.
  */
 void _lf_free_all_reactors(void) {
-    struct allocation_record_t* head = _lf_reactors_to_free;
+    struct allocation_record_t* head = _lf_instance->reactors_to_free;
     while (head != NULL) {
         _lf_free_reactor((self_base_t*)head->allocated);
         struct allocation_record_t* tmp = head->next;
         free(head);
         head = tmp;
     }
-    _lf_reactors_to_free = NULL;
+    _lf_instance->reactors_to_free = NULL;
+}
+
+#ifdef LF_STATIC_MEMORY
+/**
+ * Allocate memory that does not fit into a pool from the heap, which is
+ * allowed even in a thread that may otherwise not allocate.
+ * @param size The size of the memory.
+ * @param overflow Whether to count this as an overflow of a pool, which the
+ *  overflow policy LF_OVERFLOW_HEAP permits.
+ */
+static void* _lf_allocate_from_heap(size_t size, bool overflow) {
+    if (overflow) {
+#ifdef NUMBER_OF_WORKERS
+        lf_atomic_fetch_add(&_lf_instance->pool_overflows, 1);
+#else
+        _lf_instance->pool_overflows++;
+#endif
+    }
+    int forbidden = lf_forbid_heap_allocation(false);
+    void* memory = malloc(size);
+    if (forbidden > 0) {
+        lf_forbid_heap_allocation(true);
+    }
+    if (memory == NULL) lf_print_error_and_exit("Out of memory!");
+    return memory;
+}
+
+/**
+ * Take a block from a pool of the instance that the calling thread is bound
+ * to. Before initialize() has created the pools, the block is allocated from
+ * the heap instead. If the pool has no free block, the overflow policy
+ * decides whether to exit or to allocate the block from the heap.
+ * @param pool The pool.
+ * @param name The name of what the pool holds, for error messages.
+ * @param size The size of the block.
+ */
+static void* _lf_pool_take(pool_t* pool, const char* name, size_t size) {
+    if (pool->blocks == NULL) {
+        return _lf_allocate_from_heap(size, false);
+    }
+    void* block = pool_take(pool);
+    if (block == NULL) {
+        if (_lf_instance->overflow_policy == LF_OVERFLOW_EXIT) {
+            lf_print_error_and_exit("Static-memory mode: all %zu %s are in use. "
+                    "Use --max-events or --max-tokens to provide more.", pool->capacity, name);
+        }
+        block = _lf_allocate_from_heap(size, true);
+    }
+    return block;
+}
+
+/**
+ * Give back a block to the pool that it was taken from with _lf_pool_take(),
+ * or free it if it was allocated from the heap.
+ */
+static void _lf_pool_give(pool_t* pool, void* block) {
+    if (pool_contains(pool, block)) {
+        pool_give(pool, block);
+    } else {
+        free(block);
+    }
+}
+
+/**
+ * Allocate the pools of the instance that the calling thread is bound to.
+ * This is called by initialize() after the trigger objects have been
+ * created, so that the pools can be sized for them. There are as many tokens
+ * as --max-tokens specifies or else, because each port or action with tokens
+ * holds at most one token and one writable copy of it at a time, twice as
+ * many as there are such ports and actions in addition to one per event.
+ * Each token has a block for its payload.
+ */
+static void _lf_initialize_pools() {
+    size_t max_tokens = _lf_instance->max_tokens;
+    if (max_tokens == 0) {
+        max_tokens = _lf_instance->max_events;
+        for (lf_enclave_t* enclave = &_lf_main_enclave; enclave != NULL; enclave = enclave->next) {
+            max_tokens += 2 * (size_t)enclave->tokens_with_ref_count_size;
+        }
+    }
+    if (pool_init(&_lf_instance->event_pool, sizeof(event_t), _lf_instance->max_events) != 0
+            || pool_init(&_lf_instance->token_pool, sizeof(lf_token_t), max_tokens) != 0
+            || pool_init(&_lf_instance->payload_pool, _lf_instance->max_payload_size, max_tokens) != 0) {
+        lf_print_error_and_exit("Out of memory allocating the pools of static-memory mode.");
+    }
+#ifdef MODAL_REACTORS
+    _lf_preallocate_suspended_events(_lf_instance->max_events);
+#endif
+    LF_PRINT_LOG("Static-memory mode: memory for %zu events, %zu tokens, and %zu payloads of %zu bytes.",
+            _lf_instance->max_events, max_tokens, max_tokens, _lf_instance->payload_pool.block_size);
+}
+
+/**
+ * Report how many blocks of each pool were in use at most and how many
+ * allocations did not fit into the pools.
+ */
+static void _lf_report_pools() {
+    LF_PRINT_LOG("Static-memory mode: at most %zu of %zu events, %zu of %zu tokens, and %zu of %zu payloads were in use.",
+            _lf_instance->event_pool.high_water_mark, _lf_instance->event_pool.capacity,
+            _lf_instance->token_pool.high_water_mark, _lf_instance->token_pool.capacity,
+            _lf_instance->payload_pool.high_water_mark, _lf_instance->payload_pool.capacity);
+    if (_lf_instance->pool_overflows > 0) {
+        lf_print_warning("Static-memory mode: %d allocations did not fit into the pools and used the heap.",
+                _lf_instance->pool_overflows);
+    }
+}
+
+void _lf_forbid_heap_allocation(bool forbidden) {
+    static bool warned = false;
+    if (lf_forbid_heap_allocation(forbidden) < 0 && !warned) {
+        warned = true;
+        lf_print_warning("Static-memory mode cannot detect heap allocations on this platform.");
+    }
+}
+#endif // LF_STATIC_MEMORY
+
+/**
+ * Allocate memory for a payload that the runtime creates on behalf of a
+ * reactor, which _lf_free_token() frees. In static-memory mode, this takes
+ * a block from the payload pool, unless the payload is larger than a block,
+ * which the overflow policy then handles.
+ * @param size The size of the payload in bytes.
+ */
+void* _lf_allocate_payload(size_t size) {
+#ifdef LF_STATIC_MEMORY
+    if (size > _lf_instance->payload_pool.block_size && _lf_instance->payload_pool.blocks != NULL) {
+        if (_lf_instance->overflow_policy == LF_OVERFLOW_EXIT) {
+            lf_print_error_and_exit("Static-memory mode: a payload of %zu bytes is larger than %zu bytes. "
+                    "Use --max-payload-size to allow it.", size, _lf_instance->payload_pool.block_size);
+        }
+        return _lf_allocate_from_heap(size, true);
+    }
+    return _lf_pool_take(&_lf_instance->payload_pool, "payloads", size);
+#else
+    return malloc(size);
+#endif
+}
+
+/**
+ * Free a payload allocated with _lf_allocate_payload() or by a reactor with
+ * malloc().
+ */
+static void _lf_free_payload(void* payload) {
+#ifdef LF_STATIC_MEMORY
+    _lf_pool_give(&_lf_instance->payload_pool, payload);
+#else
+    free(payload);
+#endif
+}
+
+/**
+ * Return whether the payload of the specified token is stored in the token
+ * itself rather than in memory that has to be freed.
+ */
+static inline bool _lf_token_value_is_inline(lf_token_t* token) {
+#if LF_TOKEN_INLINE_SIZE > 0
+    return token->value == (void*)token->inline_value.bytes;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Return memory for a payload of the specified size to be carried by the
+ * specified token. A payload that is to be freed by a destructor is allocated
+ * with malloc(), since destructors free it with free(). Otherwise, a payload
+ * that fits is stored in the token itself, and a larger one is allocated with
+ * _lf_allocate_payload().
+ * @param token The token that is to carry the payload.
+ * @param size The size of the payload in bytes.
+ * @param has_destructor Whether the payload is to be freed by a destructor.
+ */
+static void* _lf_allocate_token_payload(lf_token_t* token, size_t size, bool has_destructor) {
+    if (has_destructor) {
+        return malloc(size);
+    }
+#if LF_TOKEN_INLINE_SIZE > 0
+    if (size <= LF_TOKEN_INLINE_SIZE) {
+        return token->inline_value.bytes;
+    }
+#endif
+    return _lf_allocate_payload(size);
 }
 
 /**
@@ -266,8 +394,8 @@ void _lf_free_all_reactors(void) {
  *  calling this function.
  */
 void _lf_set_stop_tag(tag_t tag) {
-    if (lf_tag_compare(tag, stop_tag) < 0) {
-        stop_tag = tag;
+    if (lf_tag_compare(tag, _lf_enclave->stop_tag) < 0) {
+        _lf_enclave->stop_tag = tag;
     }
 }
 
@@ -298,39 +426,12 @@ void lf_set_stp_offset(interval_t offset) {
 /////////////////////////////
 // The following is not in scope for reactors:
 
-/** Priority queues. */
-pqueue_t* event_q;     // For sorting by time.
-
-static pqueue_t* recycle_q;   // For recycling malloc'd events.
-static pqueue_t* next_q;      // For temporarily storing the next event lined
-                       // up in superdense time.
-
-static trigger_handle_t _lf_handle = 1;
-
-/**
- * Counter used to issue a warning if memory is
- * allocated for message payloads and never freed.
- */
-static int _lf_count_payload_allocations;
-
-/**
- * Counter used to issue a warning if memory is
- * allocated for tokens and never freed. Note that
- * every trigger will have one token allocated for
- * it. That token is not counted because it is not
- * expected to be freed.
- */
-static int _lf_count_token_allocations;
-
-/**
- * Tokens always have the same size in memory so they are easily recycled.
- * When a token is freed, this pointer will be updated to point to it.
- * Freed tokens are chained using their next_free field.
- */
-static lf_token_t* _lf_token_recycling_bin = NULL;
-
-/** Count of the number of tokens in the recycling bin. */
-static int _lf_token_recycling_bin_size = 0;
+// Tokens always have the same size in memory so they are easily recycled.
+// Freed tokens are chained using their next_free field in the recycling bin
+// of the enclave that the calling thread is bound to (see enclave.h), so that
+// enclaves do not contend for one bin.
+#define _lf_token_recycling_bin (_lf_enclave->token_recycling_bin)
+#define _lf_token_recycling_bin_size (_lf_enclave->token_recycling_bin_size)
 
 /**
  * To allow a system to recover from burst of activity, the token recycling
@@ -346,6 +447,8 @@ typedef enum token_freed {
 } token_freed;
 
 
+static token_freed _lf_done_using(lf_token_t* token);
+
 /**
  * Determine which part of the token should be freed and
  * free each part correspondingly.
@@ -360,22 +463,35 @@ static token_freed _lf_free_token(lf_token_t* token) {
         return NOT_FREED;
     }
     token_freed result = NOT_FREED;
-    if (token->value != NULL) {
+    if (token->parent != NULL) {
+        // The token is a view, so the payload belongs to its parent.
+        lf_token_t* parent = token->parent;
+        token->parent = NULL;
+        token->value = NULL;
+        _lf_done_using(parent);
+        result = VALUE_FREED;
+    } else if (token->value != NULL) {
         // Count frees to issue a warning if this is never freed.
         // Do not free the value field if it is garbage collected and token's
         // ok_to_free field is not "token_and_value".
-        _lf_count_payload_allocations--;
-        // Free the value field (the payload).
-        // First check whether the value field is garbage collected (e.g. in the
-        // Python target), in which case the payload should not be freed.
-        if (OK_TO_FREE != token_only
+        _lf_instance->count_payload_allocations--;
+        // Free the value field (the payload), or release it if the program
+        // owns it. Otherwise, check whether the value field is garbage
+        // collected (e.g. in the Python target), in which case the payload
+        // should not be freed, and whether it is stored in the token itself.
+        if (token->release != NULL) {
+            LF_PRINT_DEBUG("_lf_free_token: Releasing payload (token value): %p", token->value);
+            token->release(token->value, token->length, token->release_context);
+            token->release = NULL;
+        } else if (OK_TO_FREE != token_only
                 && token->value != NULL
                 && token->ok_to_free != token_only
+                && !_lf_token_value_is_inline(token)
             ) {
             LF_PRINT_DEBUG("_lf_free_token: Freeing allocated memory for payload (token value): %p",
                     token->value);
             if (token->destructor == NULL) {
-                free(token->value);
+                _lf_free_payload(token->value);
             } else {
                 token->destructor(token->value);
             }
@@ -388,6 +504,10 @@ static token_freed _lf_free_token(lf_token_t* token) {
     // ports and should not be freed. They are expected to be reused instead.
     if (token->ok_to_free) {
         // Need to free the lf_token_t struct also.
+#ifdef LF_STATIC_MEMORY
+        // The token pool is itself a recycling bin without a size limit.
+        _lf_pool_give(&_lf_instance->token_pool, token);
+#else
         if (_lf_token_recycling_bin_size < _LF_TOKEN_RECYCLING_BIN_SIZE_LIMIT) {
             // Recycle instead of freeing.
             token->next_free = _lf_token_recycling_bin;
@@ -397,7 +517,8 @@ static token_freed _lf_free_token(lf_token_t* token) {
             // Recycling bin is full.
             free(token);
         }
-        _lf_count_token_allocations--;
+#endif
+        _lf_instance->count_token_allocations--;
         LF_PRINT_DEBUG("_lf_free_token: Freeing allocated memory for token: %p", token);
         result = TOKEN_FREED;
     }
@@ -427,6 +548,17 @@ static token_freed _lf_done_using(lf_token_t* token) {
     return token->ref_count == 0 ? _lf_free_token(token) : NOT_FREED;
 }
 
+/**
+ * Free a token that nothing refers to, such as one that could not be
+ * scheduled, and its payload. A token with references is left alone.
+ * @param token Pointer to a token, or NULL.
+ */
+void _lf_free_unreferenced_token(lf_token_t* token) {
+    if (token != NULL && token->ref_count == 0) {
+        _lf_free_token(token);
+    }
+}
+
 /**
  * Trigger 'reaction'.
  *
@@ -445,7 +577,7 @@ void _lf_trigger_reaction(reaction_t* reaction, int worker_number);
  * counts between time steps and at the end of execution.
  */
 void _lf_start_time_step() {
-    LF_PRINT_LOG("--------- Start time step at tag " PRINTF_TAG ".", current_tag.time - start_time, current_tag.microstep);
+    LF_PRINT_LOG("--------- Start time step at tag " PRINTF_TAG ".", _lf_enclave->current_tag.time - _lf_instance->start_time, _lf_enclave->current_tag.microstep);
     for(int i = 0; i < _lf_tokens_with_ref_count_size; i++) {
         if (*(_lf_tokens_with_ref_count[i].status) == present) {
             if (_lf_tokens_with_ref_count[i].reset_is_present
@@ -510,6 +642,9 @@ void _lf_start_time_step() {
  */
 lf_token_t* _lf_create_token(size_t element_size) {
     lf_token_t* token;
+#ifdef LF_STATIC_MEMORY
+    token = (lf_token_t*)_lf_pool_take(&_lf_instance->token_pool, "tokens", sizeof(lf_token_t));
+#else
     // Check the recycling bin.
     if (_lf_token_recycling_bin != NULL) {
         token = _lf_token_recycling_bin;
@@ -520,6 +655,7 @@ lf_token_t* _lf_create_token(size_t element_size) {
         token = (lf_token_t*)malloc(sizeof(lf_token_t));
         LF_PRINT_DEBUG("_lf_create_token: Allocated memory for token: %p", token);
     }
+#endif
     token->value = NULL;
     token->length = 0;
     token->element_size = element_size;
@@ -528,6 +664,9 @@ lf_token_t* _lf_create_token(size_t element_size) {
     token->copy_constructor = NULL;
     token->ok_to_free = no;
     token->next_free = NULL;
+    token->parent = NULL;
+    token->release = NULL;
+    token->release_context = NULL;
     return token;
 }
 
@@ -543,7 +682,7 @@ lf_token_t* _lf_create_token(size_t element_size) {
  */
 lf_token_t* create_token(size_t element_size) {
     LF_PRINT_DEBUG("create_token: element_size: %zu", element_size);
-    _lf_count_token_allocations++;
+    _lf_instance->count_token_allocations++;
     lf_token_t* result = _lf_create_token(element_size);
     result->ok_to_free = OK_TO_FREE;
     return result;
@@ -596,11 +735,13 @@ lf_token_t* _lf_initialize_token_with_value(lf_token_t* token, void* value, size
 lf_token_t* _lf_initialize_token(lf_token_t* token, size_t length) {
     assert(token != NULL);
 
-    // Allocate memory for storing the array.
-    void* value = malloc(token->element_size * length);
+    // Choose the token first, since a small payload is stored in it.
+    bool has_destructor = token->destructor != NULL;
+    lf_token_t* result = _lf_initialize_token_with_value(token, NULL, length);
+    result->value = _lf_allocate_token_payload(result, result->element_size * length, has_destructor);
     // Count allocations to issue a warning if this is never freed.
-    _lf_count_payload_allocations++;
-    return _lf_initialize_token_with_value(token, value, length);
+    _lf_instance->count_payload_allocations++;
+    return result;
 }
 
 /**
@@ -609,11 +750,101 @@ lf_token_t* _lf_initialize_token(lf_token_t* token, size_t length) {
  * @param tag The tag to check against stop tag
  */
 bool _lf_is_tag_after_stop_tag(tag_t tag) {
-    return (lf_tag_compare(tag, stop_tag) > 0);
+    return (lf_tag_compare(tag, _lf_enclave->stop_tag) > 0);
 }
 
 /**
- * Pop all events from event_q with timestamp equal to current_tag.time, extract all
+ * Return the name of a class of threads as used by --thread-policy.
+ */
+static const char* _lf_thread_class_name(lf_thread_class_t thread_class) {
+    switch (thread_class) {
+        case LF_WORKER_THREAD: return "workers";
+        case LF_TRACE_THREAD: return "trace";
+        case LF_NETWORK_THREAD: return "network";
+        case LF_IO_THREAD: return "io";
+        default: return NULL;
+    }
+}
+
+/**
+ * Apply the real-time options given on the command line to the calling
+ * thread, which belongs to the specified class of threads. This sets the
+ * scheduling policy of the thread, if one was given for its class, and
+ * prefaults its stack, if --prefault-stack was given. If the process lacks
+ * permission to use the requested policy, this prints a warning and the
+ * thread continues with its current policy.
+ * @param thread_class The class of the calling thread.
+ */
+void _lf_initialize_thread(lf_thread_class_t thread_class) {
+    if (_lf_thread_policy_specified[thread_class]
+            && lf_thread_set_scheduling_policy(&_lf_thread_policies[thread_class]) != 0) {
+        lf_print_warning("Failed to set the scheduling policy of a %s thread: %s. "
+                "Continuing with the default policy.",
+                _lf_thread_class_name(thread_class), strerror(errno));
+    }
+    if (_lf_prefault_stack_size > 0) {
+        lf_prefault_stack(_lf_prefault_stack_size);
+    }
+}
+
+/**
+ * Spin on the physical clock until physical time matches or exceeds the
+ * specified time. This is used for the last part of a wait for physical
+ * time, within _lf_spin_margin of the target time.
+ * @param wakeup_time The time, as returned by lf_time_physical(), to wait for.
+ */
+void _lf_spin_until(instant_t wakeup_time) {
+    while (lf_time_physical() < wakeup_time) {
+        // Busy wait.
+    }
+}
+
+/**
+ * Record in the wait lag histogram of the current enclave how late a wait for
+ * physical time ended.
+ * @param lag The physical time at which the wait ended minus the time
+ *  that was waited for.
+ */
+void _lf_record_wait_lag(interval_t lag) {
+    int bucket = 0;
+    while (lag > 0LL && bucket < LF_WAIT_LAG_HISTOGRAM_BUCKETS - 1) {
+        lag >>= 1;
+        bucket++;
+    }
+    _lf_enclave->wait_lag_histogram[bucket]++;
+}
+
+/**
+ * Print the wait lag histogram of an enclave, omitting empty buckets.
+ * @param enclave The enclave.
+ */
+static void _lf_print_wait_lag_histogram(lf_enclave_t* enclave) {
+    size_t* histogram = enclave->wait_lag_histogram;
+    size_t total = 0;
+    for (int i = 0; i < LF_WAIT_LAG_HISTOGRAM_BUCKETS; i++) {
+        total += histogram[i];
+    }
+    if (total == 0) {
+        return;
+    }
+    LF_PRINT_LOG("---- Lag of physical time behind logical time after waits of enclave %s (spin margin "
+            PRINTF_TIME " ns):", enclave->name, _lf_spin_margin);
+    for (int i = 0; i < LF_WAIT_LAG_HISTOGRAM_BUCKETS; i++) {
+        if (histogram[i] == 0) {
+            continue;
+        }
+        if (i == 0) {
+            LF_PRINT_LOG("----   on time: %zu", histogram[i]);
+        } else if (i == LF_WAIT_LAG_HISTOGRAM_BUCKETS - 1) {
+            LF_PRINT_LOG("----   >= %lld ns: %zu", 1LL << (i - 1), histogram[i]);
+        } else {
+            LF_PRINT_LOG("----   %lld to %lld ns: %zu", 1LL << (i - 1), (1LL << i) - 1, histogram[i]);
+        }
+    }
+}
+
+/**
+ * Pop all events from event_q with tag equal to current_tag, extract all
  * the reactions triggered by these events, and stick them into the reaction
  * queue.
  */
@@ -622,19 +853,15 @@ void _lf_pop_events() {
     _lf_handle_mode_triggered_reactions();
 #endif
 
-    event_t* event = (event_t*)pqueue_peek(event_q);
-    while(event != NULL && event->time == current_tag.time) {
-        event = (event_t*)pqueue_pop(event_q);
+    event_t* event = (event_t*)pqueue_peek(_lf_enclave->event_q);
+    while(event != NULL && lf_tag_compare(event->tag, _lf_enclave->current_tag) == 0) {
+        event = (event_t*)pqueue_pop(_lf_enclave->event_q);
 
-        if (event->is_dummy) {
+        if (event->trigger == NULL) {
             LF_PRINT_DEBUG("Popped dummy event from the event queue.");
-            if (event->next != NULL) {
-                LF_PRINT_DEBUG("Putting event from the event queue for the next microstep.");
-                pqueue_insert(next_q, event->next);
-            }
             _lf_recycle_event(event);
             // Peek at the next event in the event queue.
-            event = (event_t*)pqueue_peek(event_q);
+            event = (event_t*)pqueue_peek(_lf_enclave->event_q);
             continue;
         }
 
@@ -665,13 +892,13 @@ void _lf_pop_events() {
                     event->trigger->intended_tag = event->intended_tag;
                     // And check if it is in the past compared to the current tag.
                     if (lf_tag_compare(event->intended_tag,
-                                    current_tag) < 0) {
+                                    _lf_enclave->current_tag) < 0) {
                         // Mark the triggered reaction with a STP violation
                         reaction->is_STP_violated = true;
                         LF_PRINT_LOG("Trigger %p has violated the reaction's STP offset. Intended tag: " PRINTF_TAG ". Current tag: " PRINTF_TAG,
                                     event->trigger,
-                                    event->intended_tag.time - start_time, event->intended_tag.microstep,
-                                    current_tag.time - start_time, current_tag.microstep);
+                                    event->intended_tag.time - _lf_instance->start_time, event->intended_tag.microstep,
+                                    _lf_enclave->current_tag.time - _lf_instance->start_time, _lf_enclave->current_tag.microstep);
                     }
                 }
 #endif
@@ -721,16 +948,10 @@ void _lf_pop_events() {
         // Mark the trigger present.
         event->trigger->status = present;
 
-        // If this event points to a next event, insert it into the next queue.
-        if (event->next != NULL) {
-            // Insert the next event into the next queue.
-            pqueue_insert(next_q, event->next);
-        }
-
         _lf_recycle_event(event);
 
         // Peek at the next event in the event queue.
-        event = (event_t*)pqueue_peek(event_q);
+        event = (event_t*)pqueue_peek(_lf_enclave->event_q);
     };
 
 #ifdef FEDERATED
@@ -738,14 +959,6 @@ void _lf_pop_events() {
     // the reaction queue
     enqueue_network_control_reactions();
 #endif // FEDERATED
-
-    LF_PRINT_DEBUG("There are %zu events deferred to the next microstep.", pqueue_size(next_q));
-
-    // After populating the reaction queue, see if there are things on the
-    // next queue to put back into the event queue.
-    while(pqueue_peek(next_q) != NULL) {
-        pqueue_insert(event_q, pqueue_pop(next_q));
-    }
 }
 
 /**
@@ -753,8 +966,15 @@ void _lf_pop_events() {
  * If not, allocate a new one. In either case, all fields will be zero'ed out.
  */
 static event_t* _lf_get_new_event() {
+#ifdef LF_STATIC_MEMORY
+    event_t* e = (event_t*)_lf_pool_take(&_lf_instance->event_pool, "events", sizeof(struct event_t));
+    memset(e, 0, sizeof(struct event_t));
+#ifdef FEDERATED_DECENTRALIZED
+    e->intended_tag = (tag_t) { .time = NEVER, .microstep = 0u};
+#endif
+#else
     // Recycle event_t structs, if possible.
-    event_t* e = (event_t*)pqueue_pop(recycle_q);
+    event_t* e = (event_t*)pqueue_pop(_lf_enclave->recycle_q);
     if (e == NULL) {
         e = (event_t*)calloc(1, sizeof(struct event_t));
         if (e == NULL) lf_print_error_and_exit("Out of memory!");
@@ -762,17 +982,74 @@ static event_t* _lf_get_new_event() {
         e->intended_tag = (tag_t) { .time = NEVER, .microstep = 0u};
 #endif
     }
+#endif
     return e;
 }
 
+/**
+ * Free an event that is on neither the event queue nor the recycle queue.
+ */
+static void _lf_free_event(event_t* e) {
+#ifdef LF_STATIC_MEMORY
+    _lf_pool_give(&_lf_instance->event_pool, e);
+#else
+    free(e);
+#endif
+}
+
+/**
+ * Insert the specified event into the event queue and, if it is later than
+ * any event previously scheduled for its trigger, record its tag in the trigger.
+ * @param e The event, which must have a trigger.
+ */
+static void _lf_insert_event(event_t* e) {
+    if (lf_tag_compare(e->tag, e->trigger->last_tag) > 0) {
+        e->trigger->last_tag = e->tag;
+    }
+    pqueue_insert(_lf_enclave->event_q, e);
+}
+
+/**
+ * Move the specified event, which conflicts with an event for the same
+ * trigger that is already on the event queue, to the first microstep
+ * after the queued events for that trigger at the same time.
+ * Usually, the last tag recorded in the trigger gives this microstep
+ * directly, so a pile-up of events in superdense time does not need
+ * to be searched one microstep at a time. The last tag only grows, however,
+ * and events can leave the event queue without being processed, such as when
+ * their mode is left. Hence, it is used only while the event at the last tag
+ * is still on the event queue; otherwise, the microsteps are searched one
+ * at a time.
+ * @param e The event, which must have a trigger.
+ */
+static void _lf_defer_to_free_microstep(event_t* e) {
+    tag_t last_tag = e->trigger->last_tag;
+    if (last_tag.time == e->tag.time && lf_tag_compare(last_tag, e->tag) > 0) {
+        tag_t tag = e->tag;
+        e->tag = last_tag;
+        if (pqueue_find_equal_same_priority(_lf_enclave->event_q, e) == NULL) {
+            // The event at the last tag has left the event queue.
+            e->tag = tag;
+        }
+    }
+    do {
+        e->tag.microstep++;
+    } while (pqueue_find_equal_same_priority(_lf_enclave->event_q, e) != NULL);
+}
+
 /**
  * Initialize the given timer.
  * If this timer has a zero offset, enqueue the reactions it triggers.
  * If this timer is to trigger reactions at a _future_ tag as well,
  * schedule it accordingly.
+ * A timer of an enclave other than the one that the calling thread
+ * is bound to is left for that enclave to initialize.
  */
 void _lf_initialize_timer(trigger_t* timer) {
     interval_t delay = 0;
+    if (lf_enclave_of_trigger(timer) != _lf_enclave) {
+        return;
+    }
 
 #ifdef MODAL_REACTORS
     // Suspend all timer events that start in inactive mode
@@ -782,7 +1059,7 @@ void _lf_initialize_timer(trigger_t* timer) {
         // && (timer->offset != 0 || timer->period != 0)) {
         event_t* e = _lf_get_new_event();
         e->trigger = timer;
-        e->time = lf_time_logical() + timer->offset;
+        e->tag = (tag_t) {.time = lf_time_logical() + timer->offset, .microstep = 0u};
         _lf_add_suspended_event(e);
         return;
     }
@@ -807,56 +1084,44 @@ void _lf_initialize_timer(trigger_t* timer) {
     // Recycle event_t structs, if possible.
     event_t* e = _lf_get_new_event();
     e->trigger = timer;
-    e->time = lf_time_logical() + delay;
+    e->tag = (tag_t) {.time = lf_time_logical() + delay, .microstep = 0u};
     // NOTE: No lock is being held. Assuming this only happens at startup.
-    pqueue_insert(event_q, e);
+    _lf_insert_event(e);
     tracepoint_schedule(timer, delay); // Trace even though schedule is not called.
 }
 
 /**
  * Recycle the given event.
  * Zero it out and pushed it onto the recycle queue.
+ * In static-memory mode, give it back to the event pool instead.
  */
 void _lf_recycle_event(event_t* e) {
-    e->time = 0LL;
+#ifdef LF_STATIC_MEMORY
+    _lf_free_event(e);
+#else
+    e->tag = (tag_t) {.time = 0LL, .microstep = 0u};
     e->trigger = NULL;
     e->pos = 0;
     e->token = NULL;
-    e->is_dummy = false;
 #ifdef FEDERATED_DECENTRALIZED
     e->intended_tag = (tag_t) { .time = NEVER, .microstep = 0u};
 #endif
-    e->next = NULL;
-    pqueue_insert(recycle_q, e);
-}
-
-/**
- * Create dummy events to be used as spacers in the event queue.
- * @param trigger The eventual event to be triggered.
- * @param time The logical time of that event.
- * @param next The event to place after the dummy events.
- * @param offset The number of dummy events to insert.
- * @return A pointer to the first dummy event.
- */
-event_t* _lf_create_dummy_events(trigger_t* trigger, instant_t time, event_t* next, microstep_t offset) {
-    event_t* first_dummy = _lf_get_new_event();
-    event_t* dummy = first_dummy;
-    dummy->time = time;
-    dummy->is_dummy = true;
-    dummy->trigger = trigger;
-    while (offset > 0) {
-        if (offset == 1) {
-            dummy->next = next;
-            break;
-        }
-        dummy->next = _lf_get_new_event();
-        dummy = dummy->next;
-        dummy->time = time;
-        dummy->is_dummy = true;
-        dummy->trigger = trigger;
-        offset--;
-    }
-    return first_dummy;
+    pqueue_insert(_lf_enclave->recycle_q, e);
+#endif
+}
+
+/**
+ * Create a dummy event to be used as a placeholder in the event queue.
+ * A dummy event has no trigger. Its only purpose is to force the runtime
+ * to advance to its tag. Since the event queue is sorted by tag, a
+ * single dummy event suffices for any microstep.
+ * @param tag The tag of the dummy event.
+ * @return A pointer to the dummy event.
+ */
+event_t* _lf_create_dummy_event(tag_t tag) {
+    event_t* dummy = _lf_get_new_event();
+    dummy->tag = tag;
+    return dummy;
 }
 
 /**
@@ -879,17 +1144,14 @@ static void _lf_replace_token(event_t* event, lf_token_t* token) {
  * that the tag is in the future relative to the current tag.
  * The input time values are absolute.
  *
- * If there is an event found at the requested tag, the payload
- * is replaced and 0 is returned.
+ * If there is an event found at the requested tag, then, depending on the
+ * policy of the trigger, the new event is dropped, the payload of the
+ * existing event is replaced, or the new event is deferred to the first
+ * later microstep at which there is no event for the trigger. In the first
+ * two cases, 0 is returned.
  *
- * Note that this function is an internal API that must
- * be called with tags that are in order for a given
- * trigger. This means that the following order is illegal:
- * _lf_schedule_at_tag(trigger1, bigger_tag, ...);
- * _lf_schedule_at_tag(trigger1, smaller_tag, ...);
- * where bigger_tag > smaller_tag. This function is primarily
- * used for network communication (which is assumed to be
- * in order).
+ * This function is primarily used for network communication and for
+ * resuming events suspended by modal reactors.
  *
  * This function assumes the caller holds the mutex lock.
  *
@@ -905,8 +1167,8 @@ int _lf_schedule_at_tag(trigger_t* trigger, tag_t tag, lf_token_t* token) {
     tag_t current_logical_tag = lf_tag();
 
     LF_PRINT_DEBUG("_lf_schedule_at_tag() called with tag " PRINTF_TAG " at tag " PRINTF_TAG ".",
-                  tag.time - start_time, tag.microstep,
-                  current_logical_tag.time - start_time, current_logical_tag.microstep);
+                  tag.time - _lf_instance->start_time, tag.microstep,
+                  current_logical_tag.time - _lf_instance->start_time, current_logical_tag.microstep);
     if (lf_tag_compare(tag, current_logical_tag) <= 0) {
         lf_print_warning("_lf_schedule_at_tag(): requested to schedule an event in the past.");
         return -1;
@@ -925,8 +1187,8 @@ int _lf_schedule_at_tag(trigger_t* trigger, tag_t tag, lf_token_t* token) {
     }
 
     event_t* e = _lf_get_new_event();
-    // Set the event time
-    e->time = tag.time;
+    // Set the event tag
+    e->tag = tag;
 
     tracepoint_schedule(trigger, tag.time - current_logical_tag.time);
 
@@ -942,135 +1204,50 @@ int _lf_schedule_at_tag(trigger_t* trigger, tag_t tag, lf_token_t* token) {
     e->intended_tag = trigger->intended_tag;
 #endif
 
-    event_t* found = (event_t *)pqueue_find_equal_same_priority(event_q, e);
+    event_t* found = (event_t *)pqueue_find_equal_same_priority(_lf_enclave->event_q, e);
     if (found != NULL) {
-        if (tag.microstep == 0u) {
-                // The microstep is 0, which means that the event is being scheduled
-                // at a future time and at the beginning of the skip list of events
-                // at that time.
-                // In case the event is a dummy event
-                // convert it to a real event.
-                found->is_dummy = false;
-                switch (trigger->policy) {
-                    case drop:
-                        if (found->token != token) {
-                            _lf_done_using(token);
-                        }
-                        _lf_recycle_event(e);
-                        return(0);
-                        break;
-                    case replace:
-                        // Replace the payload of the event at the head with our
-                        // current payload.
-                        _lf_replace_token(found, token);
-                        _lf_recycle_event(e);
-                        return 0;
-                        break;
-                    default:
-                        // Adding a microstep to the original
-                        // intended tag.
-                        if (_lf_is_tag_after_stop_tag((tag_t) {.time=found->time,.microstep=1})) {
-                            // Scheduling e will incur a microstep after the stop tag,
-                            // which is illegal.
-                            _lf_recycle_event(e);
-                            return 0;
-                        }
-                        if (found->next != NULL) {
-                            lf_print_error("_lf_schedule_at_tag: in-order contract violated.");
-                            return -1;
-                        }
-                        found->next = e;
+        switch (trigger->policy) {
+            case drop:
+                if (found->token != token) {
+                    _lf_done_using(token);
                 }
-        } else {
-            // We are requesting a microstep greater than 0
-            // where there is already an event for this trigger on the event queue.
-            // That event may itself be a dummy event for a real event that is
-            // also at a microstep greater than 0.
-            // We have to insert our event into the chain or append it
-            // to the end of the chain, depending on which microstep is lesser.
-            microstep_t microstep_of_found = 0;
-            if (tag.time == current_logical_tag.time) {
-                // This is a situation where the head of the queue
-                // is an event with microstep == current_microstep + 1
-                // which should be reflected in our steps calculation.
-                microstep_of_found += current_logical_tag.microstep + 1; // Indicating that
-                                                            // the found event
-                                                            // is at this microstep.
-            }
-            // Follow the chain of events until the right point
-            // to insert the new event.
-            while (microstep_of_found < tag.microstep - 1) {
-                if (found->next == NULL) {
-                    // The chain stops short of where we want to be.
-                    // If it exactly one microstep short of where we want to be,
-                    // then we don't need a dummy. Otherwise, we do.
-                    microstep_t undershot_by = (tag.microstep - 1) - microstep_of_found;
-                    if (undershot_by > 0) {
-                        found->next = _lf_create_dummy_events(trigger, tag.time, e, undershot_by);
-                    } else {
-                        found->next = e;
-                    }
-                    return 1;
-                }
-                found = found->next;
-                microstep_of_found++;
-            }
-            // At this point, microstep_of_found == tag.microstep - 1.
-            if (found->next == NULL) {
-                found->next = e;
-            } else {
-                switch (trigger->policy) {
-                    case drop:
-                        if (found->next->token != token) {
-                            _lf_done_using(token);
-                        }
-                        _lf_recycle_event(e);
-                        return 0;
-                        break;
-                    case replace:
-                        // Replace the payload of the event at the head with our
-                        // current payload.
-                        _lf_replace_token(found->next, token);
-                        _lf_recycle_event(e);
-                        return 0;
-                        break;
-                    default:
-                        // Adding a microstep to the original
-                        // intended tag.
-                        if (_lf_is_tag_after_stop_tag((tag_t){.time=found->time,.microstep=microstep_of_found+1})) {
-                            // Scheduling e will incur a microstep at timeout,
-                            // which is illegal.
-                            _lf_recycle_event(e);
-                            return 0;
-                        }
-                        if (found->next->next != NULL) {
-                            lf_print_error("_lf_schedule_at_tag: in-order contract violated.");
-                            return -1;
-                        }
-                        found->next->next = e;
+                _lf_recycle_event(e);
+                return 0;
+            case replace:
+                // Replace the payload of the event at the requested tag with our
+                // current payload.
+                _lf_replace_token(found, token);
+                _lf_recycle_event(e);
+                return 0;
+            default:
+                // Let events pile up in superdense time.
+                _lf_defer_to_free_microstep(e);
+                if (_lf_is_tag_after_stop_tag(e->tag)) {
+                    // Scheduling e will incur a microstep after the stop tag,
+                    // which is illegal.
+                    _lf_done_using(token);
+                    _lf_recycle_event(e);
+                    return 0;
                 }
-            }
-        }
-    } else {
-        // No existing event queued.
-        microstep_t relative_microstep = tag.microstep;
-        if (tag.time == current_logical_tag.time) {
-            relative_microstep -= current_logical_tag.microstep;
-        }
-        if (((tag.time == current_logical_tag.time) && (relative_microstep == 1)) ||
-                tag.microstep == 0) {
-            // Do not need a dummy event if we are scheduling at 1 microstep
-            // in the future at current time or at microstep 0 in a future time.
-            pqueue_insert(event_q, e);
-        } else {
-            // Create a dummy event. Insert it into the queue, and let its next
-            // pointer point to the actual event.
-            pqueue_insert(event_q, _lf_create_dummy_events(trigger, tag.time, e, relative_microstep));
         }
     }
+    _lf_insert_event(e);
     return 1;
 }
 
+/**
+ * Return the tag at which an event with the specified time should be
+ * scheduled. If the time matches the current time, this is the next
+ * microstep after the current tag. Otherwise, it is microstep 0.
+ * @param time A time that is not earlier than the current time.
+ */
+static tag_t _lf_tag_for_time(instant_t time) {
+    if (time == _lf_enclave->current_tag.time) {
+        return (tag_t) {.time = time, .microstep = _lf_enclave->current_tag.microstep + 1};
+    }
+    return (tag_t) {.time = time, .microstep = 0u};
+}
+
 /**
  * Schedule the specified trigger at current_tag.time plus the offset of the
  * specified trigger plus the delay. See schedule_token() in reactor.h for details.
@@ -1104,7 +1281,7 @@ int _lf_schedule_at_tag(trigger_t* trigger, tag_t tag, lf_token_t* token) {
  * @return A handle to the event, or 0 if no new event was scheduled, or -1 for error.
  */
 trigger_handle_t _lf_schedule(trigger_t* trigger, interval_t extra_delay, lf_token_t* token) {
-    if (_lf_is_tag_after_stop_tag(current_tag)) {
+    if (_lf_is_tag_after_stop_tag(_lf_enclave->current_tag)) {
         // If schedule is called after stop_tag
         // This is a critical condition.
         _lf_done_using(token);
@@ -1142,16 +1319,13 @@ trigger_handle_t _lf_schedule(trigger_t* trigger, interval_t extra_delay, lf_tok
     if (!trigger->is_timer) {
         delay += trigger->offset;
     }
-    interval_t intended_time = current_tag.time + delay;
+    interval_t intended_time = _lf_enclave->current_tag.time + delay;
     LF_PRINT_DEBUG("_lf_schedule: current_tag.time = " PRINTF_TIME ". Total logical delay = " PRINTF_TIME "",
-            current_tag.time, delay);
+            _lf_enclave->current_tag.time, delay);
     interval_t min_spacing = trigger->period;
 
     event_t* e = _lf_get_new_event();
 
-    // Initialize the next pointer.
-    e->next = NULL;
-
     // Set the payload.
     e->token = token;
 
@@ -1174,11 +1348,11 @@ trigger_handle_t _lf_schedule(trigger_t* trigger, interval_t extra_delay, lf_tok
         // FIXME: This can go away once:
         // - we have eliminated the possibility to have a negative additional delay; and
         // - we detect the asynchronous use of logical actions
-        if (intended_time < current_tag.time) {
+        if (intended_time < _lf_enclave->current_tag.time) {
             lf_print_warning("Attempting to schedule an event earlier than current time by " PRINTF_TIME " nsec! "
                     "Revising to the current time " PRINTF_TIME ".",
-                    current_tag.time - intended_time, current_tag.time);
-            intended_time = current_tag.time;
+                    _lf_enclave->current_tag.time - intended_time, _lf_enclave->current_tag.time);
+            intended_time = _lf_enclave->current_tag.time;
         }
     }
 
@@ -1192,36 +1366,31 @@ trigger_handle_t _lf_schedule(trigger_t* trigger, interval_t extra_delay, lf_tok
     // Check for conflicts (a queued event with the same trigger and time).
     if (trigger->period < 0) {
         // No minimum spacing defined.
-        tag_t intended_tag = (tag_t) {.time = intended_time, .microstep = 0u};
-        e->time = intended_tag.time;
-        event_t* found = (event_t *)pqueue_find_equal_same_priority(event_q, e);
+        e->tag = _lf_tag_for_time(intended_time);
+        event_t* found = (event_t *)pqueue_find_equal_same_priority(_lf_enclave->event_q, e);
         // Check for conflicts. Let events pile up in super dense time.
         if (found != NULL) {
-            intended_tag.microstep++;
-            // Skip to the last node in the linked list.
-            while(found->next != NULL) {
-                found = found->next;
-                intended_tag.microstep++;
-            }
-            if (_lf_is_tag_after_stop_tag(intended_tag)) {
+            _lf_defer_to_free_microstep(e);
+            if (_lf_is_tag_after_stop_tag(e->tag)) {
                 LF_PRINT_DEBUG("Attempt to schedule an event after stop_tag was rejected.");
                 // Scheduling an event will incur a microstep
                 // after the stop tag.
+                _lf_done_using(token);
                 _lf_recycle_event(e);
                 return 0;
             }
-            // Hook the event into the list.
-            found->next = e;
+            _lf_insert_event(e);
+            tracepoint_schedule(trigger, e->tag.time - _lf_enclave->current_tag.time);
             return(0); // FIXME: return value
         }
         // If there are not conflicts, schedule as usual. If intended time is
-        // equal to the current logical time, the event will effectively be
+        // equal to the current logical time, the event will be
         // scheduled at the next microstep.
     } else if (!trigger->is_timer && existing != NULL) {
         // There exists a previously scheduled event. It determines the
         // earliest time at which the new event can be scheduled.
         // Check to see whether the event is too early.
-        instant_t earliest_time = existing->time + min_spacing;
+        instant_t earliest_time = existing->tag.time + min_spacing;
         LF_PRINT_DEBUG("There is a previously scheduled event; earliest possible time "
                 "with min spacing: " PRINTF_TIME,
                 earliest_time);
@@ -1232,7 +1401,7 @@ trigger_handle_t _lf_schedule(trigger_t* trigger, interval_t extra_delay, lf_tok
                 case drop:
                     LF_PRINT_DEBUG("Policy is drop. Dropping the event.");
                     if (min_spacing > 0 ||
-                            pqueue_find_equal_same_priority(event_q, existing) != NULL) {
+                            pqueue_find_equal_same_priority(_lf_enclave->event_q, existing) != NULL) {
                         // Recycle the new event and the token.
                         if (existing->token != token) {
                             _lf_done_using(token);
@@ -1246,14 +1415,9 @@ trigger_handle_t _lf_schedule(trigger_t* trigger, interval_t extra_delay, lf_tok
                     // it. WARNING: If provide a mechanism for unscheduling, we
                     // can no longer rely on the tag of the existing event to
                     // determine whether or not it has been recycled (the
-                    // existing->time < current_tag.time case below).
-                    // NOTE: Because microsteps are not explicit, if the tag of
-                    // the preceding event is equal to the current time, then
-                    // we search the event queue to figure out whether it has
-                    // been handled yet.
-                    if (existing->time > current_tag.time ||
-                            (existing->time == current_tag.time &&
-                            pqueue_find_equal_same_priority(event_q, existing) != NULL)) {
+                    // existing tag < current_tag case below).
+                    if (lf_tag_compare(existing->tag, _lf_enclave->current_tag) > 0
+                            && pqueue_find_equal_same_priority(_lf_enclave->event_q, existing) != NULL) {
                         // Recycle the existing token and the new event
                         // and update the token of the existing event.
                         _lf_replace_token(existing, token);
@@ -1265,17 +1429,22 @@ trigger_handle_t _lf_schedule(trigger_t* trigger, interval_t extra_delay, lf_tok
                     intended_time = earliest_time;
                     break;
                 default:
-                    if (existing->time == current_tag.time &&
-                            pqueue_find_equal_same_priority(event_q, existing) != NULL) {
-                        if (_lf_is_tag_after_stop_tag((tag_t){.time=existing->time,.microstep=lf_tag().microstep+1})) {
+                    if (existing->tag.time == _lf_enclave->current_tag.time &&
+                            pqueue_find_equal_same_priority(_lf_enclave->event_q, existing) != NULL) {
+                        // If the last event hasn't been handled yet, insert
+                        // the new event right behind.
+                        e->tag = existing->tag;
+                        e->tag.microstep++;
+                        if (_lf_is_tag_after_stop_tag(e->tag)) {
                             // Scheduling e will incur a microstep at timeout,
                             // which is illegal.
+                            _lf_done_using(token);
                             _lf_recycle_event(e);
                             return 0;
                         }
-                        // If the last event hasn't been handled yet, insert
-                        // the new event right behind.
-                        existing->next = e;
+                        trigger->last = e;
+                        _lf_insert_event(e);
+                        tracepoint_schedule(trigger, e->tag.time - _lf_enclave->current_tag.time);
                         return 0; // FIXME: return a value
                     } else {
                          // Adjust the tag.
@@ -1290,21 +1459,21 @@ trigger_handle_t _lf_schedule(trigger_t* trigger, interval_t extra_delay, lf_tok
     // This is a sanity check for the logic above
     // FIXME: This is a development assertion and might
     // not be necessary for end-user LF programs
-    if (intended_time < current_tag.time) {
+    if (intended_time < _lf_enclave->current_tag.time) {
         lf_print_error("Attempting to schedule an event earlier than current time by " PRINTF_TIME " nsec! "
                 "Revising to the current time " PRINTF_TIME ".",
-                current_tag.time - intended_time, current_tag.time);
-        intended_time = current_tag.time;
+                _lf_enclave->current_tag.time - intended_time, _lf_enclave->current_tag.time);
+        intended_time = _lf_enclave->current_tag.time;
     }
 
     // Set the tag of the event.
-    e->time = intended_time;
+    e->tag = _lf_tag_for_time(intended_time);
 
-    // Do not schedule events if if the event time is past the stop time
-    // (current microsteps are checked earlier).
-    LF_PRINT_DEBUG("Comparing event with elapsed time " PRINTF_TIME " against stop time " PRINTF_TIME ".", e->time - start_time, stop_tag.time - start_time);
-    if (e->time > stop_tag.time) {
-        LF_PRINT_DEBUG("_lf_schedule: event time is past the timeout. Discarding event.");
+    // Do not schedule events if the event tag is past the stop tag.
+    LF_PRINT_DEBUG("Comparing event with elapsed tag " PRINTF_TAG " against stop tag " PRINTF_TAG ".",
+            e->tag.time - _lf_instance->start_time, e->tag.microstep, _lf_enclave->stop_tag.time - _lf_instance->start_time, _lf_enclave->stop_tag.microstep);
+    if (_lf_is_tag_after_stop_tag(e->tag)) {
+        LF_PRINT_DEBUG("_lf_schedule: event tag is past the stop tag. Discarding event.");
         _lf_done_using(token);
         _lf_recycle_event(e);
         return(0);
@@ -1316,25 +1485,19 @@ trigger_handle_t _lf_schedule(trigger_t* trigger, interval_t extra_delay, lf_tok
     trigger->last = (event_t*)e;
 
     // Queue the event.
-    // NOTE: There is no need for an explicit microstep because
-    // when this is called, all events at the current tag
-    // (time and microstep) have been pulled from the queue,
-    // and any new events added at this tag will go into the reaction_q
-    // rather than the event_q, so anything put in the event_q with this
-    // same time will automatically be executed at the next microstep.
-    LF_PRINT_LOG("Inserting event in the event queue with elapsed time " PRINTF_TIME ".",
-            e->time - start_time);
-    pqueue_insert(event_q, e);
-
-    tracepoint_schedule(trigger, e->time - current_tag.time);
+    LF_PRINT_LOG("Inserting event in the event queue with elapsed tag " PRINTF_TAG ".",
+            e->tag.time - _lf_instance->start_time, e->tag.microstep);
+    _lf_insert_event(e);
+
+    tracepoint_schedule(trigger, e->tag.time - _lf_enclave->current_tag.time);
 
     // FIXME: make a record of handle and implement unschedule.
     // NOTE: Rather than wrapping around to get a negative number,
     // we reset the handle on the assumption that much earlier
     // handles are irrelevant.
-    int return_value = _lf_handle++;
-    if (_lf_handle < 0) {
-        _lf_handle = 1;
+    int return_value = _lf_enclave->handle++;
+    if (_lf_enclave->handle < 0) {
+        _lf_enclave->handle = 1;
     }
     return return_value;
 }
@@ -1459,13 +1622,13 @@ trigger_t* _lf_action_to_trigger(void* action) {
 }
 
 /**
- * Advance from the current tag to the next. If the given next_time is equal to
- * the current time, then increase the microstep. Otherwise, update the current
- * time and set the microstep to zero.
+ * Advance from the current tag to the specified next tag, which is
+ * required to be later than the current tag and no later than the
+ * tag of the event at the head of the event queue.
  *
- * @param next_time The time step to advance to.
+ * @param next_tag The tag to advance to.
  */
-void _lf_advance_logical_time(instant_t next_time) {
+void _lf_advance_logical_time(tag_t next_tag) {
     // FIXME: The following checks that _lf_advance_logical_time()
     // is being called correctly. Namely, check if logical time
     // is being pushed past the head of the event queue. This should
@@ -1474,24 +1637,22 @@ void _lf_advance_logical_time(instant_t next_time) {
     // to the ordinary execution of LF programs. Instead, there might
     // be a need for a target property that enables these kinds of logic
     // assertions for development purposes only.
-    event_t* next_event = (event_t*)pqueue_peek(event_q);
+    event_t* next_event = (event_t*)pqueue_peek(_lf_enclave->event_q);
     if (next_event != NULL) {
-        if (next_time > next_event->time) {
-            lf_print_error_and_exit("_lf_advance_logical_time(): Attempted to move time to " PRINTF_TIME ", which is "
-                    "past the head of the event queue, " PRINTF_TIME ".",
-                    next_time - start_time, next_event->time - start_time);
+        if (lf_tag_compare(next_tag, next_event->tag) > 0) {
+            lf_print_error_and_exit("_lf_advance_logical_time(): Attempted to move tag to " PRINTF_TAG ", which is "
+                    "past the head of the event queue, " PRINTF_TAG ".",
+                    next_tag.time - _lf_instance->start_time, next_tag.microstep,
+                    next_event->tag.time - _lf_instance->start_time, next_event->tag.microstep);
         }
     }
 
-    if (current_tag.time < next_time) {
-        current_tag.time = next_time;
-        current_tag.microstep = 0;
-    } else if (current_tag.time == next_time) {
-        current_tag.microstep++;
+    if (lf_tag_compare(_lf_enclave->current_tag, next_tag) < 0) {
+        _lf_enclave->current_tag = next_tag;
     } else {
         lf_print_error_and_exit("_lf_advance_logical_time(): Attempted to move tag back in time.");
     }
-    LF_PRINT_LOG("Advanced (elapsed) tag to " PRINTF_TAG, next_time - start_time, current_tag.microstep);
+    LF_PRINT_LOG("Advanced (elapsed) tag to " PRINTF_TAG, next_tag.time - _lf_instance->start_time, _lf_enclave->current_tag.microstep);
 }
 
 /**
@@ -1502,15 +1663,14 @@ void _lf_advance_logical_time(instant_t next_time) {
 trigger_handle_t _lf_schedule_int(void* action, interval_t extra_delay, int value) {
     trigger_t* trigger = _lf_action_to_trigger(action);
     // NOTE: This doesn't acquire the mutex lock in the multithreaded version
-    // until schedule_value is called. This should be OK because the element_size
+    // until schedule_copy is called. This should be OK because the element_size
     // does not change dynamically.
     if (trigger->element_size != sizeof(int)) {
         lf_print_error("Action type is not an integer.");
         return -1;
     }
-    int* container = (int*)malloc(sizeof(int));
-    *container = value;
-    return _lf_schedule_value(action, extra_delay, container, 1);
+    // A copy of the integer is stored in the token itself.
+    return _lf_schedule_copy(action, extra_delay, &value, 1);
 }
 
 /**
@@ -1549,7 +1709,7 @@ lf_token_t* _lf_set_new_array_impl(lf_token_t* token, size_t length, int num_des
  */
 bool _lf_check_deadline(self_base_t* self, bool invoke_deadline_handler) {
     reaction_t* reaction = self->executing_reaction;
-    if (lf_time_physical() > lf_time_logical() + reaction->deadline) {
+    if (lf_time_physical_fast() > lf_time_logical() + reaction->deadline) {
         if (invoke_deadline_handler) {
             reaction->deadline_violation_handler(self);
         }
@@ -1572,6 +1732,186 @@ void _lf_invoke_reaction(reaction_t* reaction, int worker) {
     tracepoint_reaction_ends(reaction, worker);
 }
 
+/**
+ * See reactor.h for documentation.
+ */
+void* lf_reaction_suspend(void* self, lf_continuation_t continuation, void* arg) {
+    reaction_t* reaction = ((self_base_t*) self)->executing_reaction;
+    if (reaction == NULL || reaction->suspension.state != reaction_not_suspended) {
+        lf_print_error_and_exit("lf_reaction_suspend() can only be called once by a reaction or a continuation.");
+    }
+    reaction->suspension.continuation = continuation;
+    reaction->suspension.arg = arg;
+    reaction->suspension.enclave = _lf_enclave;
+    reaction->suspension.state = reaction_suspending;
+    LF_PRINT_DEBUG("Reaction %s is suspending.", reaction->name);
+    return reaction;
+}
+
+/**
+ * Invoke the continuation of the given reaction, which has been resumed.
+ *
+ * @param reaction The reaction.
+ * @param worker The thread number of the worker thread or 0 for unthreaded execution (for tracing).
+ */
+void _lf_invoke_continuation(reaction_t* reaction, int worker) {
+    LF_PRINT_DEBUG("Continuing reaction %s.", reaction->name);
+    reaction->suspension.state = reaction_not_suspended;
+    tracepoint_reaction_starts(reaction, worker);
+    ((self_base_t*) reaction->self)->executing_reaction = reaction;
+    reaction->suspension.continuation(reaction->self, reaction->suspension.arg);
+    ((self_base_t*) reaction->self)->executing_reaction = NULL;
+    tracepoint_reaction_ends(reaction, worker);
+}
+
+/**
+ * The flattened outputs of a reaction, which follow this header in the same
+ * allocation, on the list of its enclave.
+ */
+typedef struct lf_flattened_outputs_t {
+    struct lf_flattened_outputs_t* next;
+    reaction_t* reaction;
+} lf_flattened_outputs_t;
+
+/**
+ * Flatten the relation from the outputs of the specified reaction to the
+ * reactions that they trigger, which is spread over the triggers of each
+ * output, into a compressed sparse row: one contiguous array of downstream
+ * reactions, output by output, and the offset of the reactions of each output
+ * in it. The reactions of each output are listed once, in order of level, so
+ * that they are enabled in the order in which the reaction queue releases them.
+ * This allocates, so it is called once per reaction: at startup, by
+ * _lf_initialize_output_reactions(), for the reactions in the reaction table
+ * of an enclave, and otherwise the first time that the reaction executes.
+ * @param reaction The reaction.
+ * @return The allocation, which the caller puts on the list of its enclave.
+ */
+static lf_flattened_outputs_t* _lf_flatten_output_reactions(reaction_t* reaction) {
+    size_t total = 0;
+    for (size_t i = 0; i < reaction->num_outputs; i++) {
+        for (int j = 0; j < reaction->triggered_sizes[i]; j++) {
+            trigger_t* trigger = reaction->triggers[i][j];
+            if (trigger != NULL) {
+                total += trigger->number_of_reactions;
+            }
+        }
+    }
+    lf_flattened_outputs_t* flattened = (lf_flattened_outputs_t*)malloc(sizeof(lf_flattened_outputs_t)
+            + (reaction->num_outputs + 1) * sizeof(size_t) + total * sizeof(reaction_t*));
+    if (flattened == NULL) lf_print_error_and_exit("Out of memory!");
+    flattened->reaction = reaction;
+    size_t* offsets = (size_t*)(flattened + 1);
+    reaction_t** downstream = (reaction_t**)(offsets + reaction->num_outputs + 1);
+    size_t size = 0;
+    for (size_t i = 0; i < reaction->num_outputs; i++) {
+        offsets[i] = size;
+        for (int j = 0; j < reaction->triggered_sizes[i]; j++) {
+            trigger_t* trigger = reaction->triggers[i][j];
+            for (int k = 0; trigger != NULL && k < trigger->number_of_reactions; k++) {
+                reaction_t* downstream_reaction = trigger->reactions[k];
+                size_t position = offsets[i];
+                while (position < size && downstream[position] != downstream_reaction) {
+                    position++;
+                }
+                if (downstream_reaction == NULL || position < size) {
+                    continue;
+                }
+                // Insert the reaction in order of level, after those of the same level.
+                while (position > offsets[i]
+                        && LF_LEVEL(downstream[position - 1]->index) > LF_LEVEL(downstream_reaction->index)) {
+                    downstream[position] = downstream[position - 1];
+                    position--;
+                }
+                downstream[position] = downstream_reaction;
+                size++;
+            }
+        }
+    }
+    offsets[reaction->num_outputs] = size;
+    reaction->downstream_reactions = downstream;
+    reaction->downstream_offsets = offsets;
+    return flattened;
+}
+
+void _lf_initialize_output_reactions(void) {
+    for (lf_enclave_t* enclave = &_lf_main_enclave; enclave != NULL; enclave = enclave->next) {
+        for (int i = 0; i < enclave->reactions_size; i++) {
+            reaction_t* reaction = enclave->reactions[i];
+            if (reaction->num_outputs > 0 && reaction->downstream_offsets == NULL) {
+                lf_flattened_outputs_t* flattened = _lf_flatten_output_reactions(reaction);
+                flattened->next = enclave->flattened_outputs;
+                enclave->flattened_outputs = flattened;
+            }
+        }
+    }
+}
+
+void _lf_free_output_reactions(void) {
+    for (lf_enclave_t* enclave = &_lf_main_enclave; enclave != NULL; enclave = enclave->next) {
+        while (enclave->flattened_outputs != NULL) {
+            lf_flattened_outputs_t* flattened = enclave->flattened_outputs;
+            enclave->flattened_outputs = flattened->next;
+            flattened->reaction->downstream_offsets = NULL;
+            flattened->reaction->downstream_reactions = NULL;
+            free(flattened);
+        }
+    }
+}
+
+/**
+ * Enable a reaction that is triggered by an output of the specified reaction.
+ * If it is the first one enabled and the specified reaction is its last
+ * enabling reaction, make it the candidate to execute immediately.
+ * Otherwise, put it and any previous candidate on the reaction queue.
+ * @param reaction The reaction that has just executed.
+ * @param downstream_reaction The reaction triggered by one of its outputs.
+ * @param downstream_to_execute_now The candidate to execute immediately, or NULL.
+ * @param num_downstream_reactions The number of reactions enabled so far.
+ * @param worker The thread number of the worker thread or 0 for unthreaded execution (for tracing).
+ */
+static inline void _lf_enable_downstream_reaction(
+        reaction_t* reaction,
+        reaction_t* downstream_reaction,
+        reaction_t** downstream_to_execute_now,
+        int* num_downstream_reactions,
+        int worker
+) {
+#ifdef FEDERATED_DECENTRALIZED // Only pass down tardiness for federated LF programs
+    // Set the is_STP_violated for the downstream reaction
+    downstream_reaction->is_STP_violated = reaction->is_STP_violated;
+    LF_PRINT_DEBUG("Passing is_STP_violated of %d to the downstream reaction: %s",
+            downstream_reaction->is_STP_violated, downstream_reaction->name);
+#endif
+    if (downstream_reaction != *downstream_to_execute_now) {
+        (*num_downstream_reactions)++;
+        // If there is exactly one downstream reaction that is enabled by this
+        // reaction, then we can execute that reaction immediately without
+        // going through the reaction queue. In multithreaded execution, this
+        // avoids acquiring a mutex lock.
+        // FIXME: Check the earliest deadline on the reaction queue.
+        // This optimization could violate EDF scheduling otherwise.
+        if (*num_downstream_reactions == 1 && downstream_reaction->last_enabling_reaction == reaction) {
+            // So far, this downstream reaction is a candidate to execute now.
+            *downstream_to_execute_now = downstream_reaction;
+        } else {
+            // If there is a previous candidate reaction to execute now,
+            // it is no longer a candidate.
+            if (*downstream_to_execute_now != NULL) {
+                // More than one downstream reaction is enabled.
+                // In this case, if we were to execute the downstream reaction
+                // immediately without changing any queues, then the second
+                // downstream reaction would be blocked because this reaction
+                // remains on the executing queue. Hence, the optimization
+                // is not valid. Put the candidate reaction on the queue.
+                _lf_trigger_reaction(*downstream_to_execute_now, worker);
+                *downstream_to_execute_now = NULL;
+            }
+            // Queue the reaction.
+            _lf_trigger_reaction(downstream_reaction, worker);
+        }
+    }
+}
+
 /**
  * For the specified reaction, if it has produced outputs, insert the
  * resulting triggered reactions into the reaction queue.
@@ -1596,59 +1936,49 @@ void schedule_output_reactions(reaction_t* reaction, int worker) {
     reaction_t* downstream_to_execute_now = NULL;
     int num_downstream_reactions = 0;
 #ifdef FEDERATED_DECENTRALIZED // Only pass down STP violation for federated programs that use decentralized coordination.
-    // Extract the inherited STP violation
-    bool inherited_STP_violation = reaction->is_STP_violated;
     LF_PRINT_LOG("Reaction %s has STP violation status: %d.", reaction->name, reaction->is_STP_violated);
 #endif
     LF_PRINT_DEBUG("There are %zu outputs from reaction %s.", reaction->num_outputs, reaction->name);
+#ifndef LF_STATIC_MEMORY
+    if (reaction->downstream_offsets == NULL && reaction->num_outputs > 0) {
+        // Generated code does not list the reactions in the reaction table,
+        // so flatten the outputs of this one the first time that it executes.
+        // A reaction executes on one worker at a time, and only other
+        // reactions of its enclave put theirs on the list concurrently.
+        lf_flattened_outputs_t* flattened = _lf_flatten_output_reactions(reaction);
+#ifdef NUMBER_OF_WORKERS
+        lf_mutex_lock(&_lf_enclave->mutex);
+#endif
+        flattened->next = _lf_enclave->flattened_outputs;
+        _lf_enclave->flattened_outputs = flattened;
+#ifdef NUMBER_OF_WORKERS
+        lf_mutex_unlock(&_lf_enclave->mutex);
+#endif
+    }
+#endif
+    size_t* offsets = reaction->downstream_offsets;
     for (size_t i=0; i < reaction->num_outputs; i++) {
-        if (reaction->output_produced[i] != NULL && *(reaction->output_produced[i])) {
+        if (reaction->output_produced[i] == NULL || !*(reaction->output_produced[i])) {
+            continue;
+        }
+        if (offsets != NULL) {
+            LF_PRINT_DEBUG("Output %zu has been produced. It triggers %zu reactions.",
+                    i, offsets[i + 1] - offsets[i]);
+            for (size_t k = offsets[i]; k < offsets[i + 1]; k++) {
+                _lf_enable_downstream_reaction(reaction, reaction->downstream_reactions[k],
+                        &downstream_to_execute_now, &num_downstream_reactions, worker);
+            }
+        } else {
+            // In static-memory mode, the outputs of a reaction that is not in
+            // the reaction table of its enclave are not flattened, because the
+            // heap may not be used after startup. Follow the triggers.
             LF_PRINT_DEBUG("Output %zu has been produced.", i);
-            trigger_t** triggerArray = (reaction->triggers)[i];
-            LF_PRINT_DEBUG("There are %d trigger arrays associated with output %zu.",
-                    reaction->triggered_sizes[i], i);
-            for (int j=0; j < reaction->triggered_sizes[i]; j++) {
-                trigger_t* trigger = triggerArray[j];
-                if (trigger != NULL) {
-                    LF_PRINT_DEBUG("Trigger %p lists %d reactions.", trigger, trigger->number_of_reactions);
-                    for (int k=0; k < trigger->number_of_reactions; k++) {
-                        reaction_t* downstream_reaction = trigger->reactions[k];
-#ifdef FEDERATED_DECENTRALIZED // Only pass down tardiness for federated LF programs
-                        // Set the is_STP_violated for the downstream reaction
-                        if (downstream_reaction != NULL) {
-                            downstream_reaction->is_STP_violated = inherited_STP_violation;
-                            LF_PRINT_DEBUG("Passing is_STP_violated of %d to the downstream reaction: %s",
-                                    downstream_reaction->is_STP_violated, downstream_reaction->name);
-                        }
-#endif
-                        if (downstream_reaction != NULL && downstream_reaction != downstream_to_execute_now) {
-                            num_downstream_reactions++;
-                            // If there is exactly one downstream reaction that is enabled by this
-                            // reaction, then we can execute that reaction immediately without
-                            // going through the reaction queue. In multithreaded execution, this
-                            // avoids acquiring a mutex lock.
-                            // FIXME: Check the earliest deadline on the reaction queue.
-                            // This optimization could violate EDF scheduling otherwise.
-                            if (num_downstream_reactions == 1 && downstream_reaction->last_enabling_reaction == reaction) {
-                                // So far, this downstream reaction is a candidate to execute now.
-                                downstream_to_execute_now = downstream_reaction;
-                            } else {
-                                // If there is a previous candidate reaction to execute now,
-                                // it is no longer a candidate.
-                                if (downstream_to_execute_now != NULL) {
-                                    // More than one downstream reaction is enabled.
-                                    // In this case, if we were to execute the downstream reaction
-                                    // immediately without changing any queues, then the second
-                                    // downstream reaction would be blocked because this reaction
-                                    // remains on the executing queue. Hence, the optimization
-                                    // is not valid. Put the candidate reaction on the queue.
-                                    _lf_trigger_reaction(downstream_to_execute_now, worker);
-                                    downstream_to_execute_now = NULL;
-                                }
-                                // Queue the reaction.
-                                _lf_trigger_reaction(downstream_reaction, worker);
-                            }
-                        }
+            for (int j = 0; j < reaction->triggered_sizes[i]; j++) {
+                trigger_t* trigger = reaction->triggers[i][j];
+                for (int k = 0; trigger != NULL && k < trigger->number_of_reactions; k++) {
+                    if (trigger->reactions[k] != NULL) {
+                        _lf_enable_downstream_reaction(reaction, trigger->reactions[k],
+                                &downstream_to_execute_now, &num_downstream_reactions, worker);
                     }
                 }
             }
@@ -1701,9 +2031,9 @@ void schedule_output_reactions(reaction_t* reaction, int worker) {
 #endif
         if (downstream_to_execute_now->deadline >= 0LL) {
             // Get the current physical time.
-            instant_t physical_time = lf_time_physical();
+            instant_t physical_time = lf_time_physical_fast();
             // Check for deadline violation.
-            if (downstream_to_execute_now->deadline == 0 || physical_time > current_tag.time + downstream_to_execute_now->deadline) {
+            if (downstream_to_execute_now->deadline == 0 || physical_time > _lf_enclave->current_tag.time + downstream_to_execute_now->deadline) {
                 // Deadline violation has occurred.
                 violation = true;
                 // Invoke the local handler, if there is one.
@@ -1724,7 +2054,11 @@ void schedule_output_reactions(reaction_t* reaction, int worker) {
 
             // If the downstream_reaction produced outputs, put the resulting triggered
             // reactions into the queue (or execute them directly, if possible).
-            schedule_output_reactions(downstream_to_execute_now, worker);
+            // If it has suspended itself, the worker that executes its
+            // continuation does this instead.
+            if (!_lf_release_suspended_reaction(downstream_to_execute_now, worker)) {
+                schedule_output_reactions(downstream_to_execute_now, worker);
+            }
         }
 
         // Reset the is_STP_violated because it has been passed
@@ -1739,40 +2073,55 @@ void schedule_output_reactions(reaction_t* reaction, int worker) {
  * Return a writable copy of the specified token.
  * If the reference count is 1, this returns the original token rather than a copy.
  * The reference count will still be 1.
+ * If the token is a view, it must also be the only holder of its parent.
  * If the size of the token payload is zero, this also returns the original token.
- * Otherwise, this returns a new token with a reference count of 0.
+ * Otherwise, this returns a new token with a reference count of 0, which,
+ * for a view, carries a copy of the slice only.
  * To ensure that the allocated memory is not leaked, this new token must be
  * either passed to an output using set_token() or scheduled with a action
  * using schedule_token().
  */
 lf_token_t* writable_copy(lf_token_t* token) {
     LF_PRINT_DEBUG("writable_copy: Requesting writable copy of token %p with reference count %d.", token, token->ref_count);
-    if (token->ref_count == 1) {
+    if (token->ref_count == 1 && (token->parent == NULL || token->parent->ref_count == 1)) {
         LF_PRINT_DEBUG("writable_copy: Avoided copy because reference count is %d.", token->ref_count);
         return token;
     }
     LF_PRINT_DEBUG("writable_copy: Copying array because reference count is greater than 1. It is %d.", token->ref_count);
-    void* copy;
+    if (token->copy_constructor == NULL && token->element_size * token->length == 0) {
+        return token;
+    }
+    return _lf_copy_token(token);
+}
+
+/**
+ * Return a new token with a reference count of 0 that carries a copy of
+ * the payload of the specified token. The copy is made with the copy
+ * constructor of the token, if it has one, and with memcpy otherwise.
+ * @param token The token to copy (must not be NULL).
+ */
+lf_token_t* _lf_copy_token(lf_token_t* token) {
+    // Create a new, dynamically allocated token, in which a small copy is stored.
+    lf_token_t* result = create_token(token->element_size);
+    void* copy = NULL;
     if (token->copy_constructor == NULL) {
         LF_PRINT_DEBUG("writable_copy: Copy constructor is NULL. Using default strategy.");
         size_t size = token->element_size * token->length;
-        if (size == 0) {
-            return token;
+        if (size > 0) {
+            copy = _lf_allocate_token_payload(result, size, token->destructor != NULL);
+            LF_PRINT_DEBUG("Allocating memory for writable copy %p.", copy);
+            memcpy(copy, token->value, size);
+            // Count allocations to issue a warning if this is never freed.
+            _lf_instance->count_payload_allocations++;
         }
-        copy = malloc(size);
-        LF_PRINT_DEBUG("Allocating memory for writable copy %p.", copy);
-        memcpy(copy, token->value, size);
-        // Count allocations to issue a warning if this is never freed.
     } else {
         LF_PRINT_DEBUG("writable_copy: Copy constructor is not NULL. Using copy constructor.");
         if (token->destructor == NULL) {
             lf_print_warning("writable_copy: Using non-default copy constructor without setting destructor. Potential memory leak.");
         }
         copy = token->copy_constructor(token->value);
+        _lf_instance->count_payload_allocations++;
     }
-    // Create a new, dynamically allocated token.
-    lf_token_t* result = create_token(token->element_size);
-    _lf_count_payload_allocations++;
     result->length = token->length;
     result->value = copy;
     result->destructor = token->destructor;
@@ -1780,6 +2129,80 @@ lf_token_t* writable_copy(lf_token_t* token) {
     return result;
 }
 
+/**
+ * Return a new token that is a view of a slice of the array carried by the
+ * specified token. See reactor.h for documentation.
+ */
+lf_token_t* lf_token_slice(lf_token_t* token, size_t offset, size_t length) {
+    if (token->value == NULL || offset > token->length || length > token->length - offset) {
+        lf_print_error("lf_token_slice: Slice [%zu, %zu) is out of the bounds of an array of length %zu.",
+                offset, offset + length, token->value == NULL ? 0 : token->length);
+        return NULL;
+    }
+    if (token->copy_constructor != NULL) {
+        lf_print_error("lf_token_slice: Cannot slice a token with a copy constructor.");
+        return NULL;
+    }
+#ifdef NUMBER_OF_WORKERS
+    // Reactions that execute in parallel may slice the same token. As in
+    // lf_token_wrap_batch(), the token is created and the reference is taken
+    // with the event queue locked.
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
+#endif
+    lf_token_t* result = create_token(token->element_size);
+    result->value = (char*)token->value + offset * token->element_size;
+    result->length = length;
+    // Refer to the token that owns the payload, so that views do not chain.
+    result->parent = token->parent == NULL ? token : token->parent;
+    result->parent->ref_count++;
+#ifdef NUMBER_OF_WORKERS
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+#endif
+    LF_PRINT_DEBUG("lf_token_slice: Created view %p of [%zu, %zu) of token %p.",
+            result, offset, offset + length, result->parent);
+    return result;
+}
+
+/**
+ * Return a new token that carries the specified buffer, which the program owns.
+ * See reactor.h for documentation.
+ */
+lf_token_t* lf_token_wrap(size_t element_size, void* value, size_t length,
+        lf_token_release_t release, void* context) {
+    lf_token_t* result;
+    lf_token_wrap_batch(element_size, &value, &length, 1, release, context, &result);
+    return result;
+}
+
+/**
+ * Create tokens for a batch of buffers owned by the program.
+ * See reactor.h for documentation.
+ */
+void lf_token_wrap_batch(size_t element_size, void* const* values, const size_t* lengths, size_t count,
+        lf_token_release_t release, void* context, lf_token_t** tokens) {
+#ifdef NUMBER_OF_WORKERS
+    // As in _lf_schedule_value(), tokens are created with the event queue locked.
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
+#endif
+    for (size_t i = 0; i < count; i++) {
+        lf_token_t* token = create_token(element_size);
+        token->value = values[i];
+        token->length = lengths[i];
+        // The token is freed, but the payload is released, if at all, by the program.
+        token->ok_to_free = token_only;
+        token->release = release;
+        token->release_context = context;
+        if (token->value != NULL) {
+            // Count payloads to issue a warning if one is never released.
+            _lf_instance->count_payload_allocations++;
+        }
+        tokens[i] = token;
+    }
+#ifdef NUMBER_OF_WORKERS
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+#endif
+}
+
 /**
  * Print a usage message.
  */
@@ -1792,8 +2215,43 @@ void usage(int argc, const char* argv[]) {
     printf("   nsec, usec, msec, sec, minute, hour, day, week, or the plurals of those.\n\n");
     printf("  -k, --keepalive\n");
     printf("   Whether continue execution even when there are no events to process.\n\n");
+    printf("  -s, --spin-margin <duration> <units>\n");
+    printf("   Stop sleeping this long before each target time and spin on the physical\n");
+    printf("   clock for the rest of the wait. Units are as for --timeout.\n\n");
+    printf("  --clock-tolerance <duration> <units>\n");
+    printf("   Error in physical time that deadline checks and tracing can tolerate in\n");
+    printf("   exchange for cheaper clock reads. Units are as for --timeout.\n\n");
+    printf("  --thread-policy <class> <policy>\n");
+    printf("   Scheduling policy for the class of runtime threads, which is one of workers,\n");
+    printf("   trace, network, or io. The policy is one of fair, rr <priority>,\n");
+    printf("   fifo <priority>, or deadline <runtime> <units> <period> <units>.\n\n");
+    printf("  --lock-memory [true | false]\n");
+    printf("   Whether to lock all memory of the process into RAM.\n\n");
+    printf("  --prefault-stack <bytes>\n");
+    printf("   Touch this many bytes of the stack of each runtime thread when it starts.\n");
+    printf("   This must be less than the stack size of the threads.\n\n");
+    #ifdef LF_STATIC_MEMORY
+    printf("  --max-events <n>\n");
+    printf("   The number of events for which memory is allocated at startup.\n\n");
+    printf("  --max-tokens <n>\n");
+    printf("   The number of tokens and payloads for which memory is allocated at startup.\n\n");
+    printf("  --max-payload-size <bytes>\n");
+    printf("   The largest payload that the runtime allocates for a reactor.\n\n");
+    printf("  --max-reactions <n>\n");
+    printf("   The number of reactions that each reaction queue has room for.\n\n");
+    printf("  --overflow-policy [exit | heap]\n");
+    printf("   Whether to exit or to use the heap when memory allocated at startup runs out.\n\n");
+    #endif
     printf("  -w, --workers <n>\n");
     printf("   Executed in <n> threads if possible (optional feature).\n\n");
+    #ifdef NUMBER_OF_WORKERS
+    printf("  --min-workers <n>\n");
+    printf("   Park the workers beyond <n> while the program does not need them\n");
+    printf("   (NP, GEDF_NP, and GEDF_NP_CI schedulers).\n\n");
+    printf("  --sched-profile <file>\n");
+    printf("   Start from the numbers of workers per level saved in <file> by a\n");
+    printf("   previous run, and save them there at exit (adaptive scheduler).\n\n");
+    #endif
     printf("  -i, --id <n>\n");
     printf("   The ID of the federation that this reactor will join.\n\n");
     #ifdef FEDERATED
@@ -1814,6 +2272,111 @@ int default_argc = 0;
 const char** default_argv = NULL;
 
 
+/**
+ * Parse a duration given as a number and units on the command line.
+ * @param time_spec The number.
+ * @param units The units, one of nsec, usec, msec, sec, minute, hour, day,
+ *  week, or the plurals of those.
+ * @param result Where to store the duration in nanoseconds.
+ * @return true if the duration was parsed, false otherwise.
+ */
+static bool parse_duration(const char* time_spec, const char* units, interval_t* result) {
+    #ifdef BIT_32
+    *result = atol(time_spec);
+    #else
+    *result = atoll(time_spec);
+    #endif
+    // A parse error returns 0LL, so check to see whether that is what is meant.
+    if (*result == 0LL && strncmp(time_spec, "0", 1) != 0) {
+        // Parse error.
+        lf_print_error("Invalid time value: %s", time_spec);
+        return false;
+    }
+    if (strncmp(units, "sec", 3) == 0) {
+        *result = SEC(*result);
+    } else if (strncmp(units, "msec", 4) == 0) {
+        *result = MSEC(*result);
+    } else if (strncmp(units, "usec", 4) == 0) {
+        *result = USEC(*result);
+    } else if (strncmp(units, "nsec", 4) == 0) {
+        *result = NSEC(*result);
+    } else if (strncmp(units, "min", 3) == 0) {
+        *result = MINUTE(*result);
+    } else if (strncmp(units, "hour", 4) == 0) {
+        *result = HOUR(*result);
+    } else if (strncmp(units, "day", 3) == 0) {
+        *result = DAY(*result);
+    } else if (strncmp(units, "week", 4) == 0) {
+        *result = WEEK(*result);
+    } else {
+        // Invalid units.
+        lf_print_error("Invalid time units: %s", units);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Parse the arguments of the --thread-policy command-line option, starting
+ * at argv[*i], and record the policy for the given class of threads.
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line arguments.
+ * @param i Pointer to the index of the first argument after --thread-policy,
+ *  which is advanced past the arguments consumed.
+ * @return true if the arguments were parsed, false otherwise.
+ */
+static bool parse_thread_policy(int argc, const char* argv[], int* i) {
+    if (argc < *i + 2) {
+        lf_print_error("--thread-policy needs a thread class and a policy.");
+        return false;
+    }
+    const char* class_spec = argv[(*i)++];
+    const char* policy_spec = argv[(*i)++];
+    int thread_class = 0;
+    while (thread_class < LF_NUMBER_OF_THREAD_CLASSES
+            && strcmp(class_spec, _lf_thread_class_name(thread_class)) != 0) {
+        thread_class++;
+    }
+    if (thread_class == LF_NUMBER_OF_THREAD_CLASSES) {
+        lf_print_error("Invalid thread class for --thread-policy: %s", class_spec);
+        return false;
+    }
+    lf_scheduling_policy_t policy = { .policy = LF_SCHED_FAIR };
+    if (strcmp(policy_spec, "rr") == 0 || strcmp(policy_spec, "fifo") == 0) {
+        if (argc < *i + 1) {
+            lf_print_error("--thread-policy %s needs a priority.", policy_spec);
+            return false;
+        }
+        policy.policy = (policy_spec[0] == 'r') ? LF_SCHED_TIMESLICE : LF_SCHED_PRIORITY;
+        policy.priority = atoi(argv[(*i)++]);
+        if (policy.priority <= 0) {
+            lf_print_error("Invalid priority for --thread-policy: %s", argv[*i - 1]);
+            return false;
+        }
+    } else if (strcmp(policy_spec, "deadline") == 0) {
+        if (argc < *i + 4) {
+            lf_print_error("--thread-policy deadline needs a runtime and a period, each with units.");
+            return false;
+        }
+        if (!parse_duration(argv[*i], argv[*i + 1], &policy.runtime)
+                || !parse_duration(argv[*i + 2], argv[*i + 3], &policy.period)) {
+            return false;
+        }
+        *i += 4;
+        if (policy.runtime <= 0LL || policy.runtime > policy.period) {
+            lf_print_error("--thread-policy deadline needs 0 < runtime <= period.");
+            return false;
+        }
+        policy.policy = LF_SCHED_DEADLINE;
+    } else if (strcmp(policy_spec, "fair") != 0) {
+        lf_print_error("Invalid policy for --thread-policy: %s", policy_spec);
+        return false;
+    }
+    _lf_thread_policies[thread_class] = policy;
+    _lf_thread_policy_specified[thread_class] = true;
+    return true;
+}
+
 /**
  * Process the command-line arguments. If the command line arguments are not
  * understood, then print a usage message and return 0. Otherwise, return 1.
@@ -1831,9 +2394,9 @@ int process_args(int argc, const char* argv[]) {
             }
             const char* fast_spec = argv[i++];
             if (strcmp(fast_spec, "true") == 0) {
-                fast = true;
+                _lf_instance->fast = true;
             } else if (strcmp(fast_spec, "false") == 0) {
-                fast = false;
+                _lf_instance->fast = false;
             } else {
                 lf_print_error("Invalid value for --fast: %s", fast_spec);
             }
@@ -1848,38 +2411,7 @@ int process_args(int argc, const char* argv[]) {
             }
             const char* time_spec = argv[i++];
             const char* units = argv[i++];
-
-            #ifdef BIT_32
-            duration = atol(time_spec);
-            #else
-            duration = atoll(time_spec);
-            #endif
-            // A parse error returns 0LL, so check to see whether that is what is meant.
-            if (duration == 0LL && strncmp(time_spec, "0", 1) != 0) {
-                // Parse error.
-                lf_print_error("Invalid time value: %s", time_spec);
-                usage(argc, argv);
-                return 0;
-            }
-            if (strncmp(units, "sec", 3) == 0) {
-                duration = SEC(duration);
-            } else if (strncmp(units, "msec", 4) == 0) {
-                duration = MSEC(duration);
-            } else if (strncmp(units, "usec", 4) == 0) {
-                duration = USEC(duration);
-            } else if (strncmp(units, "nsec", 4) == 0) {
-                duration = NSEC(duration);
-            } else if (strncmp(units, "min", 3) == 0) {
-                duration = MINUTE(duration);
-            } else if (strncmp(units, "hour", 4) == 0) {
-                duration = HOUR(duration);
-            } else if (strncmp(units, "day", 3) == 0) {
-                duration = DAY(duration);
-            } else if (strncmp(units, "week", 4) == 0) {
-                duration = WEEK(duration);
-            } else {
-                // Invalid units.
-                lf_print_error("Invalid time units: %s", units);
+            if (!parse_duration(time_spec, units, &_lf_instance->duration)) {
                 usage(argc, argv);
                 return 0;
             }
@@ -1891,13 +2423,123 @@ int process_args(int argc, const char* argv[]) {
             }
             const char* keep_spec = argv[i++];
             if (strcmp(keep_spec, "true") == 0) {
-                keepalive_specified = true;
+                _lf_instance->keepalive_specified = true;
             } else if (strcmp(keep_spec, "false") == 0) {
-                keepalive_specified = false;
+                _lf_instance->keepalive_specified = false;
             } else {
                 lf_print_error("Invalid value for --keepalive: %s", keep_spec);
             }
-        } else if (strcmp(arg, "-w") == 0 || strcmp(arg, "--workers") == 0) {
+        } else if (strcmp(arg, "-s") == 0 || strcmp(arg, "--spin-margin") == 0) {
+            if (argc < i + 2) {
+                lf_print_error("--spin-margin needs time and units.");
+                usage(argc, argv);
+                return 0;
+            }
+            const char* time_spec = argv[i++];
+            const char* units = argv[i++];
+            if (!parse_duration(time_spec, units, &_lf_spin_margin)) {
+                usage(argc, argv);
+                return 0;
+            }
+        } else if (strcmp(arg, "--clock-tolerance") == 0) {
+            if (argc < i + 2) {
+                lf_print_error("--clock-tolerance needs time and units.");
+                usage(argc, argv);
+                return 0;
+            }
+            const char* time_spec = argv[i++];
+            const char* units = argv[i++];
+            if (!parse_duration(time_spec, units, &_lf_physical_clock_tolerance)) {
+                usage(argc, argv);
+                return 0;
+            }
+        } else if (strcmp(arg, "--thread-policy") == 0) {
+            if (!parse_thread_policy(argc, argv, &i)) {
+                usage(argc, argv);
+                return 0;
+            }
+        } else if (strcmp(arg, "--lock-memory") == 0) {
+            if (argc < i + 1) {
+                lf_print_error("--lock-memory needs a boolean.");
+                usage(argc, argv);
+                return 0;
+            }
+            const char* lock_spec = argv[i++];
+            if (strcmp(lock_spec, "true") == 0) {
+                _lf_lock_memory_specified = true;
+            } else if (strcmp(lock_spec, "false") == 0) {
+                _lf_lock_memory_specified = false;
+            } else {
+                lf_print_error("Invalid value for --lock-memory: %s", lock_spec);
+            }
+        } else if (strcmp(arg, "--prefault-stack") == 0) {
+            if (argc < i + 1) {
+                lf_print_error("--prefault-stack needs an integer argument.");
+                usage(argc, argv);
+                return 0;
+            }
+            const char* size_spec = argv[i++];
+            long long size = atoll(size_spec);
+            if (size < 0LL) {
+                lf_print_error("Invalid value for --prefault-stack: %s", size_spec);
+                usage(argc, argv);
+                return 0;
+            }
+            // By default, threads get stacks as large as that of the main thread.
+            size_t stack_size = lf_thread_stack_size();
+            if (stack_size > 0 && (unsigned long long)size >= stack_size) {
+                lf_print_error("Value for --prefault-stack %s is not less than the stack size of %zu bytes.",
+                        size_spec, stack_size);
+                usage(argc, argv);
+                return 0;
+            }
+            _lf_prefault_stack_size = (size_t)size;
+        }
+        #ifdef LF_STATIC_MEMORY
+          else if (strcmp(arg, "--max-events") == 0
+                || strcmp(arg, "--max-tokens") == 0
+                || strcmp(arg, "--max-payload-size") == 0
+                || strcmp(arg, "--max-reactions") == 0) {
+            if (argc < i + 1) {
+                lf_print_error("%s needs an integer argument.", arg);
+                usage(argc, argv);
+                return 0;
+            }
+            const char* count_spec = argv[i++];
+            long long count = atoll(count_spec);
+            if (count <= 0LL) {
+                lf_print_error("Invalid value for %s: %s", arg, count_spec);
+                usage(argc, argv);
+                return 0;
+            }
+            if (strcmp(arg, "--max-events") == 0) {
+                _lf_instance->max_events = (size_t)count;
+            } else if (strcmp(arg, "--max-tokens") == 0) {
+                _lf_instance->max_tokens = (size_t)count;
+            } else if (strcmp(arg, "--max-reactions") == 0) {
+                _lf_instance->max_reactions = (size_t)count;
+            } else {
+                _lf_instance->max_payload_size = (size_t)count;
+            }
+        } else if (strcmp(arg, "--overflow-policy") == 0) {
+            if (argc < i + 1) {
+                lf_print_error("--overflow-policy needs exit or heap.");
+                usage(argc, argv);
+                return 0;
+            }
+            const char* policy_spec = argv[i++];
+            if (strcmp(policy_spec, "exit") == 0) {
+                _lf_instance->overflow_policy = LF_OVERFLOW_EXIT;
+            } else if (strcmp(policy_spec, "heap") == 0) {
+                _lf_instance->overflow_policy = LF_OVERFLOW_HEAP;
+            } else {
+                lf_print_error("Invalid value for --overflow-policy: %s", policy_spec);
+                usage(argc, argv);
+                return 0;
+            }
+        }
+        #endif
+          else if (strcmp(arg, "-w") == 0 || strcmp(arg, "--workers") == 0) {
             if (argc < i + 1) {
                 lf_print_error("--workers needs an integer argument.s");
                 usage(argc, argv);
@@ -1909,8 +2551,31 @@ int process_args(int argc, const char* argv[]) {
                 lf_print_error("Invalid value for --workers: %s. Using 1.", threads_spec);
                 num_workers = 1;
             }
-            _lf_number_of_workers = (unsigned int)num_workers;
+            _lf_instance->number_of_workers = (unsigned int)num_workers;
         }
+        #ifdef NUMBER_OF_WORKERS
+          else if (strcmp(arg, "--min-workers") == 0) {
+            if (argc < i + 1) {
+                lf_print_error("--min-workers needs an integer argument.");
+                usage(argc, argv);
+                return 0;
+            }
+            const char* min_workers_spec = argv[i++];
+            int min_workers = atoi(min_workers_spec);
+            if (min_workers <= 0) {
+                lf_print_error("Invalid value for --min-workers: %s. Using 1.", min_workers_spec);
+                min_workers = 1;
+            }
+            _lf_instance->min_workers = (unsigned int)min_workers;
+        } else if (strcmp(arg, "--sched-profile") == 0) {
+            if (argc < i + 1) {
+                lf_print_error("--sched-profile needs a file name.");
+                usage(argc, argv);
+                return 0;
+            }
+            _lf_instance->sched_profile = argv[i++];
+        }
+        #endif
         #ifdef FEDERATED
           else if (strcmp(arg, "-i") == 0 || strcmp(arg, "--id") == 0) {
             if (argc < i + 1) {
@@ -1966,52 +2631,133 @@ int process_args(int argc, const char* argv[]) {
  * physical time. This also prints a message reporting the start time.
  */
 void initialize(void) {
-    _lf_count_payload_allocations = 0;
-    _lf_count_token_allocations = 0;
+    _lf_instance->count_payload_allocations = 0;
+    _lf_instance->count_token_allocations = 0;
 
-    // Initialize our priority queues.
+    // Lock memory before anything else is allocated, so that MCL_FUTURE
+    // (or its equivalent) covers the queues and the stacks of all threads.
+    if (_lf_lock_memory_specified && lf_lock_memory() != 0) {
+        lf_print_warning("Failed to lock memory: %s. Continuing without memory locking.",
+                strerror(errno));
+    }
 
-    event_q = pqueue_init(INITIAL_EVENT_QUEUE_SIZE, in_reverse_order, get_event_time,
-            get_event_position, set_event_position, event_matches, print_event);
-    // NOTE: The recycle and next queue does not need to be sorted. But here it is.
-    recycle_q = pqueue_init(INITIAL_EVENT_QUEUE_SIZE, in_no_particular_order, get_event_time,
-            get_event_position, set_event_position, event_matches, print_event);
-    next_q = pqueue_init(INITIAL_EVENT_QUEUE_SIZE, in_no_particular_order, get_event_time,
-            get_event_position, set_event_position, event_matches, print_event);
+    // Initialize our priority queues.
+    _lf_initialize_event_queues(&_lf_main_enclave);
 
-    // Initialize the trigger table.
+    // Initialize the trigger table. This also creates any enclaves other than
+    // the main one.
     _lf_initialize_trigger_objects();
 
-    physical_start_time = lf_time_physical();
-    current_tag.time = physical_start_time;
-    start_time = current_tag.time;
+    // Flatten the outputs of the reactions while heap allocation is allowed.
+    _lf_initialize_output_reactions();
+
+#ifdef LF_STATIC_MEMORY
+    // From here on, events, tokens, and payloads come from pools.
+    _lf_initialize_pools();
+#endif
+
+    _lf_instance->physical_start_time = lf_time_physical();
+    _lf_instance->start_time = _lf_instance->physical_start_time;
+    for (lf_enclave_t* enclave = &_lf_main_enclave; enclave != NULL; enclave = enclave->next) {
+        enclave->current_tag = (tag_t) {.time = _lf_instance->start_time, .microstep = 0u};
+    }
 
     #ifdef BIT_32
         #ifdef MICROSECOND_TIME
-            LF_PRINT_DEBUG("Start time: " PRINTF_TIME "us", start_time);
+            LF_PRINT_DEBUG("Start time: " PRINTF_TIME "us", _lf_instance->start_time);
         #else
-            LF_PRINT_DEBUG("Start time: " PRINTF_TIME "ns", start_time);
+            LF_PRINT_DEBUG("Start time: " PRINTF_TIME "ns", _lf_instance->start_time);
         #endif
     #else
         #ifdef MICROSECOND_TIME
-            LF_PRINT_DEBUG("Start time: " PRINTF_TIME "us", start_time);
+            LF_PRINT_DEBUG("Start time: " PRINTF_TIME "us", _lf_instance->start_time);
         #else
-            LF_PRINT_DEBUG("Start time: " PRINTF_TIME "ns", start_time);
+            LF_PRINT_DEBUG("Start time: " PRINTF_TIME "ns", _lf_instance->start_time);
         #endif
     #endif
 
     #ifdef ARDUINO
-    printf("---- Start execution at time " PRINTF_TIME "us\n", physical_start_time);
+    printf("---- Start execution at time " PRINTF_TIME "us\n", _lf_instance->physical_start_time);
     #else
-    struct timespec physical_time_timespec = {physical_start_time / BILLION, physical_start_time % BILLION};
+    struct timespec physical_time_timespec = {_lf_instance->physical_start_time / BILLION, _lf_instance->physical_start_time % BILLION};
 
     printf("---- Start execution at time %s---- plus %ld nanoseconds.\n",
             ctime(&physical_time_timespec.tv_sec), physical_time_timespec.tv_nsec);
     #endif
-    if (duration >= 0LL) {
-        // A duration has been specified. Calculate the stop time.
-        _lf_set_stop_tag((tag_t) {.time = current_tag.time + duration, .microstep = 0});
+    if (_lf_instance->duration >= 0LL) {
+        // A duration has been specified. Calculate the stop time,
+        // which is the same for all enclaves.
+        tag_t timeout_tag = (tag_t) {.time = _lf_instance->start_time + _lf_instance->duration, .microstep = 0};
+        for (lf_enclave_t* enclave = &_lf_main_enclave; enclave != NULL; enclave = enclave->next) {
+            if (lf_tag_compare(timeout_tag, enclave->stop_tag) < 0) {
+                enclave->stop_tag = timeout_tag;
+            }
+        }
+    }
+}
+
+/**
+ * Create the event queue and the queue of recycled events of an enclave.
+ * @param enclave The enclave.
+ */
+void _lf_initialize_event_queues(lf_enclave_t* enclave) {
+#ifdef LF_STATIC_MEMORY
+    // Make room for all events so that the queue never grows.
+    size_t event_q_size = _lf_instance->max_events;
+#else
+    size_t event_q_size = INITIAL_EVENT_QUEUE_SIZE;
+#endif
+    enclave->event_q = pqueue_init(event_q_size, in_reverse_tag_order, get_event_tag,
+            get_event_position, set_event_position, event_matches, print_event);
+    // NOTE: The recycle queue does not need to be sorted. But here it is.
+    enclave->recycle_q = pqueue_init(INITIAL_EVENT_QUEUE_SIZE, in_no_particular_order, get_event_tag,
+            get_event_position, set_event_position, event_matches, print_event);
+}
+
+/**
+ * Return the number of reactions that a reaction queue of the enclave that the
+ * calling thread is bound to needs room for. This is the number of reactions
+ * that the code generator has listed for the enclave, since a reaction is
+ * never queued twice at once. In static-memory mode, where a reaction queue
+ * must never grow, --max-reactions overrides it, and LF_STATIC_MAX_REACTIONS
+ * stands in for it if the reactions have not been listed.
+ */
+size_t _lf_reaction_queue_capacity() {
+#ifdef LF_STATIC_MEMORY
+    if (_lf_instance->max_reactions > 0) {
+        return _lf_instance->max_reactions;
     }
+    return _lf_reactions_size > 0 ? (size_t)_lf_reactions_size : LF_STATIC_MAX_REACTIONS;
+#else
+    return _lf_reactions_size > INITIAL_REACT_QUEUE_SIZE ? (size_t)_lf_reactions_size : INITIAL_REACT_QUEUE_SIZE;
+#endif
+}
+
+/**
+ * Free the event queues of an enclave and the events on them, including their
+ * payloads, and the tokens in the recycling bin of the enclave. The calling
+ * thread must be bound to the enclave.
+ * @param enclave The enclave.
+ */
+void _lf_free_event_queues(lf_enclave_t* enclave) {
+    event_t* e;
+    while ((e = (event_t*)pqueue_pop(enclave->event_q)) != NULL) {
+        _lf_done_using(e->token);
+        _lf_free_event(e);
+    }
+    while ((e = (event_t*)pqueue_pop(enclave->recycle_q)) != NULL) {
+        _lf_free_event(e);
+    }
+    pqueue_free(enclave->event_q);
+    pqueue_free(enclave->recycle_q);
+    enclave->event_q = NULL;
+    enclave->recycle_q = NULL;
+    while (enclave->token_recycling_bin != NULL) {
+        lf_token_t* token = enclave->token_recycling_bin;
+        enclave->token_recycling_bin = token->next_free;
+        free(token);
+    }
+    enclave->token_recycling_bin_size = 0;
 }
 
 /**
@@ -2020,6 +2766,12 @@ void initialize(void) {
  * has not been freed.
  */
 void termination(void) {
+    // Termination may happen in a thread that may not allocate memory.
+    _lf_forbid_heap_allocation(false);
+
+    // Stop handling file descriptors, whose handlers may schedule actions.
+    _lf_fd_sources_free();
+
     // Invoke the code generated termination function.
     terminate_execution();
 
@@ -2028,6 +2780,17 @@ void termination(void) {
 
     // In order to free tokens, we perform the same actions we would have for a new time step.
     _lf_start_time_step();
+#ifdef NUMBER_OF_WORKERS
+    // Do the same for the other enclaves, if any, and free their tables.
+    for (lf_enclave_t* enclave = _lf_main_enclave.next; enclave != NULL; enclave = enclave->next) {
+        _lf_enclave = enclave;
+        _lf_start_time_step();
+        free(_lf_tokens_with_ref_count);
+        free(_lf_is_present_fields);
+        free(_lf_is_present_fields_abbreviated);
+    }
+    _lf_enclave = &_lf_main_enclave;
+#endif
 
 #ifdef MODAL_REACTORS
     // Free events and tokens suspended by modal reactors.
@@ -2035,21 +2798,28 @@ void termination(void) {
 #endif
 
     // If the event queue still has events on it, report that.
-    if (event_q != NULL && pqueue_size(event_q) > 0) {
-        lf_print_warning("---- There are %zu unprocessed future events on the event queue.", pqueue_size(event_q));
-        event_t* event = (event_t*)pqueue_peek(event_q);
-        interval_t event_time = event->time - start_time;
+    if (_lf_enclave->event_q != NULL && pqueue_size(_lf_enclave->event_q) > 0) {
+        lf_print_warning("---- There are %zu unprocessed future events on the event queue.", pqueue_size(_lf_enclave->event_q));
+        event_t* event = (event_t*)pqueue_peek(_lf_enclave->event_q);
+        interval_t event_time = event->tag.time - _lf_instance->start_time;
         lf_print_warning("---- The first future event has timestamp " PRINTF_TIME " after start time.", event_time);
     }
     // Issue a warning if a memory leak has been detected.
-    if (_lf_count_payload_allocations > 0) {
+    if (_lf_instance->count_payload_allocations > 0) {
         lf_print_warning("Memory allocated for messages has not been freed.");
-        lf_print_warning("Number of unfreed messages: %d.", _lf_count_payload_allocations);
+        lf_print_warning("Number of unfreed messages: %d.", _lf_instance->count_payload_allocations);
     }
-    if (_lf_count_token_allocations > 0) {
+    if (_lf_instance->count_token_allocations > 0) {
         lf_print_warning("Memory allocated for tokens has not been freed!");
-        lf_print_warning("Number of unfreed tokens: %d.", _lf_count_token_allocations);
+        lf_print_warning("Number of unfreed tokens: %d.", _lf_instance->count_token_allocations);
     }
+    for (lf_enclave_t* enclave = &_lf_main_enclave; enclave != NULL; enclave = enclave->next) {
+        _lf_print_wait_lag_histogram(enclave);
+    }
+#ifdef LF_STATIC_MEMORY
+    _lf_report_pools();
+#endif
+
     // Print elapsed times.
     // If these are negative, then the program failed to start up.
     interval_t elapsed_time = lf_time_logical_elapsed();
@@ -2060,11 +2830,12 @@ void termination(void) {
 
         // If physical_start_time is 0, then execution didn't get far enough along
         // to initialize this.
-        if (physical_start_time > 0LL) {
+        if (_lf_instance->physical_start_time > 0LL) {
             lf_comma_separated_time(time_buffer, lf_time_physical_elapsed());
             printf("---- Elapsed physical time (in nsec): %s\n", time_buffer);
         }
     }
+    _lf_free_output_reactions();
     _lf_free_all_reactors();
     free(_lf_tokens_with_ref_count);
     free(_lf_is_present_fields);
@@ -0,0 +1,312 @@
+/*************
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************/
+
+/**
+ * @file schedule_cache.c
+ * @brief Cached schedules of reactions for the unthreaded runtime.
+ *
+ * See schedule_cache.h for an overview. A schedule records two sequences: the
+ * reactions in the order in which they were triggered, and the reactions in
+ * the order in which they were executed, along with the number of reactions
+ * that had been triggered before each execution. If a later step triggers the
+ * same reactions at the same points, the reaction queue holds the same
+ * reactions whenever a reaction is popped, so the executions can be replayed
+ * from the schedule.
+ */
+
+#ifdef LF_CACHED_SCHEDULES
+
+#include <stdint.h>
+
+#include "pqueue.h"
+#include "reactor.h"
+#include "schedule_cache.h"
+#include "util.h"
+
+extern pqueue_t* reaction_q;
+
+/**
+ * A cached schedule. Its sequences are stored at the same offset in the
+ * arrays of entries below.
+ */
+typedef struct {
+    uint64_t signature;                   // The hash of the reactions triggered before the step.
+    size_t initial;                       // The number of reactions triggered before the step.
+    size_t length;                        // The number of reactions triggered, and executed, in the step.
+    size_t offset;                        // The offset of the sequences of the schedule.
+} _lf_schedule_t;
+
+/** What is being done with the reactions of the step in progress. */
+typedef enum {
+    collecting,                           // Reactions are triggered before the step.
+    replaying,                            // A cached schedule is being replayed.
+    recording,                            // The step is scheduled dynamically and recorded.
+    dynamic                               // The step is scheduled dynamically.
+} _lf_schedule_cache_state_t;
+
+static _lf_schedule_t _lf_schedules[LF_SCHEDULE_CACHE_SIZE];
+static size_t _lf_schedules_count = 0;
+
+static reaction_t* _lf_schedule_triggered[LF_SCHEDULE_CACHE_ENTRIES];
+static reaction_t* _lf_schedule_executed[LF_SCHEDULE_CACHE_ENTRIES];
+static size_t _lf_schedule_triggered_before[LF_SCHEDULE_CACHE_ENTRIES];
+static size_t _lf_schedule_entries_used = 0;
+
+/** The step in progress. */
+static struct {
+    _lf_schedule_cache_state_t state;
+    _lf_schedule_t* schedule;             // The schedule that is replayed.
+    uint64_t signature;                   // The hash of the reactions triggered before the step.
+    size_t initial;                       // The number of reactions triggered before the step.
+    size_t triggered;                     // The number of reactions triggered so far.
+    size_t executed;                      // The number of reactions executed so far.
+    // The step, as far as it has been recorded. Before the step, the collected reactions.
+    reaction_t* triggered_reactions[LF_SCHEDULE_CACHE_MAX_LENGTH];
+    reaction_t* executed_reactions[LF_SCHEDULE_CACHE_MAX_LENGTH];
+    size_t triggered_before[LF_SCHEDULE_CACHE_MAX_LENGTH];
+} _lf_step;
+
+/**
+ * Return a hash of a reaction. The signature of a set of reactions is the sum
+ * of their hashes, so it does not depend on the order in which they were
+ * triggered.
+ */
+static uint64_t _lf_schedule_cache_hash(reaction_t* reaction) {
+    uint64_t hash = (uint64_t)(uintptr_t)reaction * 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 29);
+}
+
+/**
+ * Return whether the specified schedule, other than the one that is replayed,
+ * agrees with the step so far, that is, whether it has the same prefix of
+ * triggered and executed reactions.
+ */
+static bool _lf_schedule_cache_agrees(_lf_schedule_t* schedule) {
+    _lf_schedule_t* current = _lf_step.schedule;
+    if (schedule == current || schedule->signature != current->signature
+            || schedule->initial != current->initial || schedule->length < _lf_step.triggered) {
+        return false;
+    }
+    for (size_t i = 0; i < _lf_step.triggered; i++) {
+        if (_lf_schedule_triggered[schedule->offset + i] != _lf_schedule_triggered[current->offset + i]) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < _lf_step.executed; i++) {
+        if (_lf_schedule_executed[schedule->offset + i] != _lf_schedule_executed[current->offset + i]
+                || _lf_schedule_triggered_before[schedule->offset + i]
+                    != _lf_schedule_triggered_before[current->offset + i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Look for another cached schedule that agrees with the step so far and
+ * continues with the specified reaction being triggered or, if the reaction
+ * is NULL, with the next reaction being executed, and replay it instead.
+ * @return true if there is such a schedule.
+ */
+static bool _lf_schedule_cache_switch(reaction_t* reaction) {
+    size_t triggered = _lf_step.triggered;
+    size_t executed = _lf_step.executed;
+    for (size_t s = 0; s < _lf_schedules_count; s++) {
+        _lf_schedule_t* schedule = &_lf_schedules[s];
+        if (!_lf_schedule_cache_agrees(schedule)) {
+            continue;
+        }
+        bool continues;
+        if (reaction != NULL) {
+            continues = schedule->length > triggered
+                    && _lf_schedule_triggered[schedule->offset + triggered] == reaction;
+        } else {
+            continues = (executed < schedule->length)
+                    ? _lf_schedule_triggered_before[schedule->offset + executed] == triggered
+                    : triggered == schedule->length;
+        }
+        if (continues) {
+            _lf_step.schedule = schedule;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Stop replaying schedules: move the reactions that have been triggered but
+ * not executed yet to the reaction queue, and schedule the rest of the step
+ * dynamically. If there is room, the step is recorded as another schedule for
+ * the same reactions, starting with what has been replayed.
+ */
+static void _lf_schedule_cache_deviate() {
+    LF_PRINT_DEBUG("Deviating from a cached schedule after %zu reactions.", _lf_step.executed);
+    _lf_schedule_t* schedule = _lf_step.schedule;
+    for (size_t i = 0; i < _lf_step.triggered; i++) {
+        reaction_t* reaction = _lf_schedule_triggered[schedule->offset + i];
+        if (reaction->status == queued) {
+            pqueue_insert(reaction_q, reaction);
+        }
+    }
+    if (_lf_schedules_count < LF_SCHEDULE_CACHE_SIZE
+            && _lf_schedule_entries_used < LF_SCHEDULE_CACHE_ENTRIES) {
+        for (size_t i = 0; i < _lf_step.triggered; i++) {
+            _lf_step.triggered_reactions[i] = _lf_schedule_triggered[schedule->offset + i];
+        }
+        for (size_t i = 0; i < _lf_step.executed; i++) {
+            _lf_step.executed_reactions[i] = _lf_schedule_executed[schedule->offset + i];
+            _lf_step.triggered_before[i] = _lf_schedule_triggered_before[schedule->offset + i];
+        }
+        _lf_step.signature = schedule->signature;
+        _lf_step.initial = schedule->initial;
+        _lf_step.state = recording;
+    } else {
+        _lf_step.state = dynamic;
+    }
+}
+
+bool _lf_schedule_cache_trigger(reaction_t* reaction) {
+    switch (_lf_step.state) {
+        case collecting:
+            if (_lf_step.triggered < LF_SCHEDULE_CACHE_MAX_LENGTH) {
+                _lf_step.triggered_reactions[_lf_step.triggered++] = reaction;
+                return true;
+            }
+            // Too many reactions to cache the step.
+            for (size_t i = 0; i < _lf_step.triggered; i++) {
+                pqueue_insert(reaction_q, _lf_step.triggered_reactions[i]);
+            }
+            _lf_step.state = dynamic;
+            return false;
+        case replaying:
+            if ((_lf_step.triggered < _lf_step.schedule->length
+                    && _lf_schedule_triggered[_lf_step.schedule->offset + _lf_step.triggered] == reaction)
+                    || _lf_schedule_cache_switch(reaction)) {
+                _lf_step.triggered++;
+                return true;
+            }
+            _lf_schedule_cache_deviate();
+            // Record the reaction, if the step is now recorded.
+            return _lf_schedule_cache_trigger(reaction);
+        case recording:
+            if (_lf_step.triggered < LF_SCHEDULE_CACHE_MAX_LENGTH) {
+                _lf_step.triggered_reactions[_lf_step.triggered++] = reaction;
+            } else {
+                _lf_step.state = dynamic;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+void _lf_schedule_cache_start_step() {
+    if (_lf_step.state != collecting) {
+        return;
+    }
+    uint64_t signature = 0;
+    for (size_t i = 0; i < _lf_step.triggered; i++) {
+        signature += _lf_schedule_cache_hash(_lf_step.triggered_reactions[i]);
+    }
+    for (size_t s = 0; s < _lf_schedules_count; s++) {
+        _lf_schedule_t* schedule = &_lf_schedules[s];
+        if (schedule->signature != signature || schedule->initial != _lf_step.triggered) {
+            continue;
+        }
+        // Since exactly the collected reactions are queued, the sets are equal
+        // if all the reactions of the schedule are queued.
+        size_t i = 0;
+        while (i < schedule->initial && _lf_schedule_triggered[schedule->offset + i]->status == queued) {
+            i++;
+        }
+        if (i == schedule->initial) {
+            _lf_step.state = replaying;
+            _lf_step.schedule = schedule;
+            return;
+        }
+    }
+    for (size_t i = 0; i < _lf_step.triggered; i++) {
+        pqueue_insert(reaction_q, _lf_step.triggered_reactions[i]);
+    }
+    if (_lf_schedules_count < LF_SCHEDULE_CACHE_SIZE
+            && _lf_schedule_entries_used < LF_SCHEDULE_CACHE_ENTRIES) {
+        _lf_step.state = recording;
+        _lf_step.signature = signature;
+        _lf_step.initial = _lf_step.triggered;
+    } else {
+        _lf_step.state = dynamic;
+    }
+}
+
+reaction_t* _lf_schedule_cache_next() {
+    if (_lf_step.state != replaying || _lf_step.executed == _lf_step.schedule->length) {
+        return NULL;
+    }
+    if (_lf_step.triggered != _lf_schedule_triggered_before[_lf_step.schedule->offset + _lf_step.executed]
+            && !_lf_schedule_cache_switch(NULL)) {
+        // The reactions were not triggered at the same points as when the
+        // schedule was recorded, so the reaction queue may order them differently.
+        _lf_schedule_cache_deviate();
+        return NULL;
+    }
+    if (_lf_step.executed == _lf_step.schedule->length) {
+        // Switched to a schedule that is complete.
+        return NULL;
+    }
+    return _lf_schedule_executed[_lf_step.schedule->offset + _lf_step.executed++];
+}
+
+void _lf_schedule_cache_record(reaction_t* reaction) {
+    if (_lf_step.state != recording) {
+        return;
+    }
+    _lf_step.executed_reactions[_lf_step.executed] = reaction;
+    _lf_step.triggered_before[_lf_step.executed] = _lf_step.triggered;
+    _lf_step.executed++;
+}
+
+void _lf_schedule_cache_end_step() {
+    size_t length = _lf_step.executed;
+    if (_lf_step.state == recording && length > 0 && length == _lf_step.triggered
+            && _lf_schedule_entries_used + length <= LF_SCHEDULE_CACHE_ENTRIES) {
+        _lf_schedule_t* schedule = &_lf_schedules[_lf_schedules_count++];
+        schedule->signature = _lf_step.signature;
+        schedule->initial = _lf_step.initial;
+        schedule->length = length;
+        schedule->offset = _lf_schedule_entries_used;
+        for (size_t i = 0; i < length; i++) {
+            _lf_schedule_triggered[schedule->offset + i] = _lf_step.triggered_reactions[i];
+            _lf_schedule_executed[schedule->offset + i] = _lf_step.executed_reactions[i];
+            _lf_schedule_triggered_before[schedule->offset + i] = _lf_step.triggered_before[i];
+        }
+        _lf_schedule_entries_used += length;
+        LF_PRINT_DEBUG("Cached a schedule of %zu reactions.", length);
+    }
+    _lf_step.state = collecting;
+    _lf_step.schedule = NULL;
+    _lf_step.triggered = 0;
+    _lf_step.executed = 0;
+}
+
+#endif // LF_CACHED_SCHEDULES
@@ -35,29 +35,26 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdio.h>
 #include <string.h>
 
+#include "enclave.h"
 #include "tag.h"
 #include "util.h"
 
 // Global variables :(
 
 /**
- * Current time in nanoseconds since January 1, 1970
- * This is not in scope for reactors.
- * This should only ever be accessed while holding the mutex lock.
+ * The instance of the program that every thread is bound to unless it binds
+ * itself to another one with lf_instance_bind(). The event queues of its main
+ * enclave are created in initialize(). It is defined here, with the
+ * physical clock state, so that tag.c, which the RTI includes and tag_test
+ * links, does not depend on the rest of the runtime.
  */
-tag_t current_tag = {.time = 0LL, .microstep = 0};
+lf_instance_t _lf_default_instance = LF_INSTANCE_INITIALIZER(&_lf_default_instance);
 
-/**
- * Physical time at the start of the execution.
- * This should only ever be accessed while holding the mutex lock.
- */
-instant_t physical_start_time = NEVER;
-
-/**
- * Logical time at the start of execution.
- * This should only ever be accessed while holding the mutex lock.
- */
-instant_t start_time = NEVER;
+#ifdef NUMBER_OF_WORKERS
+// The instance and the enclave that the calling thread is bound to. See enclave.h.
+LF_THREAD_LOCAL lf_instance_t* _lf_instance = &_lf_default_instance;
+LF_THREAD_LOCAL lf_enclave_t* _lf_enclave = &_lf_default_instance.main_enclave;
+#endif
 
 /**
  * Global physical clock offset.
@@ -98,10 +95,19 @@ instant_t _lf_last_reported_physical_time_ns = 0LL;
 instant_t _lf_last_reported_unadjusted_physical_time_ns = NEVER;
 
 /**
- * Return the current tag, a logical time, microstep pair.
+ * The error in physical time that deadline checks, tracing, and the
+ * recording of message arrival times can tolerate in exchange for
+ * cheaper reads of the physical clock (see lf_time_physical_fast()).
+ * The default of 0 makes those use the precise clock.
+ */
+interval_t _lf_physical_clock_tolerance = 0LL;
+
+/**
+ * Return the current tag, a logical time, microstep pair, of the enclave
+ * that the calling thread is bound to.
  */
 tag_t lf_tag() {
-    return current_tag;
+    return _lf_enclave->current_tag;
 }
 
 /**
@@ -165,19 +171,12 @@ tag_t _lf_delay_tag(tag_t tag, interval_t interval) {
 }
 
 /**
- * Return the current physical time in nanoseconds since January 1, 1970,
- * adjusted by the global physical time offset.
+ * Adjust a reading of the physical clock by the clock synchronization
+ * and test offsets.
  */
-instant_t _lf_physical_time() {
-    // Get the current clock value
-    int result = lf_clock_gettime(&_lf_last_reported_unadjusted_physical_time_ns);
-
-    if (result != 0) {
-        lf_print_error("Failed to read the physical clock.");
-    }
-
+static instant_t _lf_adjust_physical_time(instant_t unadjusted_clock_ns) {
     // Adjust the reported clock with the appropriate offsets
-    instant_t adjusted_clock_ns = _lf_last_reported_unadjusted_physical_time_ns
+    instant_t adjusted_clock_ns = unadjusted_clock_ns
             + _lf_time_physical_clock_offset;
 
     // Apply the test offset
@@ -191,6 +190,22 @@ instant_t _lf_physical_time() {
     //     adjusted_clock_ns += drift;
     //     LF_PRINT_DEBUG("Physical time adjusted for clock drift by " PRINTF_TIME ".", drift);
     // }
+    return adjusted_clock_ns;
+}
+
+/**
+ * Return the current physical time in nanoseconds since January 1, 1970,
+ * adjusted by the global physical time offset.
+ */
+instant_t _lf_physical_time() {
+    // Get the current clock value
+    int result = lf_clock_gettime(&_lf_last_reported_unadjusted_physical_time_ns);
+
+    if (result != 0) {
+        lf_print_error("Failed to read the physical clock.");
+    }
+
+    instant_t adjusted_clock_ns = _lf_adjust_physical_time(_lf_last_reported_unadjusted_physical_time_ns);
 
     // Check if the clock has progressed since the last reported value
     // This ensures that the clock is monotonic
@@ -202,7 +217,7 @@ instant_t _lf_physical_time() {
     		". Elapsed: " PRINTF_TIME
 			". Offset: " PRINTF_TIME,
             _lf_last_reported_physical_time_ns,
-            _lf_last_reported_physical_time_ns - start_time,
+            _lf_last_reported_physical_time_ns - _lf_instance->start_time,
             _lf_time_physical_clock_offset + _lf_time_test_physical_clock_offset);
 
     return _lf_last_reported_physical_time_ns;
@@ -230,15 +245,15 @@ instant_t _lf_time(_lf_time_type type) {
     switch (type)
     {
     case LF_LOGICAL:
-        return current_tag.time;
+        return _lf_enclave->current_tag.time;
     case LF_PHYSICAL:
         return _lf_physical_time();
     case LF_ELAPSED_LOGICAL:
-        return current_tag.time - start_time;
+        return _lf_enclave->current_tag.time - _lf_instance->start_time;
     case LF_ELAPSED_PHYSICAL:
-        return _lf_physical_time() - physical_start_time;
+        return _lf_physical_time() - _lf_instance->physical_start_time;
     case LF_START:
-        return start_time;
+        return _lf_instance->start_time;
     default:
         return NEVER;
     }
@@ -267,6 +282,29 @@ instant_t lf_time_physical(void) {
     return _lf_time(LF_PHYSICAL);
 }
 
+/**
+ * Return the current physical time in nanoseconds since January 1, 1970,
+ * adjusted by the global physical time offset, as read from a clock that
+ * may be cheaper to read than that of lf_time_physical() but may be off by
+ * up to _lf_physical_clock_tolerance. This does not affect what
+ * lf_time_physical() returns.
+ */
+instant_t lf_time_physical_fast(void) {
+    if (_lf_physical_clock_tolerance <= 0LL) {
+        return lf_time_physical();
+    }
+    instant_t clock_ns;
+    if (lf_clock_gettime_fast(&clock_ns, _lf_physical_clock_tolerance) != 0) {
+        lf_print_error("Failed to read the physical clock.");
+    }
+    instant_t adjusted_clock_ns = _lf_adjust_physical_time(clock_ns);
+    // Do not report a time earlier than lf_time_physical() already has.
+    if (adjusted_clock_ns < _lf_last_reported_physical_time_ns) {
+        adjusted_clock_ns = _lf_last_reported_physical_time_ns;
+    }
+    return adjusted_clock_ns;
+}
+
 /**
  * Return the elapsed physical time in nanoseconds.
  * This is the time returned by lf_time_physical() minus the
@@ -0,0 +1,513 @@
+/*************
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************/
+
+/**
+ * @file enclave.c
+ * @brief Creation of enclaves and instances and coordination of the logical
+ * times of enclaves.
+ *
+ * Each enclave publishes its next event tag (NET), which is a lower bound on
+ * the tags of the events that it may still send to other enclaves. An
+ * enclave with upstream enclaves computes a grant from the NETs and event
+ * queues of all enclaves and the delays of the connections between them,
+ * much like the RTI does for the federates of a federation, and advances its
+ * logical time only to tags that are earlier than its grant.
+ *
+ * The next event tags are protected by the enclave_mutex of the instance
+ * together with the event_q_mutex of their enclave. An enclave may lower its
+ * own next event tag while holding only its event_q_mutex, which is safe
+ * because lowering it cannot unblock another enclave. The locks are acquired
+ * in this order: the mutex of at most one enclave, enclave_mutex, and then the
+ * event_q_mutex of at most one enclave. enclave_epoch is incremented whenever
+ * a next event tag is raised or a stop tag is lowered, so that an enclave that
+ * waits for its grant notices that it may have changed.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "enclave.h"
+#include "fd_source.h"
+#include "platform.h"
+#include "reactor_common.h"
+#include "scheduler.h"
+#include "util.h"
+
+/**
+ * Delay a tag by the delay of a connection between enclaves. Unlike
+ * _lf_delay_tag(), this maps every tag at time FOREVER to FOREVER_TAG.
+ */
+static tag_t _lf_enclave_delay_tag(tag_t tag, interval_t delay) {
+    if (tag.time == FOREVER) {
+        return FOREVER_TAG;
+    }
+    tag_t result = _lf_delay_tag(tag, delay);
+    return (result.time == FOREVER) ? FOREVER_TAG : result;
+}
+
+/**
+ * Return the earliest tag of any event that the specified enclave may still
+ * send or receive, not accounting for its upstream enclaves. The caller must
+ * hold the enclave_mutex of the instance.
+ * @param enclave The enclave.
+ * @param now The current physical time.
+ * @param used_physical_time Set to true if the result was bounded by physical time.
+ */
+static tag_t _lf_enclave_earliest_tag(lf_enclave_t* enclave, instant_t now, bool* used_physical_time) {
+    lf_mutex_lock(&enclave->event_q_mutex);
+    if (enclave->terminated) {
+        lf_mutex_unlock(&enclave->event_q_mutex);
+        return FOREVER_TAG;
+    }
+    tag_t result = enclave->next_event_tag;
+    event_t* head = (event_t*)pqueue_peek(enclave->event_q);
+    if (head != NULL && lf_tag_compare(head->tag, result) < 0) {
+        result = head->tag;
+    }
+    if (enclave->has_physical_actions) {
+        tag_t physical_tag = (tag_t) {.time = now, .microstep = 0u};
+        if (lf_tag_compare(physical_tag, result) < 0) {
+            result = physical_tag;
+            *used_physical_time = true;
+        }
+    }
+    // The enclave sends nothing after its stop tag.
+    if (lf_tag_compare(result, enclave->stop_tag) > 0) {
+        result = FOREVER_TAG;
+    }
+    lf_mutex_unlock(&enclave->event_q_mutex);
+    return result;
+}
+
+/**
+ * Compute the grant of the enclave that the calling thread is bound to, which
+ * is the earliest tag of any event that an upstream enclave may still send it.
+ * The caller must hold the enclave_mutex of the instance.
+ * @param used_physical_time Set to true if the grant depends on physical time.
+ */
+static tag_t _lf_enclave_compute_grant(bool* used_physical_time) {
+    tag_t* earliest = _lf_enclave->earliest_tags;
+    instant_t now = lf_time_physical();
+    *used_physical_time = false;
+    for (lf_enclave_t* e = &_lf_main_enclave; e != NULL; e = e->next) {
+        earliest[e->id] = _lf_enclave_earliest_tag(e, now, used_physical_time);
+    }
+    // Propagate the bounds along the connections. After as many rounds as
+    // there are enclaves, every path without cycles has been accounted for.
+    for (int round = 0; round < _lf_instance->number_of_enclaves; round++) {
+        bool changed = false;
+        for (lf_enclave_t* e = &_lf_main_enclave; e != NULL; e = e->next) {
+            for (size_t i = 0; i < e->number_of_upstream; i++) {
+                tag_t bound = _lf_enclave_delay_tag(earliest[e->upstream[i].upstream->id], e->upstream[i].delay);
+                if (lf_tag_compare(bound, earliest[e->id]) < 0) {
+                    earliest[e->id] = bound;
+                    changed = true;
+                }
+            }
+        }
+        if (!changed) {
+            break;
+        }
+    }
+    tag_t grant = FOREVER_TAG;
+    for (size_t i = 0; i < _lf_enclave->number_of_upstream; i++) {
+        tag_t bound = _lf_enclave_delay_tag(earliest[_lf_enclave->upstream[i].upstream->id], _lf_enclave->upstream[i].delay);
+        if (lf_tag_compare(bound, grant) < 0) {
+            grant = bound;
+        }
+    }
+    return grant;
+}
+
+/**
+ * Return true if the event queue of the enclave that the calling thread is
+ * bound to has an event earlier than the specified tag or its stop tag is
+ * earlier than the specified tag. The caller must hold the event_q_mutex.
+ */
+static bool _lf_enclave_has_earlier_tag(tag_t tag) {
+    event_t* head = (event_t*)pqueue_peek(_lf_enclave->event_q);
+    return (head != NULL && lf_tag_compare(head->tag, tag) < 0)
+            || lf_tag_compare(_lf_enclave->stop_tag, tag) < 0;
+}
+
+/**
+ * Exit with an error if the runtime cannot have more than one enclave, which
+ * is the case if it keeps state in global variables that enclaves would share.
+ * @param function The name of the calling function, for the error message.
+ */
+static void _lf_check_enclaves_supported(const char* function) {
+#ifndef LF_ENCLAVES_SUPPORTED
+    lf_print_error_and_exit("%s: enclaves and instances are not supported in federated execution,"
+            " with modal reactors, or with tracing.", function);
+#endif
+    if (!lf_sched_supports_enclaves) {
+        lf_print_error_and_exit("%s: the scheduler does not support enclaves and instances."
+                " Use the NP or GEDF_NP scheduler.", function);
+    }
+}
+
+lf_enclave_t* lf_enclave_create(const char* name, unsigned int number_of_workers) {
+    _lf_check_enclaves_supported("lf_enclave_create");
+    lf_enclave_t* enclave = (lf_enclave_t*)calloc(1, sizeof(lf_enclave_t));
+    if (enclave == NULL) {
+        lf_print_error_and_exit("Out of memory creating enclave %s.", name);
+    }
+    enclave->name = name;
+    enclave->id = _lf_instance->number_of_enclaves++;
+    enclave->instance = _lf_instance;
+    enclave->stop_tag = FOREVER_TAG;
+    enclave->handle = 1;
+    enclave->number_of_workers = number_of_workers;
+    lf_mutex_init(&enclave->mutex);
+    lf_mutex_init(&enclave->event_q_mutex);
+    lf_cond_init(&enclave->event_q_changed);
+    _lf_initialize_event_queues(enclave);
+
+    lf_enclave_t* last = &_lf_main_enclave;
+    while (last->next != NULL) {
+        last = last->next;
+    }
+    last->next = enclave;
+    LF_PRINT_LOG("Created enclave %s with id %d.", name, enclave->id);
+    return enclave;
+}
+
+void lf_enclave_connect(lf_enclave_t* upstream, lf_enclave_t* downstream, interval_t delay) {
+    if (delay <= 0LL) {
+        lf_print_error_and_exit("The connection from enclave %s to enclave %s must have a positive delay.",
+                upstream->name, downstream->name);
+    }
+    for (size_t i = 0; i < downstream->number_of_upstream; i++) {
+        if (downstream->upstream[i].upstream == upstream) {
+            // Keep the smallest delay.
+            if (delay < downstream->upstream[i].delay) {
+                downstream->upstream[i].delay = delay;
+            }
+            return;
+        }
+    }
+    lf_enclave_link_t* links = (lf_enclave_link_t*)realloc(downstream->upstream,
+            (downstream->number_of_upstream + 1) * sizeof(lf_enclave_link_t));
+    if (links == NULL) {
+        lf_print_error_and_exit("Out of memory connecting enclave %s to enclave %s.",
+                upstream->name, downstream->name);
+    }
+    links[downstream->number_of_upstream++] = (lf_enclave_link_t) {.upstream = upstream, .delay = delay};
+    downstream->upstream = links;
+}
+
+lf_instance_t* lf_instance_create() {
+    _lf_check_enclaves_supported("lf_instance_create");
+    lf_instance_t* instance = (lf_instance_t*)malloc(sizeof(lf_instance_t));
+    if (instance == NULL) {
+        lf_print_error_and_exit("Out of memory creating an instance.");
+    }
+    *instance = (lf_instance_t) LF_INSTANCE_INITIALIZER(instance);
+    return instance;
+}
+
+void lf_instance_bind(lf_instance_t* instance) {
+    _lf_instance = instance;
+    _lf_enclave = &instance->main_enclave;
+}
+
+void lf_instance_free(lf_instance_t* instance) {
+    if (instance == &_lf_default_instance) {
+        lf_print_error("The default instance cannot be freed.");
+        return;
+    }
+    lf_instance_t* previous_instance = _lf_instance;
+    lf_enclave_t* previous_enclave = _lf_enclave;
+    _lf_instance = instance;
+    _lf_fd_sources_free();
+    lf_enclave_t* enclave = &instance->main_enclave;
+    while (enclave != NULL) {
+        lf_enclave_t* next = enclave->next;
+        _lf_enclave = enclave;
+        if (enclave->event_q != NULL) {
+            _lf_free_event_queues(enclave);
+        }
+        vector_free(&enclave->sparse_io_record_sizes);
+        free(enclave->upstream);
+        free(enclave->affected);
+        free(enclave->earliest_tags);
+        if (enclave != &instance->main_enclave) {
+            free(enclave);
+        }
+        enclave = next;
+    }
+#ifdef LF_STATIC_MEMORY
+    pool_free(&instance->event_pool);
+    pool_free(&instance->token_pool);
+    pool_free(&instance->payload_pool);
+#endif
+    free(instance);
+    _lf_instance = previous_instance;
+    _lf_enclave = previous_enclave;
+}
+
+void _lf_enclave_initialize_coordination() {
+    lf_mutex_init(&_lf_instance->enclave_mutex);
+    for (lf_enclave_t* e = &_lf_main_enclave; e != NULL; e = e->next) {
+        e->next_event_tag = (tag_t) {.time = _lf_instance->start_time, .microstep = 0u};
+        if (e->number_of_upstream > 0) {
+            e->earliest_tags = (tag_t*)calloc(_lf_instance->number_of_enclaves, sizeof(tag_t));
+        }
+    }
+    // Find the enclaves that each enclave affects directly or indirectly by
+    // a breadth-first search along the connections.
+    // The queue has room for the start and for every enclave, which includes
+    // the start again if it is on a cycle.
+    lf_enclave_t** queue = (lf_enclave_t**)calloc(_lf_instance->number_of_enclaves + 1, sizeof(lf_enclave_t*));
+    bool* visited = (bool*)calloc(_lf_instance->number_of_enclaves, sizeof(bool));
+    for (lf_enclave_t* e = &_lf_main_enclave; e != NULL; e = e->next) {
+        memset(visited, 0, _lf_instance->number_of_enclaves * sizeof(bool));
+        size_t head = 0;
+        size_t tail = 0;
+        queue[tail++] = e;
+        while (head < tail) {
+            lf_enclave_t* current = queue[head++];
+            for (lf_enclave_t* d = &_lf_main_enclave; d != NULL; d = d->next) {
+                for (size_t i = 0; i < d->number_of_upstream; i++) {
+                    if (d->upstream[i].upstream == current && !visited[d->id]) {
+                        visited[d->id] = true;
+                        queue[tail++] = d;
+                    }
+                }
+            }
+        }
+        // The queue holds e followed by the enclaves that it affects, which
+        // may include e itself if it is on a cycle.
+        e->number_of_affected = tail - 1;
+        if (e->number_of_affected > 0) {
+            e->affected = (lf_enclave_t**)malloc(e->number_of_affected * sizeof(lf_enclave_t*));
+            memcpy(e->affected, &queue[1], e->number_of_affected * sizeof(lf_enclave_t*));
+        }
+    }
+    free(queue);
+    free(visited);
+}
+
+void _lf_enclave_publish_next_event_tag(tag_t tag) {
+    if (_lf_enclave->number_of_affected == 0) {
+        return;
+    }
+    lf_mutex_lock(&_lf_instance->enclave_mutex);
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
+    _lf_enclave->next_event_tag = tag;
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+    lf_atomic_fetch_add(&_lf_instance->enclave_epoch, 1);
+    lf_mutex_unlock(&_lf_instance->enclave_mutex);
+
+    for (size_t i = 0; i < _lf_enclave->number_of_affected; i++) {
+        lf_enclave_t* affected = _lf_enclave->affected[i];
+        lf_mutex_lock(&affected->event_q_mutex);
+        lf_cond_broadcast(&affected->event_q_changed);
+        lf_mutex_unlock(&affected->event_q_mutex);
+    }
+}
+
+bool _lf_enclave_expects_events() {
+    if (_lf_enclave->number_of_upstream == 0) {
+        return false;
+    }
+    bool used_physical_time;
+    lf_mutex_lock(&_lf_instance->enclave_mutex);
+    tag_t grant = _lf_enclave_compute_grant(&used_physical_time);
+    lf_mutex_unlock(&_lf_instance->enclave_mutex);
+    return lf_tag_compare(grant, FOREVER_TAG) < 0;
+}
+
+bool _lf_enclave_wait_for_grant(tag_t tag) {
+    if (_lf_enclave->number_of_upstream == 0) {
+        return true;
+    }
+    while (true) {
+        bool used_physical_time;
+        lf_mutex_lock(&_lf_instance->enclave_mutex);
+        int epoch = _lf_instance->enclave_epoch;
+        tag_t grant = _lf_enclave_compute_grant(&used_physical_time);
+        lf_mutex_unlock(&_lf_instance->enclave_mutex);
+
+        if (lf_tag_compare(tag, grant) < 0) {
+            return true;
+        }
+        if (lf_tag_compare(grant, FOREVER_TAG) == 0) {
+            // No upstream enclave will send anything and there is nothing to
+            // advance to. With keepalive, wait for physical actions as usual.
+            // Otherwise, let the caller notice that the enclave is starved.
+            return _lf_instance->keepalive_specified;
+        }
+        LF_PRINT_DEBUG("Enclave %s: waiting for a grant greater than " PRINTF_TAG ". The grant is " PRINTF_TAG ".",
+                _lf_enclave->name, tag.time - _lf_instance->start_time, tag.microstep, grant.time - _lf_instance->start_time, grant.microstep);
+
+        lf_mutex_lock(&_lf_enclave->event_q_mutex);
+        if (_lf_enclave_has_earlier_tag(tag)) {
+            lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+            return false;
+        }
+        if (epoch == _lf_instance->enclave_epoch) {
+            // Release the tag lock only while holding the event queue lock so
+            // that a change that is published after the epoch was read is
+            // notified after the wait begins.
+            lf_mutex_unlock(&_lf_enclave->mutex);
+            if (used_physical_time && tag.time > lf_time_physical()) {
+                // An upstream physical action bounds the grant, which grows
+                // with physical time.
+                lf_cond_timedwait(&_lf_enclave->event_q_changed, &_lf_enclave->event_q_mutex, tag.time);
+            } else {
+                lf_cond_wait(&_lf_enclave->event_q_changed, &_lf_enclave->event_q_mutex);
+            }
+            // Respect the lock order when reacquiring the tag lock.
+            lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+            lf_mutex_lock(&_lf_enclave->mutex);
+            lf_mutex_lock(&_lf_enclave->event_q_mutex);
+            if (_lf_enclave_has_earlier_tag(tag)) {
+                lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+                return false;
+            }
+        }
+        lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+    }
+}
+
+void _lf_enclave_request_stop(tag_t tag) {
+    lf_enclave_t* self = _lf_enclave;
+    for (lf_enclave_t* e = &_lf_main_enclave; e != NULL; e = e->next) {
+        if (e == self) {
+            continue;
+        }
+        _lf_enclave = e;
+        lf_mutex_lock(&e->mutex);
+        lf_mutex_lock(&e->event_q_mutex);
+        // An enclave that is already past the tag stops at its next microstep.
+        tag_t stop_tag = tag;
+        if (lf_tag_compare(e->current_tag, stop_tag) >= 0) {
+            stop_tag = (tag_t) {.time = e->current_tag.time, .microstep = e->current_tag.microstep + 1};
+        }
+        _lf_set_stop_tag(stop_tag);
+        lf_atomic_fetch_add(&_lf_instance->enclave_epoch, 1);
+        lf_cond_broadcast(&e->event_q_changed);
+        lf_mutex_unlock(&e->event_q_mutex);
+        lf_mutex_unlock(&e->mutex);
+    }
+    _lf_enclave = self;
+}
+
+/**
+ * Schedule a trigger of the destination enclave, to which the calling thread
+ * has been switched and whose event_q_mutex it holds.
+ * @param source The enclave that schedules the trigger.
+ * @param source_tag The current tag of the source enclave.
+ * @param destination The enclave of the trigger.
+ * @param trigger The trigger.
+ * @param extra_delay The delay in addition to the offset of the trigger.
+ * @param token The token carrying the payload, or NULL.
+ * @return A handle to the event, or 0 if no new event was scheduled, or -1 for error.
+ */
+static trigger_handle_t _lf_enclave_schedule_locked(lf_enclave_t* source, tag_t source_tag,
+        lf_enclave_t* destination, trigger_t* trigger, interval_t extra_delay, lf_token_t* token) {
+    trigger_handle_t result;
+    if (trigger->is_physical) {
+        result = _lf_schedule(trigger, extra_delay, token);
+    } else {
+        if (extra_delay < 0LL) {
+            lf_print_warning("schedule called with a negative extra_delay " PRINTF_TIME ". Replacing with zero.", extra_delay);
+            extra_delay = 0LL;
+        }
+        interval_t delay = trigger->offset + extra_delay;
+        interval_t min_delay = FOREVER;
+        for (size_t i = 0; i < destination->number_of_upstream; i++) {
+            if (destination->upstream[i].upstream == source) {
+                min_delay = destination->upstream[i].delay;
+            }
+        }
+        if (delay < min_delay) {
+            lf_print_error("Enclave %s scheduled an action of enclave %s with delay " PRINTF_TIME
+                    ", but they are not connected with a delay of at most that.",
+                    source->name, destination->name, delay);
+            // As _lf_schedule_at_tag() does, free the token that was given away.
+            _lf_free_unreferenced_token(token);
+            result = -1;
+        } else {
+            result = _lf_schedule_at_tag(trigger, _lf_delay_tag(source_tag, delay), token);
+            if (result > 0) {
+                result = destination->handle++;
+                // Handles are positive, so wrap around to 1.
+                if (destination->handle < 0) {
+                    destination->handle = 1;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+trigger_handle_t _lf_enclave_schedule(lf_enclave_t* destination, trigger_t* trigger, interval_t extra_delay, lf_token_t* token) {
+    tag_t source_tag = _lf_enclave->current_tag;
+    lf_enclave_t* source = _lf_enclave;
+    _lf_enclave = destination;
+    lf_mutex_lock(&destination->event_q_mutex);
+    if (token != NULL && token->ref_count > 0) {
+        // The token is shared with reactors of the source enclave, which
+        // decrement its reference count without holding the locks of the
+        // destination enclave. The copy belongs to the destination.
+        token = _lf_copy_token(token);
+    }
+    trigger_handle_t result = _lf_enclave_schedule_locked(source, source_tag, destination, trigger, extra_delay, token);
+    lf_cond_broadcast(&destination->event_q_changed);
+    lf_mutex_unlock(&destination->event_q_mutex);
+    _lf_enclave = source;
+    return result;
+}
+
+trigger_handle_t _lf_enclave_schedule_value(lf_enclave_t* destination, trigger_t* trigger, interval_t extra_delay,
+        void* value, size_t length, bool copy) {
+    tag_t source_tag = _lf_enclave->current_tag;
+    lf_enclave_t* source = _lf_enclave;
+    _lf_enclave = destination;
+    lf_mutex_lock(&destination->event_q_mutex);
+    lf_token_t* token;
+    if (copy) {
+        if (trigger->token == NULL || trigger->token->element_size <= 0) {
+            lf_mutex_unlock(&destination->event_q_mutex);
+            _lf_enclave = source;
+            lf_print_error("schedule: Invalid trigger or element size.");
+            return -1;
+        }
+        // The token of the trigger belongs to the destination, which may be
+        // using it, so use a fresh one.
+        token = _lf_initialize_token(create_token(trigger->token->element_size), length);
+        memcpy(token->value, value, token->element_size * length);
+    } else {
+        token = create_token(trigger->element_size);
+        token->value = value;
+        token->length = length;
+    }
+    trigger_handle_t result = _lf_enclave_schedule_locked(source, source_tag, destination, trigger, extra_delay, token);
+    lf_cond_broadcast(&destination->event_q_changed);
+    lf_mutex_unlock(&destination->event_q_mutex);
+    _lf_enclave = source;
+    return result;
+}
@@ -0,0 +1,130 @@
+/*************
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************/
+
+/**
+ * @file parallel_for.c
+ * @brief Loops of a reaction that idle workers help to execute.
+ *
+ * A reaction that calls lf_parallel_for() publishes its loop in its enclave
+ * and asks the scheduler to wake up idle workers, which then claim ranges of
+ * iterations along with the calling worker until none are left. The calling
+ * worker then withdraws the loop and waits for the helpers to finish the
+ * ranges that they have claimed.
+ *
+ * A helper registers in the parallel_helpers count of the enclave before it
+ * looks at the loop, and deregisters when it is done with it. Since the
+ * calling worker withdraws the loop before it waits for that count to drop to
+ * zero, a helper that registers too late finds no loop, and no helper can
+ * touch the loop, which is on the stack of the calling worker, once
+ * lf_parallel_for() has returned.
+ */
+
+#include "enclave.h"
+#include "platform.h"
+#include "reactor.h"
+#include "scheduler.h"
+#include "util.h"
+
+/**
+ * When the caller does not choose the grain, the iterations are split into
+ * this many ranges per worker, so that a worker that is slower, or starts
+ * later, than the others does not delay the end of the loop by much.
+ */
+#define LF_PARALLEL_FOR_RANGES_PER_WORKER 8
+
+/**
+ * A loop given to lf_parallel_for().
+ */
+typedef struct _lf_parallel_loop_t {
+    lf_parallel_for_body_t body;
+    void* arg;
+    size_t end;
+    size_t grain;
+    volatile size_t next;                  // The first iteration that has not been claimed.
+} _lf_parallel_loop_t;
+
+/**
+ * Whether the calling thread is executing the body of a loop. A loop that the
+ * body starts is executed inline, even once the outer loop has been withdrawn,
+ * since a helper that shared it would wait for itself to deregister.
+ */
+static LF_THREAD_LOCAL bool _lf_parallel_loop_nested = false;
+
+/**
+ * Claim and execute ranges of iterations of a loop until none are left.
+ */
+static void _lf_parallel_loop_run(_lf_parallel_loop_t* loop) {
+    size_t begin;
+    bool nested = _lf_parallel_loop_nested;
+    _lf_parallel_loop_nested = true;
+    while ((begin = lf_atomic_fetch_add(&loop->next, loop->grain)) < loop->end) {
+        size_t end = (loop->end - begin > loop->grain) ? begin + loop->grain : loop->end;
+        loop->body(begin, end, loop->arg);
+    }
+    _lf_parallel_loop_nested = nested;
+}
+
+void lf_parallel_for(size_t start, size_t end, size_t grain, lf_parallel_for_body_t body, void* arg) {
+    if (start >= end) {
+        return;
+    }
+    if (grain == 0) {
+        grain = (end - start) / (LF_PARALLEL_FOR_RANGES_PER_WORKER * _lf_enclave->number_of_workers);
+        if (grain == 0) {
+            grain = 1;
+        }
+    }
+    _lf_parallel_loop_t loop = {.body = body, .arg = arg, .end = end, .grain = grain, .next = start};
+    size_t ranges = (end - start - 1) / grain + 1;
+    if (ranges == 1 || _lf_parallel_loop_nested
+            || !lf_bool_compare_and_swap(&_lf_enclave->parallel_loop, NULL, &loop)) {
+        // There is nothing to share, this loop is nested in another, or
+        // another loop is being shared.
+        _lf_parallel_loop_run(&loop);
+        return;
+    }
+    size_t helpers = lf_sched_wake_idle_workers(ranges - 1);
+    LF_PRINT_DEBUG("Sharing a loop of %zu ranges with %zu idle workers.", ranges, helpers);
+    _lf_parallel_loop_run(&loop);
+
+    lf_bool_compare_and_swap(&_lf_enclave->parallel_loop, &loop, NULL);
+    int32_t remaining;
+    while ((remaining = _lf_enclave->parallel_helpers) != 0) {
+        lf_futex_wait(&_lf_enclave->parallel_helpers, remaining);
+    }
+}
+
+void _lf_parallel_for_help() {
+    if (_lf_enclave->parallel_loop == NULL) {
+        return;
+    }
+    lf_atomic_fetch_add(&_lf_enclave->parallel_helpers, 1);
+    _lf_parallel_loop_t* loop = (_lf_parallel_loop_t*)_lf_enclave->parallel_loop;
+    if (loop != NULL) {
+        _lf_parallel_loop_run(loop);
+    }
+    if (lf_atomic_add_fetch(&_lf_enclave->parallel_helpers, -1) == 0) {
+        lf_futex_wake(&_lf_enclave->parallel_helpers);
+    }
+}
@@ -38,6 +38,7 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <signal.h>
 #include <string.h>
 
+#include "enclave.h"
 #include "lf_types.h"
 #include "platform.h"
 #include "reactor_common.h"
@@ -69,16 +70,35 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  * of tag if
  * 1- Number of requestors is larger than 0
  * 2- Value of horizon is not (FOREVER, 0)
+ *
+ * The barrier is raised and lowered by threads that listen to the network,
+ * which must not have to wait for the tag lock (mutex) to do so. Hence, the
+ * barrier does not use mutex. The requestors count is read without any lock
+ * and doubles as the futex word on which the thread that advances the tag
+ * blocks. The horizon is a (time, microstep) pair, which is too wide to be
+ * updated with a single atomic instruction, so it and the count are only
+ * updated while holding a spinlock private to the barrier. Critical sections
+ * under the spinlock are a handful of instructions and never block.
+ *
+ * Raising the barrier must not race with advancing the tag: the horizon
+ * depends on the current tag, and the tag may only advance if it does not
+ * reach the horizon. Hence, the thread that advances the tag checks the
+ * barrier and records the tag it advances to in one critical section, and
+ * raising the barrier takes that tag as the current tag.
  */
 typedef struct _lf_tag_advancement_barrier {
-    int requestors; // Used to indicate the number of
-                    // requestors that have asked
-                    // for a barrier to be raised
-                    // on tag.
-    tag_t horizon;  // If semaphore is larger than 0
-                    // then the runtime should not
-                    // advance its tag beyond the
-                    // horizon.
+    volatile int32_t requestors; // Used to indicate the number of
+                                 // requestors that have asked
+                                 // for a barrier to be raised
+                                 // on tag.
+    tag_t horizon;               // If semaphore is larger than 0
+                                 // then the runtime should not
+                                 // advance its tag beyond the
+                                 // horizon.
+    tag_t passed_tag;            // The latest tag that the barrier has
+                                 // let the current tag advance to.
+    volatile int lock;           // Spinlock that serializes updates of
+                                 // requestors, horizon, and passed_tag.
 } _lf_tag_advancement_barrier;
 
 
@@ -86,16 +106,114 @@ typedef struct _lf_tag_advancement_barrier {
  * Create a global tag barrier and
  * initialize the barrier's semaphore to 0 and its horizon to FOREVER_TAG.
  */
-_lf_tag_advancement_barrier _lf_global_tag_advancement_barrier = {0, FOREVER_TAG_INITIALIZER};
+_lf_tag_advancement_barrier _lf_global_tag_advancement_barrier = {0, FOREVER_TAG_INITIALIZER, NEVER_TAG_INITIALIZER, 0};
 
-// The one and only global mutex lock.
-lf_mutex_t mutex;
+/**
+ * Acquire the spinlock of the global tag barrier.
+ */
+static void _lf_lock_global_tag_barrier() {
+    while (!lf_bool_compare_and_swap(&_lf_global_tag_advancement_barrier.lock, 0, 1)) {
+        while (_lf_global_tag_advancement_barrier.lock != 0);
+    }
+}
 
-// Condition variables used for notification between threads.
-lf_cond_t event_q_changed;
-// A condition variable that notifies threads whenever the number
-// of requestors on the tag barrier reaches zero.
-lf_cond_t global_tag_barrier_requestors_reached_zero;
+/**
+ * Release the spinlock of the global tag barrier.
+ */
+static void _lf_unlock_global_tag_barrier() {
+    lf_bool_compare_and_swap(&_lf_global_tag_advancement_barrier.lock, 1, 0);
+}
+
+#ifdef LF_LOCK_PROFILING
+// Maximum number of distinct call sites of lf_mutex_lock() that are profiled.
+#define LOCK_PROFILE_SITES 256
+
+/**
+ * Lock acquisition statistics for one call site of lf_mutex_lock().
+ * An entry is claimed by setting file and then line, so an entry with
+ * a file but no line yet is in the process of being claimed.
+ */
+typedef struct lock_profile_site_t {
+    const char* volatile file;
+    volatile int line;
+    size_t count;
+    interval_t total_wait;
+    interval_t max_wait;
+} lock_profile_site_t;
+
+static lock_profile_site_t _lf_lock_profile[LOCK_PROFILE_SITES];
+
+/**
+ * Return the entry for the given call site, claiming a free one if this is
+ * the first time the site acquires a lock. Return NULL if the table is full.
+ */
+static lock_profile_site_t* _lf_lock_profile_site(const char* file, int line) {
+    size_t start = ((size_t)file + (size_t)line * 31) % LOCK_PROFILE_SITES;
+    for (size_t i = 0; i < LOCK_PROFILE_SITES; i++) {
+        lock_profile_site_t* site = &_lf_lock_profile[(start + i) % LOCK_PROFILE_SITES];
+        if (site->file == NULL && lf_bool_compare_and_swap(&site->file, NULL, file)) {
+            lf_bool_compare_and_swap(&site->line, 0, line);
+            return site;
+        }
+        while (site->line == 0);  // Another thread is claiming this entry.
+        if (site->line == line && (site->file == file || strcmp(site->file, file) == 0)) {
+            return site;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Acquire the mutex and record how long the call site waited for it.
+ * In the lock profiling build mode, platform.h replaces every call to
+ * lf_mutex_lock() with a call to this function.
+ */
+int _lf_mutex_lock_profiled(lf_mutex_t* mutex, const char* file, int line) {
+    instant_t before, after;
+    lf_clock_gettime(&before);
+    int result = (lf_mutex_lock)(mutex);
+    lf_clock_gettime(&after);
+    lock_profile_site_t* site = _lf_lock_profile_site(file, line);
+    if (site != NULL) {
+        interval_t wait = after - before;
+        lf_atomic_fetch_add(&site->count, 1);
+        lf_atomic_fetch_add(&site->total_wait, wait);
+        interval_t max = site->max_wait;
+        while (wait > max && !lf_bool_compare_and_swap(&site->max_wait, max, wait)) {
+            max = site->max_wait;
+        }
+    }
+    return result;
+}
+
+/** Order lock profile entries by decreasing total wait time. */
+static int _lf_compare_lock_profile_sites(const void* a, const void* b) {
+    interval_t wait_a = ((const lock_profile_site_t*)a)->total_wait;
+    interval_t wait_b = ((const lock_profile_site_t*)b)->total_wait;
+    return (wait_a < wait_b) - (wait_a > wait_b);
+}
+
+/**
+ * Print the lock wait statistics of every call site that acquired a lock,
+ * the sites with the most total wait time first.
+ */
+static void _lf_print_lock_profile() {
+    lock_profile_site_t sites[LOCK_PROFILE_SITES];
+    size_t number_of_sites = 0;
+    for (size_t i = 0; i < LOCK_PROFILE_SITES; i++) {
+        if (_lf_lock_profile[i].line != 0) {
+            sites[number_of_sites++] = _lf_lock_profile[i];
+        }
+    }
+    qsort(sites, number_of_sites, sizeof(lock_profile_site_t), _lf_compare_lock_profile_sites);
+    lf_print("---- Lock wait time by call site (count, total ns, mean ns, max ns):");
+    for (size_t i = 0; i < number_of_sites; i++) {
+        lf_print("%s:%d: %zu " PRINTF_TIME " " PRINTF_TIME " " PRINTF_TIME,
+                sites[i].file, sites[i].line, sites[i].count, sites[i].total_wait,
+                sites[i].total_wait / (interval_t)sites[i].count, sites[i].max_wait);
+    }
+}
+#endif // LF_LOCK_PROFILING
 
 /**
  * Raise a barrier to prevent the current tag from advancing to or
@@ -104,7 +222,7 @@ lf_cond_t global_tag_barrier_requestors_reached_zero;
  * prevent any further advances. This function will increment the
  * total number of pending barrier requests. For each call to this
  * function, there should always be a subsequent call to
- * _lf_decrement_global_tag_barrier_locked()
+ * _lf_lower_global_tag_barrier()
  * to release the barrier.
  *
  * If there is already a barrier raised at a tag later than future_tag, this
@@ -114,8 +232,8 @@ lf_cond_t global_tag_barrier_requestors_reached_zero;
  * no existing barriers and future_tag is in the past relative to the
  * current tag, this function will raise a barrier to the current tag.
  *
- * This function assumes the mutex lock is already held, thus, it will not
- * acquire it itself.
+ * The barrier has its own lock, so the caller may or may not hold the
+ * mutex.
  *
  * @note This function is only useful in threaded applications to facilitate
  *  certain non-blocking functionalities such as receiving timed messages
@@ -126,17 +244,25 @@ lf_cond_t global_tag_barrier_requestors_reached_zero;
  * If future_tag is in the past (or equals to current logical time), the runtime
  * will freeze advancement of logical time.
  */
-void _lf_increment_global_tag_barrier_already_locked(tag_t future_tag) {
+void _lf_raise_global_tag_barrier(tag_t future_tag) {
     // Check if future_tag is after stop tag.
     // This will only occur when a federate receives a timed message with
     // a tag that is after the stop tag
     if (_lf_is_tag_after_stop_tag(future_tag)) {
         lf_print_warning("Attempting to raise a barrier after the stop tag.");
-        future_tag = stop_tag;
+        future_tag = _lf_enclave->stop_tag;
     }
-    tag_t current_tag = lf_tag();
+    // The caller need not hold mutex, so the tag may advance concurrently.
+    // Count the request and read the tag in the same critical section in
+    // which _lf_pass_global_tag_barrier() checks the barrier and records the
+    // tag it lets the current tag advance to. Either the tag has been passed
+    // before and is read here, or the barrier is checked after the horizon
+    // has been set.
+    _lf_lock_global_tag_barrier();
+    lf_atomic_fetch_add(&_lf_global_tag_advancement_barrier.requestors, 1);
+    tag_t current_logical_tag = _lf_global_tag_advancement_barrier.passed_tag;
     // Check to see if future_tag is actually in the future.
-    if (lf_tag_compare(future_tag, current_tag) > 0) {
+    if (lf_tag_compare(future_tag, current_logical_tag) > 0) {
         // Future tag is actually in the future.
         // See whether it is smaller than any pre-existing barrier.
         if (lf_tag_compare(future_tag, _lf_global_tag_advancement_barrier.horizon) < 0) {
@@ -144,9 +270,6 @@ void _lf_increment_global_tag_barrier_already_locked(tag_t future_tag) {
             // Therefore, we should prevent logical time from reaching the
             // future tag.
             _lf_global_tag_advancement_barrier.horizon = future_tag;
-            LF_PRINT_DEBUG("Raised barrier at elapsed tag " PRINTF_TAG ".",
-                        _lf_global_tag_advancement_barrier.horizon.time - start_time,
-                        _lf_global_tag_advancement_barrier.horizon.microstep);
         }
     } else {
             // The future_tag is not in the future.
@@ -158,48 +281,15 @@ void _lf_increment_global_tag_barrier_already_locked(tag_t future_tag) {
             // Prevent logical time from advancing further so that the measure of
             // STP violation properly reflects the amount of time (logical or physical)
             // that has elapsed after the incoming message would have violated the STP offset.
-            _lf_global_tag_advancement_barrier.horizon = current_tag;
-            _lf_global_tag_advancement_barrier.horizon.microstep++;
-            LF_PRINT_DEBUG("Raised barrier at elapsed tag " PRINTF_TAG ".",
-                        _lf_global_tag_advancement_barrier.horizon.time - start_time,
-                        _lf_global_tag_advancement_barrier.horizon.microstep);
+            current_logical_tag.microstep++;
+            if (lf_tag_compare(current_logical_tag, _lf_global_tag_advancement_barrier.horizon) < 0) {
+                _lf_global_tag_advancement_barrier.horizon = current_logical_tag;
+            }
     }
-    // Increment the number of requestors
-    _lf_global_tag_advancement_barrier.requestors++;
-}
-
-/**
- * Raise a barrier to prevent the current tag from advancing to or
- * beyond the value of the future_tag argument, if possible.
- * If the current tag is already at or beyond future_tag, then
- * prevent any further advances. This function will increment the
- * total number of pending barrier requests. For each call to this
- * function, there should always be a subsequent call to
- * _lf_decrement_global_tag_barrier_locked()
- * to release the barrier.
- *
- * If there is already a barrier raised at a tag later than future_tag, this
- * function will change the barrier to future_tag or the current tag, whichever
- * is larger. If the existing barrier is earlier
- * than future_tag, this function will not change the barrier. If there are
- * no existing barriers and future_tag is in the past relative to the
- * current tag, this function will raise a barrier to the current tag.
- *
- * This function acquires the mutex lock .
- *
- * @note This function is only useful in threaded applications to facilitate
- *  certain non-blocking functionalities such as receiving timed messages
- *  over the network or handling stop in a federated execution.
- *
- * @param future_tag A desired tag for the barrier. This function will guarantee
- * that current tag will not go past future_tag if it is in the future.
- * If future_tag is in the past (or equals to current tag), the runtime
- * will freeze advancement of tag.
- */
-void _lf_increment_global_tag_barrier(tag_t future_tag) {
-    lf_mutex_lock(&mutex);
-    _lf_increment_global_tag_barrier_already_locked(future_tag);
-    lf_mutex_unlock(&mutex);
+    tag_t horizon = _lf_global_tag_advancement_barrier.horizon;
+    _lf_unlock_global_tag_barrier();
+    LF_PRINT_DEBUG("Raised barrier at elapsed tag " PRINTF_TAG ".",
+                horizon.time - _lf_instance->start_time, horizon.microstep);
 }
 
 /**
@@ -208,35 +298,35 @@ void _lf_increment_global_tag_barrier(tag_t future_tag) {
  * tag barrier to FOREVER_TAG and notifies all threads that are waiting
  * on the barrier that the number of requests has reached zero.
  *
- * This function assumes that the caller already holds the mutex lock.
- *
  * @note This function is only useful in threaded applications to facilitate
  *  certain non-blocking functionalities such as receiving timed messages
  *  over the network or handling stop in the federated execution.
  */
-void _lf_decrement_global_tag_barrier_locked() {
+void _lf_lower_global_tag_barrier() {
+    _lf_lock_global_tag_barrier();
     // Decrement the number of requestors for the tag barrier.
-    _lf_global_tag_advancement_barrier.requestors--;
-    // Check to see if the semaphore is negative, which indicates that
-    // a mismatched call was placed for this function.
-    if (_lf_global_tag_advancement_barrier.requestors < 0) {
-        lf_print_error_and_exit("Mismatched use of _lf_increment_global_tag_barrier()"
-                " and  _lf_decrement_global_tag_barrier_locked().");
-    } else if (_lf_global_tag_advancement_barrier.requestors == 0) {
+    int32_t requestors = lf_atomic_add_fetch(&_lf_global_tag_advancement_barrier.requestors, -1);
+    if (requestors == 0) {
         // When the semaphore reaches zero, reset the horizon to forever.
         _lf_global_tag_advancement_barrier.horizon = FOREVER_TAG;
-        // Notify waiting threads that the semaphore has reached zero.
-        lf_cond_broadcast(&global_tag_barrier_requestors_reached_zero);
     }
-    LF_PRINT_DEBUG("Barrier is at tag " PRINTF_TAG ".",
-                 _lf_global_tag_advancement_barrier.horizon.time,
-                 _lf_global_tag_advancement_barrier.horizon.microstep);
+    tag_t horizon = _lf_global_tag_advancement_barrier.horizon;
+    _lf_unlock_global_tag_barrier();
+    // Check to see if the semaphore is negative, which indicates that
+    // a mismatched call was placed for this function.
+    if (requestors < 0) {
+        lf_print_error_and_exit("Mismatched use of _lf_raise_global_tag_barrier()"
+                " and  _lf_lower_global_tag_barrier().");
+    } else if (requestors == 0) {
+        // Notify the waiting thread, if any, that the semaphore has reached zero.
+        lf_futex_wake(&_lf_global_tag_advancement_barrier.requestors);
+    }
+    LF_PRINT_DEBUG("Barrier is at tag " PRINTF_TAG ".", horizon.time, horizon.microstep);
 }
 
 /**
  * If the proposed_tag is greater than or equal to a barrier tag that has been
- * set by a call to _lf_increment_global_tag_barrier or
- * _lf_increment_global_tag_barrier_already_locked, and if there are requestors
+ * set by a call to _lf_raise_global_tag_barrier, and if there are requestors
  * still pending on that barrier, then wait until all requestors have been
  * satisfied. This is used in federated execution when an incoming timed
  * message has been partially read so that we know its tag, but the rest of
@@ -248,8 +338,9 @@ void _lf_decrement_global_tag_barrier_locked() {
  * If the proposed_tag is greater than the stop tag, then use the stop tag instead.
  *
  * This function assumes the mutex is already locked.
- * Thus, it unlocks the mutex while it's waiting to allow
- * the tag barrier to change.
+ * It unlocks the mutex while it's blocked (on a futex, not on a condition
+ * variable) so that the threads that lower the barrier can finish handling
+ * their messages.
  *
  * @param proposed_tag The tag that the runtime wants to advance to.
  * @return 0 if no wait was needed and 1 if a wait actually occurred.
@@ -260,7 +351,7 @@ int _lf_wait_on_global_tag_barrier(tag_t proposed_tag) {
 
     // Do not wait for tags after the stop tag
     if (_lf_is_tag_after_stop_tag(proposed_tag)) {
-        proposed_tag = stop_tag;
+        proposed_tag = _lf_enclave->stop_tag;
     }
     // Do not wait forever
     if (proposed_tag.time == FOREVER) {
@@ -270,22 +361,56 @@ int _lf_wait_on_global_tag_barrier(tag_t proposed_tag) {
     int result = 0;
     // Wait until the global barrier semaphore on logical time is zero
     // and the proposed_time is larger than or equal to the horizon.
-    while (_lf_global_tag_advancement_barrier.requestors > 0
-            && lf_tag_compare(proposed_tag, _lf_global_tag_advancement_barrier.horizon) >= 0
-    ) {
+    while (true) {
+        int32_t requestors = _lf_global_tag_advancement_barrier.requestors;
+        if (requestors <= 0) break;
+        _lf_lock_global_tag_barrier();
+        tag_t horizon = _lf_global_tag_advancement_barrier.horizon;
+        _lf_unlock_global_tag_barrier();
+        if (lf_tag_compare(proposed_tag, horizon) < 0) break;
+
         result = 1;
-        LF_PRINT_LOG("Waiting on barrier for tag " PRINTF_TAG ".", proposed_tag.time - start_time, proposed_tag.microstep);
-        // Wait until no requestor remains for the barrier on logical time
-        lf_cond_wait(&global_tag_barrier_requestors_reached_zero, &mutex);
+        LF_PRINT_LOG("Waiting on barrier for tag " PRINTF_TAG ".", proposed_tag.time - _lf_instance->start_time, proposed_tag.microstep);
+        // Wait until the number of requestors changes. The thread that
+        // lowers the barrier may need mutex to finish handling its message,
+        // so release it while blocked.
+        lf_mutex_unlock(&_lf_enclave->mutex);
+        lf_futex_wait(&_lf_global_tag_advancement_barrier.requestors, requestors);
+        lf_mutex_lock(&_lf_enclave->mutex);
 
         // The stop tag may have changed during the wait.
         if (_lf_is_tag_after_stop_tag(proposed_tag)) {
-            proposed_tag = stop_tag;
+            proposed_tag = _lf_enclave->stop_tag;
         }
     }
     return result;
 }
 
+/**
+ * Check whether the global tag barrier lets the current tag advance to the
+ * proposed tag and, if so, record the proposed tag as the current tag for the
+ * purpose of raising the barrier. The barrier may have been raised since
+ * _lf_wait_on_global_tag_barrier() returned, and it is only raised
+ * consistently with the tag that this records. Hence, the current tag may
+ * only advance to proposed_tag if this returns true.
+ *
+ * @param proposed_tag The tag that the runtime wants to advance to.
+ * @return true if the current tag may advance to proposed_tag, and false if
+ *  the barrier is at or before it.
+ */
+bool _lf_pass_global_tag_barrier(tag_t proposed_tag) {
+    _lf_lock_global_tag_barrier();
+    // As in _lf_wait_on_global_tag_barrier(), FOREVER is never held back.
+    bool passed = _lf_global_tag_advancement_barrier.requestors <= 0
+            || proposed_tag.time == FOREVER
+            || lf_tag_compare(proposed_tag, _lf_global_tag_advancement_barrier.horizon) < 0;
+    if (passed) {
+        _lf_global_tag_advancement_barrier.passed_tag = proposed_tag;
+    }
+    _lf_unlock_global_tag_barrier();
+    return passed;
+}
+
 /**
  * Schedule the specified trigger at current_tag.time plus the offset of the
  * specified trigger plus the delay.
@@ -293,11 +418,15 @@ int _lf_wait_on_global_tag_barrier(tag_t proposed_tag) {
  */
 trigger_handle_t _lf_schedule_token(void* action, interval_t extra_delay, lf_token_t* token) {
     trigger_t* trigger = _lf_action_to_trigger(action);
-    lf_mutex_lock(&mutex);
+    lf_enclave_t* destination = lf_enclave_of_trigger(trigger);
+    if (destination != _lf_enclave) {
+        return _lf_enclave_schedule(destination, trigger, extra_delay, token);
+    }
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
     int return_value = _lf_schedule(trigger, extra_delay, token);
     // Notify the main thread in case it is waiting for physical time to elapse.
-    lf_cond_broadcast(&event_q_changed);
-    lf_mutex_unlock(&mutex);
+    lf_cond_broadcast(&_lf_enclave->event_q_changed);
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
     return return_value;
 }
 
@@ -311,12 +440,18 @@ trigger_handle_t _lf_schedule_copy(void* action, interval_t offset, void* value,
         return _lf_schedule_token(action, offset, NULL);
     }
     trigger_t* trigger = _lf_action_to_trigger(action);
+    lf_enclave_t* destination = lf_enclave_of_trigger(trigger);
+    if (trigger != NULL && destination != _lf_enclave) {
+        // The token of the trigger belongs to the destination, so it is
+        // checked under the lock of the destination.
+        return _lf_enclave_schedule_value(destination, trigger, offset, value, length, true);
+    }
 
     if (trigger == NULL || trigger->token == NULL || trigger->token->element_size <= 0) {
         lf_print_error("schedule: Invalid trigger or element size.");
         return -1;
     }
-    lf_mutex_lock(&mutex);
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
     // Initialize token with an array size of length and a reference count of 0.
     lf_token_t* token = _lf_initialize_token(trigger->token, length);
     // Copy the value into the newly allocated memory.
@@ -324,8 +459,8 @@ trigger_handle_t _lf_schedule_copy(void* action, interval_t offset, void* value,
     // The schedule function will increment the reference count.
     trigger_handle_t result = _lf_schedule(trigger, offset, token);
     // Notify the main thread in case it is waiting for physical time to elapse.
-    lf_cond_signal(&event_q_changed);
-    lf_mutex_unlock(&mutex);
+    lf_cond_signal(&_lf_enclave->event_q_changed);
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
     return result;
 }
 
@@ -335,15 +470,19 @@ trigger_handle_t _lf_schedule_copy(void* action, interval_t offset, void* value,
  */
 trigger_handle_t _lf_schedule_value(void* action, interval_t extra_delay, void* value, size_t length) {
     trigger_t* trigger = _lf_action_to_trigger(action);
+    lf_enclave_t* destination = lf_enclave_of_trigger(trigger);
+    if (destination != _lf_enclave) {
+        return _lf_enclave_schedule_value(destination, trigger, extra_delay, value, length, false);
+    }
 
-    lf_mutex_lock(&mutex);
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
     lf_token_t* token = create_token(trigger->element_size);
     token->value = value;
     token->length = length;
     int return_value = _lf_schedule(trigger, extra_delay, token);
     // Notify the main thread in case it is waiting for physical time to elapse.
-    lf_cond_signal(&event_q_changed);
-    lf_mutex_unlock(&mutex);
+    lf_cond_signal(&_lf_enclave->event_q_changed);
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
     return return_value;
 }
 
@@ -391,6 +530,48 @@ void _lf_set_present(lf_port_base_t* port) {
  */
 void synchronize_with_other_federates();
 
+/**
+ * Wait for a notification on event_q_changed or, unless wakeup_time is
+ * FOREVER, until the platform clock reaches wakeup_time (which is not
+ * adjusted by clock synchronization).
+ *
+ * Because schedulers only acquire event_q_mutex, a notification may have
+ * been sent between the caller's last look at the event queue and the
+ * start of this wait. Therefore, if the event queue now has an event with
+ * a tag earlier than expected_tag or the stop tag is earlier than
+ * expected_tag, this returns immediately as if the wait had been interrupted.
+ *
+ * The caller must hold the mutex exactly once and must not hold
+ * event_q_mutex. The mutex is released during the wait, so anything that
+ * it protects may have changed when this returns.
+ *
+ * @param expected_tag The earliest tag that the caller expects to process next.
+ * @param wakeup_time The time at which to stop waiting, or FOREVER.
+ * @return LF_TIMEOUT if the wait timed out and 0 otherwise.
+ */
+int _lf_wait_on_event_q_changed(tag_t expected_tag, instant_t wakeup_time) {
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
+    event_t* head = (event_t*)pqueue_peek(_lf_enclave->event_q);
+    if ((head != NULL && lf_tag_compare(head->tag, expected_tag) < 0)
+            || lf_tag_compare(_lf_enclave->stop_tag, expected_tag) < 0) {
+        lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+        return 0;
+    }
+    // Release the tag lock only while holding the event queue lock so that
+    // any change made under the tag lock is notified after the wait begins.
+    lf_mutex_unlock(&_lf_enclave->mutex);
+    int result;
+    if (wakeup_time == FOREVER) {
+        result = lf_cond_wait(&_lf_enclave->event_q_changed, &_lf_enclave->event_q_mutex);
+    } else {
+        result = lf_cond_timedwait(&_lf_enclave->event_q_changed, &_lf_enclave->event_q_mutex, wakeup_time);
+    }
+    // Respect the lock order when reacquiring the tag lock.
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+    lf_mutex_lock(&_lf_enclave->mutex);
+    return result;
+}
+
 /**
  * Wait until physical time matches or exceeds the specified logical time,
  * unless -fast is given.
@@ -402,7 +583,12 @@ void synchronize_with_other_federates();
  * The mutex lock is assumed to be held by the calling thread.
  * Note this this could return true even if the a new event
  * was placed on the queue if that event time matches or exceeds
- * the specified time.
+ * the specified time. If the condition is event_q_changed, the wait
+ * is done with _lf_wait_on_event_q_changed().
+ *
+ * If a spin margin has been given with --spin-margin, then the wait
+ * sleeps only until that margin before the specified time and spins
+ * on the physical clock with the mutex held for the rest of the wait.
  *
  * @param logical_time_ns Logical time to wait until physical time matches it.
  * @param return_if_interrupted If this is false, then wait_util will wait
@@ -426,11 +612,11 @@ bool wait_until(instant_t logical_time_ns, lf_cond_t* condition) {
         // If wait_time is not forever
         LF_PRINT_DEBUG("Adding STA " PRINTF_TIME " to wait until time " PRINTF_TIME ".",
                 _lf_fed_STA_offset,
-                wait_until_time_ns - start_time);
+                wait_until_time_ns - _lf_instance->start_time);
         wait_until_time_ns += _lf_fed_STA_offset;
     }
 #endif
-    if (!fast) {
+    if (!_lf_instance->fast) {
         // Get physical time as adjusted by clock synchronization offset.
         instant_t current_physical_time = lf_time_physical();
         // We want to wait until that adjusted time matches the logical time.
@@ -443,55 +629,71 @@ bool wait_until(instant_t logical_time_ns, lf_cond_t* condition) {
             return return_value;
         }
 
-        // We will use lf_cond_timedwait, which takes as an argument the absolute
-        // time to wait until. However, that will not include the offset that we
-        // have calculated with clock synchronization. So we need to instead ensure
-        // that the time it waits is ns_to_wait.
-        // We need the current clock value as obtained using CLOCK_REALTIME because
-        // that is what lf_cond_timedwait will use.
-        // The above call to setPhysicalTime() set the
-        // _lf_last_reported_unadjusted_physical_time_ns to the CLOCK_REALTIME value
-        // unadjusted by clock synchronization.
-        // Note that if ns_to_wait is large enough, then the following addition could
-        // overflow. This could happen, for example, if wait_until_time_ns == FOREVER.
-        instant_t unadjusted_wait_until_time_ns = FOREVER;
-        if (FOREVER - _lf_last_reported_unadjusted_physical_time_ns > ns_to_wait) {
-            unadjusted_wait_until_time_ns = _lf_last_reported_unadjusted_physical_time_ns + ns_to_wait;
-        }
-        LF_PRINT_DEBUG("-------- Clock offset is " PRINTF_TIME " ns.", current_physical_time - _lf_last_reported_unadjusted_physical_time_ns);
-        LF_PRINT_DEBUG("-------- Waiting " PRINTF_TIME " ns for physical time to match logical time " PRINTF_TIME ".",
-        		ns_to_wait,
-                logical_time_ns - start_time);
-
-        // lf_cond_timedwait returns 0 if it is awakened before the timeout.
-        // Hence, we want to run it repeatedly until either it returns non-zero or the
-        // current physical time matches or exceeds the logical time.
-        if (lf_cond_timedwait(condition, &mutex, unadjusted_wait_until_time_ns) != LF_TIMEOUT) {
-            LF_PRINT_DEBUG("-------- wait_until interrupted before timeout.");
-
-            // Wait did not time out, which means that there
-            // may have been an asynchronous call to lf_schedule().
-            // Continue waiting.
-            // Do not adjust current_tag.time here. If there was an asynchronous
-            // call to lf_schedule(), it will have put an event on the event queue,
-            // and current_tag.time will be set to that time when that event is pulled.
-            return_value = false;
-        } else {
+        // In precision mode, stop sleeping _lf_spin_margin before the target time
+        // and spin for the rest of the wait below.
+        if (ns_to_wait > _lf_spin_margin) {
+            interval_t ns_to_sleep = ns_to_wait - _lf_spin_margin;
+
+            // We will use lf_cond_timedwait, which takes as an argument the absolute
+            // time to wait until. However, that will not include the offset that we
+            // have calculated with clock synchronization. So we need to instead ensure
+            // that the time it waits is ns_to_sleep.
+            // The above call to lf_time_physical() set the
+            // _lf_last_reported_unadjusted_physical_time_ns to the clock value
+            // unadjusted by clock synchronization.
+            // Note that if ns_to_sleep is large enough, then the following addition could
+            // overflow. This could happen, for example, if wait_until_time_ns == FOREVER.
+            instant_t unadjusted_wait_until_time_ns = FOREVER;
+            if (FOREVER - _lf_last_reported_unadjusted_physical_time_ns > ns_to_sleep) {
+                unadjusted_wait_until_time_ns = _lf_last_reported_unadjusted_physical_time_ns + ns_to_sleep;
+            }
+            LF_PRINT_DEBUG("-------- Clock offset is " PRINTF_TIME " ns.", current_physical_time - _lf_last_reported_unadjusted_physical_time_ns);
+            LF_PRINT_DEBUG("-------- Waiting " PRINTF_TIME " ns for physical time to match logical time " PRINTF_TIME ".",
+                    ns_to_wait,
+                    logical_time_ns - _lf_instance->start_time);
+
+            // lf_cond_timedwait returns 0 if it is awakened before the timeout.
+            // Hence, we want to run it repeatedly until either it returns non-zero or the
+            // current physical time matches or exceeds the logical time.
+            int wait_result;
+            if (condition == &_lf_enclave->event_q_changed) {
+                wait_result = _lf_wait_on_event_q_changed(
+                        (tag_t) {.time = logical_time_ns, .microstep = 0},
+                        unadjusted_wait_until_time_ns);
+            } else {
+                wait_result = lf_cond_timedwait(condition, &_lf_enclave->mutex, unadjusted_wait_until_time_ns);
+            }
+            if (wait_result != LF_TIMEOUT) {
+                LF_PRINT_DEBUG("-------- wait_until interrupted before timeout.");
+
+                // Wait did not time out, which means that there
+                // may have been an asynchronous call to lf_schedule().
+                // Continue waiting.
+                // Do not adjust current_tag.time here. If there was an asynchronous
+                // call to lf_schedule(), it will have put an event on the event queue,
+                // and current_tag.time will be set to that time when that event is pulled.
+                return false;
+            }
             // Reached timeout.
             // FIXME: move this to Mac-specific platform implementation
             // Unfortunately, at least on Macs, pthread_cond_timedwait appears
             // to be implemented incorrectly and it returns well short of the target
             // time.  Check for this condition and wait again if necessary.
-            interval_t ns_to_wait = wait_until_time_ns - lf_time_physical();
-            // We should not wait if that adjusted time is already ahead
-            // of logical time.
-            if (ns_to_wait < MIN_WAIT_TIME) {
-                return true;
+            interval_t ns_remaining = wait_until_time_ns - lf_time_physical();
+            if (ns_remaining >= MIN_WAIT_TIME && ns_remaining > _lf_spin_margin) {
+                LF_PRINT_DEBUG("-------- lf_cond_timedwait claims to have timed out, "
+                        "but it did not reach the target time. Waiting again.");
+                return wait_until(wait_until_time_ns, condition);
             }
-            LF_PRINT_DEBUG("-------- lf_cond_timedwait claims to have timed out, "
-                    "but it did not reach the target time. Waiting again.");
-            return wait_until(wait_until_time_ns, condition);
         }
+        if (_lf_spin_margin > 0LL) {
+            // Spin for the rest of the wait. The mutex stays locked, but
+            // lf_schedule() only needs event_q_mutex, so other threads can
+            // still schedule events. The caller looks at the event queue
+            // again after this returns.
+            _lf_spin_until(wait_until_time_ns);
+        }
+        _lf_record_wait_lag(lf_time_physical() - wait_until_time_ns);
 
         LF_PRINT_DEBUG("-------- Returned from wait, having waited " PRINTF_TIME " ns.", lf_time_physical() - current_physical_time);
     }
@@ -502,37 +704,33 @@ bool wait_until(instant_t logical_time_ns, lf_cond_t* condition) {
  * Return the tag of the next event on the event queue.
  * If the event queue is empty then return either FOREVER_TAG
  * or, is a stop_time (timeout time) has been set, the stop time.
+ * This acquires event_q_mutex.
  */
 tag_t get_next_event_tag() {
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
     // Peek at the earliest event in the event queue.
-    event_t* event = (event_t*)pqueue_peek(event_q);
+    event_t* event = (event_t*)pqueue_peek(_lf_enclave->event_q);
     tag_t next_tag = FOREVER_TAG;
     if (event != NULL) {
         // There is an event in the event queue.
-        if (event->time < current_tag.time) {
-            lf_print_error_and_exit("get_next_event_tag(): Earliest event on the event queue (" PRINTF_TIME ") is "
-                                  "earlier than the current time (" PRINTF_TIME ").",
-                                  event->time - start_time,
-                                  current_tag.time - start_time);
+        if (lf_tag_compare(event->tag, _lf_enclave->current_tag) <= 0) {
+            lf_print_error_and_exit("get_next_event_tag(): Earliest event on the event queue " PRINTF_TAG " is "
+                                  "not later than the current tag " PRINTF_TAG ".",
+                                  event->tag.time - _lf_instance->start_time, event->tag.microstep,
+                                  _lf_enclave->current_tag.time - _lf_instance->start_time, _lf_enclave->current_tag.microstep);
         }
 
-        next_tag.time = event->time;
-        if (next_tag.time == current_tag.time) {
-        	LF_PRINT_DEBUG("Earliest event matches current time. Incrementing microstep. Event is dummy: %d.",
-        			event->is_dummy);
-            next_tag.microstep =  lf_tag().microstep + 1;
-        } else {
-            next_tag.microstep = 0;
-        }
+        next_tag = event->tag;
     }
 
     // If a timeout tag was given, adjust the next_tag from the
     // event tag to that timeout tag.
     if (_lf_is_tag_after_stop_tag(next_tag)) {
-        next_tag = stop_tag;
+        next_tag = _lf_enclave->stop_tag;
     }
     LF_PRINT_LOG("Earliest event on the event queue (or stop time if empty) is " PRINTF_TAG ". Event queue has size %zu.",
-            next_tag.time - start_time, next_tag.microstep, pqueue_size(event_q));
+            next_tag.time - _lf_instance->start_time, next_tag.microstep, pqueue_size(_lf_enclave->event_q));
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
     return next_tag;
 }
 
@@ -580,11 +778,14 @@ tag_t send_next_event_tag(tag_t tag, bool wait_for_reply) {
  * equal, shutdown reactions are triggered.
  *
  * This does not acquire the mutex lock. It assumes the lock is already held.
+ * It acquires event_q_mutex whenever it accesses the event queue.
  */
 void _lf_next_locked() {
 #ifdef MODAL_REACTORS
     // Perform mode transitions
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
     _lf_handle_mode_changes();
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
 #endif
 
     // Previous logical time is complete.
@@ -619,24 +820,36 @@ void _lf_next_locked() {
     // behavior with centralized coordination as with unfederated execution.
 
 #else  // not FEDERATED_CENTRALIZED
-    if (pqueue_peek(event_q) == NULL && !keepalive_specified) {
+    // An enclave whose upstream enclaves may still send it events is not starved.
+    bool expects_events = _lf_enclave_expects_events();
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
+    if (pqueue_peek(_lf_enclave->event_q) == NULL && !_lf_instance->keepalive_specified && !expects_events) {
         // There is no event on the event queue and keepalive is false.
         // No event in the queue
         // keepalive is not set so we should stop.
         // Note that federated programs with decentralized coordination always have
         // keepalive = true
-        _lf_set_stop_tag((tag_t){.time=current_tag.time,.microstep=current_tag.microstep+1});
+        _lf_set_stop_tag((tag_t){.time=_lf_enclave->current_tag.time,.microstep=_lf_enclave->current_tag.microstep+1});
 
         // Stop tag has changed. Need to check next_tag again.
         next_tag = get_next_event_tag();
     }
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+
+    // Let downstream enclaves know how far this enclave is, and wait until
+    // upstream enclaves can no longer send events at or before next_tag.
+    _lf_enclave_publish_next_event_tag(next_tag);
+    if (!_lf_enclave_wait_for_grant(next_tag)) {
+        // The event queue or the stop tag has changed.
+        return;
+    }
 #endif
 
     // Wait for physical time to advance to the next event time (or stop time).
     // This can be interrupted if a physical action triggers (e.g., a message
     // arrives from an upstream federate or a local physical action triggers).
-    LF_PRINT_LOG("Waiting until elapsed time " PRINTF_TIME ".", (next_tag.time - start_time));
-    while (!wait_until(next_tag.time, &event_q_changed)) {
+    LF_PRINT_LOG("Waiting until elapsed time " PRINTF_TIME ".", (next_tag.time - _lf_instance->start_time));
+    while (!wait_until(next_tag.time, &_lf_enclave->event_q_changed)) {
         LF_PRINT_DEBUG("_lf_next_locked(): Wait until time interrupted.");
         // Sleep was interrupted.  Check for a new next_event.
         // The interruption could also have been due to a call to lf_request_stop().
@@ -673,35 +886,59 @@ void _lf_next_locked() {
     }
 #endif // FEDERATED
 
+    // Hold the event queue lock from here on so that the events popped below
+    // are exactly those at next_tag. Since the last look at the event queue,
+    // lf_schedule() may have put an event with an earlier tag on it, but
+    // physical time has already passed the time of that tag.
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
+    next_tag = get_next_event_tag();
+
     // If the first event in the event queue has a tag greater than or equal to the
     // stop time, and the current_tag matches the stop tag (meaning that we have already
     // executed microstep 0 at the timeout time), then we are done. The above code prevents the next_tag
     // from exceeding the stop_tag, so we have to do further checks if
     // they are equal.
-    if (lf_tag_compare(next_tag, stop_tag) >= 0 && lf_tag_compare(current_tag, stop_tag) >= 0) {
+    if (lf_tag_compare(next_tag, _lf_enclave->stop_tag) >= 0 && lf_tag_compare(_lf_enclave->current_tag, _lf_enclave->stop_tag) >= 0) {
         // If we pop anything further off the event queue with this same time or larger,
         // then it will be assigned a tag larger than the stop tag.
+        lf_mutex_unlock(&_lf_enclave->event_q_mutex);
         return;
     }
 
+#ifdef FEDERATED
+    // A barrier may have been raised since the wait above. If it holds the
+    // tag back now, wait on it again.
+    if (!_lf_pass_global_tag_barrier(next_tag)) {
+        lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+        return;
+    }
+#endif // FEDERATED
+
     // Invoke code that must execute before starting a new logical time round,
     // such as initializing outputs to be absent.
     _lf_start_time_step();
 
+    // Events that this enclave sends from now on are no earlier than next_tag,
+    // which may be earlier than the tag published above.
+    if (_lf_enclave->number_of_affected > 0) {
+        _lf_enclave->next_event_tag = next_tag;
+    }
+
     // At this point, finally, we have an event to process.
     // Advance current time to match that of the first event on the queue.
-    _lf_advance_logical_time(next_tag.time);
+    _lf_advance_logical_time(next_tag);
 
-    if (lf_tag_compare(current_tag, stop_tag) >= 0) {
+    if (lf_tag_compare(_lf_enclave->current_tag, _lf_enclave->stop_tag) >= 0) {
         // Pop shutdown events
         LF_PRINT_DEBUG("Scheduling shutdown reactions.");
         _lf_trigger_shutdown_reactions();
     }
 
-    // Pop all events from event_q with timestamp equal to current_tag.time,
+    // Pop all events from event_q with tag equal to current_tag,
     // extract all the reactions triggered by these events, and
     // stick them into the reaction queue.
     _lf_pop_events();
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
 }
 
 /**
@@ -713,12 +950,12 @@ void _lf_next_locked() {
  * all federates stop at the same logical time.
  */
 void lf_request_stop() {
-    lf_mutex_lock(&mutex);
+    lf_mutex_lock(&_lf_enclave->mutex);
     // Check if already at the previous stop tag.
-    if (lf_tag_compare(current_tag, stop_tag) >= 0) {
+    if (lf_tag_compare(_lf_enclave->current_tag, _lf_enclave->stop_tag) >= 0) {
         // If so, ignore the stop request since the program
         // is already stopping at the current tag.
-        lf_mutex_unlock(&mutex);
+        lf_mutex_unlock(&_lf_enclave->mutex);
         return;
     }
 #ifdef FEDERATED
@@ -731,13 +968,22 @@ void lf_request_stop() {
     // logical time.
 #else
     // In a non-federated program, the stop_tag will be the next microstep
-    _lf_set_stop_tag((tag_t) {.time = current_tag.time, .microstep = current_tag.microstep+1});
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
+    tag_t stop_tag = (tag_t) {.time = _lf_enclave->current_tag.time, .microstep = _lf_enclave->current_tag.microstep+1};
+    _lf_set_stop_tag(stop_tag);
     // We signal instead of broadcast under the assumption that only
     // one worker thread can call wait_until at a given time because
     // the call to wait_until is protected by a mutex lock
-    lf_cond_signal(&event_q_changed);
+    lf_cond_signal(&_lf_enclave->event_q_changed);
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+#endif
+    lf_mutex_unlock(&_lf_enclave->mutex);
+#ifndef FEDERATED
+    // Stop the other enclaves, if any, at the same tag.
+    if (_lf_main_enclave.next != NULL) {
+        _lf_enclave_request_stop(stop_tag);
+    }
 #endif
-    lf_mutex_unlock(&mutex);
 }
 
 /**
@@ -748,8 +994,14 @@ void lf_request_stop() {
  *  used if there is only one worker (e.g., when the program is using the
  *  unthreaded C runtime). -1 is used for an anonymous call in a context where a
  *  worker number does not make sense (e.g., the caller is not a worker thread).
+ *  A reaction of an enclave other than the one that the calling thread is bound
+ *  to is not triggered. This happens for startup and shutdown reactions, which
+ *  each enclave triggers for itself.
  */
 void _lf_trigger_reaction(reaction_t* reaction, int worker_number) {
+    if (lf_enclave_of((self_base_t*)reaction->self) != _lf_enclave) {
+        return;
+    }
 #ifdef MODAL_REACTORS
         // Check if reaction is disabled by mode inactivity
         if (_lf_mode_is_active(reaction->mode)) {
@@ -783,7 +1035,14 @@ void _lf_initialize_start_tag() {
 
     // Get a start_time from the RTI
     synchronize_with_other_federates(); // Resets start_time in federated execution according to the RTI.
-    current_tag = (tag_t){.time = start_time, .microstep = 0u};
+#endif
+
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
+#ifdef FEDERATED
+    _lf_lock_global_tag_barrier();
+    _lf_enclave->current_tag = (tag_t){.time = _lf_instance->start_time, .microstep = 0u};
+    _lf_global_tag_advancement_barrier.passed_tag = _lf_enclave->current_tag;
+    _lf_unlock_global_tag_barrier();
 #endif
 
     _lf_initialize_timers();
@@ -791,9 +1050,10 @@ void _lf_initialize_start_tag() {
     // If the stop_tag is (0,0), also insert the shutdown
     // reactions. This can only happen if the timeout time
     // was set to 0.
-    if (lf_tag_compare(current_tag, stop_tag) >= 0) {
+    if (lf_tag_compare(_lf_enclave->current_tag, _lf_enclave->stop_tag) >= 0) {
         _lf_trigger_shutdown_reactions();
     }
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
 
 #ifdef FEDERATED
     // Call wait_until if federated. This is required because the startup procedure
@@ -810,22 +1070,22 @@ void _lf_initialize_start_tag() {
     // especially useful if an STA is set properly because the federate will get
     // a chance to process incoming messages while utilizing the STA.
     LF_PRINT_LOG("Waiting for start time " PRINTF_TIME " plus STA " PRINTF_TIME ".",
-            start_time, _lf_fed_STA_offset);
+            _lf_instance->start_time, _lf_fed_STA_offset);
     // Ignore interrupts to this wait. We don't want to start executing until
     // physical time matches or exceeds the logical start time.
-    while (!wait_until(start_time, &event_q_changed)) {}
-    LF_PRINT_DEBUG("Done waiting for start time " PRINTF_TIME ".", start_time);
+    while (!wait_until(_lf_instance->start_time, &_lf_enclave->event_q_changed)) {}
+    LF_PRINT_DEBUG("Done waiting for start time " PRINTF_TIME ".", _lf_instance->start_time);
     LF_PRINT_DEBUG("Physical time is ahead of current time by " PRINTF_TIME ". This should be small.",
-            lf_time_physical() - start_time);
+            lf_time_physical() - _lf_instance->start_time);
 
     // Reinitialize the physical start time to match the start_time.
     // Otherwise, reports of lf_time_physical() are not very meaningful
     // w.r.t. logical time.
-    physical_start_time = start_time;
+    _lf_instance->physical_start_time = _lf_instance->start_time;
 
     // Each federate executes the start tag (which is the current
     // tag). Inform the RTI of this if needed.
-    send_next_event_tag(current_tag, true);
+    send_next_event_tag(_lf_enclave->current_tag, true);
 
     // Depending on RTI's answer, if any, enqueue network control reactions,
     // which will selectively block reactions that depend on network input ports
@@ -842,17 +1102,14 @@ void _lf_initialize_start_tag() {
     // from exceeding the timestamp of the message. It will remove that barrier
     // once the complete message has been read. Here, we wait for that barrier
     // to be removed, if appropriate before proceeding to executing tag (0,0).
-    _lf_wait_on_global_tag_barrier((tag_t){.time=start_time,.microstep=0});
+    _lf_wait_on_global_tag_barrier((tag_t){.time=_lf_instance->start_time,.microstep=0});
 #endif // FEDERATED_DECENTRALIZED
 
     // Set the following boolean so that other thread(s), including federated threads,
     // know that the execution has started
-    _lf_execution_started = true;
+    _lf_instance->execution_started = true;
 }
 
-/** For logging and debugging, each worker thread is numbered. */
-int worker_thread_count = 0;
-
 /**
  * Handle deadline violation for 'reaction'.
  * The mutex should NOT be locked when this function is called. It might acquire
@@ -871,9 +1128,9 @@ bool _lf_worker_handle_deadline_violation_for_reaction(int worker_number, reacti
     // then the reaction will be invoked and the violation reaction will not be invoked again.
     if (reaction->deadline >= 0LL) {
         // Get the current physical time.
-        instant_t physical_time = lf_time_physical();
+        instant_t physical_time = lf_time_physical_fast();
         // Check for deadline violation.
-        if (reaction->deadline == 0 || physical_time > current_tag.time + reaction->deadline) {
+        if (reaction->deadline == 0 || physical_time > _lf_enclave->current_tag.time + reaction->deadline) {
             // Deadline violation has occurred.
             violation_occurred = true;
             // Invoke the local handler, if there is one.
@@ -973,20 +1230,26 @@ bool _lf_worker_handle_violations(int worker_number, reaction_t* reaction) {
  * The mutex should NOT be locked when this function is called. It might acquire
  * the mutex when scheduling the reactions that are triggered as a result of
  * executing 'reaction'.
+ * @return false if the reaction has suspended itself and the worker has let go
+ *  of it, in which case the worker that executes its continuation finishes it.
  */
-void _lf_worker_invoke_reaction(int worker_number, reaction_t* reaction) {
+bool _lf_worker_invoke_reaction(int worker_number, reaction_t* reaction) {
     LF_PRINT_LOG("Worker %d: Invoking reaction %s at elapsed tag " PRINTF_TAG ".",
             worker_number,
             reaction->name,
-            current_tag.time - start_time,
-            current_tag.microstep);
+            _lf_enclave->current_tag.time - _lf_instance->start_time,
+            _lf_enclave->current_tag.microstep);
     _lf_invoke_reaction(reaction, worker_number);
+    if (_lf_release_suspended_reaction(reaction, worker_number)) {
+        return false;
+    }
 
     // If the reaction produced outputs, put the resulting triggered
     // reactions into the queue or execute them immediately.
     schedule_output_reactions(reaction, worker_number);
 
     reaction->is_STP_violated = false;
+    return true;
 }
 
 /**
@@ -1020,15 +1283,18 @@ void _lf_worker_do_work(int worker_number) {
             current_reaction_to_execute
         );
 
-        if (!violation) {
-            // Invoke the reaction function.
-            _lf_worker_invoke_reaction(worker_number, current_reaction_to_execute);
-        }
+        if (violation
+                // Invoke the reaction function.
+                || _lf_worker_invoke_reaction(worker_number, current_reaction_to_execute)) {
+            LF_PRINT_DEBUG("Worker %d: Done with reaction %s.",
+                    worker_number, current_reaction_to_execute->name);
 
-        LF_PRINT_DEBUG("Worker %d: Done with reaction %s.",
-                worker_number, current_reaction_to_execute->name);
+            lf_sched_done_with_reaction(worker_number, current_reaction_to_execute);
+        }
 
-        lf_sched_done_with_reaction(worker_number, current_reaction_to_execute);
+        // Execute the continuations of suspended reactions that have been
+        // resumed when no worker was idle.
+        _lf_run_resumed_reactions(worker_number);
     }
 }
 
@@ -1036,31 +1302,47 @@ void _lf_worker_do_work(int worker_number) {
  * Worker thread for the thread pool.
  * This acquires the mutex lock and releases it to wait for time to
  * elapse or for asynchronous events and also releases it to execute reactions.
+ * @param arg The enclave that the worker thread belongs to.
  */
 void* worker(void* arg) {
-    lf_mutex_lock(&mutex);
-    int worker_number = worker_thread_count++;
+    _lf_enclave = (lf_enclave_t*)arg;
+    _lf_instance = _lf_enclave->instance;
+    _lf_initialize_thread(LF_WORKER_THREAD);
+
+    lf_mutex_lock(&_lf_enclave->mutex);
+    int worker_number = _lf_enclave->worker_thread_count++;
     LF_PRINT_LOG("Worker thread %d started.", worker_number);
-    lf_mutex_unlock(&mutex);
+    lf_mutex_unlock(&_lf_enclave->mutex);
 
+    // In static-memory mode, everything has been allocated by now.
+    _lf_forbid_heap_allocation(true);
     _lf_worker_do_work(worker_number);
+    _lf_forbid_heap_allocation(false);
 
-    lf_mutex_lock(&mutex);
+    lf_mutex_lock(&_lf_enclave->mutex);
 
     // This thread is exiting, so don't count it anymore.
-    worker_thread_count--;
+    _lf_enclave->worker_thread_count--;
 
-    if (worker_thread_count == 0) {
+    if (_lf_enclave->worker_thread_count == 0) {
         // The last worker thread to exit will inform the RTI if needed.
         // Notify the RTI that there will be no more events (if centralized coord).
         // False argument means don't wait for a reply.
         send_next_event_tag(FOREVER_TAG, false);
+
+        // Downstream enclaves no longer need to wait for this one.
+        lf_mutex_lock(&_lf_enclave->event_q_mutex);
+        _lf_enclave->terminated = true;
+        lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+        _lf_enclave_publish_next_event_tag(FOREVER_TAG);
     }
 
-    lf_cond_signal(&event_q_changed);
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
+    lf_cond_signal(&_lf_enclave->event_q_changed);
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
 
     LF_PRINT_DEBUG("Worker %d: Stop requested. Exiting.", worker_number);
-    lf_mutex_unlock(&mutex);
+    lf_mutex_unlock(&_lf_enclave->mutex);
     // timeout has been requested.
     return NULL;
 }
@@ -1076,21 +1358,18 @@ void lf_print_snapshot() {
         // pqueue_dump(reaction_q, print_reaction); FIXME: reaction_q is not
         // accessible here
         LF_PRINT_DEBUG("Event queue size: %zu. Contents:",
-                        pqueue_size(event_q));
-        pqueue_dump(event_q, print_reaction);
+                        pqueue_size(_lf_enclave->event_q));
+        pqueue_dump(_lf_enclave->event_q, print_reaction);
         LF_PRINT_DEBUG(">>> END Snapshot");
     }
 }
 
-// Array of thread IDs (to be dynamically allocated).
-lf_thread_t* _lf_thread_ids;
-
 // Start threads in the thread pool.
 void start_threads() {
-    LF_PRINT_LOG("Starting %u worker threads.", _lf_number_of_workers);
-    _lf_thread_ids = (lf_thread_t*)malloc(_lf_number_of_workers * sizeof(lf_thread_t));
-    for (unsigned int i = 0; i < _lf_number_of_workers; i++) {
-        lf_thread_create(&_lf_thread_ids[i], worker, NULL);
+    LF_PRINT_LOG("Starting %u worker threads.", _lf_enclave->number_of_workers);
+    _lf_enclave->thread_ids = (lf_thread_t*)malloc(_lf_enclave->number_of_workers * sizeof(lf_thread_t));
+    for (unsigned int i = 0; i < _lf_enclave->number_of_workers; i++) {
+        lf_thread_create(&_lf_enclave->thread_ids[i], worker, _lf_enclave);
     }
 }
 
@@ -1101,44 +1380,40 @@ void start_threads() {
 void determine_number_of_workers(void) {
     // If _lf_number_of_workers is 0, it means that it was not provided on
     // the command-line using the --workers argument.
-    if (_lf_number_of_workers == 0u) {
+    if (_lf_instance->number_of_workers == 0u) {
         #if !defined(NUMBER_OF_WORKERS) || NUMBER_OF_WORKERS == 0
         // Use the number of cores on the host machine.
-        _lf_number_of_workers = lf_available_cores();
+        _lf_instance->number_of_workers = lf_available_cores();
 
         // If reaction graph breadth is available. Cap number of workers
         #if defined(LF_REACTION_GRAPH_BREADTH)
-        if (LF_REACTION_GRAPH_BREADTH < _lf_number_of_workers) {
-            _lf_number_of_workers = LF_REACTION_GRAPH_BREADTH;
+        if (LF_REACTION_GRAPH_BREADTH < _lf_instance->number_of_workers) {
+            _lf_instance->number_of_workers = LF_REACTION_GRAPH_BREADTH;
         }
         #endif
 
         #else
         // Use the provided number of workers by the user
-        _lf_number_of_workers = NUMBER_OF_WORKERS;
+        _lf_instance->number_of_workers = NUMBER_OF_WORKERS;
         #endif
     }
 
     #if defined(WORKERS_NEEDED_FOR_FEDERATE)
     // Add the required number of workers needed for the proper function of
     // federated execution
-    _lf_number_of_workers += WORKERS_NEEDED_FOR_FEDERATE;
+    _lf_instance->number_of_workers += WORKERS_NEEDED_FOR_FEDERATE;
     #endif
 }
 
 /**
- * The main loop of the LF program.
- *
- * An unambiguous function name that can be called
- * by external libraries.
- *
- * Note: In target languages that use the C core library,
- * there should be an unambiguous way to execute the LF
- * program's main function that will not conflict with
- * other main functions that might get resolved and linked
- * at compile time.
+ * Run the instance that the calling thread is bound to until its worker
+ * threads exit.
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line arguments.
+ * @return 0 on success, 1 if a worker thread reported an error, and -1 if the
+ *  arguments are invalid.
  */
-int lf_reactor_c_main(int argc, const char* argv[]) {
+static int _lf_run(int argc, const char* argv[]) {
     // Invoke the function that optionally provides default command-line options.
     _lf_set_default_command_line_options();
 
@@ -1153,78 +1428,133 @@ int lf_reactor_c_main(int argc, const char* argv[]) {
     // If this happens, no other thread can satisfy the condition
     // of the predicate.”  This seems like a bug in the implementation of
     // pthreads. Maybe it has been fixed?
-    // The one and only mutex lock.
-    lf_mutex_init(&mutex);
+    // The tag lock and the event queue lock.
+    lf_mutex_init(&_lf_enclave->mutex);
+    lf_mutex_init(&_lf_enclave->event_q_mutex);
 
     // Initialize condition variables used for notification between threads.
-    lf_cond_init(&event_q_changed);
-    lf_cond_init(&global_tag_barrier_requestors_reached_zero);
-
-    if (atexit(termination) != 0) {
-        lf_print_warning("Failed to register termination function!");
-    }
-    // The above handles only "normal" termination (via a call to exit).
-    // As a consequence, we need to also trap ctrl-C, which issues a SIGINT,
-    // and cause it to call exit.
-    signal(SIGINT, exit);
-#ifdef SIGPIPE
-    // Ignore SIGPIPE errors, which terminate the entire application if
-    // socket write() fails because the reader has closed the socket.
-    // Instead, cause an EPIPE error to be set when write() fails.
-    signal(SIGPIPE, SIG_IGN);
-#endif // SIGPIPE
+    lf_cond_init(&_lf_enclave->event_q_changed);
 
     if (process_args(default_argc, default_argv)
             && process_args(argc, argv)) {
 
         determine_number_of_workers();
 
-        lf_mutex_lock(&mutex);
+        lf_mutex_lock(&_lf_enclave->mutex);
         initialize(); // Sets start_time
 #ifdef MODAL_REACTORS
         // Set up modal infrastructure
         _lf_initialize_modes();
 #endif
 
-        lf_print("---- Using %d workers.", _lf_number_of_workers);
+        lf_print("---- Using %d workers.", _lf_instance->number_of_workers);
+        _lf_main_enclave.number_of_workers = _lf_instance->number_of_workers;
+        _lf_enclave_initialize_coordination();
 
-        // Initialize the scheduler
-        lf_sched_init(
-            (size_t)_lf_number_of_workers,
-            NULL);
+        // Start each enclave, beginning with the main one, which holds the
+        // lock of the main enclave until all enclaves have started.
+        for (lf_enclave_t* enclave = &_lf_main_enclave; enclave != NULL; enclave = enclave->next) {
+            _lf_enclave = enclave;
+            if (enclave != &_lf_main_enclave) {
+                lf_mutex_lock(&enclave->mutex);
+            }
+            if (enclave->number_of_workers == 0u) {
+                enclave->number_of_workers = _lf_instance->number_of_workers;
+            }
+
+            // Initialize the scheduler
+            lf_sched_init(
+                (size_t)enclave->number_of_workers,
+                NULL);
+
+            // Call the following function only once, rather than per worker thread (although
+            // it can be probably called in that manner as well).
+            _lf_initialize_start_tag();
 
-        // Call the following function only once, rather than per worker thread (although
-        // it can be probably called in that manner as well).
-        _lf_initialize_start_tag();
+            start_threads();
 
-        start_threads();
+            if (enclave != &_lf_main_enclave) {
+                lf_mutex_unlock(&enclave->mutex);
+            }
+        }
+        _lf_enclave = &_lf_main_enclave;
 
-        lf_mutex_unlock(&mutex);
+        lf_mutex_unlock(&_lf_enclave->mutex);
         LF_PRINT_DEBUG("Waiting for worker threads to exit.");
 
         // Wait for the worker threads to exit.
         void* worker_thread_exit_status = NULL;
-        LF_PRINT_DEBUG("Number of threads: %d.", _lf_number_of_workers);
         int ret = 0;
-        for (int i = 0; i < _lf_number_of_workers; i++) {
-        	int failure = lf_thread_join(_lf_thread_ids[i], &worker_thread_exit_status);
-        	if (failure) {
-        		lf_print_error("Failed to join thread listening for incoming messages: %s", strerror(failure));
-        	}
-        	if (worker_thread_exit_status != NULL) {
-                lf_print_error("---- Worker %d reports error code %p", i, worker_thread_exit_status);
-                ret = 1;
-        	}
+        for (lf_enclave_t* enclave = &_lf_main_enclave; enclave != NULL; enclave = enclave->next) {
+            LF_PRINT_DEBUG("Number of threads of enclave %s: %u.", enclave->name, enclave->number_of_workers);
+            for (unsigned int i = 0; i < enclave->number_of_workers; i++) {
+                int failure = lf_thread_join(enclave->thread_ids[i], &worker_thread_exit_status);
+                if (failure) {
+                    lf_print_error("Failed to join thread listening for incoming messages: %s", strerror(failure));
+                }
+                if (worker_thread_exit_status != NULL) {
+                    lf_print_error("---- Worker %u reports error code %p", i, worker_thread_exit_status);
+                    ret = 1;
+                }
+            }
         }
 
         if (ret == 0) {
             LF_PRINT_LOG("---- All worker threads exited successfully.");
         }
 
-        lf_sched_free();
-        free(_lf_thread_ids);
+        for (lf_enclave_t* enclave = &_lf_main_enclave; enclave != NULL; enclave = enclave->next) {
+            _lf_enclave = enclave;
+            lf_sched_free();
+            free(enclave->thread_ids);
+        }
+        _lf_enclave = &_lf_main_enclave;
         return ret;
     } else {
         return -1;
     }
 }
+
+/**
+ * The main loop of the LF program.
+ *
+ * An unambiguous function name that can be called
+ * by external libraries.
+ *
+ * Note: In target languages that use the C core library,
+ * there should be an unambiguous way to execute the LF
+ * program's main function that will not conflict with
+ * other main functions that might get resolved and linked
+ * at compile time.
+ */
+int lf_reactor_c_main(int argc, const char* argv[]) {
+    if (atexit(termination) != 0) {
+        lf_print_warning("Failed to register termination function!");
+    }
+#ifdef LF_LOCK_PROFILING
+    if (atexit(_lf_print_lock_profile) != 0) {
+        lf_print_warning("Failed to register the lock profile report!");
+    }
+#endif
+    // The above handles only "normal" termination (via a call to exit).
+    // As a consequence, we need to also trap ctrl-C, which issues a SIGINT,
+    // and cause it to call exit.
+    signal(SIGINT, exit);
+#ifdef SIGPIPE
+    // Ignore SIGPIPE errors, which terminate the entire application if
+    // socket write() fails because the reader has closed the socket.
+    // Instead, cause an EPIPE error to be set when write() fails.
+    signal(SIGPIPE, SIG_IGN);
+#endif // SIGPIPE
+
+    return _lf_run(argc, argv);
+}
+
+int lf_instance_run(lf_instance_t* instance, int argc, const char* argv[]) {
+    lf_instance_bind(instance);
+    int result = _lf_run(argc, argv);
+    if (result >= 0) {
+        termination();
+    }
+    return result;
+}
@@ -1,3 +1,11 @@
+// The values that SCHEDULER can name. Without these definitions, each name
+// would be replaced by 0 in the conditions below, which would then always
+// select the first scheduler.
+#define NP 1
+#define ADAPTIVE 2
+#define GEDF_NP 3
+#define GEDF_NP_CI 4
+
 #if SCHEDULER == ADAPTIVE
 #include "scheduler_adaptive.c"
 
@@ -11,3 +19,8 @@
 #include "scheduler_NP.c"
 
 #endif
+
+#if SCHEDULER != ADAPTIVE
+// The other schedulers keep their idle workers in their scheduler instance.
+#include "scheduler_instance.c"
+#endif
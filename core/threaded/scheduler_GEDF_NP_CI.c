@@ -43,6 +43,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "platform.h"
 #include "pqueue.h"
+#include "reactor_common.h"
 #include "reactor.h"
 #include "scheduler_instance.h"
 #include "scheduler_sync_tag_advance.h"
@@ -51,16 +52,23 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "trace.h"
 #include "util.h"
 #include "vector.h"
+#include "worker_pool.h"
 
 #ifndef MAX_REACTION_LEVEL
 #define MAX_REACTION_LEVEL INITIAL_REACT_QUEUE_SIZE
 #endif
 
-/////////////////// External Variables /////////////////////////
-extern lf_mutex_t mutex;
-
 /////////////////// Scheduler Variables and Structs /////////////////////////
-_lf_sched_instance_t* _lf_sched_instance;
+// The scheduler instance is a field of the enclave (see scheduler_instance.h).
+
+/** See scheduler.h for documentation. This scheduler keeps per-worker state in a global variable. */
+const bool lf_sched_supports_enclaves = false;
+
+/** See scheduler.h for documentation. */
+const bool lf_sched_supports_suspension = true;
+
+/** See scheduler.h for documentation. */
+const bool lf_sched_has_worker_pool = true;
 
 /**
  * @brief Information about one worker thread.
@@ -245,6 +253,9 @@ int _lf_sched_distribute_ready_reactions_locked() {
  * This assumes that the caller is not holding any thread mutexes.
  */
 void _lf_sched_notify_workers() {
+    // Park or unpark workers to suit the parallelism of the program.
+    lf_worker_pool_resize(
+        pqueue_size((pqueue_t*)_lf_sched_instance->_lf_sched_executing_reactions));
     size_t workers_to_awaken =
         LF_MIN(_lf_sched_instance->_lf_sched_number_of_idle_workers,
             pqueue_size(
@@ -278,7 +289,7 @@ bool _lf_sched_try_advance_tag_and_distribute() {
                (pqueue_t*)_lf_sched_instance->_lf_sched_executing_reactions) ==
            0);
 
-    lf_mutex_lock(&mutex);
+    lf_mutex_lock(&_lf_enclave->mutex);
     while (pqueue_size(
                (pqueue_t*)_lf_sched_instance->_lf_sched_triggered_reactions) ==
            0) {
@@ -293,7 +304,7 @@ bool _lf_sched_try_advance_tag_and_distribute() {
     }
 
     int reactions_distributed = _lf_sched_distribute_ready_reactions_locked();
-    lf_mutex_unlock(&mutex);
+    lf_mutex_unlock(&_lf_enclave->mutex);
 
     if (reactions_distributed) {
         _lf_sched_notify_workers();
@@ -310,6 +321,7 @@ bool _lf_sched_try_advance_tag_and_distribute() {
  */
 void _lf_sched_signal_stop() {
     _lf_sched_instance->_lf_sched_should_stop = true;
+    lf_worker_pool_unpark_all();
     lf_semaphore_release(_lf_sched_instance->_lf_sched_semaphore,
                          (_lf_sched_instance->_lf_sched_number_of_workers - 1));
 }
@@ -323,13 +335,13 @@ void _lf_sched_signal_stop() {
  * @param worker_number The worker number of the calling worker thread.
  */
 void _lf_sched_update_triggered_reactions(size_t worker_number) {
-    lf_mutex_lock(&mutex);
+    lf_mutex_lock(&_lf_enclave->mutex);
     LF_PRINT_DEBUG("Scheduler: Emptying the output reaction queue of Worker %zu.",
                 worker_number);
     pqueue_empty_into(
         (pqueue_t**)&_lf_sched_instance->_lf_sched_triggered_reactions,
         &_lf_sched_threads_info[worker_number].output_reactions);
-    lf_mutex_unlock(&mutex);
+    lf_mutex_unlock(&_lf_enclave->mutex);
 }
 
 /**
@@ -343,6 +355,7 @@ void _lf_sched_update_triggered_reactions(size_t worker_number) {
  * to be assigned to it.
  */
 void _lf_sched_wait_for_work(size_t worker_number) {
+    lf_worker_pool_worker_idle(worker_number);
     // First, empty the 'output_reactions' for this worker thread into the
     // '_lf_sched_instance->_lf_sched_triggered_reactions'.
     _lf_sched_update_triggered_reactions(worker_number);
@@ -351,7 +364,9 @@ void _lf_sched_wait_for_work(size_t worker_number) {
     // check if this is the last worker thread to become idle.
     if (lf_atomic_add_fetch(&_lf_sched_instance->_lf_sched_number_of_idle_workers,
                             1) ==
-        _lf_sched_instance->_lf_sched_number_of_workers) {
+        _lf_sched_instance->_lf_sched_number_of_workers
+        // Suspended reactions keep the level from completing.
+        && !_lf_suspended_reactions_hold_level()) {
         // Last thread to go idle
         LF_PRINT_DEBUG("Scheduler: Worker %zu is the last idle thread.",
                     worker_number);
@@ -361,10 +376,18 @@ void _lf_sched_wait_for_work(size_t worker_number) {
             _lf_sched_signal_stop();
         }
     } else {
-        // Not the last thread to become idle.
+        // Not the last thread to become idle, or suspended reactions hold the
+        // level.
         // Wait for work to be released.
         lf_semaphore_acquire(_lf_sched_instance->_lf_sched_semaphore);
+        // The worker may have been woken up to park until it is needed.
+        lf_worker_pool_park_if_surplus();
+        // Or to help with a parallel loop.
+        _lf_parallel_for_help();
+        // Or to execute the continuation of a suspended reaction.
+        _lf_run_resumed_reactions(worker_number);
     }
+    lf_worker_pool_worker_busy(worker_number);
 }
 
 ///////////////////// Scheduler Init and Destroy API /////////////////////////
@@ -389,7 +412,7 @@ void lf_sched_init(
         return;
     }
 
-    size_t queue_size = INITIAL_REACT_QUEUE_SIZE;
+    size_t queue_size = _lf_reaction_queue_capacity();
     if (params != NULL) {
         if (params->num_reactions_per_level != NULL) {
             // Recalculate the queue size
@@ -429,6 +452,8 @@ void lf_sched_init(
             get_reaction_position, set_reaction_position, reaction_matches,
             print_reaction);
     }
+
+    lf_worker_pool_init(number_of_workers);
 }
 
 /**
@@ -437,6 +462,7 @@ void lf_sched_init(
  * This must be called when the scheduler is no longer needed.
  */
 void lf_sched_free() {
+    lf_worker_pool_free();
     for (int i = 0; i < _lf_sched_instance->_lf_sched_number_of_workers; i++) {
         pqueue_free(_lf_sched_threads_info[i].output_reactions);
     }
@@ -446,6 +472,7 @@ void lf_sched_free() {
     pqueue_free((pqueue_t*)_lf_sched_instance->_lf_sched_executing_reactions);
     lf_semaphore_destroy(_lf_sched_instance->_lf_sched_semaphore);
     free(_lf_sched_threads_info);
+    free_sched_instance(&_lf_sched_instance);
 }
 
 ///////////////////// Scheduler Worker API (public) /////////////////////////
@@ -524,12 +551,12 @@ void lf_sched_trigger_reaction(reaction_t* reaction, int worker_number) {
     LF_PRINT_DEBUG("Scheduler: Enqueing reaction %s, which has level %lld.",
             reaction->name, LF_LEVEL(reaction->index));
     if (worker_number == -1) {
-        lf_mutex_lock(&mutex);
+        lf_mutex_lock(&_lf_enclave->mutex);
         // Immediately put 'reaction' on the reaction queue.
         pqueue_insert(
             (pqueue_t*)_lf_sched_instance->_lf_sched_triggered_reactions,
             (void*)reaction);
-        lf_mutex_unlock(&mutex);
+        lf_mutex_unlock(&_lf_enclave->mutex);
     } else {
         reaction->worker_affinity = worker_number;
         // Note: The scheduler has already checked that we are not enqueueing
@@ -48,12 +48,19 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "semaphore.h"
 #include "trace.h"
 #include "util.h"
-
-/////////////////// External Variables /////////////////////////
-extern lf_mutex_t mutex;
+#include "worker_pool.h"
 
 /////////////////// Scheduler Variables and Structs /////////////////////////
-_lf_sched_instance_t* _lf_sched_instance;
+// The scheduler instance is a field of the enclave (see scheduler_instance.h).
+
+/** See scheduler.h for documentation. */
+const bool lf_sched_supports_enclaves = true;
+
+/** See scheduler.h for documentation. */
+const bool lf_sched_supports_suspension = true;
+
+/** See scheduler.h for documentation. */
+const bool lf_sched_has_worker_pool = true;
 
 /////////////////// Scheduler Private API /////////////////////////
 /**
@@ -146,6 +153,10 @@ int _lf_sched_distribute_ready_reactions() {
  * This assumes that the caller is not holding any thread mutexes.
  */
 void _lf_sched_notify_workers() {
+    // Park or unpark workers to suit the parallelism of the program.
+    lf_worker_pool_resize(_lf_sched_instance->_lf_sched_indexes[
+        _lf_sched_instance->_lf_sched_next_reaction_level - 1]);
+
     // Calculate the number of workers that we need to wake up, which is the
     // Note: All threads are idle. Therefore, there is no need to lock the mutex
     // while accessing the index for the current level.
@@ -177,6 +188,7 @@ void _lf_sched_notify_workers() {
  */
 void _lf_sched_signal_stop() {
     _lf_sched_instance->_lf_sched_should_stop = true;
+    lf_worker_pool_unpark_all();
     lf_semaphore_release(_lf_sched_instance->_lf_sched_semaphore,
                          (_lf_sched_instance->_lf_sched_number_of_workers - 1));
 }
@@ -200,17 +212,17 @@ void _lf_sched_try_advance_tag_and_distribute() {
         if (_lf_sched_instance->_lf_sched_next_reaction_level ==
             (_lf_sched_instance->max_reaction_level + 1)) {
             _lf_sched_instance->_lf_sched_next_reaction_level = 0;
-            lf_mutex_lock(&mutex);
+            lf_mutex_lock(&_lf_enclave->mutex);
             // Nothing more happening at this tag.
             LF_PRINT_DEBUG("Scheduler: Advancing tag.");
             // This worker thread will take charge of advancing tag.
             if (_lf_sched_advance_tag_locked()) {
                 LF_PRINT_DEBUG("Scheduler: Reached stop tag.");
                 _lf_sched_signal_stop();
-                lf_mutex_unlock(&mutex);
+                lf_mutex_unlock(&_lf_enclave->mutex);
                 break;
             }
-            lf_mutex_unlock(&mutex);
+            lf_mutex_unlock(&_lf_enclave->mutex);
         }
 
         if (_lf_sched_distribute_ready_reactions() > 0) {
@@ -231,18 +243,22 @@ void _lf_sched_try_advance_tag_and_distribute() {
  * to be assigned to it.
  */
 void _lf_sched_wait_for_work(size_t worker_number) {
+    lf_worker_pool_worker_idle(worker_number);
     // Increment the number of idle workers by 1 and check if this is the last
     // worker thread to become idle.
     if (lf_atomic_add_fetch(&_lf_sched_instance->_lf_sched_number_of_idle_workers,
                             1) ==
-        _lf_sched_instance->_lf_sched_number_of_workers) {
+        _lf_sched_instance->_lf_sched_number_of_workers
+        // Suspended reactions keep the level from completing.
+        && !_lf_suspended_reactions_hold_level()) {
         // Last thread to go idle
         LF_PRINT_DEBUG("Scheduler: Worker %zu is the last idle thread.",
                     worker_number);
         // Call on the scheduler to distribute work or advance tag.
         _lf_sched_try_advance_tag_and_distribute();
     } else {
-        // Not the last thread to become idle. Wait for work to be released.
+        // Not the last thread to become idle, or suspended reactions hold the
+        // level. Wait for work to be released.
         LF_PRINT_DEBUG(
             "Scheduler: Worker %zu is trying to acquire the scheduling "
             "semaphore.",
@@ -250,7 +266,14 @@ void _lf_sched_wait_for_work(size_t worker_number) {
         lf_semaphore_acquire(_lf_sched_instance->_lf_sched_semaphore);
         LF_PRINT_DEBUG("Scheduler: Worker %zu acquired the scheduling semaphore.",
                     worker_number);
+        // The worker may have been woken up to park until it is needed.
+        lf_worker_pool_park_if_surplus();
+        // Or to help with a parallel loop.
+        _lf_parallel_for_help();
+        // Or to execute the continuation of a suspended reaction.
+        _lf_run_resumed_reactions(worker_number);
     }
+    lf_worker_pool_worker_busy(worker_number);
 }
 
 ///////////////////// Scheduler Init and Destroy API /////////////////////////
@@ -320,6 +343,8 @@ void lf_sched_init(
     _lf_sched_instance->_lf_sched_executing_reactions =
         (void*)((reaction_t***)_lf_sched_instance->
             _lf_sched_triggered_reactions)[0];
+
+    lf_worker_pool_init(number_of_workers);
 }
 
 /**
@@ -328,12 +353,16 @@ void lf_sched_init(
  * This must be called when the scheduler is no longer needed.
  */
 void lf_sched_free() {
+    lf_worker_pool_free();
     // for (size_t j = 0; j <= _lf_sched_instance->max_reaction_level; j++) {
     //     free(((reaction_t***)_lf_sched_instance->_lf_sched_triggered_reactions)[j]);
     // }
     free(_lf_sched_instance->_lf_sched_triggered_reactions);
     free(_lf_sched_instance->_lf_sched_executing_reactions);
+    free(_lf_sched_instance->_lf_sched_array_of_mutexes);
+    free((void*)_lf_sched_instance->_lf_sched_indexes);
     lf_semaphore_destroy(_lf_sched_instance->_lf_sched_semaphore);
+    free_sched_instance(&_lf_sched_instance);
 }
 
 ///////////////////// Scheduler Worker API (public) /////////////////////////
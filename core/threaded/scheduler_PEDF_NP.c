@@ -48,12 +48,17 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "semaphore.h"
 #include "vector.h"
 
-/////////////////// External Variables /////////////////////////
-extern lf_mutex_t mutex;
+/////////////////// Scheduler Variables and Structs /////////////////////////
+// The scheduler instance is a field of the enclave (see scheduler_instance.h).
 
+/** See scheduler.h for documentation. This scheduler also keeps state in global variables. */
+const bool lf_sched_supports_enclaves = false;
 
-/////////////////// Scheduler Variables and Structs /////////////////////////
-_lf_sched_instance_t* _lf_sched_instance;
+/** See scheduler.h for documentation. */
+const bool lf_sched_supports_suspension = false;
+
+/** See scheduler.h for documentation. */
+const bool lf_sched_has_worker_pool = false;
 
 /**
  * @brief Information about one worker thread.
@@ -406,7 +411,7 @@ bool _lf_sched_try_advance_tag_and_distribute() {
     // Executing queue must be empty when this is called.
     assert(pqueue_size(_lf_sched_instance->_lf_sched_executing_reactions) != 0);
 
-    lf_mutex_lock(&mutex);
+    lf_mutex_lock(&_lf_enclave->mutex);
     if (!_lf_sched_update_queues()) {
         if (pqueue_size(_lf_sched_instance->_lf_sched_triggered_reactions) == 0
                 && pqueue_size(_lf_sched_instance->_lf_sched_executing_reactions) == 0) {
@@ -421,7 +426,7 @@ bool _lf_sched_try_advance_tag_and_distribute() {
     }
 
     int reactions_distributed = _lf_sched_distribute_ready_reactions_locked();
-    lf_mutex_unlock(&mutex);
+    lf_mutex_unlock(&_lf_enclave->mutex);
 
     if (reactions_distributed) {
         _lf_sched_notify_workers();
@@ -571,6 +576,7 @@ void lf_sched_free() {
     vector_free(&_lf_sched_instance->_lf_sched_transfer_reactions);
     pqueue_free(_lf_sched_instance->_lf_sched_executing_reactions);
     free(_lf_sched_threads_info);
+    free_sched_instance(&_lf_sched_instance);
 }
 
 ///////////////////// Scheduler Worker API (public) /////////////////////////
@@ -665,10 +671,10 @@ void lf_sched_trigger_reaction(reaction_t* reaction, int worker_number) {
     LF_PRINT_DEBUG("Scheduler: Enqueing reaction %s, which has level %lld.",
             reaction->name, LF_LEVEL(reaction->index));
     if (worker_number == -1) {
-        lf_mutex_lock(&mutex);
+        lf_mutex_lock(&_lf_enclave->mutex);
         // Immediately put 'reaction' on the reaction queue.
         pqueue_insert((pqueue_t*)_lf_sched_instance->_lf_sched_triggered_reactions, reaction);
-        lf_mutex_unlock(&mutex);
+        lf_mutex_unlock(&_lf_enclave->mutex);
     } else {
         reaction->worker_affinity = worker_number;
         // Note: The scheduler will check that we don't enqueue this reaction
@@ -677,4 +683,18 @@ void lf_sched_trigger_reaction(reaction_t* reaction, int worker_number) {
     }
 }
 
+/**
+ * @brief Wake up idle workers to help execute a loop of lf_parallel_for().
+ *
+ * Each worker of this scheduler waits on its own semaphore for the reactions
+ * assigned to it, so idle workers are not lent out and the calling worker
+ * executes the whole loop.
+ *
+ * @param count The maximum number of workers to wake up.
+ * @return 0.
+ */
+size_t lf_sched_wake_idle_workers(size_t count) {
+    return 0;
+}
+
 #endif // SCHEDULER == PEDF_NP
@@ -45,6 +45,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 static bool init_called = false;
 static bool should_stop = false;
 
+/** See scheduler.h for documentation. This scheduler keeps its state in static variables. */
+const bool lf_sched_supports_enclaves = false;
+
+/** See scheduler.h for documentation. */
+const bool lf_sched_supports_suspension = false;
+
+/** See scheduler.h for documentation. */
+const bool lf_sched_has_worker_pool = false;
+
 ///////////////////////// Scheduler Private Functions ///////////////////////////
 
 /**
@@ -125,3 +134,8 @@ void lf_sched_trigger_reaction(reaction_t* reaction, int worker_number) {
     if (!lf_bool_compare_and_swap(&reaction->status, inactive, queued)) return;
     worker_assignments_put(reaction);
 }
+
+size_t lf_sched_wake_idle_workers(size_t count) {
+    // Idle workers sleep until their level is reached and cannot be lent out.
+    return 0;
+}
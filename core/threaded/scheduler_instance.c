@@ -0,0 +1,66 @@
+/*************
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************/
+
+/**
+ * @file scheduler_instance.c
+ * @brief The part of the scheduler API that is the same for the schedulers
+ * whose idle workers wait on the semaphore of their scheduler instance
+ * (see scheduler_instance.h).
+ */
+
+#include "platform.h"
+#include "scheduler_instance.h"
+#include "scheduler.h"
+#include "semaphore.h"
+#include "util.h"
+
+/**
+ * @brief Wake up to 'count' idle workers to help execute a loop of
+ * lf_parallel_for() or the continuations of resumed reactions.
+ *
+ * The woken workers are no longer counted as idle, as if work had been
+ * distributed to them, so the last of them to become idle again still
+ * advances the tag.
+ *
+ * @param count The maximum number of workers to wake up.
+ * @return The number of workers that were woken up.
+ */
+size_t lf_sched_wake_idle_workers(size_t count) {
+    size_t idle;
+    size_t workers_to_awaken;
+    do {
+        idle = _lf_sched_instance->_lf_sched_number_of_idle_workers;
+        workers_to_awaken = LF_MIN(idle, count);
+        if (workers_to_awaken == 0) {
+            return 0;
+        }
+    } while (!lf_bool_compare_and_swap(
+        &_lf_sched_instance->_lf_sched_number_of_idle_workers,
+        idle, idle - workers_to_awaken));
+    LF_PRINT_DEBUG("Scheduler: Waking %zu idle workers.",
+                workers_to_awaken);
+    lf_semaphore_release(_lf_sched_instance->_lf_sched_semaphore,
+                         workers_to_awaken);
+    return workers_to_awaken;
+}
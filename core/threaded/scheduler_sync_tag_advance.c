@@ -35,13 +35,10 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
 #include "scheduler_sync_tag_advance.h"
+#include "enclave.h"
 #include "trace.h"
 #include "util.h"
 
-/////////////////// External Variables /////////////////////////
-extern tag_t current_tag;
-extern tag_t stop_tag;
-
 /////////////////// External Functions /////////////////////////
 /**
  * Placeholder for function that will advance tag and initially fill the
@@ -51,21 +48,16 @@ extern tag_t stop_tag;
  */
 void _lf_next_locked();
 
-/**
- * @brief Indicator that execution of at least one tag has completed.
- */
-static bool _lf_logical_tag_completed = false;
-
 /**
  * Return true if the worker should stop now; false otherwise.
  * This function assumes the caller holds the mutex lock.
  */
 bool _lf_sched_should_stop_locked() {
     // If this is not the very first step, check against the stop tag to see whether this is the last step.
-    if (_lf_logical_tag_completed) {
+    if (_lf_enclave->logical_tag_completed) {
         // If we are at the stop tag, do not call _lf_next_locked()
         // to prevent advancing the logical time.
-        if (lf_tag_compare(current_tag, stop_tag) >= 0) {
+        if (lf_tag_compare(_lf_enclave->current_tag, _lf_enclave->stop_tag) >= 0) {
             return true;
         }
     }
@@ -81,13 +73,13 @@ bool _lf_sched_should_stop_locked() {
  * @return should_exit True if the worker thread should exit. False otherwise.
  */
 bool _lf_sched_advance_tag_locked() {
-    logical_tag_complete(current_tag);
+    logical_tag_complete(_lf_enclave->current_tag);
 
     if (_lf_sched_should_stop_locked()) {
         return true;
     }
 
-    _lf_logical_tag_completed = true;
+    _lf_enclave->logical_tag_completed = true;
 
     // Advance time.
     // _lf_next_locked() may block waiting for real time to pass or events to appear.
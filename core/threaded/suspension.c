@@ -0,0 +1,161 @@
+/*************
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************/
+
+/**
+ * @file suspension.c
+ * @brief Reactions that let go of their worker thread while they wait.
+ *
+ * A reaction that calls lf_reaction_suspend() returns to its worker thread,
+ * which then lets go of it, counts it in the suspended_reactions of its
+ * enclave, and goes on to execute other reactions. The schedulers do not
+ * advance to the next level while that count is not zero. When
+ * lf_reaction_resume() is called, the reaction is put on the list of
+ * resumed reactions of its enclave and an idle worker, if there is one, is
+ * woken up to execute its continuation. Workers also look at that list after
+ * each reaction that they execute, and the last worker to become idle wakes
+ * up one of the idle workers if it is not empty, so a resumed reaction is not
+ * forgotten when no worker was idle to be woken up.
+ *
+ * If lf_reaction_resume() is called before the worker has let go of the
+ * reaction, the worker executes the continuation itself right away.
+ */
+
+#include "enclave.h"
+#include "platform.h"
+#include "reactor.h"
+#include "reactor_common.h"
+#include "scheduler.h"
+#include "util.h"
+
+/**
+ * Finish a reaction whose continuation has returned without suspending it
+ * again, as the worker that invoked the reaction would have if it had not
+ * been suspended.
+ */
+static void _lf_finish_resumed_reaction(reaction_t* reaction, int worker_number) {
+    schedule_output_reactions(reaction, worker_number);
+    reaction->is_STP_violated = false;
+    // A reaction that schedule_output_reactions() executed right away, without
+    // queuing it, is not known to the scheduler.
+    if (reaction->status != inactive) {
+        lf_sched_done_with_reaction(worker_number, reaction);
+    }
+    LF_PRINT_DEBUG("Worker %d: Done with resumed reaction %s.", worker_number, reaction->name);
+}
+
+/**
+ * If the given reaction has suspended itself, let go of it if the scheduler
+ * supports that. Otherwise, or if the reaction has already been resumed,
+ * execute its continuation, repeatedly if the continuation suspends it again.
+ * @param reaction The reaction that has just executed.
+ * @param worker The number of the calling worker thread.
+ * @return true if the worker has let go of the reaction.
+ */
+bool _lf_release_suspended_reaction(reaction_t* reaction, int worker) {
+    while (reaction->suspension.state != reaction_not_suspended) {
+        if (lf_sched_supports_suspension) {
+            // Count the reaction before lf_reaction_resume() can hand it to
+            // another worker, which stops counting it.
+            lf_atomic_fetch_add(&_lf_enclave->suspended_reactions, 1);
+            if (lf_bool_compare_and_swap(&reaction->suspension.state, reaction_suspending, reaction_suspended)) {
+                LF_PRINT_DEBUG("Worker %d: Reaction %s is suspended.", worker, reaction->name);
+                return true;
+            }
+            // The reaction has already been resumed.
+            lf_atomic_fetch_add(&_lf_enclave->suspended_reactions, -1);
+        } else {
+            int32_t state;
+            while ((state = reaction->suspension.state) == reaction_suspending) {
+                lf_futex_wait(&reaction->suspension.state, state);
+            }
+        }
+        _lf_invoke_continuation(reaction, worker);
+    }
+    return false;
+}
+
+/**
+ * Resume a suspended reaction. See reactor.h for documentation.
+ */
+void lf_reaction_resume(void* handle) {
+    reaction_t* reaction = (reaction_t*)handle;
+    if (lf_bool_compare_and_swap(&reaction->suspension.state, reaction_suspending, reaction_resumed)) {
+        // The worker that executes the reaction has not let go of it yet, and
+        // may be waiting for this.
+        lf_futex_wake(&reaction->suspension.state);
+        return;
+    }
+    if (!lf_bool_compare_and_swap(&reaction->suspension.state, reaction_suspended, reaction_resumed)) {
+        lf_print_error_and_exit("lf_reaction_resume() was called for reaction %s, which is not suspended.",
+                reaction->name);
+    }
+    lf_enclave_t* enclave = reaction->suspension.enclave;
+    lf_mutex_lock(&enclave->mutex);
+    reaction->suspension.next = enclave->resumed_reactions;
+    enclave->resumed_reactions = reaction;
+    lf_mutex_unlock(&enclave->mutex);
+
+    // The calling thread may belong to another enclave, or to none.
+    lf_enclave_t* previous = _lf_enclave;
+    _lf_enclave = enclave;
+    lf_sched_wake_idle_workers(1);
+    _lf_enclave = previous;
+}
+
+bool _lf_suspended_reactions_hold_level() {
+    if (_lf_enclave->suspended_reactions == 0) {
+        return false;
+    }
+    if (_lf_enclave->resumed_reactions != NULL) {
+        // lf_reaction_resume() may have found no idle worker to wake up.
+        lf_sched_wake_idle_workers(1);
+    }
+    return true;
+}
+
+void _lf_run_resumed_reactions(int worker_number) {
+    while (_lf_enclave->resumed_reactions != NULL) {
+        lf_mutex_lock(&_lf_enclave->mutex);
+        reaction_t* reaction = _lf_enclave->resumed_reactions;
+        if (reaction != NULL) {
+            _lf_enclave->resumed_reactions = reaction->suspension.next;
+        }
+        bool more = (_lf_enclave->resumed_reactions != NULL);
+        lf_mutex_unlock(&_lf_enclave->mutex);
+        if (reaction == NULL) {
+            return;
+        }
+        // This worker holds the level until the reaction is done or
+        // suspended again, when it is counted again.
+        lf_atomic_fetch_add(&_lf_enclave->suspended_reactions, -1);
+        if (more) {
+            // Let an idle worker execute the next continuation.
+            lf_sched_wake_idle_workers(1);
+        }
+        _lf_invoke_continuation(reaction, worker_number);
+        if (!_lf_release_suspended_reaction(reaction, worker_number)) {
+            _lf_finish_resumed_reaction(reaction, worker_number);
+        }
+    }
+}
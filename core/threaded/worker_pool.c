@@ -0,0 +1,202 @@
+/*************
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************/
+
+/**
+ * @file worker_pool.c
+ * @brief An elastic pool of worker threads. See worker_pool.h.
+ */
+
+#include "worker_pool.h"
+
+#include "enclave.h"
+#include "platform.h"
+#include "scheduler_instance.h"
+#include "semaphore.h"
+#include "util.h"
+
+/**
+ * The state of an elastic pool of workers.
+ */
+typedef struct lf_worker_pool_t {
+    size_t min_workers;                    // The number of workers that are never parked.
+    size_t max_workers;                    // The number of worker threads.
+    size_t parked_workers;                 // The number of workers that are parked or about to park.
+    volatile size_t workers_to_park;       // The number of woken workers that should park.
+    semaphore_t* semaphore;                // The semaphore that parked workers block on.
+    instant_t* busy_since;                 // For each worker, when it stopped waiting for work, or NEVER.
+    interval_t* busy_time;                 // For each worker, the time that it has spent not waiting for work.
+    instant_t period_start;                // When the current measurement period started, or NEVER.
+    interval_t period_start_busy_time;     // The total busy time of the workers at that time.
+} lf_worker_pool_t;
+
+/** The pool of the scheduler instance of the enclave of the calling thread, or NULL if it is not elastic. */
+#define _lf_worker_pool (_lf_sched_instance->_lf_sched_worker_pool)
+
+/**
+ * Return the time of the clock, which is only used to measure durations.
+ */
+static instant_t _lf_worker_pool_now() {
+    instant_t now;
+    lf_clock_gettime(&now);
+    return now;
+}
+
+/**
+ * Return the total time that the workers have spent not waiting for work.
+ */
+static interval_t _lf_worker_pool_busy_time(lf_worker_pool_t* pool) {
+    interval_t total = 0;
+    for (size_t i = 0; i < pool->max_workers; i++) {
+        total += pool->busy_time[i];
+    }
+    return total;
+}
+
+void lf_worker_pool_init(size_t number_of_workers) {
+    size_t min_workers = _lf_instance->min_workers;
+#ifdef MIN_NUMBER_OF_WORKERS
+    if (min_workers == 0) {
+        min_workers = MIN_NUMBER_OF_WORKERS;
+    }
+#endif
+    if (min_workers == 0 || min_workers >= number_of_workers) {
+        // The pool is not elastic.
+        return;
+    }
+    lf_worker_pool_t* pool = (lf_worker_pool_t*)calloc(1, sizeof(lf_worker_pool_t));
+    if (pool == NULL) {
+        lf_print_error_and_exit("Out of memory for the worker pool.");
+    }
+    pool->min_workers = min_workers;
+    pool->max_workers = number_of_workers;
+    pool->semaphore = lf_semaphore_new(0);
+    pool->busy_since = (instant_t*)malloc(number_of_workers * sizeof(instant_t));
+    pool->busy_time = (interval_t*)calloc(number_of_workers, sizeof(interval_t));
+    if (pool->semaphore == NULL || pool->busy_since == NULL || pool->busy_time == NULL) {
+        lf_print_error_and_exit("Out of memory for the worker pool.");
+    }
+    for (size_t i = 0; i < number_of_workers; i++) {
+        pool->busy_since[i] = NEVER;
+    }
+    pool->period_start = NEVER;
+    LF_PRINT_LOG("Scheduler: Keeping between %zu and %zu workers active.", min_workers, number_of_workers);
+    _lf_worker_pool = pool;
+}
+
+void lf_worker_pool_free() {
+    lf_worker_pool_t* pool = _lf_worker_pool;
+    if (pool == NULL) {
+        return;
+    }
+    _lf_sched_instance->_lf_sched_number_of_workers = pool->max_workers;
+    lf_semaphore_destroy(pool->semaphore);
+    free(pool->busy_since);
+    free(pool->busy_time);
+    free(pool);
+    _lf_worker_pool = NULL;
+}
+
+void lf_worker_pool_resize(size_t ready_reactions) {
+    lf_worker_pool_t* pool = _lf_worker_pool;
+    if (pool == NULL) {
+        return;
+    }
+    size_t active = _lf_sched_instance->_lf_sched_number_of_workers;
+    instant_t now = _lf_worker_pool_now();
+    if (ready_reactions > active && pool->parked_workers > 0) {
+        size_t to_unpark = LF_MIN(ready_reactions - active, pool->parked_workers);
+        LF_PRINT_DEBUG("Scheduler: Unparking %zu workers.", to_unpark);
+        pool->parked_workers -= to_unpark;
+        _lf_sched_instance->_lf_sched_number_of_workers += to_unpark;
+        lf_semaphore_release(pool->semaphore, to_unpark);
+        // Measure the parallelism from now on, so that the workers are not
+        // parked again just because the program was waiting before.
+        pool->period_start = NEVER;
+    }
+    if (pool->period_start == NEVER) {
+        pool->period_start = now;
+        pool->period_start_busy_time = _lf_worker_pool_busy_time(pool);
+        return;
+    }
+    interval_t elapsed = now - pool->period_start;
+    if (elapsed < LF_WORKER_POOL_PERIOD) {
+        return;
+    }
+    interval_t busy_time = _lf_worker_pool_busy_time(pool);
+    // The average number of workers that were busy, rounded up.
+    size_t needed = (size_t)((busy_time - pool->period_start_busy_time + elapsed - 1) / elapsed);
+    size_t target = LF_MAX(needed, pool->min_workers);
+    if (active > target) {
+        // All active workers are idle. Those to park leave the count of idle
+        // workers now, and park when they wake up.
+        size_t to_park = active - target;
+        LF_PRINT_DEBUG("Scheduler: Parking %zu workers.", to_park);
+        pool->parked_workers += to_park;
+        lf_atomic_fetch_add(&pool->workers_to_park, to_park);
+        _lf_sched_instance->_lf_sched_number_of_workers -= to_park;
+        lf_atomic_fetch_add(&_lf_sched_instance->_lf_sched_number_of_idle_workers, -to_park);
+        lf_semaphore_release(_lf_sched_instance->_lf_sched_semaphore, to_park);
+    }
+    pool->period_start = now;
+    pool->period_start_busy_time = busy_time;
+}
+
+void lf_worker_pool_park_if_surplus() {
+    lf_worker_pool_t* pool = _lf_worker_pool;
+    if (pool == NULL) {
+        return;
+    }
+    size_t to_park;
+    do {
+        to_park = pool->workers_to_park;
+        if (to_park == 0) {
+            return;
+        }
+    } while (!lf_bool_compare_and_swap(&pool->workers_to_park, to_park, to_park - 1));
+    lf_semaphore_acquire(pool->semaphore);
+}
+
+void lf_worker_pool_unpark_all() {
+    lf_worker_pool_t* pool = _lf_worker_pool;
+    if (pool == NULL) {
+        return;
+    }
+    lf_semaphore_release(pool->semaphore, pool->parked_workers);
+}
+
+void lf_worker_pool_worker_idle(size_t worker_number) {
+    lf_worker_pool_t* pool = _lf_worker_pool;
+    if (pool == NULL || pool->busy_since[worker_number] == NEVER) {
+        return;
+    }
+    pool->busy_time[worker_number] += _lf_worker_pool_now() - pool->busy_since[worker_number];
+}
+
+void lf_worker_pool_worker_busy(size_t worker_number) {
+    lf_worker_pool_t* pool = _lf_worker_pool;
+    if (pool == NULL) {
+        return;
+    }
+    pool->busy_since[worker_number] = _lf_worker_pool_now();
+}
@@ -135,10 +135,10 @@ int write_trace_header() {
         lf_mutex_lock(&_lf_trace_mutex);
         // The first item in the header is the start time.
         // This is both the starting physical time and the starting logical time.
-        instant_t start_time = lf_time_start();
-        // printf("DEBUG: Start time written to trace file is %lld.\n", start_time);
+        instant_t trace_start_time = lf_time_start();
+        // printf("DEBUG: Start time written to trace file is %lld.\n", trace_start_time);
         size_t items_written = fwrite(
-                &start_time,
+                &trace_start_time,
                 sizeof(instant_t),
                 1,
                 _lf_trace_file
@@ -206,6 +206,8 @@ int write_trace_header() {
  * Thread that actually flushes the buffers to a file.
  */
 void* flush_trace(void* args) {
+    _lf_initialize_thread(LF_TRACE_THREAD);
+
     lf_mutex_lock(&_lf_trace_mutex);
     while (_lf_trace_file != NULL) {
         // Look for a buffer to flush.
@@ -337,7 +339,7 @@ void start_trace(char* filename) {
     // Allocate an array of arrays of trace records, one per worker thread plus one
     // for the 0 thread (the main thread, or in an unthreaded program, the only
     // thread).
-    _lf_number_of_trace_buffers = _lf_number_of_workers + 1;
+    _lf_number_of_trace_buffers = _lf_instance->number_of_workers + 1;
     _lf_trace_buffer = (trace_record_t**)malloc(sizeof(trace_record_t*) * _lf_number_of_trace_buffers);
     for (int i = 0; i < _lf_number_of_trace_buffers; i++) {
         _lf_trace_buffer[i] = (trace_record_t*)malloc(sizeof(trace_record_t) * TRACE_BUFFER_CAPACITY);
@@ -381,6 +383,7 @@ void start_trace(char* filename) {
  * @param trigger Pointer to the trigger_t struct for calls to schedule or NULL otherwise.
  * @param extra_delay The extra delay passed to schedule(). If not relevant for this event
  *  type, pass 0.
+ * This does nothing unless tracing has started and has not stopped.
  */
 void tracepoint(
         trace_event_t event_type,
@@ -391,6 +394,11 @@ void tracepoint(
         trigger_t* trigger,
         interval_t extra_delay
 ) {
+    // Code that runs without start_trace(), such as unit tests of the
+    // runtime, has no trace buffers.
+    if (_lf_trace_stop) {
+        return;
+    }
     // printf("DEBUG: Creating trace record.\n");
     // Flush the buffer if it is full.
     int index = (worker >= 0) ? worker : 0;
@@ -410,7 +418,7 @@ void tracepoint(
     if (physical_time != NULL) {
         _lf_trace_buffer[index][i].physical_time = *physical_time;
     } else {
-        _lf_trace_buffer[index][i].physical_time = lf_time_physical();
+        _lf_trace_buffer[index][i].physical_time = lf_time_physical_fast();
     }
     _lf_trace_buffer_size[index]++;
     _lf_trace_buffer[index][i].trigger = trigger;
@@ -0,0 +1,110 @@
+/*************
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************/
+
+/**
+ * @file pool.c
+ * @brief A pool of memory blocks of equal size. See pool.h.
+ */
+
+#include <stdalign.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+int pool_init(pool_t* pool, size_t block_size, size_t capacity) {
+    // Each free block holds the link to the next one, and every block must
+    // be aligned as malloc() would align it.
+    if (block_size < sizeof(void*)) {
+        block_size = sizeof(void*);
+    }
+    size_t alignment = alignof(max_align_t);
+    block_size = (block_size + alignment - 1) / alignment * alignment;
+
+    pool->block_size = block_size;
+    pool->capacity = capacity;
+    pool->free_blocks = NULL;
+    pool->in_use = 0;
+    pool->high_water_mark = 0;
+    pool->blocks = NULL;
+    if (capacity > 0) {
+        pool->blocks = (char*)malloc(block_size * capacity);
+        if (pool->blocks == NULL) {
+            pool->capacity = 0;
+            return -1;
+        }
+    }
+    // Chain the blocks so that they are taken in order of their addresses.
+    for (size_t i = capacity; i > 0; i--) {
+        void** block = (void**)(pool->blocks + (i - 1) * block_size);
+        *block = pool->free_blocks;
+        pool->free_blocks = block;
+    }
+#ifdef NUMBER_OF_WORKERS
+    lf_mutex_init(&pool->mutex);
+#endif
+    return 0;
+}
+
+void* pool_take(pool_t* pool) {
+#ifdef NUMBER_OF_WORKERS
+    lf_mutex_lock(&pool->mutex);
+#endif
+    void** block = (void**)pool->free_blocks;
+    if (block != NULL) {
+        pool->free_blocks = *block;
+        if (++pool->in_use > pool->high_water_mark) {
+            pool->high_water_mark = pool->in_use;
+        }
+    }
+#ifdef NUMBER_OF_WORKERS
+    lf_mutex_unlock(&pool->mutex);
+#endif
+    return block;
+}
+
+void pool_give(pool_t* pool, void* block) {
+#ifdef NUMBER_OF_WORKERS
+    lf_mutex_lock(&pool->mutex);
+#endif
+    *(void**)block = pool->free_blocks;
+    pool->free_blocks = block;
+    pool->in_use--;
+#ifdef NUMBER_OF_WORKERS
+    lf_mutex_unlock(&pool->mutex);
+#endif
+}
+
+bool pool_contains(pool_t* pool, const void* pointer) {
+    const char* p = (const char*)pointer;
+    return pool->blocks != NULL && p >= pool->blocks
+            && p < pool->blocks + pool->block_size * pool->capacity;
+}
+
+void pool_free(pool_t* pool) {
+    free(pool->blocks);
+    pool->blocks = NULL;
+    pool->free_blocks = NULL;
+    pool->capacity = 0;
+    pool->in_use = 0;
+}
@@ -36,6 +36,7 @@
 #include <string.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "pqueue.h"
 #include "util.h"
@@ -107,7 +108,11 @@ void* find_equal_same_priority(pqueue_t *q, void *e, int pos) {
         return NULL;
     }
 
-    if (q->getpri(curr) == q->getpri(e) && q->eqelem(curr, e)) {
+    // At this point, curr does not rank after e. It has the same priority
+    // if e does not rank after curr either. Priorities are compared using
+    // cmppri rather than == so that priorities that refer to compound keys,
+    // such as the tag of an event, are supported.
+    if (!q->cmppri(q->getpri(e), q->getpri(curr)) && q->eqelem(curr, e)) {
         return curr;
     } else {
         rval = find_equal_same_priority(q, e, LF_LEFT(pos));
@@ -384,6 +389,14 @@ int in_reverse_order(pqueue_pri_t thiz, pqueue_pri_t that) {
     return (thiz > that);
 }
 
+/**
+ * Return whether the tags of the events given as priorities are in reverse order.
+ * The priorities are the events themselves, as reported by get_event_tag().
+ */
+int in_reverse_tag_order(pqueue_pri_t thiz, pqueue_pri_t that) {
+    return (lf_tag_compare(((event_t*)thiz)->tag, ((event_t*)that)->tag) > 0);
+}
+
 /**
  * Return false (0) regardless of reaction order.
  */
@@ -407,11 +420,12 @@ int reaction_matches(void* next, void* curr) {
 }
 
 /**
- * Report a priority equal to the time of the given event.
- * Used for sorting pointers to event_t structs in the event queue.
+ * Report the given event itself as its priority.
+ * A tag (time, microstep) does not fit into a pqueue_pri_t, so the
+ * event queue compares the tags of the events using in_reverse_tag_order().
  */
-pqueue_pri_t get_event_time(void *a) {
-    return (pqueue_pri_t)(((event_t*) a)->time);
+pqueue_pri_t get_event_tag(void *a) {
+    return (pqueue_pri_t)(uintptr_t)a;
 }
 
 /**
@@ -469,6 +483,6 @@ void print_reaction(void *reaction) {
  */
 void print_event(void *event) {
     event_t *e = (event_t*)event;
-    LF_PRINT_DEBUG("time: " PRINTF_TIME ", trigger: %p, token: %p",
-            e->time, e->trigger, e->token);
+    LF_PRINT_DEBUG("tag: " PRINTF_TAG ", trigger: %p, token: %p",
+            e->tag.time, e->tag.microstep, e->trigger, e->token);
 }
@@ -50,6 +50,14 @@ static int in_reverse_order(pqueue_pri_t thiz, pqueue_pri_t that) {
     return (thiz > that);
 }
 
+/**
+ * Return whether the tags of the events given as priorities are in reverse order.
+ * The priorities are the events themselves, as reported by get_event_tag().
+ */
+static int in_reverse_tag_order(pqueue_pri_t thiz, pqueue_pri_t that) {
+    return (lf_tag_compare(((event_t*)thiz)->tag, ((event_t*)that)->tag) > 0);
+}
+
 /**
  * Return false (0) regardless of reaction order.
  */
@@ -73,11 +81,12 @@ static int reaction_matches(void* next, void* curr) {
 }
 
 /**
- * Report a priority equal to the time of the given event.
- * Used for sorting pointers to event_t structs in the event queue.
+ * Report the given event itself as its priority.
+ * A tag (time, microstep) does not fit into a pqueue_pri_t, so the
+ * event queue compares the tags of the events using in_reverse_tag_order().
  */
-static pqueue_pri_t get_event_time(void *a) {
-    return (pqueue_pri_t)(((event_t*) a)->time);
+static pqueue_pri_t get_event_tag(void *a) {
+    return (pqueue_pri_t)(uintptr_t)a;
 }
 
 /**
@@ -135,8 +144,8 @@ static void print_reaction(void *reaction) {
  */
 static void print_event(void *event) {
 	event_t *e = (event_t*)event;
-    LF_PRINT_DEBUG("time: " PRINTF_TIME ", trigger: %p, token: %p",
-			e->time, e->trigger, e->token);
+    LF_PRINT_DEBUG("tag: " PRINTF_TAG ", trigger: %p, token: %p",
+			e->tag.time, e->tag.microstep, e->trigger, e->token);
 }
 
 // ********** Priority Queue Support End
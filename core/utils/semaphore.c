@@ -41,12 +41,84 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 semaphore_t* lf_semaphore_new(int count) {
     semaphore_t* semaphore = (semaphore_t*)malloc(sizeof(semaphore_t));
+#ifdef LF_FUTEX_SEMAPHORE
+    semaphore->waiters = 0;
+#else
     lf_cond_init(&semaphore->cond);
     lf_mutex_init(&semaphore->mutex);
+#endif
     semaphore->count = count;
     return semaphore;
 }
 
+#ifdef LF_FUTEX_SEMAPHORE
+/**
+ * @brief Block while the count of the 'semaphore' is 0, until woken up.
+ *
+ * A thread registers as a waiter before it blocks, so a release that adds to
+ * the count before the thread blocks either sees the waiter and wakes it up
+ * or makes lf_futex_wait() return at once because the count is no longer 0.
+ *
+ * @param semaphore Instance of a semaphore.
+ */
+static void _lf_semaphore_block(semaphore_t* semaphore) {
+    lf_atomic_fetch_add(&semaphore->waiters, 1);
+    lf_futex_wait(&semaphore->count, 0);
+    lf_atomic_fetch_add(&semaphore->waiters, -1);
+}
+
+/**
+ * @brief Release the 'semaphore' and add 'i' to its count.
+ *
+ * This wakes up at most 'i' waiting threads, and none if none are waiting.
+ *
+ * @param semaphore Instance of a semaphore
+ * @param i The count to add.
+ */
+void lf_semaphore_release(semaphore_t* semaphore, int i) {
+    assert(semaphore != NULL);
+    lf_atomic_fetch_add(&semaphore->count, i);
+    if (semaphore->waiters > 0) {
+        lf_futex_wake_n(&semaphore->count, i);
+    }
+}
+
+/**
+ * @brief Acquire the 'semaphore'. Will block if count is 0.
+ *
+ * @param semaphore Instance of a semaphore.
+ */
+void lf_semaphore_acquire(semaphore_t* semaphore) {
+    assert(semaphore != NULL);
+    while (true) {
+        int32_t count = semaphore->count;
+        if (count > 0) {
+            if (lf_bool_compare_and_swap(&semaphore->count, count, count - 1)) {
+                return;
+            }
+        } else {
+            _lf_semaphore_block(semaphore);
+        }
+    }
+}
+
+/**
+ * @brief Wait on the 'semaphore' if count is 0.
+ *
+ * @param semaphore Instance of a semaphore.
+ */
+void lf_semaphore_wait(semaphore_t* semaphore) {
+    assert(semaphore != NULL);
+    if (semaphore->count == 0) {
+        do {
+            _lf_semaphore_block(semaphore);
+        } while (semaphore->count == 0);
+        // The wakeup may have been meant for a thread that takes from the
+        // count, so pass it on.
+        lf_futex_wake_n(&semaphore->count, 1);
+    }
+}
+#else
 /**
  * @brief Release the 'semaphore' and add 'i' to its count.
  *
@@ -90,6 +162,8 @@ void lf_semaphore_wait(semaphore_t* semaphore) {
     lf_mutex_unlock(&semaphore->mutex);
 }
 
+#endif // LF_FUTEX_SEMAPHORE
+
 /**
  * @brief Destroy the 'semaphore'.
  *
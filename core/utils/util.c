@@ -106,8 +106,10 @@ void _lf_message_print(
 		// If we make multiple calls to printf(), then the results could be
 		// interleaved between threads.
 		// vprintf() is a version that takes an arg list rather than multiple args.
+		// The format is short, so it goes on the stack, which also avoids heap
+		// allocation in static-memory mode.
 		size_t length = strlen(prefix) + strlen(format) + 32;
-		char* message = (char*) malloc(length + 1);
+		char message[length + 1];
 		if (_lf_my_fed_id < 0) {
 			snprintf(message, length, "%s%s\n",
 					prefix, format);
@@ -124,7 +126,6 @@ void _lf_message_print(
 		} else {
 			(*print_message_function)(message, args);
 		}
-		free(message);
 	}
 }
 
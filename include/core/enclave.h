@@ -0,0 +1,449 @@
+/*************
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************/
+
+/**
+ * @file enclave.h
+ * @brief Enclaves, which are independent scheduling domains within a program,
+ * and instances of programs.
+ *
+ * An enclave is a set of reactors that has its own logical time, event
+ * queue, locks, scheduler instance, and worker threads. Every program has
+ * a main enclave, which holds every reactor that is not explicitly assigned
+ * to another enclave. In the unthreaded runtime, the main enclave is the
+ * only one.
+ *
+ * Enclaves communicate only through actions with a positive delay or through
+ * physical actions. Scheduling an action of another enclave puts an event on
+ * the event queue of that enclave. An enclave that has upstream enclaves
+ * (see lf_enclave_connect()) does not advance its logical time to a tag t
+ * until no upstream enclave can send it an event with a tag at or before t.
+ *
+ * The state that used to be global to the runtime (the current tag, the stop
+ * tag, the event queue, the locks, and so on) is now a field of the enclave
+ * that the calling thread is bound to, _lf_enclave. Worker threads are bound
+ * to their enclave when they start. Every other thread, including those that
+ * call lf_schedule() asynchronously, is bound to the main enclave.
+ *
+ * The state that belongs to a program as a whole (the start time, the
+ * command-line options, the list of enclaves, and so on) is a field of an
+ * instance, lf_instance_t. The threaded runtime can run several instances in
+ * one process, each with its own enclaves and worker threads. A thread is
+ * bound to an instance, _lf_instance, and to an enclave of that instance. By
+ * default, this is the main enclave of _lf_default_instance.
+ */
+
+#ifndef ENCLAVE_H
+#define ENCLAVE_H
+
+#include "lf_types.h"
+#include "pool.h"
+#include "pqueue.h"
+#include "tag.h"
+#include "vector.h"
+
+#ifdef LF_STATIC_MEMORY
+/**
+ * The default number of events for which an instance has memory in
+ * static-memory mode. This can be changed with --max-events.
+ */
+#ifndef LF_STATIC_MAX_EVENTS
+#define LF_STATIC_MAX_EVENTS 1024
+#endif
+
+/**
+ * The default size of the blocks for payloads that the runtime allocates in
+ * static-memory mode. This can be changed with --max-payload-size.
+ */
+#ifndef LF_STATIC_MAX_PAYLOAD_SIZE
+#define LF_STATIC_MAX_PAYLOAD_SIZE 256
+#endif
+
+/**
+ * The default number of reactions that a reaction queue has room for in
+ * static-memory mode when the code generator has not listed the reactions of
+ * an enclave. This can be changed with --max-reactions.
+ */
+#ifndef LF_STATIC_MAX_REACTIONS
+#define LF_STATIC_MAX_REACTIONS 1024
+#endif
+
+/**
+ * What the runtime does when a pool has no free block in static-memory mode,
+ * as chosen with --overflow-policy.
+ */
+typedef enum lf_overflow_policy_t {
+    LF_OVERFLOW_EXIT,   // Report the pool and exit.
+    LF_OVERFLOW_HEAP    // Allocate from the heap and report the number of such allocations at termination.
+} lf_overflow_policy_t;
+#endif
+
+/**
+ * Defined if a program can have more than one enclave and more than one
+ * instance. It cannot without threads, nor in federated execution, with modal
+ * reactors, or with tracing, which keep state in global variables that
+ * enclaves and instances would share.
+ */
+#if defined(NUMBER_OF_WORKERS) && !defined(FEDERATED) && !defined(MODAL_REACTORS) && !defined(LINGUA_FRANCA_TRACE)
+#define LF_ENCLAVES_SUPPORTED
+#endif
+
+/**
+ * The number of buckets of the histogram of the lag of physical time behind
+ * the target time at the end of each wait for physical time to match logical
+ * time. Bucket 0 counts waits that were not late. Bucket i > 0 counts lags in
+ * [2^(i-1), 2^i) nanoseconds, and the last bucket also counts all larger lags.
+ */
+#define LF_WAIT_LAG_HISTOGRAM_BUCKETS 32
+
+#ifdef NUMBER_OF_WORKERS
+/**
+ * A connection from an upstream enclave to a downstream one. Every event that
+ * the upstream enclave sends the downstream one is delayed by at least delay.
+ */
+typedef struct lf_enclave_link_t {
+    struct lf_enclave_t* upstream;
+    interval_t delay;
+} lf_enclave_link_t;
+#endif
+
+/**
+ * The state of an enclave.
+ */
+typedef struct lf_enclave_t {
+    const char* name;                      // The name of the enclave, for diagnostics.
+    int id;                                // 0 for the main enclave. Others are numbered in order of creation.
+    struct lf_enclave_t* next;             // The next enclave in the list of all enclaves.
+    struct lf_instance_t* instance;        // The instance that the enclave belongs to.
+
+    tag_t current_tag;                     // The current logical tag of the enclave.
+    tag_t stop_tag;                        // The tag at which the enclave stops.
+    pqueue_t* event_q;                     // Future events, sorted by tag.
+    pqueue_t* recycle_q;                   // Events that can be reused.
+    trigger_handle_t handle;               // The next handle to return from lf_schedule().
+    bool logical_tag_completed;            // Whether at least one tag has been completed.
+    lf_token_t* token_recycling_bin;       // Freed tokens, chained using their next_free field.
+    int token_recycling_bin_size;          // The number of tokens in the recycling bin.
+    // Only the thread that holds the tag lock of the enclave waits for physical time.
+    size_t wait_lag_histogram[LF_WAIT_LAG_HISTOGRAM_BUCKETS];
+
+    // Tables that are filled in by the code generator and that are used at the
+    // start of each time step. See the corresponding macros in reactor_common.h.
+    bool** is_present_fields;
+    int is_present_fields_size;
+    bool** is_present_fields_abbreviated;
+    int is_present_fields_abbreviated_size;
+    tag_t** intended_tag_fields;
+    int intended_tag_fields_size;
+    token_present_t* tokens_with_ref_count;
+    int tokens_with_ref_count_size;
+    lf_token_t* more_tokens_with_ref_count;
+    vector_t sparse_io_record_sizes;
+    reaction_t** reactions;                // Every reaction of the enclave, or NULL if unknown.
+    int reactions_size;
+    struct lf_flattened_outputs_t* flattened_outputs; // The outputs of reactions flattened so far, to free at termination.
+
+#ifdef NUMBER_OF_WORKERS
+    lf_mutex_t mutex;                      // The tag lock. See reactor_threaded.h.
+    lf_mutex_t event_q_mutex;              // The event queue lock. See reactor_threaded.h.
+    lf_cond_t event_q_changed;             // Goes with event_q_mutex.
+    struct _lf_sched_instance_t* sched_instance;
+    unsigned int number_of_workers;        // 0 means the number of workers of the main enclave.
+    lf_thread_t* thread_ids;
+    int worker_thread_count;               // Used to number the worker threads.
+
+    // Set this to true if a physical action of this enclave can send events to
+    // another enclave. The events that such an enclave sends downstream are
+    // then bounded only by physical time, which downstream enclaves have to
+    // wait for.
+    bool has_physical_actions;
+    lf_enclave_link_t* upstream;           // Connections from upstream enclaves.
+    size_t number_of_upstream;
+    struct lf_enclave_t** affected;        // Enclaves that are directly or indirectly downstream.
+    size_t number_of_affected;
+    tag_t next_event_tag;                  // No event from this enclave will have an earlier tag than this.
+    tag_t* earliest_tags;                  // Scratch space to compute the grant of this enclave.
+    bool terminated;                       // Whether the workers of the enclave have exited.
+    void* volatile parallel_loop;          // The loop of lf_parallel_for() that idle workers can help with, or NULL.
+    volatile int32_t parallel_helpers;     // The number of workers that are helping with it.
+    volatile int32_t suspended_reactions;  // The number of reactions that have let go of their worker at this tag.
+    reaction_t* volatile resumed_reactions; // Suspended reactions that have been resumed and await a worker.
+#endif
+} lf_enclave_t;
+
+/**
+ * The state of an instance of a program.
+ */
+typedef struct lf_instance_t {
+    // The enclave that holds every reactor that is not assigned to another
+    // one. Its current tag is the tag of the program as a whole. The other
+    // enclaves follow it in a list.
+    lf_enclave_t main_enclave;
+    int number_of_enclaves;                // The number of enclaves, including the main enclave.
+
+    instant_t start_time;                  // Logical time at the start of execution.
+    instant_t physical_start_time;         // Physical time at the start of execution.
+    interval_t duration;                   // The timeout given with -o, or -1 if none was given.
+    bool fast;                             // Whether logical time may get ahead of physical time (-f).
+    bool keepalive_specified;              // Whether to keep running when the event queue is empty (-k).
+    unsigned int number_of_workers;        // The number of workers, or 0 to let the runtime decide (-w).
+    bool execution_started;                // Whether execution of the start tag has begun.
+    struct allocation_record_t* reactors_to_free; // The self structs to free at termination.
+    int count_payload_allocations;         // To warn about payloads that are never freed.
+    int count_token_allocations;           // To warn about tokens that are never freed, except the ones of triggers.
+    struct lf_fd_sources_t* fd_sources;    // The file descriptors registered with lf_register_fd(), if any.
+
+#ifdef LF_STATIC_MEMORY
+    // In static-memory mode, events, tokens, and the payloads that the
+    // runtime allocates come from these pools, which initialize() sizes.
+    size_t max_events;                     // The number of events (--max-events).
+    size_t max_tokens;                     // The number of tokens and payloads (--max-tokens), or 0 for the default.
+    size_t max_payload_size;               // The size of a payload block (--max-payload-size).
+    size_t max_reactions;                  // The capacity of reaction queues (--max-reactions), or 0 for the default.
+    lf_overflow_policy_t overflow_policy;  // What to do when a pool is exhausted (--overflow-policy).
+    pool_t event_pool;
+    pool_t token_pool;
+    pool_t payload_pool;
+    int pool_overflows;                    // The number of allocations from the heap under LF_OVERFLOW_HEAP.
+#endif
+
+#ifdef NUMBER_OF_WORKERS
+    lf_mutex_t enclave_mutex;              // Protects the next event tags of the enclaves (see enclave.c).
+    volatile int enclave_epoch;            // Incremented when the grant of an enclave may have increased.
+    unsigned int min_workers;              // The number of workers that are never parked, or 0 for all (--min-workers).
+    const char* sched_profile;             // The profile file of the adaptive scheduler, or NULL (--sched-profile).
+#endif
+} lf_instance_t;
+
+/**
+ * The initial state of an instance.
+ * @param self The address of the instance.
+ */
+#define LF_INSTANCE_INITIALIZER(self) { \
+    .main_enclave = { \
+        .name = "main", \
+        .id = 0, \
+        .instance = (self), \
+        .stop_tag = FOREVER_TAG_INITIALIZER, \
+        .handle = 1 \
+    }, \
+    .number_of_enclaves = 1, \
+    .start_time = NEVER, \
+    .physical_start_time = NEVER, \
+    .duration = -1LL \
+    _LF_STATIC_MEMORY_INITIALIZER \
+}
+
+#ifdef LF_STATIC_MEMORY
+#define _LF_STATIC_MEMORY_INITIALIZER , \
+    .max_events = LF_STATIC_MAX_EVENTS, \
+    .max_payload_size = LF_STATIC_MAX_PAYLOAD_SIZE
+#else
+#define _LF_STATIC_MEMORY_INITIALIZER
+#endif
+
+/** The instance that threads are bound to unless they bind to another one. */
+extern lf_instance_t _lf_default_instance;
+
+#ifdef NUMBER_OF_WORKERS
+/** The instance that the calling thread is bound to. */
+extern LF_THREAD_LOCAL lf_instance_t* _lf_instance;
+
+/** The enclave that the calling thread is bound to. */
+extern LF_THREAD_LOCAL lf_enclave_t* _lf_enclave;
+#else
+// Without threads, there is only the default instance, which has only the main enclave.
+#define _lf_instance (&_lf_default_instance)
+#define _lf_enclave (&_lf_main_enclave)
+#endif
+
+/** The main enclave of the instance that the calling thread is bound to. */
+#define _lf_main_enclave (_lf_instance->main_enclave)
+
+/**
+ * Return the enclave of a reactor.
+ * @param self The self struct of the reactor.
+ */
+static inline lf_enclave_t* lf_enclave_of(self_base_t* self) {
+    return (self == NULL || self->enclave == NULL) ? &_lf_main_enclave : self->enclave;
+}
+
+/**
+ * Return the enclave that a trigger belongs to, which is the enclave of
+ * the reactions that it triggers, or the main enclave if it triggers none.
+ * @param trigger The trigger.
+ */
+static inline lf_enclave_t* lf_enclave_of_trigger(trigger_t* trigger) {
+    if (trigger == NULL || trigger->number_of_reactions <= 0) {
+        return &_lf_main_enclave;
+    }
+    return lf_enclave_of((self_base_t*)trigger->reactions[0]->self);
+}
+
+#ifdef NUMBER_OF_WORKERS
+/**
+ * Create an enclave. This is meant to be called by the code generator in
+ * _lf_initialize_trigger_objects(), which assigns the enclave to reactors by
+ * setting the enclave field of their self struct and fills in the tables
+ * of the enclave while it binds _lf_enclave to the enclave.
+ *
+ * Execution with more than one enclave is not supported in federated
+ * execution, with modal reactors, with tracing, or with schedulers other than
+ * NP and GEDF_NP. This exits with an error in those cases.
+ *
+ * @param name The name of the enclave.
+ * @param number_of_workers The number of worker threads of the enclave, or 0
+ *  for the same number as the main enclave.
+ * @return The new enclave.
+ */
+lf_enclave_t* lf_enclave_create(const char* name, unsigned int number_of_workers);
+
+/**
+ * Declare that reactors of the upstream enclave can schedule actions of the
+ * downstream enclave with at least the given delay. The downstream enclave
+ * then coordinates its advancement of logical time with the upstream one.
+ * This must be called before execution starts.
+ *
+ * @param upstream The upstream enclave.
+ * @param downstream The downstream enclave.
+ * @param delay The minimum delay of the connection, which must be positive.
+ */
+void lf_enclave_connect(lf_enclave_t* upstream, lf_enclave_t* downstream, interval_t delay);
+
+/**
+ * Schedule a trigger of another enclave than the one that the calling thread
+ * is bound to. A logical action is scheduled at the tag of the calling
+ * enclave delayed by the offset of the action plus extra_delay. A physical
+ * action is scheduled as usual. A token that is shared with reactors of the
+ * calling enclave is copied while the calling thread holds the event_q_mutex
+ * of the destination, so that the two enclaves do not share reference counts
+ * and the copy belongs to the destination. If the delay is below that of the
+ * connection between the enclaves, the event is rejected and a token that
+ * nothing refers to is freed.
+ *
+ * @param destination The enclave of the trigger.
+ * @param trigger The trigger.
+ * @param extra_delay The delay in addition to the offset of the trigger.
+ * @param token The token carrying the payload, or NULL.
+ * @return A handle to the event, or 0 if no new event was scheduled, or -1 for error.
+ */
+trigger_handle_t _lf_enclave_schedule(lf_enclave_t* destination, trigger_t* trigger, interval_t extra_delay, lf_token_t* token);
+
+/**
+ * Schedule a trigger of another enclave than the one that the calling thread
+ * is bound to, as _lf_enclave_schedule() does, with a new token that carries
+ * the given value. The token is created while the calling thread holds the
+ * event_q_mutex of the destination, so that it belongs to the destination.
+ *
+ * @param destination The enclave of the trigger.
+ * @param trigger The trigger.
+ * @param extra_delay The delay in addition to the offset of the trigger.
+ * @param value The value, which must be on the heap unless copy is true.
+ * @param length The length of the value, or 1 if it is not an array.
+ * @param copy Whether to copy the value instead of taking ownership of it.
+ * @return A handle to the event, or 0 if no new event was scheduled, or -1 for error.
+ */
+trigger_handle_t _lf_enclave_schedule_value(lf_enclave_t* destination, trigger_t* trigger, interval_t extra_delay,
+        void* value, size_t length, bool copy);
+
+/**
+ * Wait until no upstream enclave can send the enclave that the calling thread
+ * is bound to an event with a tag at or before the given tag. This returns
+ * immediately if the enclave has no upstream enclaves. The caller must hold
+ * the mutex of the enclave, which is released while waiting.
+ *
+ * @param tag The tag that the enclave proposes to advance to.
+ * @return true if it is safe to advance to the tag, false if the wait was
+ *  interrupted because the event queue or the stop tag changed.
+ */
+bool _lf_enclave_wait_for_grant(tag_t tag);
+
+/**
+ * Return true if an upstream enclave of the enclave that the calling thread
+ * is bound to may still send it events. The caller must hold the mutex of
+ * the enclave, but not its event_q_mutex.
+ */
+bool _lf_enclave_expects_events();
+
+/**
+ * Publish the earliest tag of any event that the enclave that the calling
+ * thread is bound to may still send, and notify the enclaves downstream of
+ * it. The caller must hold the mutex of the enclave, but not its event_q_mutex.
+ * @param tag The tag, or FOREVER_TAG if the enclave will send no more events.
+ */
+void _lf_enclave_publish_next_event_tag(tag_t tag);
+
+/**
+ * Stop every enclave other than the one that the calling thread is bound to at
+ * the given tag, or at the next microstep of an enclave that is already past it.
+ * The caller must not hold any lock.
+ * @param tag The stop tag of the calling enclave.
+ */
+void _lf_enclave_request_stop(tag_t tag);
+
+/**
+ * Create an instance of the program, which a host can run with
+ * lf_instance_run() alongside other instances. The code generator must keep
+ * the state of the program that it allocates in _lf_initialize_trigger_objects()
+ * per instance for the instances to be independent. Instances are not
+ * supported in the same cases as enclaves (see lf_enclave_create()).
+ * @return The new instance.
+ */
+lf_instance_t* lf_instance_create();
+
+/**
+ * Bind the calling thread to the main enclave of an instance. A thread that
+ * calls lf_schedule() for reactors of an instance other than the default
+ * one must first bind itself to that instance.
+ * @param instance The instance.
+ */
+void lf_instance_bind(lf_instance_t* instance);
+
+/**
+ * Run an instance to completion in the calling thread and its own worker
+ * threads, given the command-line arguments of the instance. This binds the
+ * calling thread to the instance, and the instance terminates when this
+ * returns, which is unlike lf_reactor_c_main(), which terminates the default
+ * instance at exit.
+ * @param instance The instance.
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line arguments.
+ * @return 0 on success, 1 if a worker thread reported an error, and -1 if the
+ *  arguments are invalid.
+ */
+int lf_instance_run(lf_instance_t* instance, int argc, const char* argv[]);
+
+/**
+ * Free an instance that has been run, including its enclaves and their events.
+ * @param instance The instance, which must not be the default one.
+ */
+void lf_instance_free(lf_instance_t* instance);
+
+/**
+ * Prepare the coordination of the enclaves. This is called once, after all
+ * enclaves have been created and connected and before execution starts.
+ */
+void _lf_enclave_initialize_coordination();
+#endif // NUMBER_OF_WORKERS
+
+#endif // ENCLAVE_H
@@ -0,0 +1,131 @@
+/*************
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************/
+
+/**
+ * @file fd_source.h
+ * @brief File descriptors as sources of physical actions.
+ *
+ * Instead of creating a thread that blocks on a read and then calls
+ * lf_schedule(), a program can register a file descriptor, such as a socket,
+ * a pipe, a timerfd, or an eventfd, with lf_register_fd(). The runtime then
+ * waits for all registered file descriptors at once and schedules the
+ * associated physical action whenever one of them becomes readable.
+ *
+ * In the threaded runtime, a single thread per instance, created on the first
+ * registration, waits for the file descriptors with epoll. In the unthreaded
+ * runtime, the main thread waits for them instead of sleeping while it waits
+ * for physical time to reach the time of the next event, so file descriptors
+ * become a safe way to bring asynchronous input into an unthreaded program.
+ * Either way, use keepalive if the program should keep running while its
+ * event queue is empty.
+ *
+ * File descriptor sources are only supported on Linux.
+ */
+
+#ifndef FD_SOURCE_H
+#define FD_SOURCE_H
+
+#include <stdbool.h>
+
+#include "tag.h"
+
+/**
+ * The maximum number of bytes that the default handler reads from a file
+ * descriptor each time that it becomes readable.
+ */
+#ifndef LF_FD_READ_SIZE
+#define LF_FD_READ_SIZE 4096
+#endif
+
+/**
+ * A function that handles a file descriptor that has become readable.
+ * It is responsible for reading from the file descriptor and for scheduling
+ * the action, if appropriate. In the threaded runtime, it is called on the
+ * thread that waits for the file descriptors, so it should not block.
+ * @param fd The file descriptor.
+ * @param action The action given to lf_register_fd().
+ * @param user_data The user data given to lf_register_fd().
+ */
+typedef void (*lf_fd_handler_t)(int fd, void* action, void* user_data);
+
+/**
+ * Schedule the specified physical action whenever the specified file
+ * descriptor becomes readable.
+ *
+ * If no handler is given, the runtime reads at most LF_FD_READ_SIZE bytes
+ * from the file descriptor and schedules the action with a copy of them,
+ * as lf_schedule_copy() would, so the number of bytes read should be a
+ * multiple of the element size of the action. Reading 8 bytes from a timerfd
+ * or an eventfd, for example, suits an action of type uint64_t. At the end
+ * of the file, the file descriptor is unregistered and the action is
+ * scheduled without a value.
+ *
+ * @param fd The file descriptor, which must not already be registered.
+ * @param action The physical action.
+ * @param handler The function that reads from the file descriptor, or NULL
+ *  to use the default handler.
+ * @param user_data A pointer to pass to the handler.
+ * @return 0 on success, or -1 with errno set on failure. errno is ENOTSUP
+ *  on platforms that do not support file descriptor sources.
+ */
+int lf_register_fd(int fd, void* action, lf_fd_handler_t handler, void* user_data);
+
+/**
+ * Stop watching the specified file descriptor. Once this returns, the handler
+ * of the file descriptor is not running and will not be called again, so the
+ * file descriptor can be closed. This may be called from the handler itself.
+ * @param fd A file descriptor given to lf_register_fd().
+ * @return 0 on success, or -1 if the file descriptor is not registered.
+ */
+int lf_unregister_fd(int fd);
+
+/**
+ * Wait until the physical clock reaches the specified time, as lf_sleep_until()
+ * does, while handling the registered file descriptors, if any, of the
+ * instance that the calling thread is bound to. This is used by the unthreaded
+ * runtime.
+ * @param wakeup_time The time to wait for, on the clock of lf_sleep_until().
+ * @return 0 if the time was reached, or -1 if the wait was interrupted,
+ *  which it is after the handler of a file descriptor was called.
+ */
+int _lf_fd_sleep_until(instant_t wakeup_time);
+
+/**
+ * Handle the registered file descriptors of the instance that the calling
+ * thread is bound to that are readable. This is used by the unthreaded
+ * runtime in fast mode, when it does not wait for physical time.
+ * @param wait Whether to wait until at least one file descriptor is readable,
+ *  if any are registered. Otherwise, this does not wait.
+ * @return The number of file descriptors that were handled.
+ */
+int _lf_fd_poll(bool wait);
+
+/**
+ * Stop watching all file descriptors of the instance that the calling thread
+ * is bound to and free the resources used to do so. This is called at
+ * termination.
+ */
+void _lf_fd_sources_free(void);
+
+#endif // FD_SOURCE_H
@@ -101,7 +101,7 @@ ssize_t read_from_socket(int socket, size_t num_bytes, unsigned char* buffer);
  * @param socket The socket ID.
  * @param num_bytes The number of bytes to write.
  * @param buffer The buffer from which to get the bytes.
- * @param mutex If non-NULL, the mutex to unlock before exiting.
+ * @param lock If non-NULL, the mutex to unlock before exiting.
  * @param format A format string for error messages, followed by any number of
  *  fields that will be used to fill the format string as in printf, or NULL
  *  to prevent exit on error.
@@ -112,7 +112,7 @@ ssize_t write_to_socket_errexit_with_mutex(
 		int socket,
 		size_t num_bytes,
 		unsigned char* buffer,
-		lf_mutex_t* mutex,
+		lf_mutex_t* lock,
 		char* format, ...);
 
 /**
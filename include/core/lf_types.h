@@ -102,6 +102,24 @@ typedef enum {absent = false, present = true, unknown} port_status_t;
  */
 typedef enum {inactive = 0, queued, running} reaction_status_t;
 
+/**
+ * Suspension state of a reaction (see lf_reaction_suspend()).
+ * A reaction is 'suspending' from the time it calls lf_reaction_suspend()
+ * until the worker thread that executes it lets go of it. From then on, it
+ * is 'suspended' until lf_reaction_resume() is called. If that happens
+ * before the worker thread has let go of it, the reaction goes straight from
+ * 'suspending' to 'resumed'. It is no longer suspended once its continuation
+ * starts.
+ *
+ * @note reaction_not_suspended must equal zero for the same reason as inactive.
+ */
+typedef enum {
+    reaction_not_suspended = 0,
+    reaction_suspending,
+    reaction_suspended,
+    reaction_resumed
+} reaction_suspension_state_t;
+
 /**
  * Handles for scheduled triggers. These handles are returned
  * by lf_schedule() functions. The intent is that the handle can be
@@ -132,9 +150,25 @@ typedef pqueue_pri_t index_t;
  */
 typedef void(*reaction_function_t)(void*);
 
+/**
+ * Continuation function type. A continuation is the part of a reaction that
+ * executes once the reaction has been resumed (see lf_reaction_suspend()).
+ * The first argument is a pointer to the self struct for the reactor and the
+ * second is the argument given to lf_reaction_suspend().
+ */
+typedef void(*lf_continuation_t)(void*, void*);
+
 /** Trigger struct representing an output, timer, action, or input. See below. */
 typedef struct trigger_t trigger_t;
 
+/**
+ * Function that releases a buffer that the program, not the runtime, owns
+ * once the last token that carries it is freed (see lf_token_wrap()).
+ * The arguments are the value and length of the token and the context given
+ * when the token was created.
+ */
+typedef void(*lf_token_release_t)(void* value, size_t length, void* context);
+
 /**
  * Token type for dynamically allocated arrays and structs sent as messages.
  *
@@ -152,7 +186,23 @@ typedef struct trigger_t trigger_t;
  * that carries the message.  The message can be an array of values,
  * where the size of each value is element_size (in bytes). If it is
  * not an array, the length == 1.
+ *
+ * A payload of at most LF_TOKEN_INLINE_SIZE bytes that the runtime allocates
+ * for a token without a destructor, as lf_schedule_copy(), lf_set_new() and
+ * writable copies do, is stored in the token itself, so that it costs neither
+ * an allocation nor a free. The value then points into the token and remains
+ * valid for as long as the token does.
+ *
+ * A token can also be a view of a slice of the array of another token, its
+ * parent, created with lf_token_slice(). A view shares the payload of its
+ * parent, on which it holds a reference until it is itself freed. Finally, a
+ * token can carry a buffer that the program owns, such as a memory-mapped
+ * file, which is handed back to the program through the release function of
+ * the token, created with lf_token_wrap(), instead of being freed.
  */
+#ifndef LF_TOKEN_INLINE_SIZE
+#define LF_TOKEN_INLINE_SIZE 16
+#endif
 typedef struct lf_token_t {
     /** Pointer to dynamically allocated memory containing a message. */
     void* value;
@@ -174,6 +224,21 @@ typedef struct lf_token_t {
     ok_to_free_t ok_to_free;
     /** For recycling, a pointer to the next token in the recycling bin. */
     struct lf_token_t* next_free;
+    /** For a view, the token that owns the payload, or NULL otherwise. */
+    struct lf_token_t* parent;
+    /** For a token that carries a buffer owned by the program, the function that releases it. */
+    lf_token_release_t release;
+    /** The context to pass to the release function. */
+    void* release_context;
+#if LF_TOKEN_INLINE_SIZE > 0
+    /** Storage for a small payload, to which value then points. */
+    union {
+        unsigned char bytes[LF_TOKEN_INLINE_SIZE];
+        long long align_integer;
+        double align_double;
+        void* align_pointer;
+    } inline_value;
+#endif
 } lf_token_t;
 
 /** A struct with a pointer to a lf_token_t and an _is_present variable
@@ -195,12 +260,16 @@ typedef struct token_present_t {
  * The fields marked RUNTIME have values that change
  * during execution.
  * Instances of this struct are put onto the reaction queue by the scheduler.
+ *
+ * The fields that are used whenever the reaction is triggered or executed
+ * come first, so that they span as few cache lines as possible, and the
+ * fields that are only used for logging, for handling violations, or to
+ * flatten the connections of the reaction come last.
  */
 typedef struct reaction_t reaction_t;
 struct reaction_t {
-    reaction_function_t function; // The reaction function. COMMON.
-    void* self;    // Pointer to a struct with the reactor's state. INSTANCE.
-    int number;    // The number of the reaction in the reactor (0 is the first reaction).
+    reaction_status_t status; // Indicator of whether the reaction is inactive, queued, or running. RUNTIME.
+    size_t pos;       // Current position in the priority queue. RUNTIME.
     index_t index; // Inverse priority determined by dependency analysis. INSTANCE.
     // Binary encoding of the branches that this reaction has upstream in the dependency graph. INSTANCE.
     #ifdef BIT_32 // Use a reduced width for chain IDs on 32-bit systems.
@@ -208,70 +277,82 @@ struct reaction_t {
     #else
     unsigned long long chain_id;
     #endif
-    size_t pos;       // Current position in the priority queue. RUNTIME.
+    reaction_function_t function; // The reaction function. COMMON.
+    void* self;    // Pointer to a struct with the reactor's state. INSTANCE.
+    interval_t deadline;      // Deadline relative to the time stamp for invocation of the reaction. INSTANCE.
     reaction_t* last_enabling_reaction; // The last enabling reaction, or NULL if there is none. Used for optimization. INSTANCE.
     size_t num_outputs;  // Number of outputs that may possibly be produced by this function. COMMON.
     bool** output_produced;   // Array of pointers to booleans indicating whether outputs were produced. COMMON.
-    int* triggered_sizes;     // Pointer to array of ints with number of triggers per output. INSTANCE.
-    trigger_t ***triggers;    // Array of pointers to arrays of pointers to triggers triggered by each output. INSTANCE.
-    reaction_status_t status; // Indicator of whether the reaction is inactive, queued, or running. RUNTIME.
-    interval_t deadline;      // Deadline relative to the time stamp for invocation of the reaction. INSTANCE.
+    size_t* downstream_offsets;       // For each output, and past the last one, the offset of its reactions
+                                      // in downstream_reactions, or NULL until they are flattened. RUNTIME.
+    reaction_t** downstream_reactions; // The reactions triggered by each output, without duplicates and sorted
+                                       // by level, flattened from triggers at startup or when the reaction
+                                       // first executes. RUNTIME.
+    bool is_a_control_reaction; // Indicates whether this reaction is a control reaction. Control
+                                // reactions will not set ports or actions and don't require scheduling
+                                // any output reactions. Default is false.
     bool is_STP_violated;     // Indicator of STP violation in one of the input triggers to this reaction. default = false.
                               // Value of True indicates to the runtime that this reaction contains trigger(s)
                               // that are triggered at a later logical time that was originally anticipated.
                               // Currently, this is only possible if logical
                               // connections are used in a decentralized federated
                               // execution. COMMON.
+    size_t worker_affinity;     // The worker number of the thread that scheduled this reaction. Used
+                                // as a suggestion to the scheduler.
+    reactor_mode_t* mode;       // The enclosing mode of this reaction (if exists).
+                                // If enclosed in multiple, this will point to the innermost mode.
+    struct {
+        volatile int32_t state;         // A reaction_suspension_state_t.
+        lf_continuation_t continuation; // The function to call when the reaction is resumed.
+        void* arg;                      // The argument to pass to the continuation.
+        struct lf_enclave_t* enclave;   // The enclave whose workers execute the continuation.
+        reaction_t* next;               // The next reaction on the list of resumed reactions of the enclave.
+    } suspension;               // The state of the reaction while it is suspended. RUNTIME.
+    int number;    // The number of the reaction in the reactor (0 is the first reaction).
+    const char* name;                 // If logging is set to LOG or higher, then this will
+                                // point to the full name of the reactor followed by
+                                // the reaction number.
+    int* triggered_sizes;     // Pointer to array of ints with number of triggers per output. INSTANCE.
+    trigger_t ***triggers;    // Array of pointers to arrays of pointers to triggers triggered by each output. INSTANCE.
     reaction_function_t deadline_violation_handler; // Deadline violation handler. COMMON.
     reaction_function_t STP_handler;   // STP handler. Invoked when a trigger to this reaction
                                        // was triggered at a later logical time than originally
                                        // intended. Currently, this is only possible if logical
                                        // connections are used in a decentralized federated
                                        // execution. COMMON.
-    bool is_a_control_reaction; // Indicates whether this reaction is a control reaction. Control
-                                // reactions will not set ports or actions and don't require scheduling
-                                // any output reactions. Default is false.
-    size_t worker_affinity;     // The worker number of the thread that scheduled this reaction. Used
-                                // as a suggestion to the scheduler.
-    const char* name;                 // If logging is set to LOG or higher, then this will
-                                // point to the full name of the reactor followed by
-                                // the reaction number.
-    reactor_mode_t* mode;       // The enclosing mode of this reaction (if exists).
-                                // If enclosed in multiple, this will point to the innermost mode.
 };
 
 /** Typedef for event_t struct, used for storing activation records. */
 typedef struct event_t event_t;
 
-/** Event activation record to push onto the event queue. */
+/**
+ * Event activation record to push onto the event queue.
+ * The event queue is ordered by the full tag (time, microstep) of its events,
+ * so events lined up in superdense time are simply distinct entries on the
+ * queue that differ only in their microstep.
+ */
 struct event_t {
-    instant_t time;           // Time of release.
+    tag_t tag;                // Tag of release.
     trigger_t* trigger;       // Associated trigger, NULL if this is a dummy event.
     size_t pos;               // Position in the priority queue.
     lf_token_t* token;        // Pointer to the token wrapping the value.
-    bool is_dummy;            // Flag to indicate whether this event is merely a placeholder or an actual event.
 #ifdef FEDERATED
     tag_t intended_tag;       // The intended tag.
 #endif
-    event_t* next;            // Pointer to the next event lined up in superdense time.
 };
 
 /**
  * Trigger struct representing an output, timer, action, or input.
  * Instances of this struct are put onto the event queue (event_q).
+ * The fields that every program uses come first, with the small ones packed
+ * together, and the fields that only federated programs use come last.
  */
 struct trigger_t {
     reaction_t** reactions;   // Array of pointers to reactions sensitive to this trigger.
     int number_of_reactions;  // Number of reactions sensitive to this trigger.
     bool is_timer;            // True if this is a timer (a special kind of action), false otherwise.
-    interval_t offset;        // Minimum delay of an action. For a timer, this is also the maximum delay.
-    interval_t period;        // Minimum interarrival time of an action. For a timer, this is also the maximal interarrival time.
-    lf_token_t* token;           // Pointer to a token wrapping the payload (or NULL if there is none).
     bool is_physical;         // Indicator that this denotes a physical action.
-    event_t* last;            // Pointer to the last event that was scheduled for this action.
     lf_spacing_policy_t policy;          // Indicates which policy to use when an event is scheduled too early.
-    size_t element_size;      // The size of the payload, if there is one, zero otherwise.
-                              // If the payload is an array, then this is the size of an element of the array.
     port_status_t status;     // Determines the status of the port at the current logical time. Therefore, this
                               // value needs to be reset at the beginning of each logical time.
                               //
@@ -288,8 +369,16 @@ struct trigger_t {
                               //   coordination.
                               // - Finally, if status is 'present', then this is an error since multiple
                               //   downstream messages have been produced for the same port for the same logical time.
+    interval_t offset;        // Minimum delay of an action. For a timer, this is also the maximum delay.
+    interval_t period;        // Minimum interarrival time of an action. For a timer, this is also the maximal interarrival time.
+    lf_token_t* token;           // Pointer to a token wrapping the payload (or NULL if there is none).
+    event_t* last;            // Pointer to the last event that was scheduled for this action.
+    tag_t last_tag;           // Tag of the latest event that was scheduled for this trigger.
+    size_t element_size;      // The size of the payload, if there is one, zero otherwise.
+                              // If the payload is an array, then this is the size of an element of the array.
     reactor_mode_t* mode;     // The enclosing mode of this reaction (if exists).
                               // If enclosed in multiple, this will point to the innermost mode.
+    // The fields below are only used by federated programs.
 #ifdef FEDERATED
     tag_t last_known_status_tag;        // Last known status of the port, either via a timed message, a port absent, or a
                                         // TAG from the RTI.
@@ -326,6 +415,7 @@ typedef struct allocation_record_t {
 typedef struct self_base_t {
 	struct allocation_record_t *allocations;
 	struct reaction_t *executing_reaction;   // The currently executing reaction of the reactor.
+	struct lf_enclave_t *enclave;            // The enclave of the reactor, or NULL for the main enclave.
 #ifdef MODAL_REACTORS
     reactor_mode_state_t _lf__mode_state;    // The current mode (for modal models).
 #endif
@@ -88,6 +88,26 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  If you increment it 24 times, it will cover all possible value
  (albeit in a strange order because of the permutation) and return
  to the original value with digits 0, 0, 0.
+
+ The functions above recompute the products of the radixes on every
+ call. To visit many values of the same number, as when connecting
+ the members of large banks, use an iterator instead, which computes
+ the products once:
+ ```
+        int strides[3];
+        mixed_radix_iterator_t it;
+        mixed_radix_iterator_init(&it, &x, strides);
+        for (int i = 0; i < 24; i++) {
+            int index = mixed_radix_iterator_to_int(&it);
+            int bank = mixed_radix_iterator_parent(&it, 1);
+            ...
+            mixed_radix_iterator_incr(&it);
+        }
+ ```
+ Each of these calls takes constant time, amortized for the increment.
+ mixed_radix_iterator_fill() writes the values of many increments to
+ an array at once. The iterator keeps the digits of the mixed-radix
+ number up to date, so the functions above can still be used on it.
  */
 
 #ifndef MIXED_RADIX_H
@@ -127,4 +147,60 @@ int mixed_radix_parent(mixed_radix_int_t* mixed, int n);
  */
 int mixed_radix_to_int(mixed_radix_int_t* mixed);
 
+/**
+ * An iterator over the values of a permuted mixed-radix number.
+ * It caches the int value of the number, and, for each digit, the
+ * amount by which incrementing that digit changes the int value.
+ */
+typedef struct mixed_radix_iterator_t {
+	mixed_radix_int_t* mixed;
+	int* strides; // The product of the radixes of the lower-order digits, for each digit.
+	int value;    // The int value of the number.
+} mixed_radix_iterator_t;
+
+/**
+ * Initialize an iterator that starts at the current value of the
+ * given mixed-radix number and increments it.
+ * @param it The iterator to initialize.
+ * @param mixed A pointer to the mixed-radix number, which must not
+ *  be modified other than through the iterator while it is in use.
+ * @param strides An array of mixed->size ints that the iterator uses
+ *  and that must remain valid while it is in use.
+ */
+void mixed_radix_iterator_init(mixed_radix_iterator_t* it, mixed_radix_int_t* mixed, int* strides);
+
+/**
+ * Increment the mixed-radix number of an iterator by one according
+ * to the permutation matrix, as mixed_radix_incr() does.
+ * @param it The iterator.
+ */
+void mixed_radix_iterator_incr(mixed_radix_iterator_t* it);
+
+/**
+ * Return the int value of the mixed-radix number of an iterator.
+ * @param it The iterator.
+ */
+int mixed_radix_iterator_to_int(mixed_radix_iterator_t* it);
+
+/**
+ * Return the int value of the mixed-radix number of an iterator after
+ * dropping the first n digits, as mixed_radix_parent() does.
+ * @param it The iterator.
+ * @param n The number of digits to drop, which is assumed to
+ *  be greater than or equal to 0.
+ */
+int mixed_radix_iterator_parent(mixed_radix_iterator_t* it, int n);
+
+/**
+ * Write the int values of the mixed-radix number of an iterator and
+ * of the next count - 1 numbers that incrementing it yields to the
+ * given array, and leave the iterator at the number after those.
+ * Runs of increments that change only the first digit in the
+ * permutation are written without looking at the other digits.
+ * @param it The iterator.
+ * @param values An array of at least count ints.
+ * @param count The number of values to write.
+ */
+void mixed_radix_iterator_fill(mixed_radix_iterator_t* it, int* values, int count);
+
 #endif /* MIXED_RADIX_H */
@@ -152,6 +152,10 @@ void _lf_process_mode_changes(
 
 void _lf_add_suspended_event(event_t* event);
 
+#ifdef LF_STATIC_MEMORY
+void _lf_preallocate_suspended_events(size_t capacity);
+#endif
+
 void _lf_handle_mode_startup_reset_reactions(
         reaction_t** startup_reactions,
         int startup_reactions_size,
@@ -42,6 +42,9 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef PLATFORM_H
 #define PLATFORM_H
 
+#include <stdbool.h>
+#include <stddef.h> // For size_t
+
 #if defined(ARDUINO)
     #include "platform/lf_arduino_support.h"
 #elif defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
@@ -136,6 +139,18 @@ extern int lf_mutex_lock(lf_mutex_t* mutex);
  */
 extern int lf_mutex_unlock(lf_mutex_t* mutex);
 
+#ifdef LF_LOCK_PROFILING
+/**
+ * Lock a mutex and record, for the calling source line, how long
+ * the lock took to acquire. In the lock profiling build mode, calls
+ * to lf_mutex_lock() are redirected here.
+ *
+ * @return 0 on success, platform-specific error number otherwise.
+ */
+extern int _lf_mutex_lock_profiled(lf_mutex_t* mutex, const char* file, int line);
+#define lf_mutex_lock(mutex) _lf_mutex_lock_profiled(mutex, __FILE__, __LINE__)
+#endif
+
 
 /**
  * Initialize a conditional variable.
@@ -176,6 +191,35 @@ extern int lf_cond_wait(lf_cond_t* cond, lf_mutex_t* mutex);
  */
 extern int lf_cond_timedwait(lf_cond_t* cond, lf_mutex_t* mutex, instant_t absolute_time_ns);
 
+/**
+ * Block the calling thread for as long as the 32-bit word that address
+ * points to holds the value expected, or until another thread calls
+ * lf_futex_wake() on the same address. The check and the block are atomic
+ * with respect to lf_futex_wake(), so a waker that changes the word before
+ * calling lf_futex_wake() cannot be missed. The caller must re-check the word
+ * on return because the wait may also end spuriously.
+ *
+ * @return 0 on success, platform-specific error number otherwise.
+ */
+extern int lf_futex_wait(volatile int32_t* address, int32_t expected);
+
+/**
+ * Wake up all threads blocked in lf_futex_wait() on the word that address points to.
+ *
+ * @return 0 on success, platform-specific error number otherwise.
+ */
+extern int lf_futex_wake(volatile int32_t* address);
+
+/**
+ * Wake up at most count threads blocked in lf_futex_wait() on the word that
+ * address points to. On platforms where futexes are emulated, this may wake
+ * up all of them, which the callers of lf_futex_wait() tolerate since they
+ * re-check the word anyway.
+ *
+ * @return 0 on success, platform-specific error number otherwise.
+ */
+extern int lf_futex_wake_n(volatile int32_t* address, int32_t count);
+
 /*
  * Atomically increment the variable that ptr points to by the given value, and return the original value of the variable.
  * @param ptr A pointer to a variable. The value of this variable will be replaced with the result of the operation.
@@ -239,6 +283,17 @@ extern int lf_cond_timedwait(lf_cond_t* cond, lf_mutex_t* mutex, instant_t absol
 #error "Compiler not supported"
 #endif
 
+/*
+ * Storage class of a variable of which each thread has its own copy.
+ */
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+#define LF_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#define LF_THREAD_LOCAL __thread
+#else
+#define LF_THREAD_LOCAL _Thread_local
+#endif
+
 #endif
 
 /**
@@ -257,6 +312,18 @@ extern void lf_initialize_clock(void);
  */
 extern int lf_clock_gettime(instant_t* t);
 
+/**
+ * Fetch the value of a physical clock that is cheaper to read than the one
+ * read by lf_clock_gettime(), if the platform has one that agrees with it
+ * to within the specified tolerance, and store it in `t`. Otherwise, this
+ * reads the same clock as lf_clock_gettime().
+ *
+ * @param t Where to store the time.
+ * @param tolerance The error that the caller can tolerate.
+ * @return 0 for success, or -1 for failure
+ */
+extern int lf_clock_gettime_fast(instant_t* t, interval_t tolerance);
+
 /**
  * Pause execution for a number of nanoseconds.
  *
@@ -264,6 +331,88 @@ extern int lf_clock_gettime(instant_t* t);
  */
 extern int lf_nanosleep(instant_t requested_time);
 
+/**
+ * Pause execution until the physical clock (as reported by lf_clock_gettime)
+ * reaches the specified absolute time. If the time has already been reached,
+ * return immediately.
+ *
+ * Where the platform supports it, this uses an absolute wait on the
+ * monotonic clock so that no time is lost between reading the clock and
+ * starting the wait.
+ *
+ * @return 0 for success, or -1 for failure.
+ */
+extern int lf_sleep_until(instant_t wakeup_time);
+
+
+/**
+ * Scheduling policies that can be requested for a thread.
+ */
+typedef enum lf_scheduling_policy_type_t {
+    LF_SCHED_FAIR,      // The default time-sharing policy of the platform.
+    LF_SCHED_TIMESLICE, // Fixed priority, round robin among threads of equal priority.
+    LF_SCHED_PRIORITY,  // Fixed priority, first in first out among threads of equal priority.
+    LF_SCHED_DEADLINE   // Earliest deadline first with a reserved CPU budget per period.
+} lf_scheduling_policy_type_t;
+
+/**
+ * A scheduling policy and its parameters.
+ */
+typedef struct lf_scheduling_policy_t {
+    lf_scheduling_policy_type_t policy;
+    int priority;        // Priority for LF_SCHED_TIMESLICE and LF_SCHED_PRIORITY.
+    interval_t runtime;  // CPU time reserved per period for LF_SCHED_DEADLINE.
+    interval_t period;   // Period (and relative deadline) for LF_SCHED_DEADLINE.
+} lf_scheduling_policy_t;
+
+/**
+ * Set the scheduling policy of the calling thread.
+ *
+ * Real-time policies usually require privileges (e.g., CAP_SYS_NICE on
+ * Linux), so callers should be prepared for this to fail.
+ *
+ * @return 0 for success, or -1 for failure. In case of failure, errno will be
+ *  set appropriately (EPERM if the process lacks permission, ENOTSUP if the
+ *  platform does not support the policy).
+ */
+extern int lf_thread_set_scheduling_policy(lf_scheduling_policy_t* policy);
+
+/**
+ * Lock all current and future memory of the process into RAM so that
+ * execution does not incur page faults.
+ *
+ * @return 0 for success, or -1 for failure. In case of failure, errno will be
+ *  set appropriately.
+ */
+extern int lf_lock_memory(void);
+
+/**
+ * Return the size of the stack of the calling thread.
+ *
+ * @return The size in bytes, or 0 if it is unknown or unlimited.
+ */
+extern size_t lf_thread_stack_size(void);
+
+/**
+ * Touch the specified number of bytes of the calling thread's stack, below
+ * the current stack frame, so that later growth of the stack up to that
+ * size does not incur page faults. If the size does not fit well within
+ * the stack of the thread, this prints a warning and touches less.
+ */
+extern void lf_prefault_stack(size_t size);
+
+/**
+ * Forbid or allow heap allocation by the calling thread. While it is
+ * forbidden, a call of malloc(), calloc(), or realloc() by the thread is a
+ * fatal error. The static-memory mode of the runtime (LF_STATIC_MEMORY) uses
+ * this to assert that reactions and the runtime do not allocate memory after
+ * startup. Intercepting allocations requires LF_STATIC_MEMORY.
+ *
+ * @param forbidden Whether to forbid heap allocation.
+ * @return Whether heap allocation was forbidden before (0 or 1), or -1 for
+ *  failure. In case of failure, errno will be set to ENOTSUP.
+ */
+extern int lf_forbid_heap_allocation(bool forbidden);
 
 /**
  * Macros for marking function as deprecated
@@ -49,4 +49,7 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // The underlying physical clock for Linux
 #define _LF_CLOCK CLOCK_MONOTONIC
 
+// Futexes are system calls rather than emulated, so semaphores are built on them.
+#define LF_NATIVE_FUTEX
+
 #endif // LF_LINUX_SUPPORT_H
@@ -56,6 +56,7 @@
 #include <string.h>
 #include <time.h>
 
+#include "fd_source.h"
 #include "lf_types.h"
 #include "modes.h" // Modal model support
 #include "platform.h"  // Platform-specific times and APIs
@@ -341,6 +342,83 @@ void lf_print_snapshot(void);
  */
 void lf_request_stop(void);
 
+/**
+ * A function that executes the iterations of a loop given to lf_parallel_for()
+ * from begin to end - 1.
+ * @param begin The first iteration to execute.
+ * @param end One past the last iteration to execute.
+ * @param arg The argument given to lf_parallel_for().
+ */
+typedef void (*lf_parallel_for_body_t)(size_t begin, size_t end, void* arg);
+
+/**
+ * Execute the iterations of a loop from start to end - 1, sharing them with
+ * the workers of the enclave that are idle, and return when all of them are
+ * done. This lets a reaction that processes a large array use the workers
+ * that would otherwise wait for it to finish. Since the loop is complete when
+ * this returns, the reaction behaves as if it had executed the loop itself.
+ *
+ * The body is called with consecutive ranges of iterations, possibly at the
+ * same time on different threads, so it must only read the state that the
+ * iterations share and write what belongs to its own iterations. It must not
+ * set outputs or schedule actions, which the reaction can do after the loop.
+ *
+ * In the unthreaded runtime, and with schedulers that cannot lend out their
+ * idle workers (PEDF_NP and adaptive), the calling thread executes the whole
+ * loop. A loop started within the body of another loop, or while another
+ * one is shared, is also executed by the calling thread alone.
+ *
+ * @param start The first iteration.
+ * @param end One past the last iteration.
+ * @param grain The number of iterations that a worker claims at a time, or 0
+ *  to let the runtime choose.
+ * @param body The function that executes a range of iterations.
+ * @param arg An argument to pass to the body.
+ */
+void lf_parallel_for(size_t start, size_t end, size_t grain, lf_parallel_for_body_t body, void* arg);
+
+/**
+ * Suspend the reaction that is executing, so that it can wait for an
+ * external resource, such as a file read or a request to another process,
+ * without keeping its worker thread busy. The reaction should start the
+ * operation, hand the returned handle to whatever completes it, and return.
+ * When the operation completes, lf_reaction_resume() is called with the
+ * handle, and a worker thread then calls the continuation with the self
+ * struct of the reactor and the given argument. The continuation executes as
+ * part of the reaction: it can read the inputs and set the outputs of the
+ * reaction, and it can itself call lf_reaction_suspend() to wait again.
+ * Any state that the continuation needs must be kept in the self struct or
+ * in memory that the argument points to, not in local variables.
+ *
+ * The current tag does not complete until the continuation of every
+ * suspended reaction has finished, and no reaction that depends on a
+ * suspended reaction executes before then, but other reactions at the same
+ * level keep executing meanwhile.
+ *
+ * With schedulers that cannot lend out their idle workers (PEDF_NP and
+ * adaptive), the worker thread waits for lf_reaction_resume() instead of
+ * executing other reactions. In the unthreaded runtime, the main thread
+ * waits while it handles the file descriptors registered with
+ * lf_register_fd(), whose handlers may call lf_reaction_resume().
+ *
+ * This may be called at most once by a reaction or a continuation, and not
+ * by a deadline or STP handler.
+ *
+ * @param self The self struct of the reactor of the reaction.
+ * @param continuation The function to call when the reaction is resumed.
+ * @param arg An argument to pass to the continuation.
+ * @return A handle to pass to lf_reaction_resume().
+ */
+void* lf_reaction_suspend(void* self, lf_continuation_t continuation, void* arg);
+
+/**
+ * Resume a reaction that has called lf_reaction_suspend(). This may be
+ * called by any thread, including the reaction itself before it returns.
+ * It returns without waiting for the continuation to execute.
+ * @param handle The handle returned by lf_reaction_suspend().
+ */
+void lf_reaction_resume(void* handle);
+
 /**
  * Allocate zeroed-out memory and record the allocated memory on
  * the specified list so that it will be freed when calling
@@ -403,7 +481,7 @@ void _lf_start_time_step(void);
 void _lf_initialize_trigger_objects(void);
 
 /**
- * Pop all events from event_q with timestamp equal to current_time, extract all
+ * Pop all events from event_q with tag equal to current_tag, extract all
  * the reactions triggered by these events, and stick them into the reaction
  * queue.
  */
@@ -452,6 +530,66 @@ bool _lf_trigger_shutdown_reactions(void);
  */
 lf_token_t* create_token(size_t element_size);
 
+/**
+ * Return a new token that is a view of a slice of the array carried by the
+ * specified token, without copying it. The view shares the payload of the
+ * token, on which it holds a reference until the view is freed, so it can be
+ * sent with lf_set_token() or _lf_schedule_token() like any other token, for
+ * example to hand out tiles of a frame to several reactors. A view of a view
+ * refers to the token that owns the payload. The payload is copied only if a
+ * reactor asks for a writable copy of a view that is shared, and then only
+ * the slice is copied. A token that nothing else refers to is freed along
+ * with its last view. Tokens with a copy constructor cannot be sliced.
+ * @param token The token carrying the array (must not be NULL).
+ * @param offset The index of the first element of the slice.
+ * @param length The number of elements of the slice.
+ * @return A token with a reference count of 0, or NULL if the slice is out
+ *  of the bounds of the array or the token cannot be sliced.
+ */
+lf_token_t* lf_token_slice(lf_token_t* token, size_t offset, size_t length);
+
+/**
+ * Return a new token that carries the specified buffer, which the program
+ * rather than the runtime owns, such as a memory-mapped file, a frame in
+ * shared memory, or a buffer from a pool of the program. The buffer is not
+ * copied. Once the last reference to the token, including those of views of
+ * it, is released, the runtime calls the release function instead of freeing
+ * the buffer. The release function is called on the thread that frees the
+ * token, typically while the runtime holds its mutex, so it should return
+ * quickly and must not call functions of the runtime.
+ *
+ * A writable copy of a token that is shared is an ordinary copy made by the
+ * runtime, but a reaction that is the only reader of the token gets the
+ * token itself, so a buffer that cannot be written to should only be sent
+ * to inputs that are not mutable.
+ *
+ * @param element_size The size of an element of the buffer.
+ * @param value The buffer.
+ * @param length The number of elements in the buffer.
+ * @param release The function that releases the buffer, or NULL if it does
+ *  not need to be released.
+ * @param context The context to pass to the release function.
+ * @return A token with a reference count of 0.
+ */
+lf_token_t* lf_token_wrap(size_t element_size, void* value, size_t length,
+        lf_token_release_t release, void* context);
+
+/**
+ * Create tokens for a batch of buffers owned by the program, which share
+ * a release function and its context, as lf_token_wrap() would for each.
+ * This takes the mutex of the runtime only once for the whole batch.
+ * @param element_size The size of an element of the buffers.
+ * @param values The buffers.
+ * @param lengths The number of elements in each buffer.
+ * @param count The number of buffers.
+ * @param release The function that releases each buffer, or NULL.
+ * @param context The context to pass to the release function.
+ * @param tokens An array of count tokens to fill, each with a reference
+ *  count of 0.
+ */
+void lf_token_wrap_batch(size_t element_size, void* const* values, const size_t* lengths, size_t count,
+        lf_token_release_t release, void* context, lf_token_t** tokens);
+
 /**
  * Schedule the specified action with an integer value at a later logical
  * time that depends on whether the action is logical or physical and
@@ -465,9 +603,10 @@ lf_token_t* create_token(size_t element_size);
 trigger_handle_t _lf_schedule_int(void* action, interval_t extra_delay, int value);
 
 /**
- * Create a dummy event to be used as a spacer in the event queue.
+ * Create a dummy event with the specified tag to be used as a placeholder
+ * in the event queue.
  */
-event_t* _lf_create_dummy_event(trigger_t* trigger, instant_t time, event_t* next, unsigned int offset);
+event_t* _lf_create_dummy_event(tag_t tag);
 
 /**
  * Schedule the specified action with the specified token as a payload.
@@ -1,6 +1,7 @@
 #ifndef REACTOR_COMMON_H
 #define REACTOR_COMMON_H
 
+#include "enclave.h"
 #include "lf_types.h"
 #include "tag.h"
 #include "pqueue.h"
@@ -11,26 +12,61 @@
 
 
 //  ******** Global Variables :( ********  //
-extern unsigned int _lf_number_of_workers;
-extern bool fast;
-extern unsigned int _lf_number_of_workers;
-extern instant_t duration;
-extern bool _lf_execution_started;
-extern tag_t stop_tag;
-extern bool keepalive_specified;
-extern bool** _lf_is_present_fields;
+extern interval_t _lf_spin_margin;
+extern bool _lf_lock_memory_specified;
+extern size_t _lf_prefault_stack_size;
 extern interval_t _lf_fed_STA_offset;
-extern int _lf_is_present_fields_size;
-extern bool** _lf_is_present_fields_abbreviated;
-extern int _lf_is_present_fields_abbreviated_size;
-extern tag_t** _lf_intended_tag_fields;
-extern int _lf_intended_tag_fields_size;
-extern token_present_t* _lf_tokens_with_ref_count;
-extern lf_token_t* _lf_more_tokens_with_ref_count;
-extern int _lf_tokens_with_ref_count_size;
-extern vector_t _lf_sparse_io_record_sizes;
 
-extern pqueue_t* event_q;
+// The tables used at the start of each time step, which the code generator
+// fills in, belong to the enclave that the calling thread is bound to.
+#define _lf_is_present_fields (_lf_enclave->is_present_fields)
+#define _lf_is_present_fields_size (_lf_enclave->is_present_fields_size)
+#define _lf_is_present_fields_abbreviated (_lf_enclave->is_present_fields_abbreviated)
+#define _lf_is_present_fields_abbreviated_size (_lf_enclave->is_present_fields_abbreviated_size)
+#define _lf_intended_tag_fields (_lf_enclave->intended_tag_fields)
+#define _lf_intended_tag_fields_size (_lf_enclave->intended_tag_fields_size)
+#define _lf_tokens_with_ref_count (_lf_enclave->tokens_with_ref_count)
+#define _lf_more_tokens_with_ref_count (_lf_enclave->more_tokens_with_ref_count)
+#define _lf_tokens_with_ref_count_size (_lf_enclave->tokens_with_ref_count_size)
+#define _lf_sparse_io_record_sizes (_lf_enclave->sparse_io_record_sizes)
+#define _lf_reactions (_lf_enclave->reactions)
+#define _lf_reactions_size (_lf_enclave->reactions_size)
+
+#ifndef LF_RUNTIME_SOURCE
+// Generated code refers to the state of the program by the names of the
+// globals that held it before it moved into enclaves and instances. The
+// sources of the runtime and its tests are compiled with LF_RUNTIME_SOURCE
+// defined, because these names would replace the names of the fields that they
+// access directly. The sources that generated code includes, such as
+// federate.c, use these names instead of the fields.
+#define current_tag (_lf_enclave->current_tag)
+#define stop_tag (_lf_enclave->stop_tag)
+#define event_q (_lf_enclave->event_q)
+#define start_time (_lf_instance->start_time)
+#define physical_start_time (_lf_instance->physical_start_time)
+#define duration (_lf_instance->duration)
+#define fast (_lf_instance->fast)
+#define keepalive_specified (_lf_instance->keepalive_specified)
+#define _lf_number_of_workers (_lf_instance->number_of_workers)
+#define _lf_execution_started (_lf_instance->execution_started)
+#define _lf_reactors_to_free (_lf_instance->reactors_to_free)
+#ifdef NUMBER_OF_WORKERS
+#define mutex (_lf_enclave->mutex)
+#define event_q_changed (_lf_enclave->event_q_changed)
+#endif
+#endif // LF_RUNTIME_SOURCE
+
+/**
+ * Classes of threads created by the runtime, each of which can be given its
+ * own scheduling policy with the --thread-policy command-line option.
+ */
+typedef enum lf_thread_class_t {
+    LF_WORKER_THREAD,  // Worker threads, or the main thread in the unthreaded runtime.
+    LF_TRACE_THREAD,   // The thread that flushes trace buffers to a file.
+    LF_NETWORK_THREAD, // Threads of a federate that receive messages from the network.
+    LF_IO_THREAD,      // The thread that waits for the file descriptors given to lf_register_fd().
+    LF_NUMBER_OF_THREAD_CLASSES
+} lf_thread_class_t;
 
 extern int default_argc;
 extern const char** default_argv;
@@ -51,17 +87,22 @@ void set_federation_id(const char* fid);
 #endif
 
 void* _lf_allocate(size_t count, size_t size, struct allocation_record_t** head);
-extern struct allocation_record_t* _lf_reactors_to_free;
 void* _lf_new_reactor(size_t size);
 void _lf_free(struct allocation_record_t** head);
 void _lf_free_reactor(struct self_base_t *self);
 void _lf_free_all_reactors(void);
+void* _lf_allocate_payload(size_t size);
+#ifdef LF_STATIC_MEMORY
+void _lf_forbid_heap_allocation(bool forbidden);
+#else
+// Without static-memory mode, every thread may allocate from the heap.
+#define _lf_forbid_heap_allocation(forbidden)
+#endif
+size_t _lf_reaction_queue_capacity();
 void _lf_set_stop_tag(tag_t tag);
 extern interval_t lf_get_stp_offset();
 void lf_set_stp_offset(interval_t offset);
 
-extern pqueue_t* event_q;
-
 void _lf_trigger_reaction(reaction_t* reaction, int worker_number);
 void _lf_start_time_step();
 lf_token_t* _lf_create_token(size_t element_size);
@@ -69,26 +110,32 @@ lf_token_t* create_token(size_t element_size);
 lf_token_t* _lf_initialize_token_with_value(lf_token_t* token, void* value, size_t length);
 lf_token_t* _lf_initialize_token(lf_token_t* token, size_t length);
 bool _lf_is_tag_after_stop_tag(tag_t tag);
+void _lf_initialize_thread(lf_thread_class_t thread_class);
+void _lf_spin_until(instant_t wakeup_time);
+void _lf_record_wait_lag(interval_t lag);
 void _lf_pop_events();
 void _lf_initialize_timer(trigger_t* timer);
 void _lf_recycle_event(event_t* e);
-event_t* _lf_create_dummy_events(
-    trigger_t* trigger,
-    instant_t time,
-    event_t* next,
-    microstep_t offset
-);
+event_t* _lf_create_dummy_event(tag_t tag);
 int _lf_schedule_at_tag(trigger_t* trigger, tag_t tag, lf_token_t* token);
 trigger_handle_t _lf_schedule(trigger_t* trigger, interval_t extra_delay, lf_token_t* token);
 trigger_handle_t _lf_insert_reactions_for_trigger(trigger_t* trigger, lf_token_t* token);
 trigger_t* _lf_action_to_trigger(void* action);
-void _lf_advance_logical_time(instant_t next_time);
+void _lf_advance_logical_time(tag_t next_tag);
 trigger_handle_t _lf_schedule_int(void* action, interval_t extra_delay, int value);
 lf_token_t* _lf_set_new_array_impl(lf_token_t* token, size_t length, int num_destinations);
 bool _lf_check_deadline(self_base_t* self, bool invoke_deadline_handler);
 void _lf_invoke_reaction(reaction_t* reaction, int worker);
+void _lf_invoke_continuation(reaction_t* reaction, int worker);
+bool _lf_release_suspended_reaction(reaction_t* reaction, int worker);
+void _lf_initialize_output_reactions(void);
+void _lf_free_output_reactions(void);
 void schedule_output_reactions(reaction_t* reaction, int worker);
 lf_token_t* writable_copy(lf_token_t* token);
+lf_token_t* _lf_copy_token(lf_token_t* token);
+void _lf_free_unreferenced_token(lf_token_t* token);
+void _lf_initialize_event_queues(lf_enclave_t* enclave);
+void _lf_free_event_queues(lf_enclave_t* enclave);
 int process_args(int argc, const char* argv[]);
 void initialize(void);
 void termination(void);
@@ -0,0 +1,112 @@
+/*************
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************/
+
+/**
+ * @file schedule_cache.h
+ * @brief Cached schedules of reactions for the unthreaded runtime.
+ *
+ * In many programs, such as purely timer-driven pipelines, each tag triggers
+ * the same set of reactions, which then produce the same outputs and execute
+ * in the same order. With LF_CACHED_SCHEDULES defined, the unthreaded runtime
+ * records, for each distinct set of reactions triggered by the events of a
+ * tag, the sequence in which reactions were triggered and executed, and keeps
+ * it in a flat array. Later tags that trigger the same set of reactions replay
+ * that array instead of inserting into and popping from the reaction queue.
+ *
+ * A replay checks each reaction that is triggered against the recorded
+ * sequence. As soon as the execution deviates from it, for example because an
+ * output is absent, because a deadline is violated, or because a mode changes,
+ * another schedule recorded for the same reactions that agrees so far is
+ * replayed instead, if there is one. Otherwise, the reactions that are queued
+ * are moved to the reaction queue and the rest of the tag is scheduled, and
+ * recorded, dynamically. Either way, reactions execute in an order that the
+ * reaction queue could have produced. Only reactions of equal priority, which
+ * are independent of each other, may execute in a different order than the
+ * reaction queue would have chosen for them.
+ *
+ * Schedules are kept in statically allocated arrays. Once these are full, no
+ * new schedules are recorded.
+ */
+
+#ifndef SCHEDULE_CACHE_H
+#define SCHEDULE_CACHE_H
+
+#include <stdbool.h>
+
+#include "lf_types.h"
+
+/** The maximum number of schedules that are cached. */
+#ifndef LF_SCHEDULE_CACHE_SIZE
+#define LF_SCHEDULE_CACHE_SIZE 16
+#endif
+
+/** The maximum number of reactions in a schedule. Longer tags are not cached. */
+#ifndef LF_SCHEDULE_CACHE_MAX_LENGTH
+#define LF_SCHEDULE_CACHE_MAX_LENGTH 256
+#endif
+
+/** The number of reactions in all cached schedules together. */
+#ifndef LF_SCHEDULE_CACHE_ENTRIES
+#define LF_SCHEDULE_CACHE_ENTRIES 1024
+#endif
+
+/**
+ * Take a reaction that has just been marked as queued.
+ * Before a step, the reaction is collected until _lf_schedule_cache_start_step()
+ * looks for a cached schedule. During the replay of a schedule, the reaction is
+ * checked against the schedule.
+ * @param reaction The reaction.
+ * @return true if the reaction has been taken, false if the caller should
+ *  insert it into the reaction queue.
+ */
+bool _lf_schedule_cache_trigger(reaction_t* reaction);
+
+/**
+ * Start a step by looking for a cached schedule of the reactions collected so
+ * far. If there is none, the collected reactions are inserted into the
+ * reaction queue and, if there is room, the step is recorded.
+ */
+void _lf_schedule_cache_start_step(void);
+
+/**
+ * Return the next reaction of the schedule that is replayed.
+ * @return The reaction to execute, or NULL if no schedule is replayed, if the
+ *  replay has deviated from it, or if it is complete. The remaining reactions,
+ *  if any, are then in the reaction queue.
+ */
+reaction_t* _lf_schedule_cache_next(void);
+
+/**
+ * Record that the specified reaction, popped from the reaction queue, is about
+ * to execute, if the step is being recorded.
+ * @param reaction The reaction.
+ */
+void _lf_schedule_cache_record(reaction_t* reaction);
+
+/**
+ * End a step, and cache its schedule if it has been recorded.
+ */
+void _lf_schedule_cache_end_step(void);
+
+#endif // SCHEDULE_CACHE_H
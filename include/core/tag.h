@@ -204,6 +204,15 @@ interval_t lf_time_logical_elapsed(void);
  */
 instant_t lf_time_physical(void);
 
+/**
+ * Return the current physical time in nanoseconds, like lf_time_physical(),
+ * but possibly from a cheaper clock that may be off by up to the tolerance
+ * given with the --clock-tolerance command-line option. This is meant for
+ * uses that do not release tags, such as deadline checks and tracing.
+ * @return A time instant.
+ */
+instant_t lf_time_physical_fast(void);
+
 
 /**
  * Return the elapsed physical time in nanoseconds.
@@ -279,13 +288,11 @@ tag_t _lf_convert_volatile_tag_to_nonvolatile(tag_t volatile vtag);
 #endif
 
 // Global variables :(
-extern tag_t current_tag;
-extern instant_t physical_start_time;
-extern instant_t start_time;
 extern interval_t _lf_time_physical_clock_offset;
 extern interval_t _lf_global_physical_clock_drift;
 extern interval_t _lf_time_test_physical_clock_offset;
 extern instant_t _lf_last_reported_physical_time_ns;
 extern instant_t _lf_last_reported_unadjusted_physical_time_ns;
+extern interval_t _lf_physical_clock_tolerance;
 
 #endif // TAG_H
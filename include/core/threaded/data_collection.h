@@ -35,8 +35,12 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #endif // NUMBER_OF_WORKERS
 
 #include <assert.h>
+#include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "enclave.h"
 #include "scheduler.h"
 #include "util.h"
 
@@ -46,6 +50,8 @@ static interval_t* execution_times_mins;
 static size_t* execution_times_argmins;
 static size_t data_collection_counter = 0;
 static bool collecting_data = false;
+/** A fingerprint of the structure of the program, which a profile must match to be used. */
+static uint64_t profile_fingerprint;
 
 /**
  * A monotonically increasing sequence of numbers of workers, the first and last elements of which
@@ -61,6 +67,8 @@ instant_t lf_time_physical(void);
 #define START_EXPERIMENTS 8
 #define SLOW_EXPERIMENTS 256
 #define EXECUTION_TIME_MEMORY 15
+#define PROFILE_HEADER "lf-adaptive-profile"
+#define PROFILE_VERSION 1
 
 /** @brief Initialize the possible_nums_workers array. */
 static void possible_nums_workers_init() {
@@ -112,6 +120,20 @@ static size_t get_nums_workers_neighboring_state(size_t current_state, interval_
     return possible_nums_workers[i + jitter];
 }
 
+/**
+ * @brief Return a fingerprint of the number of levels and of the number of reactions at each
+ * level, which changes whenever the program is changed in a way that affects the scheduler.
+ */
+static uint64_t compute_fingerprint(sched_params_t* params) {
+    // 64-bit FNV-1a.
+    uint64_t hash = 14695981039346656037ull;
+    hash = (hash ^ params->num_reactions_per_level_size) * 1099511628211ull;
+    for (size_t level = 0; level < params->num_reactions_per_level_size; level++) {
+        hash = (hash ^ params->num_reactions_per_level[level]) * 1099511628211ull;
+    }
+    return hash;
+}
+
 static void data_collection_init(sched_params_t* params) {
     size_t num_levels = params->num_reactions_per_level_size;
     start_times_by_level = (interval_t*) calloc(num_levels, sizeof(interval_t));
@@ -128,6 +150,7 @@ static void data_collection_init(sched_params_t* params) {
         );
     }
     possible_nums_workers_init();
+    profile_fingerprint = compute_fingerprint(params);
 }
 
 static void data_collection_free() {
@@ -139,13 +162,104 @@ static void data_collection_free() {
     free(possible_nums_workers);
 }
 
+/**
+ * @brief Return the profile file given with --sched-profile or SCHED_PROFILE, or NULL.
+ * SCHED_PROFILE, if defined, must be a quoted string literal, as in
+ * -DSCHED_PROFILE='"profile.txt"', since it is used as the name of the file as it is.
+ */
+static const char* profile_file() {
+    const char* file = _lf_instance->sched_profile;
+#ifdef SCHED_PROFILE
+    if (file == NULL) file = SCHED_PROFILE;
+#endif
+    return file;
+}
+
+/**
+ * @brief Start from the numbers of workers per level saved in the profile file by a previous run,
+ * if any, and skip the initial experiments.
+ * @param num_workers_by_level The number of workers that should be used to execute each level,
+ * which is updated in-place.
+ * @param max_num_workers_by_level The maximum number of workers that could reasonably be assigned
+ * to each level.
+ */
+static void data_collection_load_profile(
+    size_t* num_workers_by_level,
+    size_t* max_num_workers_by_level
+) {
+    const char* file = profile_file();
+    if (file == NULL) return;
+    FILE* stream = fopen(file, "r");
+    if (stream == NULL) {
+        LF_PRINT_LOG("Scheduler: No profile in %s yet.", file);
+        return;
+    }
+    unsigned int version;
+    unsigned long long fingerprint;
+    size_t levels;
+    if (fscanf(stream, PROFILE_HEADER " %u %llx %zu", &version, &fingerprint, &levels) != 3
+            || version != PROFILE_VERSION) {
+        lf_print_warning("Ignoring %s, which is not a profile of the adaptive scheduler.", file);
+    } else if (fingerprint != profile_fingerprint || levels != num_levels) {
+        lf_print_warning("Ignoring the profile in %s, which was saved by a different program.", file);
+    } else {
+        size_t level = 0;
+        size_t workers;
+        long long execution_time;
+        for (; level < num_levels; level++) {
+            if (fscanf(stream, "%zu %lld", &workers, &execution_time) != 2) break;
+            // Levels that were never measured, or with more workers than this run has, are
+            // left to the experiments.
+            if (!execution_time || !workers || workers > max_num_workers_by_level[level]) continue;
+            execution_times_by_num_workers_by_level[level][workers] = (interval_t) execution_time;
+            execution_times_mins[level] = (interval_t) execution_time;
+            execution_times_argmins[level] = workers;
+            num_workers_by_level[level] = workers;
+        }
+        if (level < num_levels) {
+            lf_print_warning("The profile in %s is truncated after %zu levels.", file, level);
+        } else {
+            LF_PRINT_LOG("Scheduler: Starting from the profile in %s.", file);
+            data_collection_counter = SLOW_EXPERIMENTS;
+        }
+    }
+    fclose(stream);
+}
+
+/**
+ * @brief Save the number of workers that has been the fastest so far for each level, along with
+ * its execution time, in the profile file, if any.
+ */
+static void data_collection_save_profile() {
+    const char* file = profile_file();
+    if (file == NULL) return;
+    FILE* stream = fopen(file, "w");
+    if (stream == NULL) {
+        lf_print_warning("Could not save the profile of the scheduler in %s: %s", file, strerror(errno));
+        return;
+    }
+    fprintf(
+        stream, PROFILE_HEADER " %d %llx %zu\n",
+        PROFILE_VERSION, (unsigned long long) profile_fingerprint, num_levels
+    );
+    for (size_t level = 0; level < num_levels; level++) {
+        fprintf(
+            stream, "%zu %lld\n",
+            execution_times_argmins[level], (long long) execution_times_mins[level]
+        );
+    }
+    if (fclose(stream) != 0) {
+        lf_print_warning("Could not save the profile of the scheduler in %s: %s", file, strerror(errno));
+    }
+}
+
 /** @brief Record that the execution of the given level is beginning. */
-static void data_collection_start_level(size_t level) {
+static inline void data_collection_start_level(size_t level) {
     if (collecting_data) start_times_by_level[level] = lf_time_physical();
 }
 
 /** @brief Record that the execution of the given level has completed. */
-static void data_collection_end_level(size_t level, size_t num_workers) {
+static inline void data_collection_end_level(size_t level, size_t num_workers) {
     if (collecting_data && start_times_by_level[level]) {
         interval_t dt = lf_time_physical() - start_times_by_level[level];
         if (!execution_times_by_num_workers_by_level[level][num_workers]) {
@@ -185,7 +299,6 @@ static void compute_number_of_workers(
         size_t ideal_number_of_workers;
         size_t max_reasonable_num_workers = max_num_workers_by_level[level];
         ideal_number_of_workers = execution_times_argmins[level];
-        int range = 1;
         if (jitter) {
             ideal_number_of_workers = get_nums_workers_neighboring_state(
                 ideal_number_of_workers, this_execution_time
@@ -230,7 +343,7 @@ static void compute_costs(size_t* num_workers_by_level) {
  * @param max_num_workers_by_level The maximum number of workers that could reasonably be used to
  * execute each level, for any tag.
  */
-static void data_collection_end_tag(
+static inline void data_collection_end_tag(
     size_t* num_workers_by_level,
     size_t* max_num_workers_by_level
 ) {
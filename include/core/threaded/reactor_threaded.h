@@ -1,9 +1,42 @@
 #ifndef REACTOR_THREADED_H
 #define REACTOR_THREADED_H
 
-extern lf_mutex_t mutex;
-extern lf_cond_t event_q_changed;
-extern lf_cond_t global_tag_barrier_requestors_reached_zero;
+/*
+ * The locks of the threaded runtime, in the order in which they must be
+ * acquired. A thread that holds one of them must not acquire one that appears
+ * earlier in this list. It may relock one that it already holds because all
+ * of them are recursive.
+ *
+ * 1. mutex, the tag lock. It protects the advancement of the current tag, the
+ *    bookkeeping of the worker threads and, in a
+ *    federated execution, the state shared with the threads that listen to
+ *    the network.
+ * 2. enclave_mutex, a field of the instance, which protects the next event
+ *    tags of its enclaves (see enclave.c).
+ * 3. event_q_mutex, the event queue lock. It protects the event queue, the
+ *    pool of recycled events, the tokens carried by events, and the state of
+ *    triggers that _lf_schedule() updates. It is the lock that goes with
+ *    event_q_changed.
+ * 4. The reaction queue locks, which are private to the scheduler (e.g., the
+ *    per-level mutexes of the NP and GEDF_NP schedulers).
+ *
+ * Each enclave has its own mutex and event_q_mutex (see enclave.h). A thread
+ * holds the mutex of at most one enclave and the event_q_mutex of at most one
+ * enclave at a time.
+ *
+ * current_tag and stop_tag are only written while holding both mutex and
+ * event_q_mutex, so either one suffices to read them. lf_schedule() and its
+ * variants acquire only event_q_mutex and hence do not contend with a worker
+ * that holds mutex while it waits for physical time or for the tag barrier.
+ *
+ * The global tag barrier is not protected by any of these locks. It is raised
+ * and lowered without mutex, and only the thread that advances the tag blocks
+ * on it, after releasing mutex.
+ *
+ * If the runtime is built with LF_LOCK_PROFILING defined, every call site of
+ * lf_mutex_lock() records how often it acquired a lock and how long it waited,
+ * and a report sorted by total wait time is printed at exit.
+ */
 
 /**
  * Enqueue network input control reactions that determine if the trigger for a
@@ -17,12 +50,13 @@ void enqueue_network_input_control_reactions();
  * message to downstream federates if a given network output port is not present.
  */
 void enqueue_network_output_control_reactions();
-void _lf_increment_global_tag_barrier_already_locked(tag_t future_tag);
-void _lf_increment_global_tag_barrier(tag_t future_tag);
-void _lf_decrement_global_tag_barrier_locked();
+void _lf_raise_global_tag_barrier(tag_t future_tag);
+void _lf_lower_global_tag_barrier();
 int _lf_wait_on_global_tag_barrier(tag_t proposed_tag);
+bool _lf_pass_global_tag_barrier(tag_t proposed_tag);
 void synchronize_with_other_federates();
 bool wait_until(instant_t logical_time_ns, lf_cond_t* condition);
+int _lf_wait_on_event_q_changed(tag_t expected_tag, instant_t wakeup_time);
 tag_t get_next_event_tag();
 tag_t send_next_event_tag(tag_t tag, bool wait_for_reply);
 void _lf_next_locked();
@@ -135,4 +135,75 @@ void lf_sched_done_with_reaction(size_t worker_number, reaction_t* done_reaction
  */
 void lf_sched_trigger_reaction(reaction_t* reaction, int worker_number);
 
+/**
+ * @brief Wake up to 'count' idle workers to help execute the loop of
+ * lf_parallel_for() that the calling worker has published, or to execute
+ * the continuations of resumed reactions.
+ *
+ * A woken worker calls `_lf_parallel_for_help` and, if the scheduler supports
+ * suspension, `_lf_run_resumed_reactions` before it looks for reactions
+ * again. A scheduler that cannot wake its idle workers this way returns 0, in
+ * which case the calling worker executes the whole loop itself.
+ *
+ * @param count The maximum number of workers to wake up.
+ * @return The number of workers that were woken up.
+ */
+size_t lf_sched_wake_idle_workers(size_t count);
+
+/**
+ * @brief Help execute the loop of lf_parallel_for() that a worker has
+ * published, if there is one.
+ *
+ * Schedulers call this in a worker that lf_sched_wake_idle_workers() may
+ * have woken up. It returns immediately if there is no loop.
+ */
+void _lf_parallel_for_help(void);
+
+/**
+ * @brief Whether the scheduler lets a worker thread execute other reactions
+ * while a reaction that it has executed is suspended (see
+ * lf_reaction_suspend()).
+ *
+ * A scheduler that does must not advance to the next level while
+ * `_lf_suspended_reactions_hold_level` returns true, and must call
+ * `_lf_run_resumed_reactions` in a worker that lf_sched_wake_idle_workers()
+ * may have woken up. With other schedulers, the worker thread waits for the
+ * reaction to be resumed.
+ */
+extern const bool lf_sched_supports_suspension;
+
+/**
+ * @brief Return whether suspended reactions keep the current level from
+ * completing.
+ *
+ * Schedulers call this in the last worker to become idle before they advance
+ * to the next level. If it returns true, that worker should wait for work
+ * like the other idle workers. This wakes one of them up if a suspended
+ * reaction has already been resumed.
+ */
+bool _lf_suspended_reactions_hold_level(void);
+
+/**
+ * @brief Execute the continuations of the suspended reactions of the
+ * enclave that have been resumed, if any.
+ *
+ * @param worker_number The number of the calling worker thread.
+ */
+void _lf_run_resumed_reactions(int worker_number);
+
+/**
+ * @brief Whether the scheduler keeps all of its state in the scheduler
+ * instance of the enclave that the calling thread is bound to (see
+ * scheduler_instance.h), which it must for a program to have more than
+ * one enclave.
+ */
+extern const bool lf_sched_supports_enclaves;
+
+/**
+ * @brief Whether the scheduler has an elastic pool of workers (see
+ * worker_pool.h), which parks the workers that the program does not need,
+ * down to the minimum number of workers (see --min-workers).
+ */
+extern const bool lf_sched_has_worker_pool;
+
 #endif // LF_SCHEDULER_H
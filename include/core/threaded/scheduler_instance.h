@@ -42,11 +42,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define NUMBER_OF_WORKERS 1
 #endif  // NUMBER_OF_WORKERS
 
+#include "enclave.h"
 #include "semaphore.h"
 #include "scheduler.h"
 
-extern lf_mutex_t mutex;
-
 
 /**
  * @brief Paramters used in schedulers of the threaded reactor C runtime.
@@ -54,7 +53,7 @@ extern lf_mutex_t mutex;
  * @note Members of this struct are added based on existing schedulers' needs.
  *  These should be expanded to accommodate new schedulers.
  */
-typedef struct {
+typedef struct _lf_sched_instance_t {
     /**
      * @brief Maximum number of levels for reactions in the program.
      *
@@ -132,8 +131,20 @@ typedef struct {
      *
      */
     volatile size_t _lf_sched_next_reaction_level;
+
+    /**
+     * @brief The elastic pool of workers, or NULL if all workers are always
+     * active (see worker_pool.h).
+     */
+    struct lf_worker_pool_t* _lf_sched_worker_pool;
 } _lf_sched_instance_t;
 
+/**
+ * @brief The scheduler instance of the enclave that the calling thread is
+ * bound to. Each enclave has its own instance.
+ */
+#define _lf_sched_instance (_lf_enclave->sched_instance)
+
 /**
  * @brief Initialize `instance` using the provided information.
  *
@@ -147,23 +158,23 @@ typedef struct {
  * @return `true` if initialization was performed. `false` if instance is already
  *  initialized (checked in a thread-safe way).
  */
-bool init_sched_instance(
+static inline bool init_sched_instance(
     _lf_sched_instance_t** instance,
     size_t number_of_workers,
     sched_params_t* params) {
 
     // Check if the instance is already initialized
-    lf_mutex_lock(&mutex); // Safeguard against multiple threads calling this
+    lf_mutex_lock(&_lf_enclave->mutex); // Safeguard against multiple threads calling this
                            // function.
     if (*instance != NULL) {
         // Already initialized
-        lf_mutex_unlock(&mutex);
+        lf_mutex_unlock(&_lf_enclave->mutex);
         return false;
     } else {
         *instance =
             (_lf_sched_instance_t*)calloc(1, sizeof(_lf_sched_instance_t));
     }
-    lf_mutex_unlock(&mutex);
+    lf_mutex_unlock(&_lf_enclave->mutex);
 
     if (params == NULL || params->num_reactions_per_level_size == 0) {
         (*instance)->max_reaction_level = DEFAULT_MAX_REACTION_LEVEL;
@@ -185,4 +196,16 @@ bool init_sched_instance(
     return true;
 }
 
+/**
+ * @brief Free `instance`, after the scheduler has freed what it allocated in
+ * it, so that an enclave that is freed does not leak it and one that runs again
+ * can initialize a new one.
+ *
+ * @param instance The `_lf_sched_instance_t` object to free.
+ */
+static inline void free_sched_instance(_lf_sched_instance_t** instance) {
+    free(*instance);
+    *instance = NULL;
+}
+
 #endif // LF_SCHEDULER_PARAMS_H
@@ -120,6 +120,7 @@ static void worker_assignments_init(size_t number_of_workers, sched_params_t* pa
         }
     }
     data_collection_init(params);
+    data_collection_load_profile(num_workers_by_level, max_num_workers_by_level);
     set_level(0);
 }
 
@@ -131,6 +132,7 @@ static void worker_assignments_free() {
         free(reactions_by_worker_by_level[level]);
         free(num_reactions_by_worker_by_level[level]);
     }
+    data_collection_save_profile();
     free(max_num_workers_by_level);
     free(num_workers_by_level);
     data_collection_free();
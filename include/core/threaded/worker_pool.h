@@ -0,0 +1,126 @@
+/*************
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************/
+
+/**
+ * @file worker_pool.h
+ * @brief An elastic pool of worker threads for the NP, GEDF_NP, and
+ * GEDF_NP_CI schedulers.
+ *
+ * These schedulers wake up as many idle workers as the current level has
+ * reactions, and workers that are not woken up block on a semaphore. With an
+ * elastic pool, the number of workers that take part in this, the active
+ * workers, varies between a minimum, given with --min-workers, and the number
+ * of worker threads. The other workers are parked: they block on a semaphore
+ * of their own and are not counted by the scheduler, so they are never woken
+ * up to look for reactions.
+ *
+ * When a level has more reactions than there are active workers, parked
+ * workers are unparked right away to execute them. Every
+ * LF_WORKER_POOL_PERIOD, the pool measures how much of that time the active
+ * workers spent outside of waiting for work, which is the parallelism that
+ * the program actually had, and parks the active workers beyond that, down
+ * to the minimum. A burst of parallel reactions thus gets as many threads as
+ * it can use, while a program that is mostly waiting, or whose reactions are
+ * too short to be worth sharing, keeps only a few workers active.
+ *
+ * Workers are only parked and unparked by the worker that distributes the
+ * reactions of a level, when every active worker is idle, so the number of
+ * active workers never changes while the scheduler compares it to the number
+ * of idle workers.
+ */
+
+#ifndef LF_WORKER_POOL_H
+#define LF_WORKER_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief The period over which the pool measures the parallelism of the
+ * program before it parks workers.
+ */
+#ifndef LF_WORKER_POOL_PERIOD
+#define LF_WORKER_POOL_PERIOD MSEC(100)
+#endif
+
+/**
+ * @brief Make the pool of the scheduler of the enclave that the calling
+ * thread is bound to elastic, if a minimum number of workers that is less
+ * than the number of worker threads has been given.
+ *
+ * The scheduler calls this when it is initialized.
+ *
+ * @param number_of_workers The number of worker threads.
+ */
+void lf_worker_pool_init(size_t number_of_workers);
+
+/**
+ * @brief Free the memory used by the pool and count every worker as active
+ * again. The scheduler calls this when it is freed, after the workers have
+ * exited.
+ */
+void lf_worker_pool_free(void);
+
+/**
+ * @brief Park or unpark workers to suit the parallelism of the program.
+ *
+ * The scheduler calls this in the worker that distributes the reactions of a
+ * level, while all active workers are idle, before it wakes up idle workers
+ * to execute them. Unparked workers look for reactions as soon as they wake
+ * up, while workers to be parked are woken up and then park.
+ *
+ * @param ready_reactions The number of reactions of the level.
+ */
+void lf_worker_pool_resize(size_t ready_reactions);
+
+/**
+ * @brief Park the calling worker if it has been woken up to park, and return
+ * when it is unparked.
+ *
+ * The scheduler calls this in a worker that it has woken up. The worker is
+ * active, but not idle, when this returns.
+ */
+void lf_worker_pool_park_if_surplus(void);
+
+/**
+ * @brief Unpark all parked workers so that they can exit. The scheduler calls
+ * this when it is time to stop.
+ */
+void lf_worker_pool_unpark_all(void);
+
+/**
+ * @brief Record that the calling worker starts to wait for work.
+ *
+ * @param worker_number The number of the worker.
+ */
+void lf_worker_pool_worker_idle(size_t worker_number);
+
+/**
+ * @brief Record that the calling worker stops waiting for work.
+ *
+ * @param worker_number The number of the worker.
+ */
+void lf_worker_pool_worker_busy(size_t worker_number);
+
+#endif // LF_WORKER_POOL_H
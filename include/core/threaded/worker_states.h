@@ -37,6 +37,7 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <assert.h>
 #include <stdlib.h>
 
+#include "enclave.h"
 #include "platform.h"
 #include "scheduler.h"
 
@@ -56,12 +57,6 @@ extern size_t current_level;
 extern size_t** num_reactions_by_worker_by_level;
 extern size_t max_num_workers;
 
-/** See reactor_threaded.c for documentation. */
-extern lf_mutex_t mutex;
-
-/** See reactor_common.c for documentation. */
-extern bool fast;
-
 /**
  * The level counter is a number that changes whenever the current level changes.
  *
@@ -130,7 +125,7 @@ static void worker_states_awaken_locked(size_t worker, size_t num_to_awaken) {
     size_t max_cond = cond_of(greatest_worker_number_to_awaken);
     if (!mutex_held[worker]) {
         mutex_held[worker] = true;
-        lf_mutex_lock(&mutex);
+        lf_mutex_lock(&_lf_enclave->mutex);
     }
     // The predicate of the condition variable depends on num_awakened and level_counter, so
     // this is a critical section.
@@ -148,8 +143,8 @@ static void worker_states_lock(size_t worker) {
     assert(num_loose_threads > 0);
     assert(num_loose_threads <= max_num_workers);
     size_t lt = num_loose_threads;
-    if (lt > 1 || !fast) {  // FIXME: Lock should be partially optimized out even when !fast
-        lf_mutex_lock(&mutex);
+    if (lt > 1 || !_lf_instance->fast) {  // FIXME: Lock should be partially optimized out even when !fast
+        lf_mutex_lock(&_lf_enclave->mutex);
         assert(!mutex_held[worker]);
         mutex_held[worker] = true;
     }
@@ -159,7 +154,7 @@ static void worker_states_lock(size_t worker) {
 static void worker_states_unlock(size_t worker) {
     if (!mutex_held[worker]) return;
     mutex_held[worker] = false;
-    lf_mutex_unlock(&mutex);
+    lf_mutex_unlock(&_lf_enclave->mutex);
 }
 
 /**
@@ -195,7 +190,7 @@ static void worker_states_sleep_and_unlock(size_t worker, size_t level_counter_s
     assert(worker < max_num_workers);
     assert(num_loose_threads <= max_num_workers);
     if (!mutex_held[worker]) {
-        lf_mutex_lock(&mutex);
+        lf_mutex_lock(&_lf_enclave->mutex);
     }
     mutex_held[worker] = false;  // This will be true soon, upon call to lf_cond_wait.
     size_t cond = cond_of(worker);
@@ -203,11 +198,11 @@ static void worker_states_sleep_and_unlock(size_t worker, size_t level_counter_s
         ((level_counter_snapshot == level_counter) || worker >= num_awakened)
     ) {
         do {
-            lf_cond_wait(worker_conds + cond, &mutex);
+            lf_cond_wait(worker_conds + cond, &_lf_enclave->mutex);
         } while (level_counter_snapshot == level_counter || worker >= num_awakened);
     }
     assert(!mutex_held[worker]);  // This thread holds the mutex, but it did not report that.
-    lf_mutex_unlock(&mutex);
+    lf_mutex_unlock(&_lf_enclave->mutex);
 }
 
 #endif
@@ -0,0 +1,320 @@
+/**
+ * @file growable_hashmap.h
+ * @brief Defines a generic hashmap data type that grows as needed and supports removal.
+ *
+ * Hashmaps are declared as with hashmap.h, by redefining K, V, HASH_OF, and HASHMAP and including
+ * this file. See pointer_growable_hashmap.h for an example. Unlike the hashmaps of hashmap.h, these
+ * need neither a capacity that is much larger than the number of items nor a key that is never
+ * used, and HASH_OF defaults to a hash that mixes all bits of a pointer or an integer key.
+ *
+ * The hashmap is an open-addressing table in the style of Swiss tables. Besides its slots, it keeps
+ * one control byte per slot that says whether the slot is empty, holds an item that was removed (a
+ * tombstone), or is full, in which case it holds 7 bits of the hash of the key. A lookup reads the
+ * control bytes of a group of GROWABLE_HASHMAP_GROUP_WIDTH consecutive slots as one word and finds
+ * the candidate slots of the group with a few arithmetic operations on that word, so it rarely
+ * compares keys that do not match and rarely leaves the first group that it looks at. The table
+ * grows, or is rebuilt without its tombstones, when at most an eighth of its slots are empty.
+ */
+
+#ifndef K
+#define K void*
+#endif
+#ifndef V
+#define V void*
+#endif
+#ifndef HASH_OF
+#define HASH_OF(key) growable_hashmap_mix((uint64_t)(uintptr_t)(key))
+#endif
+#ifndef HASHMAP
+#define HASHMAP(token) growable_hashmap ## _ ## token
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+#ifndef GROWABLE_HASHMAP_COMMON
+#define GROWABLE_HASHMAP_COMMON
+
+/** The number of slots whose control bytes are looked at together. */
+#define GROWABLE_HASHMAP_GROUP_WIDTH 8
+
+/** Control bytes. Full slots have a control byte between 0 and 0x7F. */
+#define GROWABLE_HASHMAP_EMPTY ((uint8_t)0x80)
+#define GROWABLE_HASHMAP_DELETED ((uint8_t)0xFE)
+
+#define GROWABLE_HASHMAP_LSBS 0x0101010101010101ULL
+#define GROWABLE_HASHMAP_MSBS 0x8080808080808080ULL
+
+/**
+ * @brief Return a hash of x in which every bit depends on all bits of x, so that pointers, whose
+ * low bits are often zero, spread over the table.
+ */
+static inline size_t growable_hashmap_mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return (size_t)x;
+}
+
+/**
+ * @brief Return the control bytes of a group as a word, the first byte being the least
+ * significant one, whatever the byte order of the platform.
+ */
+static inline uint64_t growable_hashmap_load_group(const uint8_t* control) {
+    uint64_t group = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&group, control, sizeof(group));
+#else
+    for (int i = 0; i < GROWABLE_HASHMAP_GROUP_WIDTH; i++) {
+        group |= (uint64_t)control[i] << (8 * i);
+    }
+#endif
+    return group;
+}
+
+/**
+ * @brief Return a mask with the most significant bit of each byte of the group that equals the
+ * given 7 bits of a hash set. Bytes that follow a match may also be set, which only costs a
+ * comparison of keys.
+ */
+static inline uint64_t growable_hashmap_match(uint64_t group, uint8_t hash) {
+    uint64_t x = group ^ (GROWABLE_HASHMAP_LSBS * hash);
+    return (x - GROWABLE_HASHMAP_LSBS) & ~x & GROWABLE_HASHMAP_MSBS;
+}
+
+/** @brief Return a mask with the most significant bit of each empty byte of the group set. */
+static inline uint64_t growable_hashmap_match_empty(uint64_t group) {
+    return group & (~group << 6) & GROWABLE_HASHMAP_MSBS;
+}
+
+/** @brief Return a mask with the most significant bit of each byte of the group that is not full set. */
+static inline uint64_t growable_hashmap_match_not_full(uint64_t group) {
+    return group & GROWABLE_HASHMAP_MSBS;
+}
+
+/** @brief Return the index in its group of the first byte set in a nonzero mask. */
+static inline size_t growable_hashmap_first(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (size_t)__builtin_ctzll(mask) / 8;
+#else
+    size_t i = 0;
+    while (!(mask & 0x80)) {
+        mask >>= 8;
+        i++;
+    }
+    return i;
+#endif
+}
+
+#endif // GROWABLE_HASHMAP_COMMON
+
+////////////////////////// Type definitions ///////////////////////////
+
+typedef struct HASHMAP(entry_t) {
+    K key;
+    V value;
+} HASHMAP(entry_t);
+
+typedef struct HASHMAP(t) {
+    HASHMAP(entry_t)* entries;
+    // One control byte per entry, followed by copies of the first GROWABLE_HASHMAP_GROUP_WIDTH
+    // ones, so that the group of any entry can be read without wrapping around.
+    uint8_t* control;
+    size_t capacity;      // A power of two that is at least GROWABLE_HASHMAP_GROUP_WIDTH.
+    size_t num_entries;
+    size_t growth_left;   // The number of empty entries that can be filled before rehashing.
+} HASHMAP(t);
+
+//////////////////////// Function declarations ////////////////////////
+
+/**
+ * @brief Construct a new hashmap object.
+ * @param capacity The number of items that the hashmap can hold before it first grows.
+ */
+HASHMAP(t)* HASHMAP(new)(size_t capacity);
+
+/** @brief Free all memory used by the given hashmap. */
+void HASHMAP(free)(HASHMAP(t)* hashmap);
+
+/** @brief Associate a value with the given key, replacing the value that it had, if any. */
+void HASHMAP(put)(HASHMAP(t)* hashmap, K key, V value);
+
+/**
+ * @brief Return a pointer to the value associated with the given key, or NULL if there is none.
+ * The pointer is valid until the next call to put or remove.
+ */
+V* HASHMAP(find)(HASHMAP(t)* hashmap, K key);
+
+/**
+ * @brief Remove the given key and the value associated with it.
+ * @return Whether the key was present.
+ */
+bool HASHMAP(remove)(HASHMAP(t)* hashmap, K key);
+
+/** @brief Return the number of keys in the hashmap. */
+size_t HASHMAP(size)(HASHMAP(t)* hashmap);
+
+/////////////////////////// Private helpers ///////////////////////////
+
+/** @brief Return the number of items that a table of the given capacity holds before rehashing. */
+static size_t HASHMAP(max_load)(size_t capacity) {
+    return capacity - capacity / 8;
+}
+
+static void HASHMAP(set_control)(HASHMAP(t)* hashmap, size_t index, uint8_t control) {
+    hashmap->control[index] = control;
+    if (index < GROWABLE_HASHMAP_GROUP_WIDTH) {
+        hashmap->control[hashmap->capacity + index] = control;
+    }
+}
+
+/**
+ * @brief Allocate empty entries and control bytes for the given capacity.
+ */
+static void HASHMAP(allocate)(HASHMAP(t)* hashmap, size_t capacity) {
+    hashmap->entries = (HASHMAP(entry_t)*)malloc(capacity * sizeof(HASHMAP(entry_t)));
+    hashmap->control = (uint8_t*)malloc(capacity + GROWABLE_HASHMAP_GROUP_WIDTH);
+    if (hashmap->entries == NULL || hashmap->control == NULL) {
+        lf_print_error_and_exit("Out of memory for a hashmap of capacity %zu.", capacity);
+    }
+    memset(hashmap->control, GROWABLE_HASHMAP_EMPTY, capacity + GROWABLE_HASHMAP_GROUP_WIDTH);
+    hashmap->capacity = capacity;
+    hashmap->growth_left = HASHMAP(max_load)(capacity) - hashmap->num_entries;
+}
+
+/**
+ * @brief Return the index of the first entry that is not full on the probe sequence of the
+ * given hash. Groups are probed at offsets that grow by GROWABLE_HASHMAP_GROUP_WIDTH each time,
+ * which visits every group of a table whose capacity is a power of two.
+ */
+static size_t HASHMAP(find_not_full)(HASHMAP(t)* hashmap, size_t hash) {
+    size_t mask = hashmap->capacity - 1;
+    size_t position = (hash >> 7) & mask;
+    size_t stride = 0;
+    while (true) {
+        uint64_t not_full = growable_hashmap_match_not_full(
+                growable_hashmap_load_group(hashmap->control + position));
+        if (not_full) {
+            return (position + growable_hashmap_first(not_full)) & mask;
+        }
+        stride += GROWABLE_HASHMAP_GROUP_WIDTH;
+        position = (position + stride) & mask;
+    }
+}
+
+/**
+ * @brief Return the index of the entry with the given key, or capacity if there is none.
+ */
+static size_t HASHMAP(find_index)(HASHMAP(t)* hashmap, K key, size_t hash) {
+    size_t mask = hashmap->capacity - 1;
+    size_t position = (hash >> 7) & mask;
+    size_t stride = 0;
+    uint8_t control = hash & 0x7F;
+    while (true) {
+        uint64_t group = growable_hashmap_load_group(hashmap->control + position);
+        for (uint64_t match = growable_hashmap_match(group, control); match; match &= match - 1) {
+            size_t index = (position + growable_hashmap_first(match)) & mask;
+            if (hashmap->entries[index].key == key) {
+                return index;
+            }
+        }
+        // An empty entry ends the probe sequence of every key that is in the table.
+        if (growable_hashmap_match_empty(group)) {
+            return hashmap->capacity;
+        }
+        stride += GROWABLE_HASHMAP_GROUP_WIDTH;
+        position = (position + stride) & mask;
+    }
+}
+
+/**
+ * @brief Move all items to a table of the given capacity, which drops the tombstones.
+ */
+static void HASHMAP(rehash)(HASHMAP(t)* hashmap, size_t capacity) {
+    HASHMAP(entry_t)* entries = hashmap->entries;
+    uint8_t* control = hashmap->control;
+    size_t old_capacity = hashmap->capacity;
+    HASHMAP(allocate)(hashmap, capacity);
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (control[i] < GROWABLE_HASHMAP_EMPTY) {
+            size_t hash = HASH_OF(entries[i].key);
+            size_t index = HASHMAP(find_not_full)(hashmap, hash);
+            HASHMAP(set_control)(hashmap, index, hash & 0x7F);
+            hashmap->entries[index] = entries[i];
+        }
+    }
+    free(entries);
+    free(control);
+}
+
+//////////////////////// Function definitions /////////////////////////
+
+HASHMAP(t)* HASHMAP(new)(size_t capacity) {
+    HASHMAP(t)* ret = (HASHMAP(t)*)malloc(sizeof(HASHMAP(t)));
+    if (ret == NULL) lf_print_error_and_exit("Out of memory for a hashmap.");
+    size_t actual = GROWABLE_HASHMAP_GROUP_WIDTH;
+    while (HASHMAP(max_load)(actual) < capacity) actual *= 2;
+    ret->num_entries = 0;
+    HASHMAP(allocate)(ret, actual);
+    return ret;
+}
+
+void HASHMAP(free)(HASHMAP(t)* hashmap) {
+    free(hashmap->entries);
+    free(hashmap->control);
+    free(hashmap);
+}
+
+void HASHMAP(put)(HASHMAP(t)* hashmap, K key, V value) {
+    size_t hash = HASH_OF(key);
+    size_t index = HASHMAP(find_index)(hashmap, key, hash);
+    if (index < hashmap->capacity) {
+        hashmap->entries[index].value = value;
+        return;
+    }
+    index = HASHMAP(find_not_full)(hashmap, hash);
+    if (hashmap->growth_left == 0 && hashmap->control[index] == GROWABLE_HASHMAP_EMPTY) {
+        // Filling the entry would leave too few empty ones. If tombstones take up much of the
+        // table, rebuilding it at the same capacity is enough.
+        size_t capacity = hashmap->capacity;
+        if (hashmap->num_entries >= HASHMAP(max_load)(capacity) / 2) {
+            capacity *= 2;
+        }
+        HASHMAP(rehash)(hashmap, capacity);
+        index = HASHMAP(find_not_full)(hashmap, hash);
+    }
+    if (hashmap->control[index] == GROWABLE_HASHMAP_EMPTY) {
+        hashmap->growth_left--;
+    }
+    HASHMAP(set_control)(hashmap, index, hash & 0x7F);
+    hashmap->entries[index].key = key;
+    hashmap->entries[index].value = value;
+    hashmap->num_entries++;
+}
+
+V* HASHMAP(find)(HASHMAP(t)* hashmap, K key) {
+    size_t index = HASHMAP(find_index)(hashmap, key, HASH_OF(key));
+    return index < hashmap->capacity ? &hashmap->entries[index].value : NULL;
+}
+
+bool HASHMAP(remove)(HASHMAP(t)* hashmap, K key) {
+    size_t index = HASHMAP(find_index)(hashmap, key, HASH_OF(key));
+    if (index == hashmap->capacity) {
+        return false;
+    }
+    // A tombstone keeps the probe sequences of other keys that pass through this entry intact.
+    HASHMAP(set_control)(hashmap, index, GROWABLE_HASHMAP_DELETED);
+    hashmap->num_entries--;
+    return true;
+}
+
+size_t HASHMAP(size)(HASHMAP(t)* hashmap) {
+    return hashmap->num_entries;
+}
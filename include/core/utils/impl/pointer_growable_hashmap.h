@@ -0,0 +1,14 @@
+/**
+ * @brief Defines a growable hashmap type that maps void pointers to integers.
+ *
+ * See growable_hashmap.h for documentation on how to declare other hashmap types.
+ */
+
+#define HASHMAP(token) growable_hashmap_object2int ## _ ## token
+#define K void*
+#define V int
+#include "growable_hashmap.h"
+#undef HASHMAP
+#undef K
+#undef V
+#undef HASH_OF
@@ -0,0 +1,12 @@
+/**
+ * @brief Defines a typed vector type whose elements are void pointers.
+ *
+ * See typed_vector.h for documentation on how to declare other vector types.
+ */
+
+#define TYPED_VECTOR(token) typed_vector_pointer ## _ ## token
+#define T void*
+#include "typed_vector.h"
+#undef TYPED_VECTOR
+#undef T
+#undef TYPED_VECTOR_INLINE_CAPACITY
@@ -0,0 +1,158 @@
+/**
+ * @file typed_vector.h
+ * @brief Defines a generic vector (resizing array) data type whose elements are stored by value and
+ * whose first few elements are stored inside the vector itself.
+ *
+ * Vectors are defined by redefining T, TYPED_VECTOR, and TYPED_VECTOR_INLINE_CAPACITY, and including
+ * this file. See pointer_typed_vector.h for an example.
+ * - T must be the type of the elements, which can be any type that can be copied by assignment.
+ * - TYPED_VECTOR must be a function-like macro that prefixes tokens with the name of the vector, as
+ *   HASHMAP does for hashmap.h.
+ * - TYPED_VECTOR_INLINE_CAPACITY is the number of elements that the vector holds without allocating
+ *   memory. It defaults to 8.
+ *
+ * Unlike vector.h, which stores void* pointers and shrinks when enough calls to vector_vote say that
+ * it is mostly empty, these vectors never shrink until they are freed. Clearing a vector keeps its
+ * memory, so a vector that is filled and emptied once per tag allocates only while it grows to the
+ * largest size that it reaches, and not at all if that size is at most the inline capacity. A vector
+ * whose memory is all zero is empty, and a vector can be copied or moved by assignment, because it
+ * does not point into itself.
+ *
+ * The functions are static, so each file that includes this gets its own copy, and the ones on the
+ * fast path are inline.
+ */
+
+#ifndef T
+#define T void*
+#endif
+#ifndef TYPED_VECTOR
+#define TYPED_VECTOR(token) typed_vector ## _ ## token
+#endif
+#ifndef TYPED_VECTOR_INLINE_CAPACITY
+#define TYPED_VECTOR_INLINE_CAPACITY 8
+#endif
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+////////////////////////// Type definitions ///////////////////////////
+
+typedef struct TYPED_VECTOR(t) {
+    size_t size;          // The number of elements.
+    size_t heap_capacity; // The number of elements that heap_elements can hold, or 0 if the
+                          // elements are in inline_elements.
+    union {
+        T* heap_elements;
+        T inline_elements[TYPED_VECTOR_INLINE_CAPACITY];
+    } storage;
+} TYPED_VECTOR(t);
+
+//////////////////////// Function definitions /////////////////////////
+
+/**
+ * @brief Initialize the given vector to an empty vector that holds no memory. Use free, not this,
+ * to empty a vector that may hold memory.
+ */
+static inline void TYPED_VECTOR(init)(TYPED_VECTOR(t)* v) {
+    v->size = 0;
+    v->heap_capacity = 0;
+}
+
+/** @brief Free the memory held by the given vector and make it empty. */
+static inline void TYPED_VECTOR(free)(TYPED_VECTOR(t)* v) {
+    if (v->heap_capacity > 0) {
+        free(v->storage.heap_elements);
+    }
+    TYPED_VECTOR(init)(v);
+}
+
+/** @brief Return the elements of the given vector, which are contiguous. */
+static inline T* TYPED_VECTOR(data)(TYPED_VECTOR(t)* v) {
+    return v->heap_capacity > 0 ? v->storage.heap_elements : v->storage.inline_elements;
+}
+
+/** @brief Return the number of elements of the given vector. */
+static inline size_t TYPED_VECTOR(size)(TYPED_VECTOR(t)* v) {
+    return v->size;
+}
+
+/** @brief Return the number of elements that the given vector can hold without growing. */
+static inline size_t TYPED_VECTOR(capacity)(TYPED_VECTOR(t)* v) {
+    return v->heap_capacity > 0 ? v->heap_capacity : TYPED_VECTOR_INLINE_CAPACITY;
+}
+
+/**
+ * @brief Move the elements of the given vector to a heap array that can hold at least the given
+ * number of elements and at least twice as many as the vector can hold now.
+ */
+static void TYPED_VECTOR(grow)(TYPED_VECTOR(t)* v, size_t capacity) {
+    size_t new_capacity = 2 * TYPED_VECTOR(capacity)(v);
+    if (new_capacity < capacity) {
+        new_capacity = capacity;
+    }
+    T* elements;
+    if (v->heap_capacity > 0) {
+        elements = (T*)realloc(v->storage.heap_elements, new_capacity * sizeof(T));
+    } else {
+        elements = (T*)malloc(new_capacity * sizeof(T));
+        if (elements != NULL && v->size > 0) {
+            memcpy(elements, v->storage.inline_elements, v->size * sizeof(T));
+        }
+    }
+    if (elements == NULL) {
+        lf_print_error_and_exit("Out of memory growing a vector to %zu elements.", new_capacity);
+    }
+    v->storage.heap_elements = elements;
+    v->heap_capacity = new_capacity;
+}
+
+/**
+ * @brief Make sure that the given vector can hold the given number of elements without growing.
+ * Reserving the size that a vector will reach before filling it avoids growing it more than once.
+ */
+static inline void TYPED_VECTOR(reserve)(TYPED_VECTOR(t)* v, size_t capacity) {
+    if (capacity > TYPED_VECTOR(capacity)(v)) {
+        TYPED_VECTOR(grow)(v, capacity);
+    }
+}
+
+/** @brief Add the given element at the end of the given vector. */
+static inline void TYPED_VECTOR(push)(TYPED_VECTOR(t)* v, T element) {
+    if (v->size == TYPED_VECTOR(capacity)(v)) {
+        TYPED_VECTOR(grow)(v, v->size + 1);
+    }
+    TYPED_VECTOR(data)(v)[v->size++] = element;
+}
+
+/** @brief Add the given number of elements of the given array at the end of the given vector. */
+static inline void TYPED_VECTOR(append)(TYPED_VECTOR(t)* v, T const* elements, size_t count) {
+    TYPED_VECTOR(reserve)(v, v->size + count);
+    if (count > 0) {
+        memcpy(TYPED_VECTOR(data)(v) + v->size, elements, count * sizeof(T));
+    }
+    v->size += count;
+}
+
+/** @brief Remove and return the last element of the given vector, which must not be empty. */
+static inline T TYPED_VECTOR(pop)(TYPED_VECTOR(t)* v) {
+    assert(v->size > 0);
+    return TYPED_VECTOR(data)(v)[--v->size];
+}
+
+/** @brief Return a pointer to the element at the given index, which must be less than the size. */
+static inline T* TYPED_VECTOR(at)(TYPED_VECTOR(t)* v, size_t index) {
+    assert(index < v->size);
+    return TYPED_VECTOR(data)(v) + index;
+}
+
+/**
+ * @brief Remove all elements of the given vector, keeping its memory for the elements that are
+ * added next.
+ */
+static inline void TYPED_VECTOR(clear)(TYPED_VECTOR(t)* v) {
+    v->size = 0;
+}
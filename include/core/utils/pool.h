@@ -0,0 +1,94 @@
+/*************
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************/
+
+/**
+ * @file pool.h
+ * @brief A pool of memory blocks of equal size that are all allocated at once.
+ *
+ * Taking a block from a pool and giving it back take constant time and never
+ * touch the heap, so they do not suffer from the latency of the allocator.
+ * In the threaded runtime, the functions of a pool may be called from any
+ * thread.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef NUMBER_OF_WORKERS
+#include "platform.h"
+#endif
+
+typedef struct pool_t {
+    char* blocks;           // The memory of all blocks, or NULL if the capacity is 0.
+    size_t block_size;      // The size of each block, rounded up to keep blocks aligned.
+    size_t capacity;        // The number of blocks.
+    void* free_blocks;      // The blocks that are not in use, chained through their first word.
+    size_t in_use;          // The number of blocks that are in use.
+    size_t high_water_mark; // The largest number of blocks that have been in use at once.
+#ifdef NUMBER_OF_WORKERS
+    lf_mutex_t mutex;       // Protects free_blocks and the counts.
+#endif
+} pool_t;
+
+/**
+ * Allocate the blocks of a pool.
+ * @param pool The pool to initialize.
+ * @param block_size The minimum size of each block.
+ * @param capacity The number of blocks.
+ * @return 0 on success, or -1 if the memory could not be allocated.
+ */
+int pool_init(pool_t* pool, size_t block_size, size_t capacity);
+
+/**
+ * Take a block from a pool. The content of the block is undefined.
+ * @param pool The pool.
+ * @return The block, or NULL if all blocks are in use.
+ */
+void* pool_take(pool_t* pool);
+
+/**
+ * Give back a block taken from a pool.
+ * @param pool The pool.
+ * @param block The block, which pool_contains() must be true for.
+ */
+void pool_give(pool_t* pool, void* block);
+
+/**
+ * Return whether a pointer points into the memory of a pool. This lets a
+ * caller that also allocates from the heap tell which is which.
+ * @param pool The pool.
+ * @param pointer Any pointer.
+ */
+bool pool_contains(pool_t* pool, const void* pointer);
+
+/**
+ * Free the memory of a pool, invalidating it and all of its blocks.
+ * @param pool The pool.
+ */
+void pool_free(pool_t* pool);
+
+#endif // POOL_H
@@ -214,10 +214,11 @@ int pqueue_is_valid(pqueue_t *q);
 
 // ********** Priority Queue Support Start
 int in_reverse_order(pqueue_pri_t thiz, pqueue_pri_t that);
+int in_reverse_tag_order(pqueue_pri_t thiz, pqueue_pri_t that);
 int in_no_particular_order(pqueue_pri_t thiz, pqueue_pri_t that);
 int event_matches(void* next, void* curr);
 int reaction_matches(void* next, void* curr);
-pqueue_pri_t get_event_time(void *a);
+pqueue_pri_t get_event_tag(void *a);
 pqueue_pri_t get_reaction_index(void *a);
 size_t get_event_position(void *a);
 size_t get_reaction_position(void *a);
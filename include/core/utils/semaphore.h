@@ -40,11 +40,27 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "platform.h"
 #include <stdlib.h>
 
+/**
+ * Where futexes are system calls (see LF_NATIVE_FUTEX in the support header
+ * of the platform), a semaphore is a count that threads take with an atomic
+ * operation. A system call is made only to block while the count is zero and
+ * to wake up as many blocked threads as the count was increased by. Elsewhere,
+ * or if LF_MUTEX_SEMAPHORE is defined, it is a count protected by a mutex,
+ * and each release wakes up all the waiting threads.
+ */
+#if defined(LF_NATIVE_FUTEX) && !defined(LF_MUTEX_SEMAPHORE)
+#define LF_FUTEX_SEMAPHORE
+typedef struct {
+    volatile int32_t count;
+    volatile int32_t waiters;              // The number of threads that are blocked or about to block.
+} semaphore_t;
+#else
 typedef struct {
     int count;
     lf_mutex_t mutex;
     lf_cond_t cond;
 } semaphore_t;
+#endif
 
 /**
  * @brief Create a new semaphore.
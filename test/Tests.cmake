@@ -30,9 +30,36 @@ foreach(FILE ${TEST_FILES})
     string(REGEX REPLACE "[./]" "_" NAME ${FILE})
     add_executable(${NAME} ${TEST_DIR}/${FILE})
     add_test(NAME ${NAME} COMMAND ${NAME})
+    # A test that does not apply to the build exits with TEST_SKIPPED (see program_utils.h).
+    set_tests_properties(${NAME} PROPERTIES SKIP_RETURN_CODE 77)
     target_link_libraries(
         ${NAME} PUBLIC
         ${CoreLib} ${Lib} ${TestLib}
     )
     target_include_directories(${NAME} PRIVATE ${TEST_DIR})
+    # Tests look into the runtime. See the names for generated code in reactor_common.h.
+    target_compile_definitions(${NAME} PRIVATE LF_RUNTIME_SOURCE)
 endforeach(FILE ${TEST_FILES})
+
+# Benchmarks are built along with the tests, but ctest does not run them.
+set(BENCHMARK_SUFFIX benchmark.c)
+file(
+    GLOB_RECURSE BENCHMARK_FILES
+    LIST_DIRECTORIES false
+    RELATIVE ${TEST_DIR}
+    ${TEST_DIR}/benchmark/*${BENCHMARK_SUFFIX}
+)
+foreach(FILE ${BENCHMARK_FILES})
+    string(REGEX REPLACE "[./]" "_" NAME ${FILE})
+    add_executable(${NAME} ${TEST_DIR}/${FILE})
+    target_link_libraries(
+        ${NAME} PUBLIC
+        ${CoreLib} ${Lib} ${TestLib}
+    )
+    if(UNIX)
+        target_link_libraries(${NAME} PUBLIC m)
+    endif()
+    target_include_directories(${NAME} PRIVATE ${TEST_DIR})
+    # Tests look into the runtime. See the names for generated code in reactor_common.h.
+    target_compile_definitions(${NAME} PRIVATE LF_RUNTIME_SOURCE)
+endforeach(FILE ${BENCHMARK_FILES})
@@ -0,0 +1,130 @@
+/**
+ * @file fanout_benchmark.c
+ * @brief Measure how fast the outputs of a reaction with a wide fan-out are
+ * dispatched to the reactions that they trigger.
+ *
+ * A source reaction with OUTPUTS outputs executes at ITERATIONS successive
+ * microsteps. Each output is connected through TRIGGERS_PER_OUTPUT triggers,
+ * as a multiport or a broadcast would be, to REACTIONS_PER_TRIGGER reactions
+ * each, which overlap so that some reactions are reached several times. The
+ * downstream reactions do nothing, so the time per microstep is dominated by
+ * schedule_output_reactions() and the reaction queue. Build with
+ * -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+ */
+
+#include <stdio.h>
+
+#include "reactor.h"
+#include "reactor_common.h"
+#ifdef NUMBER_OF_WORKERS
+#include "scheduler.h"
+#endif
+
+int lf_reactor_c_main(int argc, const char* argv[]);
+
+#define ITERATIONS 100000
+#define OUTPUTS 8
+#define TRIGGERS_PER_OUTPUT 4
+#define REACTIONS_PER_TRIGGER 8
+#define DOWNSTREAM_REACTIONS 64
+#define DOWNSTREAM_LEVELS 4
+
+static int iteration = 0;
+static long long invocations = 0;
+static instant_t start_time;
+
+static void source_function(void* self);
+static void sink_function(void* self) { invocations++; }
+
+static self_base_t self;
+static reaction_t source_reaction = {
+    .function = source_function, .self = &self, .name = "source", .index = 0, .chain_id = 1, .deadline = -1
+};
+static reaction_t* source_reactions[] = {&source_reaction};
+static trigger_t source_trigger = {
+    .reactions = source_reactions, .number_of_reactions = 1, .offset = 0, .period = -1, .policy = defer
+};
+static struct { trigger_t* trigger; } source_action = {&source_trigger};
+
+static reaction_t sinks[DOWNSTREAM_REACTIONS];
+static reaction_t* sink_lists[OUTPUTS][TRIGGERS_PER_OUTPUT][REACTIONS_PER_TRIGGER];
+static trigger_t output_triggers[OUTPUTS][TRIGGERS_PER_OUTPUT];
+static trigger_t* output_trigger_arrays[OUTPUTS][TRIGGERS_PER_OUTPUT];
+static trigger_t** triggers[OUTPUTS];
+static int triggered_sizes[OUTPUTS];
+static bool is_present[OUTPUTS];
+static bool* output_produced[OUTPUTS];
+static reaction_t* all_reactions[DOWNSTREAM_REACTIONS + 1];
+
+static void source_function(void* self) {
+    for (int i = 0; i < OUTPUTS; i++) {
+        is_present[i] = true;
+    }
+    if (++iteration < ITERATIONS) {
+        _lf_schedule_token(&source_action, 0, NULL);
+    } else {
+        lf_request_stop();
+    }
+}
+
+void _lf_initialize_trigger_objects() {
+    for (int r = 0; r < DOWNSTREAM_REACTIONS; r++) {
+        sinks[r] = (reaction_t) {
+            .function = sink_function, .self = &self, .name = "sink",
+            .index = 1 + r % DOWNSTREAM_LEVELS, .chain_id = 1, .deadline = -1
+        };
+    }
+    for (int i = 0; i < OUTPUTS; i++) {
+        for (int j = 0; j < TRIGGERS_PER_OUTPUT; j++) {
+            for (int k = 0; k < REACTIONS_PER_TRIGGER; k++) {
+                // Consecutive triggers of an output share half of their reactions.
+                sink_lists[i][j][k] = &sinks[(i * 8 + j * REACTIONS_PER_TRIGGER / 2 + k) % DOWNSTREAM_REACTIONS];
+            }
+            output_triggers[i][j] = (trigger_t) {
+                .reactions = sink_lists[i][j], .number_of_reactions = REACTIONS_PER_TRIGGER
+            };
+            output_trigger_arrays[i][j] = &output_triggers[i][j];
+        }
+        triggers[i] = output_trigger_arrays[i];
+        triggered_sizes[i] = TRIGGERS_PER_OUTPUT;
+        output_produced[i] = &is_present[i];
+    }
+    source_reaction.num_outputs = OUTPUTS;
+    source_reaction.output_produced = output_produced;
+    source_reaction.triggered_sizes = triggered_sizes;
+    source_reaction.triggers = triggers;
+    // List the reactions, as generated code does, so that their outputs are flattened at startup.
+    all_reactions[0] = &source_reaction;
+    for (int r = 0; r < DOWNSTREAM_REACTIONS; r++) {
+        all_reactions[r + 1] = &sinks[r];
+    }
+    _lf_reactions = all_reactions;
+    _lf_reactions_size = DOWNSTREAM_REACTIONS + 1;
+#ifdef NUMBER_OF_WORKERS
+    // As generated code does, give the scheduler the number of reactions per level.
+    static size_t num_reactions_per_level[DOWNSTREAM_LEVELS + 1] = {1};
+    for (int level = 1; level <= DOWNSTREAM_LEVELS; level++) {
+        num_reactions_per_level[level] = DOWNSTREAM_REACTIONS / DOWNSTREAM_LEVELS;
+    }
+    static sched_params_t sched_params = {num_reactions_per_level, DOWNSTREAM_LEVELS + 1};
+    lf_sched_init(_lf_instance->number_of_workers, &sched_params);
+#endif
+}
+void _lf_trigger_startup_reactions() {
+    start_time = lf_time_physical();
+    _lf_trigger_reaction(&source_reaction, -1);
+}
+
+void terminate_execution() {
+    if (iteration == ITERATIONS) {
+        interval_t elapsed = lf_time_physical() - start_time;
+        printf("Dispatching %d outputs to %d triggers each, over %d microsteps:\n",
+                OUTPUTS, TRIGGERS_PER_OUTPUT, ITERATIONS);
+        printf("  downstream reactions per microstep: %lld\n", invocations / ITERATIONS);
+        printf("  time per microstep:                 %lld ns\n", (long long)(elapsed / ITERATIONS));
+    }
+}
+
+int main(int argc, const char* argv[]) {
+    return lf_reactor_c_main(argc, argv);
+}
@@ -0,0 +1,106 @@
+/**
+ * @file hashmap_benchmark.c
+ * @brief Compare the growable hashmap of growable_hashmap.h with the fixed-capacity hashmap of
+ * hashmap.h on pointer keys.
+ *
+ * Keys are spaced like the addresses of structs of 64 bytes, as the ports and triggers of a
+ * program are. The fixed-capacity hashmap is given four times as many entries as keys, as its
+ * documentation asks, and the growable one starts empty. Build with
+ * -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "core/utils/impl/pointer_hashmap.h"
+#include "core/utils/impl/pointer_growable_hashmap.h"
+#include "platform.h"
+#include "util.h"
+
+#define ROUNDS 5
+static const size_t sizes[] = {100, 10000, 100000};
+
+static volatile int sink;
+
+static instant_t now() {
+    instant_t now;
+    lf_clock_gettime(&now);
+    return now;
+}
+
+static void* key_of(size_t index) {
+    return (void*)((uintptr_t)0x10000 + 64 * (uintptr_t)index);
+}
+
+/**
+ * @brief Print the average time per operation of ROUNDS rounds of n operations.
+ */
+static void report(const char* name, const char* operation, interval_t elapsed, size_t n) {
+    printf("  %-10s %-14s %6.1f ns\n", name, operation, (double)elapsed / ROUNDS / n);
+}
+
+static void benchmark_fixed(size_t n) {
+    interval_t put = 0, get = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        hashmap_object2int_t* h = hashmap_object2int_new(4 * n, NULL);
+        instant_t start = now();
+        for (size_t i = 0; i < n; i++) {
+            hashmap_object2int_put(h, key_of(i), (int)i);
+        }
+        put += now() - start;
+        start = now();
+        for (size_t i = 0; i < n; i++) {
+            int value = hashmap_object2int_get(h, key_of((i * 7919) % n));
+            sink += value;
+        }
+        get += now() - start;
+        hashmap_object2int_free(h);
+    }
+    report("fixed", "put", put, n);
+    report("fixed", "get (hit)", get, n);
+}
+
+static void benchmark_growable(size_t n) {
+    interval_t put = 0, hit = 0, miss = 0, remove = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        growable_hashmap_object2int_t* h = growable_hashmap_object2int_new(0);
+        instant_t start = now();
+        for (size_t i = 0; i < n; i++) {
+            growable_hashmap_object2int_put(h, key_of(i), (int)i);
+        }
+        put += now() - start;
+        start = now();
+        for (size_t i = 0; i < n; i++) {
+            int* value = growable_hashmap_object2int_find(h, key_of((i * 7919) % n));
+            sink += *value;
+        }
+        hit += now() - start;
+        start = now();
+        for (size_t i = 0; i < n; i++) {
+            sink += growable_hashmap_object2int_find(h, key_of(n + i)) == NULL;
+        }
+        miss += now() - start;
+        start = now();
+        for (size_t i = 0; i < n; i++) {
+            growable_hashmap_object2int_remove(h, key_of(i));
+        }
+        remove += now() - start;
+        if (growable_hashmap_object2int_size(h) != 0) {
+            lf_print_error_and_exit("The hashmap is not empty after removing all keys.");
+        }
+        growable_hashmap_object2int_free(h);
+    }
+    report("growable", "put", put, n);
+    report("growable", "find (hit)", hit, n);
+    report("growable", "find (miss)", miss, n);
+    report("growable", "remove", remove, n);
+}
+
+int main(int argc, const char* argv[]) {
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        printf("%zu keys, average time per operation:\n", sizes[i]);
+        benchmark_fixed(sizes[i]);
+        benchmark_growable(sizes[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file microstep_benchmark.c
+ * @brief Measure the cost of scheduling an action many times at the current
+ * time and processing the resulting events in consecutive microsteps.
+ *
+ * The event queue is ordered by tag, so the cost of one
+ * schedule/advance/pop round grows only with the logarithm of the number of
+ * pending microsteps, rather than linearly as it did with chains of dummy
+ * events. Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+ */
+
+#include <stdio.h>
+
+#include "reactor_common.h"
+#include "util.h"
+
+#define MAX_MICROSTEPS 100000
+
+static trigger_t action = {
+    .reactions = NULL,
+    .number_of_reactions = 0,
+    .is_timer = false,
+    .offset = 0LL,
+    .period = -1LL,
+    .policy = defer,
+};
+
+/**
+ * @brief Schedule the action n times, then advance through the n microsteps
+ * and return the average time per microstep.
+ */
+static interval_t run(int n) {
+    tag_t start = lf_tag();
+    instant_t begin = lf_time_physical();
+    for (int i = 0; i < n; i++) {
+        _lf_schedule(&action, 0LL, NULL);
+    }
+    for (int i = 1; i <= n; i++) {
+        _lf_advance_logical_time((tag_t) {.time = start.time, .microstep = start.microstep + i});
+        _lf_pop_events();
+    }
+    interval_t elapsed = lf_time_physical() - begin;
+    if (pqueue_size(_lf_enclave->event_q) != 0) {
+        lf_print_error_and_exit("Event queue not empty.");
+    }
+    return elapsed / n;
+}
+
+int main(int argc, char **argv) {
+#ifdef LF_STATIC_MEMORY
+    // As --max-events would.
+    _lf_instance->max_events = MAX_MICROSTEPS;
+#endif
+    initialize();
+    for (int n = 1000; n <= MAX_MICROSTEPS; n *= 10) {
+        printf("%6d pending microsteps: " PRINTF_TIME " ns per microstep\n", n, run(n));
+    }
+    return 0;
+}
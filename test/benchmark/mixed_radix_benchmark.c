@@ -0,0 +1,91 @@
+/**
+ * @file mixed_radix_benchmark.c
+ * @brief Measure the cost of the loops over mixed-radix numbers that connect banks of reactors
+ * at startup.
+ *
+ * The generated code connects the multiport of every member of nested banks by iterating a
+ * mixed-radix number with one digit per level of the hierarchy plus one for the channel of the
+ * multiport. For each value, it needs the index of the channel among all channels and the index of
+ * the reactor, which is the parent after dropping the channel digit. Interleaved connections permute
+ * the digits. Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mixed_radix.h"
+#include "platform.h"
+
+#define WIDTH 8
+#define MAX_DEPTH 6
+#define CHUNK 256
+
+static volatile int sink;
+
+static instant_t now() {
+    instant_t now;
+    lf_clock_gettime(&now);
+    return now;
+}
+
+/**
+ * @brief Iterate over all channels of a hierarchy of the given depth, in which every bank and
+ * multiport has WIDTH members, with the first two digits swapped as in an interleaved connection.
+ */
+static void benchmark(int depth) {
+    int size = depth + 1;
+    int total = 1;
+    int digits[MAX_DEPTH + 1] = {0};
+    int radixes[MAX_DEPTH + 1];
+    int permutation[MAX_DEPTH + 1];
+    for (int i = 0; i < size; i++) {
+        radixes[i] = WIDTH;
+        permutation[i] = i;
+        total *= WIDTH;
+    }
+    permutation[0] = 1;
+    permutation[1] = 0;
+    mixed_radix_int_t mixed = {size, digits, radixes, permutation};
+
+    instant_t start = now();
+    int sum = 0;
+    for (int i = 0; i < total; i++) {
+        sum += mixed_radix_to_int(&mixed) + mixed_radix_parent(&mixed, 1);
+        mixed_radix_incr(&mixed);
+    }
+    interval_t functions = now() - start;
+
+    int strides[MAX_DEPTH + 1];
+    mixed_radix_iterator_t it;
+    mixed_radix_iterator_init(&it, &mixed, strides);
+    start = now();
+    for (int i = 0; i < total; i++) {
+        sum += mixed_radix_iterator_to_int(&it) + mixed_radix_iterator_parent(&it, 1);
+        mixed_radix_iterator_incr(&it);
+    }
+    interval_t iterator = now() - start;
+
+    int values[CHUNK];
+    start = now();
+    for (int i = 0; i < total; i += CHUNK) {
+        int count = total - i < CHUNK ? total - i : CHUNK;
+        mixed_radix_iterator_fill(&it, values, count);
+        for (int j = 0; j < count; j++) {
+            sum += values[j] + values[j] / WIDTH;
+        }
+    }
+    interval_t fill = now() - start;
+    sink = sum;
+
+    printf("%d levels of banks (%d channels), average time per channel:\n", depth, total);
+    printf("  mixed_radix_to_int/parent/incr   %6.2f ns\n", (double)functions / total);
+    printf("  mixed_radix_iterator_*           %6.2f ns\n", (double)iterator / total);
+    printf("  mixed_radix_iterator_fill        %6.2f ns\n", (double)fill / total);
+}
+
+int main(int argc, const char* argv[]) {
+    for (int depth = 2; depth <= MAX_DEPTH; depth += 2) {
+        benchmark(depth);
+    }
+    return 0;
+}
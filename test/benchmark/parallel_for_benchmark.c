@@ -0,0 +1,120 @@
+/**
+ * @file parallel_for_benchmark.c
+ * @brief Compare a wide array transformation executed by one reaction with
+ * the same transformation split across idle workers with lf_parallel_for().
+ *
+ * A reaction is triggered ITERATIONS times and alternates between a plain
+ * loop and lf_parallel_for(). Build with -DCMAKE_BUILD_TYPE=Release and
+ * -DNUMBER_OF_WORKERS=<n> for meaningful numbers. Run with -w to vary the
+ * number of workers.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "reactor.h"
+#include "reactor_common.h"
+#ifdef NUMBER_OF_WORKERS
+#include "scheduler.h"
+#endif
+
+int lf_reactor_c_main(int argc, const char* argv[]);
+
+#define LENGTH (1 << 22)
+#define ITERATIONS 100
+
+static double* input;
+static double* output;
+static double* expected;
+static int iteration = 0;
+static interval_t sequential_time = 0;
+static interval_t parallel_time = 0;
+
+static void startup_function(void* self);
+static void transform_function(void* self);
+
+static self_base_t self;
+static reaction_t startup_reaction = {
+    .function = startup_function, .self = &self, .name = "startup", .index = 0, .chain_id = 1, .deadline = -1
+};
+static reaction_t transform_reaction = {
+    .function = transform_function, .self = &self, .name = "transform", .index = 1, .chain_id = 1, .deadline = -1
+};
+static reaction_t* transform_reactions[] = {&transform_reaction};
+static trigger_t transform_trigger = {
+    .reactions = transform_reactions, .number_of_reactions = 1, .offset = 0, .period = -1, .policy = defer
+};
+static struct { trigger_t* trigger; } transform_action = {&transform_trigger};
+
+/**
+ * Transform the elements of the input with indices from begin to end - 1.
+ */
+static void transform(size_t begin, size_t end, void* arg) {
+    double* result = (double*)arg;
+    for (size_t i = begin; i < end; i++) {
+        result[i] = sqrt(input[i]) * sin(input[i]) + log1p(input[i]);
+    }
+}
+
+static void startup_function(void* self) {
+    input = (double*)malloc(LENGTH * sizeof(double));
+    output = (double*)malloc(LENGTH * sizeof(double));
+    expected = (double*)malloc(LENGTH * sizeof(double));
+    if (input == NULL || output == NULL || expected == NULL) {
+        lf_print_error_and_exit("Out of memory.");
+    }
+    for (size_t i = 0; i < LENGTH; i++) {
+        input[i] = (double)i / LENGTH;
+    }
+    transform(0, LENGTH, expected);
+    _lf_schedule_token(&transform_action, 0, NULL);
+}
+
+static void transform_function(void* self) {
+    instant_t start = lf_time_physical();
+    if (iteration % 2 == 0) {
+        transform(0, LENGTH, output);
+        sequential_time += lf_time_physical() - start;
+    } else {
+        lf_parallel_for(0, LENGTH, 0, transform, output);
+        parallel_time += lf_time_physical() - start;
+        for (size_t i = 0; i < LENGTH; i++) {
+            if (output[i] != expected[i]) {
+                lf_print_error_and_exit("Element %zu is %f instead of %f.", i, output[i], expected[i]);
+            }
+        }
+    }
+    if (++iteration < 2 * ITERATIONS) {
+        _lf_schedule_token(&transform_action, 0, NULL);
+    } else {
+        lf_request_stop();
+    }
+}
+
+void _lf_initialize_trigger_objects() {
+#ifdef NUMBER_OF_WORKERS
+    // As generated code does, give the scheduler the number of reactions per level.
+    static size_t num_reactions_per_level[] = {1, 1};
+    static sched_params_t sched_params = {num_reactions_per_level, 2};
+    lf_sched_init(_lf_instance->number_of_workers, &sched_params);
+#endif
+}
+void _lf_trigger_startup_reactions() { _lf_trigger_reaction(&startup_reaction, -1); }
+
+void terminate_execution() {
+    if (iteration == 2 * ITERATIONS) {
+        printf("Transforming %d doubles, averaged over %d iterations:\n", LENGTH, ITERATIONS);
+        printf("  loop in one reaction: %lld us\n", (long long)(sequential_time / ITERATIONS / 1000));
+        printf("  lf_parallel_for:      %lld us (speedup %.2f)\n",
+                (long long)(parallel_time / ITERATIONS / 1000),
+                (double)sequential_time / (double)parallel_time);
+    }
+    free(input);
+    free(output);
+    free(expected);
+}
+
+int main(int argc, const char* argv[]) {
+    return lf_reactor_c_main(argc, argv);
+}
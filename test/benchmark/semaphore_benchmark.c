@@ -0,0 +1,111 @@
+/**
+ * @file semaphore_benchmark.c
+ * @brief Measure the latency of handing work from one thread to another
+ * through the semaphore that the NP, GEDF_NP, and GEDF_NP_CI schedulers use
+ * to wake up idle workers.
+ *
+ * The first measurement bounces between two threads, each of which releases
+ * the semaphore of the other and then acquires its own. The second hands one
+ * unit at a time to a pool of IDLE_WORKERS threads that wait on one semaphore,
+ * as the scheduler does when a single reaction becomes ready. Build with
+ * -DCMAKE_BUILD_TYPE=Release and -DNUMBER_OF_WORKERS=<n>, with and without
+ * -DLF_MUTEX_SEMAPHORE=1, to compare the futex-based semaphore with the one
+ * based on a mutex and a condition variable.
+ */
+
+#include <stdio.h>
+
+#include "platform.h"
+#include "util.h"
+#ifdef NUMBER_OF_WORKERS
+#include "semaphore.h"
+
+#define HANDOFFS 100000
+#define IDLE_WORKERS 8
+
+static semaphore_t* ping;
+static semaphore_t* pong;
+static semaphore_t* work;
+static semaphore_t* done;
+static volatile int32_t handled = 0;
+
+static instant_t now() {
+    instant_t now;
+    lf_clock_gettime(&now);
+    return now;
+}
+
+static void* ponger(void* arg) {
+    for (int i = 0; i < HANDOFFS; i++) {
+        lf_semaphore_acquire(ping);
+        lf_semaphore_release(pong, 1);
+    }
+    return NULL;
+}
+
+static void* idle_worker(void* arg) {
+    while (true) {
+        lf_semaphore_acquire(work);
+        if (handled == HANDOFFS) {
+            return NULL;
+        }
+        lf_atomic_fetch_add(&handled, 1);
+        lf_semaphore_release(done, 1);
+    }
+}
+
+int main(int argc, const char* argv[]) {
+    ping = lf_semaphore_new(0);
+    pong = lf_semaphore_new(0);
+    work = lf_semaphore_new(0);
+    done = lf_semaphore_new(0);
+
+    lf_thread_t thread;
+    lf_thread_create(&thread, ponger, NULL);
+    instant_t start = now();
+    for (int i = 0; i < HANDOFFS; i++) {
+        lf_semaphore_release(ping, 1);
+        lf_semaphore_acquire(pong);
+    }
+    interval_t ping_pong = now() - start;
+    lf_thread_join(thread, NULL);
+
+    lf_thread_t workers[IDLE_WORKERS];
+    for (int i = 0; i < IDLE_WORKERS; i++) {
+        lf_thread_create(&workers[i], idle_worker, NULL);
+    }
+    start = now();
+    for (int i = 0; i < HANDOFFS; i++) {
+        lf_semaphore_release(work, 1);
+        lf_semaphore_acquire(done);
+    }
+    interval_t pool = now() - start;
+    if (handled != HANDOFFS) {
+        lf_print_error_and_exit("The workers handled %d units instead of %d.", handled, HANDOFFS);
+    }
+    lf_semaphore_release(work, IDLE_WORKERS);
+    for (int i = 0; i < IDLE_WORKERS; i++) {
+        lf_thread_join(workers[i], NULL);
+    }
+
+    printf("Handing off work %d times (%s semaphore):\n", HANDOFFS,
+#ifdef LF_FUTEX_SEMAPHORE
+            "futex"
+#else
+            "mutex"
+#endif
+            );
+    printf("  between two threads:        %lld ns per round trip\n", (long long)(ping_pong / HANDOFFS));
+    printf("  to one of %d idle workers:   %lld ns per round trip\n", IDLE_WORKERS, (long long)(pool / HANDOFFS));
+    lf_semaphore_destroy(ping);
+    lf_semaphore_destroy(pong);
+    lf_semaphore_destroy(work);
+    lf_semaphore_destroy(done);
+    return 0;
+}
+#else
+int main(int argc, const char* argv[]) {
+    printf("This benchmark requires the threaded runtime (-DNUMBER_OF_WORKERS=<n>).\n");
+    return 0;
+}
+#endif
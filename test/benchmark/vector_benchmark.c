@@ -0,0 +1,175 @@
+/**
+ * @file vector_benchmark.c
+ * @brief Compare the typed vectors of typed_vector.h with the vectors of vector.h.
+ *
+ * The first workload is that of vector_test.c: vectors are created, receive a random mix of pushes,
+ * pops, and bulk appends, and are freed. The second fills a long-lived vector with a few pointers
+ * and empties it again, as a scheduler does with the reactions of each tag. The third sums integers
+ * that vector.h can only hold through pointers. Build with -DCMAKE_BUILD_TYPE=Release for
+ * meaningful numbers.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "core/utils/impl/pointer_typed_vector.h"
+#include "platform.h"
+#include "vector.h"
+
+#define TYPED_VECTOR(token) int_vector ## _ ## token
+#define T int
+#include "core/utils/impl/typed_vector.h"
+#undef TYPED_VECTOR
+#undef T
+#undef TYPED_VECTOR_INLINE_CAPACITY
+
+#define ROUNDS 20000
+#define OPERATIONS 100
+#define MAX_PUSHALL 8
+#define TAGS 1000000
+#define INTS 1000
+
+enum operation { PUSH, POP, PUSHALL };
+
+static enum operation operations[OPERATIONS];
+static size_t counts[OPERATIONS];
+static size_t initial_capacities[ROUNDS];
+static void* elements[MAX_PUSHALL];
+static int ints[INTS];
+static volatile uintptr_t sink;
+
+static instant_t now() {
+    instant_t now;
+    lf_clock_gettime(&now);
+    return now;
+}
+
+static void report(const char* workload, const char* name, interval_t elapsed, size_t n) {
+    printf("  %-28s %-8s %7.1f ns\n", workload, name, (double)elapsed / n);
+}
+
+/**
+ * @brief Draw the operations of the vector_test.c workload, with its distribution of 30% pushes,
+ * 50% pops, and 5% bulk appends; the remaining 15% are votes, which only vector.h has.
+ */
+static void draw_operations() {
+    for (int i = 0; i < OPERATIONS; i++) {
+        int choice = rand() % 85;
+        operations[i] = choice < 30 ? PUSH : choice < 80 ? POP : PUSHALL;
+        counts[i] = rand() % MAX_PUSHALL;
+    }
+    for (int i = 0; i < ROUNDS; i++) {
+        initial_capacities[i] = rand() % 100 + 1;
+    }
+    for (int i = 0; i < MAX_PUSHALL; i++) {
+        elements[i] = &elements[i];
+    }
+}
+
+static void benchmark_vector_test_workload() {
+    instant_t start = now();
+    for (int round = 0; round < ROUNDS; round++) {
+        vector_t v = vector_new(initial_capacities[round]);
+        for (int i = 0; i < OPERATIONS; i++) {
+            switch (operations[i]) {
+                case PUSH: vector_push(&v, elements[0]); break;
+                case POP: sink += (uintptr_t)vector_pop(&v); break;
+                case PUSHALL: vector_pushall(&v, elements, counts[i]); break;
+            }
+        }
+        vector_free(&v);
+    }
+    report("vector_test workload", "vector", now() - start, ROUNDS);
+    start = now();
+    for (int round = 0; round < ROUNDS; round++) {
+        typed_vector_pointer_t v = {0};
+        for (int i = 0; i < OPERATIONS; i++) {
+            switch (operations[i]) {
+                case PUSH: typed_vector_pointer_push(&v, elements[0]); break;
+                case POP:
+                    if (typed_vector_pointer_size(&v) > 0) sink += (uintptr_t)typed_vector_pointer_pop(&v);
+                    break;
+                case PUSHALL: typed_vector_pointer_append(&v, elements, counts[i]); break;
+            }
+        }
+        typed_vector_pointer_free(&v);
+    }
+    report("vector_test workload", "typed", now() - start, ROUNDS);
+}
+
+static void benchmark_per_tag(size_t per_tag) {
+    char workload[64];
+    snprintf(workload, sizeof(workload), "%zu pointers per tag", per_tag);
+    vector_t v = vector_new(1);
+    instant_t start = now();
+    for (int tag = 0; tag < TAGS; tag++) {
+        for (size_t i = 0; i < per_tag; i++) {
+            vector_push(&v, elements[i % MAX_PUSHALL]);
+        }
+        vector_vote(&v);
+        void* element;
+        while ((element = vector_pop(&v)) != NULL) {
+            sink += (uintptr_t)element;
+        }
+    }
+    report(workload, "vector", now() - start, TAGS);
+    vector_free(&v);
+    typed_vector_pointer_t t = {0};
+    start = now();
+    for (int tag = 0; tag < TAGS; tag++) {
+        for (size_t i = 0; i < per_tag; i++) {
+            typed_vector_pointer_push(&t, elements[i % MAX_PUSHALL]);
+        }
+        void** data = typed_vector_pointer_data(&t);
+        for (size_t i = typed_vector_pointer_size(&t); i > 0; i--) {
+            sink += (uintptr_t)data[i - 1];
+        }
+        typed_vector_pointer_clear(&t);
+    }
+    report(workload, "typed", now() - start, TAGS);
+    typed_vector_pointer_free(&t);
+}
+
+static void benchmark_ints() {
+    vector_t v = vector_new(INTS);
+    int_vector_t t = {0};
+    for (int i = 0; i < INTS; i++) {
+        ints[i] = rand();
+        vector_push(&v, &ints[i]);
+        int_vector_push(&t, ints[i]);
+    }
+    int rounds = TAGS / 100;
+    instant_t start = now();
+    for (int round = 0; round < rounds; round++) {
+        unsigned sum = 0;
+        for (size_t i = 0; i < vector_size(&v); i++) {
+            sum += *(int*)v.start[i];
+        }
+        sink += sum;
+    }
+    report("sum of 1000 ints", "vector", now() - start, rounds);
+    start = now();
+    for (int round = 0; round < rounds; round++) {
+        unsigned sum = 0;
+        int* data = int_vector_data(&t);
+        for (size_t i = 0; i < int_vector_size(&t); i++) {
+            sum += data[i];
+        }
+        sink += sum;
+    }
+    report("sum of 1000 ints", "typed", now() - start, rounds);
+    vector_free(&v);
+    int_vector_free(&t);
+}
+
+int main(int argc, const char* argv[]) {
+    srand(1614);
+    draw_operations();
+    printf("Average time per round, tag, or sum:\n");
+    benchmark_vector_test_workload();
+    benchmark_per_tag(4);
+    benchmark_per_tag(64);
+    benchmark_ints();
+    return 0;
+}
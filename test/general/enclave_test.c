@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "reactor.h"
+#include "reactor_common.h"
+#include "util.h"
+#include "program_utils.h"
+#ifdef LF_ENCLAVES_SUPPORTED
+#include "enclave.h"
+#include "scheduler.h"
+
+// A source reaction in the main enclave executes TICKS times, PERIOD apart,
+// and sends its elapsed logical time to a sink reaction in a second enclave
+// through an action with an offset of DELAY, which is also the delay of the
+// connection between the enclaves. It also tries once to send it through an
+// action with a smaller offset, which the connection does not allow.
+#define TICKS 10
+#define PERIOD MSEC(1)
+#define DELAY MSEC(5)
+
+static int ticks = 0;
+static int received = 0;
+static int early_received = 0;
+static int rejected = 0;
+static lf_enclave_t* sink_enclave;
+
+static void source_function(void* self);
+static void sink_function(void* self);
+static void early_function(void* self);
+
+static self_base_t source_self;
+static self_base_t sink_self;
+
+static reaction_t source_reaction = {
+    .function = source_function, .self = &source_self, .name = "source", .index = 0, .chain_id = 1, .deadline = -1
+};
+static reaction_t* source_reactions[] = {&source_reaction};
+static trigger_t tick_trigger = {
+    .reactions = source_reactions, .number_of_reactions = 1, .offset = PERIOD, .period = -1, .policy = defer
+};
+static struct { trigger_t* trigger; } tick_action = {&tick_trigger};
+
+static reaction_t sink_reaction = {
+    .function = sink_function, .self = &sink_self, .name = "sink", .index = 0, .chain_id = 1, .deadline = -1
+};
+static reaction_t* sink_reactions[] = {&sink_reaction};
+static trigger_t sink_trigger = {
+    .reactions = sink_reactions, .number_of_reactions = 1, .offset = DELAY, .period = -1, .policy = defer,
+    .element_size = sizeof(instant_t)
+};
+static struct { trigger_t* trigger; } sink_action = {&sink_trigger};
+
+static reaction_t early_reaction = {
+    .function = early_function, .self = &sink_self, .name = "early", .index = 0, .chain_id = 1, .deadline = -1
+};
+static reaction_t* early_reactions[] = {&early_reaction};
+static trigger_t early_trigger = {
+    .reactions = early_reactions, .number_of_reactions = 1, .offset = DELAY / 2, .period = -1, .policy = defer,
+    .element_size = sizeof(instant_t)
+};
+static struct { trigger_t* trigger; } early_action = {&early_trigger};
+
+static void source_function(void* self) {
+    instant_t elapsed = lf_time_logical_elapsed();
+    if (ticks == 0) {
+        // The delay of the action is below that of the connection.
+        if (_lf_schedule_copy(&early_action, 0, &elapsed, 1) == -1) {
+            rejected++;
+        }
+        instant_t* value = (instant_t*)_lf_allocate_payload(sizeof(instant_t));
+        *value = elapsed;
+        if (_lf_schedule_value(&early_action, 0, value, 1) == -1) {
+            rejected++;
+        }
+    }
+    // Alternate between a copy and a value that the destination takes over.
+    // Values come from _lf_allocate_payload(), as in static-memory mode the
+    // heap may not be used after startup.
+    trigger_handle_t handle;
+    if (ticks % 2 == 0) {
+        handle = _lf_schedule_copy(&sink_action, 0, &elapsed, 1);
+    } else {
+        instant_t* value = (instant_t*)_lf_allocate_payload(sizeof(instant_t));
+        *value = elapsed;
+        handle = _lf_schedule_value(&sink_action, 0, value, 1);
+    }
+    if (handle <= 0) {
+        lf_print_error_and_exit("Tick %d could not be sent to the sink.", ticks);
+    }
+    if (++ticks < TICKS) {
+        _lf_schedule_token(&tick_action, 0, NULL);
+    }
+}
+
+static void sink_function(void* self) {
+    if (_lf_enclave != sink_enclave) {
+        lf_print_error_and_exit("The sink executed in enclave %s.", _lf_enclave->name);
+    }
+    instant_t sent = *(instant_t*)sink_trigger.token->value;
+    instant_t expected = (instant_t)(received * PERIOD);
+    if (sent != expected) {
+        lf_print_error_and_exit("The sink received " PRINTF_TIME " instead of " PRINTF_TIME ".", sent, expected);
+    }
+    instant_t arrival = (instant_t)(sent + DELAY);
+    if (lf_time_logical_elapsed() != arrival) {
+        lf_print_error_and_exit("A value sent at " PRINTF_TIME " arrived at " PRINTF_TIME " instead of "
+                PRINTF_TIME ".", sent, lf_time_logical_elapsed(), arrival);
+    }
+    received++;
+}
+
+static void early_function(void* self) {
+    early_received++;
+}
+
+void _lf_initialize_trigger_objects() {
+    sink_enclave = lf_enclave_create("sink", 1);
+    sink_self.enclave = sink_enclave;
+    lf_enclave_connect(&_lf_main_enclave, sink_enclave, DELAY);
+    // As generated code does, create the template tokens of the actions, which
+    // the runtime frees once events replace them.
+    sink_trigger.token = _lf_create_token(sizeof(instant_t));
+    early_trigger.token = _lf_create_token(sizeof(instant_t));
+    // As generated code does, give the scheduler of each enclave the number
+    // of reactions per level. Each enclave has one worker.
+    static size_t source_reactions_per_level[1] = {1};
+    static sched_params_t source_params = {source_reactions_per_level, 1};
+    lf_sched_init(1, &source_params);
+    static size_t sink_reactions_per_level[1] = {2};
+    static sched_params_t sink_params = {sink_reactions_per_level, 1};
+    _lf_enclave = sink_enclave;
+    lf_sched_init(1, &sink_params);
+    // The sink enclave releases the tokens of its actions at each time step.
+    // Termination frees the table.
+    token_present_t* sink_tokens = (token_present_t*)malloc(2 * sizeof(token_present_t));
+    sink_tokens[0] = (token_present_t) {&sink_trigger.token, &sink_trigger.status, true};
+    sink_tokens[1] = (token_present_t) {&early_trigger.token, &early_trigger.status, true};
+    _lf_tokens_with_ref_count = sink_tokens;
+    _lf_tokens_with_ref_count_size = 2;
+    _lf_enclave = &_lf_main_enclave;
+}
+void _lf_trigger_startup_reactions() {
+    if (_lf_enclave == &_lf_main_enclave) {
+        _lf_trigger_reaction(&source_reaction, -1);
+    }
+}
+
+/**
+ * @brief Send values from one enclave to another and check that each arrives
+ * with the delay of its action, that the destination advances its logical
+ * time as far as the last of them, and that an action with a delay below that
+ * of the connection is rejected.
+ */
+int main(int argc, const char* argv[]) {
+    if (!lf_sched_supports_enclaves) {
+        lf_print("Skipped: the scheduler does not support enclaves.");
+        return TEST_SKIPPED;
+    }
+    if (!run_program("-f", "true", "-w", "1", NULL)) {
+        lf_print_error_and_exit("The program failed.");
+    }
+    if (ticks != TICKS || received != TICKS) {
+        lf_print_error_and_exit("The sink received %d of %d values.", received, ticks);
+    }
+    if (rejected != 2 || early_received != 0) {
+        lf_print_error_and_exit("An action with a delay below that of the connection was not rejected.");
+    }
+    if (sink_enclave->current_tag.time - _lf_instance->start_time < (TICKS - 1) * PERIOD + DELAY) {
+        lf_print_error_and_exit("The sink stopped at " PRINTF_TIME ", before its last event.",
+                (instant_t)(sink_enclave->current_tag.time - _lf_instance->start_time));
+    }
+    return 0;
+}
+#else
+// Enclaves exist only in the threaded runtime, and not in federated
+// execution, with modal reactors, or with tracing.
+int main(int argc, const char* argv[]) {
+    return TEST_SKIPPED;
+}
+#endif
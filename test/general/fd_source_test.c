@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "reactor.h"
+#include "reactor_common.h"
+#include "util.h"
+#include "program_utils.h"
+#ifdef __linux__
+#include <dirent.h>
+#include <unistd.h>
+#include "fd_source.h"
+#ifdef NUMBER_OF_WORKERS
+#include "scheduler.h"
+#endif
+
+// A reactor with a physical action whose source is a pipe, which it registers
+// at startup, as a program would. Its other reaction receives what is written to the pipe and writes the next message, until it
+// has received all messages. Then it unregisters the pipe and writes once more,
+// which must not trigger the action. A second pipe stays registered until
+// shutdown, which must stop watching it.
+static const char* messages[] = {"first", "second"};
+#define MESSAGES 2
+#define UNWATCHED "third"
+
+typedef struct receiver_self_t {
+    self_base_t base;
+    reaction_t startup_reaction;
+    reaction_t reaction;
+    reaction_t* reactions[1];
+    trigger_t trigger;
+    struct { trigger_t* trigger; } action;
+    trigger_t idle_trigger;
+    struct { trigger_t* trigger; } idle_action;
+    int count;
+} receiver_self_t;
+
+static receiver_self_t* receiver;
+static int fds[2];                         // The pipe that triggers the action.
+static int idle_fds[2];                    // The pipe that stays registered until shutdown.
+static int open_fds;                       // The number of open file descriptors before the runtime ran.
+static bool failed = false;
+
+/** @brief Return the number of file descriptors that the process has open. */
+static int count_open_fds() {
+    DIR* dir = opendir("/proc/self/fd");
+    if (dir == NULL) {
+        return -1;
+    }
+    int count = 0;
+    while (readdir(dir) != NULL) {
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+static void write_message(const char* message) {
+    if (write(fds[1], message, strlen(message)) != (ssize_t)strlen(message)) {
+        lf_print_error_and_exit("Failed to write to the pipe.");
+    }
+}
+
+static void startup_function(void* self) {
+    receiver_self_t* r = (receiver_self_t*)self;
+    if (lf_register_fd(fds[0], &r->action, NULL, NULL) != 0
+            || lf_register_fd(idle_fds[0], &r->idle_action, NULL, NULL) != 0) {
+        lf_print_error_and_exit("Failed to register the pipes.");
+    }
+    // This reports an error.
+    if (lf_register_fd(fds[0], &r->action, NULL, NULL) != -1) {
+        lf_print_error_and_exit("Registered a file descriptor twice.");
+    }
+}
+
+static void receiver_function(void* self) {
+    receiver_self_t* r = (receiver_self_t*)self;
+    lf_token_t* token = r->trigger.token;
+    if (r->count >= MESSAGES) {
+        lf_print_error("The action was triggered after its file descriptor was unregistered.");
+        failed = true;
+        return;
+    }
+    const char* expected = messages[r->count];
+    if (token == NULL || token->length != strlen(expected) || memcmp(token->value, expected, token->length) != 0) {
+        lf_print_error("The action did not carry \"%s\".", expected);
+        failed = true;
+    }
+    r->count++;
+    if (r->count < MESSAGES) {
+        write_message(messages[r->count]);
+    } else {
+        if (lf_unregister_fd(fds[0]) != 0 || lf_unregister_fd(fds[0]) != -1) {
+            lf_print_error("Unregistering the file descriptor, once, did not succeed.");
+            failed = true;
+        }
+        write_message(UNWATCHED);
+    }
+}
+
+void _lf_initialize_trigger_objects() {
+    receiver = (receiver_self_t*)_lf_new_reactor(sizeof(receiver_self_t));
+    receiver->startup_reaction = (reaction_t) {
+        .function = startup_function, .self = receiver, .name = "startup", .index = 0, .chain_id = 1, .deadline = -1
+    };
+    receiver->reaction = (reaction_t) {
+        .function = receiver_function, .self = receiver, .name = "receiver", .index = 1, .chain_id = 1, .deadline = -1
+    };
+    receiver->reactions[0] = &receiver->reaction;
+    receiver->trigger = (trigger_t) {
+        .reactions = receiver->reactions, .number_of_reactions = 1, .is_physical = true, .period = -1,
+        .policy = defer, .token = _lf_create_token(1), .element_size = 1
+    };
+    receiver->action.trigger = &receiver->trigger;
+    receiver->idle_trigger = (trigger_t) {.is_physical = true, .period = -1, .policy = defer};
+    receiver->idle_action.trigger = &receiver->idle_trigger;
+    // As generated code does, list the tokens to release at each time step.
+    _lf_tokens_with_ref_count = (token_present_t*)malloc(sizeof(token_present_t));
+    _lf_tokens_with_ref_count[0] = (token_present_t) {&receiver->trigger.token, &receiver->trigger.status, true};
+    _lf_tokens_with_ref_count_size = 1;
+#ifdef NUMBER_OF_WORKERS
+    static size_t reactions_per_level[2] = {1, 1};
+    static sched_params_t params = {reactions_per_level, 2};
+    lf_sched_init(_lf_instance->number_of_workers, &params);
+#endif
+}
+void _lf_trigger_startup_reactions() {
+    _lf_trigger_reaction(&receiver->startup_reaction, -1);
+}
+
+/**
+ * @brief Check, at termination, that the runtime has stopped watching the
+ * pipes and has closed its own file descriptors.
+ */
+void terminate_execution() {
+    if (_lf_instance->fd_sources != NULL) {
+        lf_print_error("The runtime still watches file descriptors at termination.");
+        failed = true;
+    }
+    if (count_open_fds() != open_fds) {
+        lf_print_error("%d file descriptors were open before the program ran and %d after.",
+                open_fds, count_open_fds());
+        failed = true;
+    }
+    if (receiver->count != MESSAGES) {
+        lf_print_error("Received %d messages instead of %d.", receiver->count, MESSAGES);
+        failed = true;
+    }
+    // This runs in a handler of exit(), which must not call exit() again.
+    if (failed) {
+        _exit(1);
+    }
+}
+
+/**
+ * @brief Run a program whose physical action is triggered by writing to a
+ * pipe, in the threaded or the unthreaded runtime, and check what it receives
+ * and that it stops watching file descriptors when asked to and at shutdown.
+ */
+int main(int argc, const char* argv[]) {
+    if (pipe(fds) != 0 || pipe(idle_fds) != 0) {
+        lf_print_error_and_exit("Failed to create the pipes.");
+    }
+    open_fds = count_open_fds();
+    write_message(messages[0]);
+    // The timeout leaves the runtime time to see what is written after the
+    // pipe is unregistered.
+    if (!run_program("-k", "true", "-o", "200", "msec", NULL)) {
+        lf_print_error_and_exit("The program failed.");
+    }
+    return 0;
+}
+#else
+// File descriptor sources are only supported on Linux.
+int main(int argc, const char* argv[]) {
+    return TEST_SKIPPED;
+}
+#endif
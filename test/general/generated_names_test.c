@@ -0,0 +1,60 @@
+// Compile as generated code is compiled, so that the names in reactor_common.h
+// that generated code uses for the state of the program are defined.
+#undef LF_RUNTIME_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "reactor.h"
+#include "reactor_common.h"
+#include "util.h"
+
+static bool* instance_fast();
+static interval_t* instance_duration();
+static instant_t* instance_start_time();
+static tag_t* enclave_current_tag();
+static tag_t* enclave_stop_tag();
+
+/**
+ * @brief Check that the names that generated code uses for the globals that
+ * moved into enclaves and instances read and write the fields of the enclave
+ * and the instance that the calling thread is bound to.
+ */
+int main(int argc, const char* argv[]) {
+    const char* args[] = {"generated_names_test", "-f", "true", "-k", "true", "-o", "5", "msec"};
+    if (!process_args(8, args)) {
+        lf_print_error_and_exit("Failed to process the arguments.");
+    }
+    if (!fast || !keepalive_specified || duration != MSEC(5)) {
+        lf_print_error_and_exit("The arguments did not set fast, keepalive_specified, and duration.");
+    }
+    if (&fast != instance_fast() || &duration != instance_duration() || &start_time != instance_start_time()) {
+        lf_print_error_and_exit("The names are not those of the fields of the instance.");
+    }
+    if (&current_tag != enclave_current_tag() || &stop_tag != enclave_stop_tag()) {
+        lf_print_error_and_exit("The names are not those of the fields of the enclave.");
+    }
+
+    start_time = SEC(1);
+    if (lf_time_start() != SEC(1)) {
+        lf_print_error_and_exit("start_time is not the start time of the instance.");
+    }
+    current_tag = (tag_t) {.time = SEC(2), .microstep = 3};
+    if (lf_tag_compare(lf_tag(), (tag_t) {.time = SEC(2), .microstep = 3}) != 0) {
+        lf_print_error_and_exit("current_tag is not the tag of the enclave.");
+    }
+    return 0;
+}
+
+// The fields themselves, which the names would replace.
+#undef fast
+#undef duration
+#undef start_time
+#undef current_tag
+#undef stop_tag
+
+static bool* instance_fast() { return &_lf_instance->fast; }
+static interval_t* instance_duration() { return &_lf_instance->duration; }
+static instant_t* instance_start_time() { return &_lf_instance->start_time; }
+static tag_t* enclave_current_tag() { return &_lf_enclave->current_tag; }
+static tag_t* enclave_stop_tag() { return &_lf_enclave->stop_tag; }
@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "reactor.h"
+#include "reactor_common.h"
+#include "util.h"
+#include "program_utils.h"
+#ifdef LF_ENCLAVES_SUPPORTED
+#include "enclave.h"
+#include "scheduler.h"
+#ifdef __linux__
+#include <dirent.h>
+#include <unistd.h>
+#include "fd_source.h"
+#endif
+
+// Each instance runs a counter that sends its count to itself through an
+// action with an offset of its own period, until its timeout. The period and
+// the timeout differ between instances, so that an instance that saw the tag,
+// the events, or the tokens of another one would count wrongly.
+#define INSTANCES 2
+#define TICKS_PER_INSTANCE 20
+
+typedef struct counter_self_t {
+    self_base_t base;
+    reaction_t reaction;
+    reaction_t* reactions[1];
+    trigger_t trigger;
+    struct { trigger_t* trigger; } action;
+    trigger_t fd_trigger;
+    struct { trigger_t* trigger; } fd_action;
+    int count;
+} counter_self_t;
+
+typedef struct instance_record_t {
+    lf_instance_t* instance;
+    interval_t period;
+    int fds[2];                            // A pipe whose read end the instance registers, or -1.
+    int count;                             // The count of the counter at termination.
+    bool failed;
+} instance_record_t;
+
+static instance_record_t records[INSTANCES];
+
+/** @brief Return the record of the instance that the calling thread is bound to. */
+static instance_record_t* current_record() {
+    for (int i = 0; i < INSTANCES; i++) {
+        if (records[i].instance == _lf_instance) {
+            return &records[i];
+        }
+    }
+    lf_print_error_and_exit("A thread is bound to an unknown instance.");
+    return NULL;
+}
+
+static LF_THREAD_LOCAL counter_self_t* current_counter;
+
+static void counter_function(void* self) {
+    counter_self_t* c = (counter_self_t*)self;
+    instance_record_t* record = current_record();
+    if (c->base.enclave != NULL || &c->base != c->reaction.self) {
+        record->failed = true;
+    }
+    // The count that the action carries is the previous one of this counter.
+    if (c->count > 0 && (c->trigger.token == NULL || *(int*)c->trigger.token->value != c->count)) {
+        lf_print_error("Instance %d received a count that it did not send.", (int)(record - records));
+        record->failed = true;
+    }
+    if (lf_time_logical_elapsed() != c->count * record->period) {
+        lf_print_error("Instance %d is at " PRINTF_TIME " instead of " PRINTF_TIME ".",
+                (int)(record - records), lf_time_logical_elapsed(), (instant_t)(c->count * record->period));
+        record->failed = true;
+    }
+    // The event that triggered this reaction has been popped, and the event
+    // queue of the instance has no other.
+    if (pqueue_size(_lf_enclave->event_q) != 0) {
+        lf_print_error("Instance %d has events that it did not schedule.", (int)(record - records));
+        record->failed = true;
+    }
+    c->count++;
+    _lf_schedule_copy(&c->action, 0, &c->count, 1);
+}
+
+void _lf_initialize_trigger_objects() {
+    instance_record_t* record = current_record();
+    counter_self_t* c = (counter_self_t*)_lf_new_reactor(sizeof(counter_self_t));
+    c->reaction = (reaction_t) {
+        .function = counter_function, .self = c, .name = "counter", .index = 0, .chain_id = 1, .deadline = -1
+    };
+    c->reactions[0] = &c->reaction;
+    lf_token_t* template = _lf_create_token(sizeof(int));
+    c->trigger = (trigger_t) {
+        .reactions = c->reactions, .number_of_reactions = 1, .offset = record->period, .period = -1,
+        .policy = defer, .token = template, .element_size = sizeof(int)
+    };
+    c->action.trigger = &c->trigger;
+    c->fd_trigger = (trigger_t) {.is_physical = true, .period = -1, .policy = defer};
+    c->fd_action.trigger = &c->fd_trigger;
+    current_counter = c;
+    // As generated code does, list the tokens to release at each time step.
+    _lf_tokens_with_ref_count = (token_present_t*)malloc(sizeof(token_present_t));
+    _lf_tokens_with_ref_count[0] = (token_present_t) {&c->trigger.token, &c->trigger.status, true};
+    _lf_tokens_with_ref_count_size = 1;
+    static size_t reactions_per_level[1] = {1};
+    static sched_params_t params = {reactions_per_level, 1};
+    lf_sched_init(1, &params);
+#ifdef __linux__
+    if (record->fds[0] >= 0 && lf_register_fd(record->fds[0], &c->fd_action, NULL, NULL) != 0) {
+        record->failed = true;
+    }
+#endif
+}
+void _lf_trigger_startup_reactions() {
+    _lf_trigger_reaction(&current_counter->reaction, -1);
+}
+void terminate_execution() {
+    current_record()->count = current_counter->count;
+}
+
+#ifdef __linux__
+/** @brief Return the number of file descriptors that the process has open. */
+static int count_open_fds() {
+    DIR* dir = opendir("/proc/self/fd");
+    if (dir == NULL) {
+        return -1;
+    }
+    int count = 0;
+    while (readdir(dir) != NULL) {
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+#endif
+
+/** @brief Create the instance of a record, with a pipe if watch is true. */
+static void create_instance(instance_record_t* record, interval_t period, bool watch) {
+    record->instance = lf_instance_create();
+    record->period = period;
+    record->fds[0] = record->fds[1] = -1;
+    record->count = 0;
+    record->failed = false;
+#ifdef __linux__
+    if (watch && pipe(record->fds) != 0) {
+        lf_print_error_and_exit("Failed to create a pipe.");
+    }
+#endif
+}
+
+/** @brief Run the instance of a record with a timeout of TICKS_PER_INSTANCE periods. */
+static void* run_instance(void* arg) {
+    instance_record_t* record = (instance_record_t*)arg;
+    char timeout[32];
+    snprintf(timeout, sizeof(timeout), "%lld", (long long)(TICKS_PER_INSTANCE * record->period));
+    const char* args[] = {"instance_test", "-f", "true", "-w", "1", "-o", timeout, "nsec"};
+    if (lf_instance_run(record->instance, 8, args) != 0) {
+        record->failed = true;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Check an instance that has run, and free it and its pipe.
+ */
+static void check_and_free(instance_record_t* record) {
+    int i = (int)(record - records);
+    lf_instance_t* instance = record->instance;
+    if (record->failed) {
+        lf_print_error_and_exit("Instance %d failed.", i);
+    }
+    // The timeout tag is included.
+    if (record->count != TICKS_PER_INSTANCE + 1) {
+        lf_print_error_and_exit("Instance %d counted to %d instead of %d.", i, record->count, TICKS_PER_INSTANCE + 1);
+    }
+    if (instance->main_enclave.current_tag.time - instance->start_time != TICKS_PER_INSTANCE * record->period) {
+        lf_print_error_and_exit("Instance %d stopped at the wrong time.", i);
+    }
+    if (instance->count_token_allocations != 0 || instance->count_payload_allocations != 0) {
+        lf_print_error_and_exit("Instance %d did not free %d tokens and %d payloads.",
+                i, instance->count_token_allocations, instance->count_payload_allocations);
+    }
+    if (instance->fd_sources != NULL) {
+        lf_print_error_and_exit("Instance %d still watches file descriptors.", i);
+    }
+    lf_instance_free(instance);
+    record->instance = NULL;
+#ifdef __linux__
+    for (int f = 0; f < 2; f++) {
+        if (record->fds[f] >= 0) {
+            close(record->fds[f]);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Run instances one after the other and then at the same time, and
+ * check that each has its own tag, events, and tokens. Check that freeing
+ * instances, including one that watches a file descriptor but never ran,
+ * closes the file descriptors of the runtime.
+ */
+int main(int argc, const char* argv[]) {
+    if (!lf_sched_supports_enclaves) {
+        lf_print("Skipped: the scheduler does not support instances.");
+        return TEST_SKIPPED;
+    }
+#ifdef __linux__
+    int open_fds = count_open_fds();
+#endif
+
+    // One after the other, with different periods.
+    for (int i = 0; i < INSTANCES; i++) {
+        create_instance(&records[i], (i + 1) * MSEC(1), false);
+        run_instance(&records[i]);
+        check_and_free(&records[i]);
+    }
+
+    // At the same time, each watching a pipe.
+    lf_thread_t threads[INSTANCES];
+    for (int i = 0; i < INSTANCES; i++) {
+        create_instance(&records[i], (i + 1) * MSEC(1), true);
+    }
+    for (int i = 0; i < INSTANCES; i++) {
+        if (lf_thread_create(&threads[i], run_instance, &records[i]) != 0) {
+            lf_print_error_and_exit("Failed to create a thread.");
+        }
+    }
+    for (int i = 0; i < INSTANCES; i++) {
+        lf_thread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < INSTANCES; i++) {
+        check_and_free(&records[i]);
+    }
+
+#ifdef __linux__
+    // An instance that watches a file descriptor, but is freed without
+    // running, stops its thread and closes its file descriptors.
+    create_instance(&records[0], MSEC(1), true);
+    lf_instance_bind(records[0].instance);
+    static trigger_t fd_trigger = {.is_physical = true, .period = -1, .policy = defer};
+    static struct { trigger_t* trigger; } fd_action = {&fd_trigger};
+    if (lf_register_fd(records[0].fds[0], &fd_action, NULL, NULL) != 0) {
+        lf_print_error_and_exit("Failed to register a file descriptor.");
+    }
+    lf_instance_bind(&_lf_default_instance);
+    lf_instance_free(records[0].instance);
+    close(records[0].fds[0]);
+    close(records[0].fds[1]);
+    if (count_open_fds() != open_fds) {
+        lf_print_error_and_exit("%d file descriptors were open before the instances and %d after.",
+                open_fds, count_open_fds());
+    }
+#endif
+    return 0;
+}
+#else
+// Instances exist only in the threaded runtime, and not in federated
+// execution, with modal reactors, or with tracing.
+int main(int argc, const char* argv[]) {
+    return TEST_SKIPPED;
+}
+#endif
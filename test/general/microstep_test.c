@@ -0,0 +1,87 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "reactor_common.h"
+#include "util.h"
+
+#define NUM_MICROSTEPS 10000
+#define FAR_MICROSTEP 1000000u
+
+static trigger_t action = {
+    .reactions = NULL,
+    .number_of_reactions = 0,
+    .is_timer = false,
+    .offset = 0LL,
+    .period = -1LL,
+    .policy = defer,
+};
+
+/**
+ * @brief Advance to the tag of the event at the head of the event queue,
+ * pop the events at that tag, and check that exactly one event has been popped.
+ *
+ * @param expected The tag at which the next event is expected.
+ */
+static void test_advance(tag_t expected) {
+    event_t* head = (event_t*)pqueue_peek(_lf_enclave->event_q);
+    if (head == NULL || lf_tag_compare(head->tag, expected) != 0) {
+        lf_print_error_and_exit("Expected an event at (" PRINTF_TIME ", %u).",
+                expected.time - lf_time_start(), expected.microstep);
+    }
+    size_t size = pqueue_size(_lf_enclave->event_q);
+    _lf_advance_logical_time(expected);
+    _lf_pop_events();
+    if (pqueue_size(_lf_enclave->event_q) != size - 1) {
+        lf_print_error_and_exit("Popped %zu events at microstep %u.",
+                size - pqueue_size(_lf_enclave->event_q), expected.microstep);
+    }
+}
+
+/**
+ * @brief Schedule many events at the current time and check that they come
+ * out of the event queue in consecutive microsteps, and that an event far
+ * ahead in superdense time comes out after them. Then check that an event
+ * that left the event queue unprocessed does not leave its microstep empty.
+ */
+int main(int argc, char **argv) {
+#ifdef LF_STATIC_MEMORY
+    // As --max-events would.
+    _lf_instance->max_events = NUM_MICROSTEPS + 1;
+#endif
+    initialize();
+    tag_t start = lf_tag();
+
+    for (int i = 0; i < NUM_MICROSTEPS; i++) {
+        _lf_schedule(&action, 0LL, NULL);
+    }
+    // An event far ahead in superdense time needs no dummy events.
+    _lf_schedule_at_tag(&action, (tag_t) {.time = start.time, .microstep = FAR_MICROSTEP}, NULL);
+    if (pqueue_size(_lf_enclave->event_q) != NUM_MICROSTEPS + 1) {
+        lf_print_error_and_exit("Expected %d events on the event queue, found %zu.",
+                NUM_MICROSTEPS + 1, pqueue_size(_lf_enclave->event_q));
+    }
+    for (int i = 1; i <= NUM_MICROSTEPS; i++) {
+        test_advance((tag_t) {.time = start.time, .microstep = start.microstep + i});
+    }
+    test_advance((tag_t) {.time = start.time, .microstep = FAR_MICROSTEP});
+
+    if (pqueue_size(_lf_enclave->event_q) != 0) {
+        lf_print_error_and_exit("Event queue not empty.");
+    }
+
+    // An event that leaves the event queue without being processed, as when
+    // its mode is left, frees its microstep for the next event.
+    start = lf_tag();
+    _lf_schedule(&action, 0LL, NULL);
+    _lf_schedule(&action, 0LL, NULL);
+    event_t* last = (event_t*)pqueue_find_equal_same_priority(_lf_enclave->event_q, &(event_t) {
+            .tag = {.time = start.time, .microstep = start.microstep + 2}, .trigger = &action});
+    if (last == NULL) {
+        lf_print_error_and_exit("Expected an event at microstep %u.", start.microstep + 2);
+    }
+    pqueue_remove(_lf_enclave->event_q, last);
+    _lf_recycle_event(last);
+    _lf_schedule(&action, 0LL, NULL);
+    test_advance((tag_t) {.time = start.time, .microstep = start.microstep + 1});
+    test_advance((tag_t) {.time = start.time, .microstep = start.microstep + 2});
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <stdlib.h>
+#include "mixed_radix.h"
+#include "util.h"
+
+#define MAX_DIGITS 5
+#define MAX_RADIX 5
+#define NUMBERS 200
+#define RANDOM_SEED 1830
+
+/**
+ * @brief Check that an iterator visits the same values as mixed_radix_incr(), with the same
+ * parents, for a random mixed-radix number with a random permutation, starting from random
+ * digits, one increment at a time and in bulk.
+ */
+static void test_random_number() {
+    int size = rand() % MAX_DIGITS + 1;
+    int radixes[MAX_DIGITS], permutation[MAX_DIGITS];
+    int digits[MAX_DIGITS], iterator_digits[MAX_DIGITS];
+    int total = 1;
+    for (int i = 0; i < size; i++) {
+        radixes[i] = rand() % MAX_RADIX + 1;
+        digits[i] = iterator_digits[i] = rand() % radixes[i];
+        permutation[i] = i;
+        total *= radixes[i];
+    }
+    for (int i = size - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        int swap = permutation[i];
+        permutation[i] = permutation[j];
+        permutation[j] = swap;
+    }
+    mixed_radix_int_t mixed = {size, digits, radixes, permutation};
+    mixed_radix_int_t iterated = {size, iterator_digits, radixes, permutation};
+    int strides[MAX_DIGITS];
+    mixed_radix_iterator_t it;
+    mixed_radix_iterator_init(&it, &iterated, strides);
+    int expected[2 * MAX_RADIX * MAX_RADIX * MAX_RADIX * MAX_RADIX * MAX_RADIX];
+    // Go around twice to cover the wrap to zero.
+    for (int i = 0; i < 2 * total; i++) {
+        expected[i] = mixed_radix_to_int(&mixed);
+        for (int n = 0; n <= size; n++) {
+            if (mixed_radix_iterator_parent(&it, n) != mixed_radix_parent(&mixed, n)) {
+                lf_print_error_and_exit("Wrong parent %d after %d increments.", n, i);
+            }
+        }
+        if (mixed_radix_iterator_to_int(&it) != expected[i]) {
+            lf_print_error_and_exit("Expected %d but got %d after %d increments.",
+                    expected[i], mixed_radix_iterator_to_int(&it), i);
+        }
+        mixed_radix_incr(&mixed);
+        mixed_radix_iterator_incr(&it);
+    }
+    int values[2 * MAX_RADIX * MAX_RADIX * MAX_RADIX * MAX_RADIX * MAX_RADIX];
+    int filled = 0;
+    while (filled < 2 * total) {
+        int count = rand() % (total + 1);
+        if (count > 2 * total - filled) count = 2 * total - filled;
+        mixed_radix_iterator_fill(&it, values + filled, count);
+        filled += count;
+    }
+    for (int i = 0; i < 2 * total; i++) {
+        if (values[i] != expected[i]) {
+            lf_print_error_and_exit("Expected %d but filled in %d at %d.", expected[i], values[i], i);
+        }
+    }
+}
+
+int main() {
+    srand(RANDOM_SEED);
+    for (int i = 0; i < NUMBERS; i++) {
+        test_random_number();
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include <stdio.h>
+
+#include "reactor.h"
+#include "reactor_common.h"
+#include "util.h"
+#include "program_utils.h"
+#ifdef NUMBER_OF_WORKERS
+#include "scheduler.h"
+#endif
+
+// A source reaction has two outputs. The first reaches a sink at level 2 and,
+// through two triggers, the same sink at level 1. The second, which the
+// source produces at every other tag, reaches another sink at level 1. As in
+// generated code, the reactions are not listed in the reaction table.
+#define ITERATIONS 10
+#define SINKS 3
+
+static int iteration = 0;
+static int invocations[SINKS];
+static bool failed = false;
+
+static void source_function(void* self);
+static self_base_t self;
+static self_base_t sink_selves[SINKS];
+
+static void sink_function(void* self) {
+    invocations[(self_base_t*)self - sink_selves]++;
+}
+
+static reaction_t source_reaction = {
+    .function = source_function, .self = &self, .name = "source", .index = 0, .chain_id = 1, .deadline = -1
+};
+static reaction_t* source_reactions[] = {&source_reaction};
+static trigger_t source_trigger = {
+    .reactions = source_reactions, .number_of_reactions = 1, .offset = 0, .period = -1, .policy = defer
+};
+static struct { trigger_t* trigger; } source_action = {&source_trigger};
+
+static reaction_t sinks[SINKS] = {
+    {.function = sink_function, .self = &sink_selves[0], .name = "sink0", .index = 2, .chain_id = 1, .deadline = -1},
+    {.function = sink_function, .self = &sink_selves[1], .name = "sink1", .index = 1, .chain_id = 1, .deadline = -1},
+    {.function = sink_function, .self = &sink_selves[2], .name = "sink2", .index = 1, .chain_id = 1, .deadline = -1}
+};
+static reaction_t* first_reactions[] = {&sinks[0], &sinks[1]};
+static reaction_t* again_reactions[] = {&sinks[1]};
+static reaction_t* second_reactions[] = {&sinks[2]};
+static trigger_t first_trigger = {.reactions = first_reactions, .number_of_reactions = 2};
+static trigger_t again_trigger = {.reactions = again_reactions, .number_of_reactions = 1};
+static trigger_t second_trigger = {.reactions = second_reactions, .number_of_reactions = 1};
+static trigger_t* first_triggers[] = {&first_trigger, &again_trigger};
+static trigger_t* second_triggers[] = {&second_trigger};
+static trigger_t** triggers[] = {first_triggers, second_triggers};
+static int triggered_sizes[] = {2, 1};
+static bool is_present[2];
+static bool* output_produced[] = {&is_present[0], &is_present[1]};
+
+/**
+ * @brief Check that the outputs of the source have been flattened, once per
+ * reaction and in order of level, unless the heap may not be used after
+ * startup.
+ */
+static void check_flattened() {
+    size_t* offsets = source_reaction.downstream_offsets;
+    reaction_t** downstream = source_reaction.downstream_reactions;
+#ifdef LF_STATIC_MEMORY
+    if (offsets != NULL) {
+        lf_print_error("The outputs of the source were flattened after startup in static-memory mode.");
+        failed = true;
+    }
+#else
+    if (offsets == NULL) {
+        lf_print_error("The outputs of the source were not flattened when it first executed.");
+        failed = true;
+    } else if (offsets[0] != 0 || offsets[1] != 2 || offsets[2] != 3
+            || downstream[0] != &sinks[1] || downstream[1] != &sinks[0] || downstream[2] != &sinks[2]) {
+        lf_print_error("The outputs of the source are not flattened by level without duplicates.");
+        failed = true;
+    }
+#endif
+}
+
+static void source_function(void* self) {
+    if (iteration > 0) {
+        check_flattened();
+    }
+    is_present[0] = true;
+    is_present[1] = (iteration % 2 == 1);
+    if (++iteration < ITERATIONS) {
+        _lf_schedule_token(&source_action, 0, NULL);
+    }
+}
+
+void _lf_initialize_trigger_objects() {
+    source_reaction.num_outputs = 2;
+    source_reaction.output_produced = output_produced;
+    source_reaction.triggered_sizes = triggered_sizes;
+    source_reaction.triggers = triggers;
+#ifdef NUMBER_OF_WORKERS
+    static size_t num_reactions_per_level[3] = {1, 2, 1};
+    static sched_params_t sched_params = {num_reactions_per_level, 3};
+    lf_sched_init(_lf_instance->number_of_workers, &sched_params);
+#endif
+}
+void _lf_trigger_startup_reactions() {
+    if (source_reaction.downstream_offsets != NULL) {
+        lf_print_error("The outputs of a reaction that is not in the reaction table were flattened at startup.");
+        failed = true;
+    }
+    _lf_trigger_reaction(&source_reaction, -1);
+}
+
+/**
+ * @brief Run a program whose reactions are not in the reaction table, and
+ * check that the outputs of a reaction are flattened when it first executes
+ * and that they trigger each downstream reaction once per tag.
+ */
+int main(int argc, const char* argv[]) {
+    if (!run_program("-f", "true", NULL) || failed) {
+        lf_print_error_and_exit("The program failed.");
+    }
+    int expected[SINKS] = {ITERATIONS, ITERATIONS, ITERATIONS / 2};
+    for (int r = 0; r < SINKS; r++) {
+        if (invocations[r] != expected[r]) {
+            lf_print_error_and_exit("Sink %d executed %d times instead of %d.", r, invocations[r], expected[r]);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "reactor.h"
+#include "reactor_common.h"
+#include "util.h"
+#include "program_utils.h"
+#ifdef NUMBER_OF_WORKERS
+#include "scheduler.h"
+#endif
+#ifndef LF_THREAD_LOCAL
+// Without threads, every loop is executed by the main thread.
+#define LF_THREAD_LOCAL
+#define lf_atomic_fetch_add(ptr, value) (*(ptr) += (value))
+#endif
+
+// A reaction sums the iterations of a loop with different grains, then
+// executes a loop whose iterations each start a nested loop. A nested loop
+// must be executed by the thread that starts it, whether the outer loop is
+// still shared, as while the calling worker executes it, or not, as while a
+// helper finishes its last range after the calling worker has withdrawn it.
+// Last, it executes a loop of two iterations, the first of which the calling
+// worker executes until an idle worker has executed the other, if the
+// scheduler lends out idle workers.
+#define START 3
+#define END 10003
+#define OUTER 64
+#define INNER 16
+#define SPIN USEC(100)
+#define HELP_TIMEOUT SEC(1)
+
+static const size_t grains[] = {0, 1, 7, END - START + 10};
+#define GRAINS (sizeof(grains) / sizeof(grains[0]))
+
+#ifdef NUMBER_OF_WORKERS
+static const bool ranges_within_grain = true;
+#else
+// The unthreaded runtime executes a loop in one range, whatever its grain.
+static const bool ranges_within_grain = false;
+#endif
+static bool lends_idle_workers = false;     // Whether idle workers help with loops.
+
+static size_t grain;                       // The grain of the current loop.
+static volatile size_t sum;
+static volatile int counts[END];           // The number of times each iteration has executed.
+static volatile int inner_counts[OUTER][INNER];
+static LF_THREAD_LOCAL int current_outer = -1; // The outer iteration that the thread executes.
+static LF_THREAD_LOCAL bool is_caller = false;  // Whether the thread executes the reaction.
+static volatile bool helped = false;       // Whether another thread has executed a range.
+static bool executed = false;
+static volatile bool failed = false;
+
+static void sum_body(size_t begin, size_t end, void* arg) {
+    if (begin < START || end > END || begin >= end || (ranges_within_grain && grain != 0 && end - begin > grain)) {
+        lf_print_error("The range [%zu, %zu) is not within [%d, %d) or exceeds the grain %zu.",
+                begin, end, START, END, grain);
+        failed = true;
+        return;
+    }
+    size_t partial = 0;
+    for (size_t i = begin; i < end; i++) {
+        lf_atomic_fetch_add(&counts[i], 1);
+        partial += i;
+    }
+    lf_atomic_fetch_add(&sum, partial);
+}
+
+static void inner_body(size_t begin, size_t end, void* arg) {
+    int outer = (int)(size_t)arg;
+    if (current_outer != outer) {
+        lf_print_error("The nested loop of iteration %d was executed by another thread.", outer);
+        failed = true;
+    }
+    for (size_t i = begin; i < end; i++) {
+        lf_atomic_fetch_add(&inner_counts[outer][i], 1);
+    }
+}
+
+static void outer_body(size_t begin, size_t end, void* arg) {
+    for (size_t i = begin; i < end; i++) {
+        // Take long enough that helpers still execute iterations after the
+        // calling worker has claimed the last one.
+        instant_t start = lf_time_physical();
+        while (lf_time_physical() - start < SPIN);
+        current_outer = (int)i;
+        lf_parallel_for(0, INNER, 1, inner_body, (void*)i);
+        current_outer = -1;
+    }
+}
+
+static void help_body(size_t begin, size_t end, void* arg) {
+    if (!is_caller) {
+        helped = true;
+        return;
+    }
+    instant_t start = lf_time_physical();
+    while (lends_idle_workers && !helped && lf_time_physical() - start < HELP_TIMEOUT);
+}
+
+static void loops_function(void* self) {
+    is_caller = true;
+    for (size_t g = 0; g < GRAINS; g++) {
+        grain = grains[g];
+        sum = 0;
+        memset((void*)counts, 0, sizeof(counts));
+        lf_parallel_for(START, END, grain, sum_body, NULL);
+        for (int i = 0; i < END; i++) {
+            if (counts[i] != (i >= START)) {
+                lf_print_error("With grain %zu, iteration %d executed %d times.", grain, i, counts[i]);
+                failed = true;
+                break;
+            }
+        }
+        size_t expected = (size_t)(END - 1) * END / 2 - (size_t)(START - 1) * START / 2;
+        if (sum != expected) {
+            lf_print_error("With grain %zu, the sum is %zu instead of %zu.", grain, sum, expected);
+            failed = true;
+        }
+    }
+    lf_parallel_for(0, OUTER, 1, outer_body, NULL);
+    for (int i = 0; i < OUTER; i++) {
+        for (int j = 0; j < INNER; j++) {
+            if (inner_counts[i][j] != 1) {
+                lf_print_error("Iteration %d of the nested loop of iteration %d executed %d times.",
+                        j, i, inner_counts[i][j]);
+                failed = true;
+            }
+        }
+    }
+    // An empty loop does nothing.
+    lf_parallel_for(END, START, 1, sum_body, NULL);
+    lf_parallel_for(0, 2, 1, help_body, NULL);
+    if (helped != lends_idle_workers) {
+        lf_print_error(helped ? "A thread other than the calling worker executed a range."
+                : "No idle worker executed a range.");
+        failed = true;
+    }
+    is_caller = false;
+    executed = true;
+}
+
+static self_base_t loops_self;
+
+static reaction_t loops_reaction = {
+    .function = loops_function, .self = &loops_self, .name = "loops", .index = 0, .chain_id = 1, .deadline = -1
+};
+
+void _lf_initialize_trigger_objects() {
+#ifdef NUMBER_OF_WORKERS
+    static size_t reactions_per_level[1] = {1};
+    static sched_params_t params = {reactions_per_level, 1};
+    lf_sched_init(_lf_instance->number_of_workers, &params);
+    // The schedulers that let go of suspended reactions are those that wake
+    // up their idle workers for lf_parallel_for() (see scheduler.h).
+    lends_idle_workers = lf_sched_supports_suspension;
+#endif
+}
+void _lf_trigger_startup_reactions() {
+    _lf_trigger_reaction(&loops_reaction, -1);
+}
+
+/**
+ * @brief Run a reaction that executes loops with lf_parallel_for(), with the
+ * workers that are idle in the threaded runtime, and check that each
+ * iteration executes exactly once, that nested loops execute inline, and
+ * that idle workers help if the scheduler lends them out.
+ */
+int main(int argc, const char* argv[]) {
+    if (!run_program("-f", "true", "-w", "4", NULL) || failed) {
+        lf_print_error_and_exit("The program failed.");
+    }
+    if (!executed) {
+        lf_print_error_and_exit("The reaction did not execute.");
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <stdio.h>
+
+#include "reactor.h"
+#include "reactor_common.h"
+#include "util.h"
+#include "program_utils.h"
+#ifdef NUMBER_OF_WORKERS
+#include "scheduler.h"
+#endif
+
+// More reactions than INITIAL_REACT_QUEUE_SIZE are ready at once, so that in
+// static-memory mode, where the heap may not be used after startup, the
+// reaction queues have to be sized for the reactions of the program.
+#define SINKS 32
+#define LEVELS 4
+#define ITERATIONS 10
+
+static int iteration = 0;
+static int invocations[SINKS];
+
+static void source_function(void* self);
+static self_base_t self;
+static self_base_t sink_selves[SINKS];
+
+static void sink_function(void* self) {
+    invocations[(self_base_t*)self - sink_selves]++;
+}
+
+static reaction_t source_reaction = {
+    .function = source_function, .self = &self, .name = "source", .index = 0, .chain_id = 1, .deadline = -1
+};
+static reaction_t* source_reactions[] = {&source_reaction};
+static trigger_t source_trigger = {
+    .reactions = source_reactions, .number_of_reactions = 1, .offset = 0, .period = -1, .policy = defer
+};
+static struct { trigger_t* trigger; } source_action = {&source_trigger};
+
+static reaction_t sinks[SINKS];
+static reaction_t* sink_list[SINKS];
+static reaction_t* all_reactions[SINKS + 1];
+static trigger_t output_trigger;
+static trigger_t* output_triggers[1] = {&output_trigger};
+static trigger_t** triggers[1] = {output_triggers};
+static int triggered_sizes[1] = {1};
+static bool is_present;
+static bool* output_produced[1] = {&is_present};
+
+static void source_function(void* self) {
+    is_present = true;
+    if (++iteration < ITERATIONS) {
+        _lf_schedule_token(&source_action, 0, NULL);
+    } else {
+        lf_request_stop();
+    }
+}
+
+void _lf_initialize_trigger_objects() {
+    all_reactions[0] = &source_reaction;
+    for (int r = 0; r < SINKS; r++) {
+        sinks[r] = (reaction_t) {
+            .function = sink_function, .self = &sink_selves[r], .name = "sink",
+            .index = 1 + r % LEVELS, .chain_id = 1, .deadline = -1
+        };
+        sink_list[r] = &sinks[r];
+        all_reactions[r + 1] = &sinks[r];
+    }
+    output_trigger = (trigger_t) {.reactions = sink_list, .number_of_reactions = SINKS};
+    source_reaction.num_outputs = 1;
+    source_reaction.output_produced = output_produced;
+    source_reaction.triggered_sizes = triggered_sizes;
+    source_reaction.triggers = triggers;
+    // As generated code does, list the reactions of the enclave.
+    _lf_reactions = all_reactions;
+    _lf_reactions_size = SINKS + 1;
+#ifdef NUMBER_OF_WORKERS
+    static size_t num_reactions_per_level[LEVELS + 1] = {1};
+    for (int level = 1; level <= LEVELS; level++) {
+        num_reactions_per_level[level] = SINKS / LEVELS;
+    }
+    static sched_params_t sched_params = {num_reactions_per_level, LEVELS + 1};
+    lf_sched_init(_lf_instance->number_of_workers, &sched_params);
+#endif
+}
+void _lf_trigger_startup_reactions() {
+    // The outputs of the listed reactions are flattened at startup, in order of level.
+    size_t* offsets = source_reaction.downstream_offsets;
+    if (offsets == NULL || offsets[1] != SINKS) {
+        lf_print_error_and_exit("The outputs of the source reaction were not flattened at startup.");
+    }
+    for (size_t k = 1; k < offsets[1]; k++) {
+        if (LF_LEVEL(source_reaction.downstream_reactions[k - 1]->index)
+                > LF_LEVEL(source_reaction.downstream_reactions[k]->index)) {
+            lf_print_error_and_exit("The reactions triggered by the source are not in order of level.");
+        }
+    }
+    _lf_trigger_reaction(&source_reaction, -1);
+}
+
+/**
+ * @brief Trigger more reactions at each tag than the initial size of a
+ * reaction queue and check that every one of them executes at every tag.
+ */
+int main(int argc, const char* argv[]) {
+    if (!run_program("-f", "true", NULL)) {
+        lf_print_error_and_exit("The program failed.");
+    }
+    for (int r = 0; r < SINKS; r++) {
+        if (invocations[r] != ITERATIONS) {
+            lf_print_error_and_exit("Sink %d executed %d times instead of %d.", r, invocations[r], ITERATIONS);
+        }
+    }
+    return 0;
+}
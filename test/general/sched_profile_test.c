@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <unistd.h>
+
+#include "reactor.h"
+#include "util.h"
+#include "program_utils.h"
+#ifdef NUMBER_OF_WORKERS
+// The state that the adaptive scheduler keeps in worker_assignments.h.
+static size_t num_levels;
+static size_t max_num_workers;
+#include "data_collection.h"
+
+#define LEVELS 3
+#define WORKERS 4
+
+// The number of reactions at each level, and the fastest number of workers
+// and execution time of each level, the last of which was never measured.
+static size_t reactions_per_level[LEVELS] = {2, 8, 1};
+static size_t saved_workers[LEVELS] = {2, 4, 1};
+static interval_t saved_times[LEVELS] = {5000, 12345, 0};
+
+static size_t num_workers_by_level[LEVELS];
+static size_t max_num_workers_by_level[LEVELS];
+static char file[64];
+static bool failed = false;
+
+/**
+ * @brief Start collecting data for a program with the given number of
+ * reactions at each level, as if no profile had been loaded.
+ */
+static void reset(size_t* reactions) {
+    static sched_params_t params;
+    params = (sched_params_t) {reactions, LEVELS};
+    num_levels = LEVELS;
+    max_num_workers = WORKERS;
+    data_collection_init(&params);
+    data_collection_counter = 0;
+    for (size_t level = 0; level < LEVELS; level++) {
+        max_num_workers_by_level[level] = reactions[level] < WORKERS ? reactions[level] : WORKERS;
+        num_workers_by_level[level] = max_num_workers_by_level[level];
+    }
+}
+
+static void write_file(const char* contents) {
+    FILE* stream = fopen(file, "w");
+    if (stream == NULL || fputs(contents, stream) < 0 || fclose(stream) != 0) {
+        lf_print_error_and_exit("Failed to write %s.", file);
+    }
+}
+
+/** @brief Check that loading the profile file leaves the scheduler to its experiments. */
+static void check_ignored(const char* description) {
+    reset(reactions_per_level);
+    data_collection_load_profile(num_workers_by_level, max_num_workers_by_level);
+    if (data_collection_counter != 0) {
+        lf_print_error("Skipped the experiments with %s.", description);
+        failed = true;
+    }
+    for (size_t level = 0; level < LEVELS; level++) {
+        if (num_workers_by_level[level] != max_num_workers_by_level[level] || execution_times_mins[level] != 0) {
+            lf_print_error("Used level %zu of %s.", level, description);
+            failed = true;
+        }
+    }
+    data_collection_free();
+}
+
+/**
+ * @brief Check that a profile that is saved is loaded as it was saved, and
+ * that a profile that is missing, malformed, truncated, or saved by another
+ * program is ignored.
+ */
+int main(int argc, const char* argv[]) {
+    snprintf(file, sizeof(file), "/tmp/sched_profile_test_%d", (int)getpid());
+    _lf_instance->sched_profile = file;
+
+    // Save a profile, then load it in a new run.
+    reset(reactions_per_level);
+    for (size_t level = 0; level < LEVELS; level++) {
+        execution_times_argmins[level] = saved_workers[level];
+        execution_times_mins[level] = saved_times[level];
+    }
+    data_collection_save_profile();
+    data_collection_free();
+    reset(reactions_per_level);
+    data_collection_load_profile(num_workers_by_level, max_num_workers_by_level);
+    if (data_collection_counter != SLOW_EXPERIMENTS) {
+        lf_print_error("The experiments were not skipped after loading the profile.");
+        failed = true;
+    }
+    for (size_t level = 0; level < LEVELS; level++) {
+        // A level that was never measured is left as it is.
+        size_t workers = saved_times[level] ? saved_workers[level] : max_num_workers_by_level[level];
+        if (num_workers_by_level[level] != workers || execution_times_mins[level] != saved_times[level]
+                || (saved_times[level] && execution_times_argmins[level] != saved_workers[level])) {
+            lf_print_error("Level %zu was loaded with %zu workers and %lld nsec instead of %zu workers and %lld nsec.",
+                    level, num_workers_by_level[level], (long long)execution_times_mins[level],
+                    workers, (long long)saved_times[level]);
+            failed = true;
+        }
+    }
+    data_collection_free();
+
+    // The same profile, saved by a program whose levels have other reactions.
+    size_t other_reactions_per_level[LEVELS] = {2, 8, 2};
+    reset(other_reactions_per_level);
+    data_collection_load_profile(num_workers_by_level, max_num_workers_by_level);
+    if (data_collection_counter != 0) {
+        lf_print_error("Used a profile saved by a different program.");
+        failed = true;
+    }
+    data_collection_free();
+
+    write_file("lf-adaptive-profile 1 0 3\n");
+    check_ignored("a profile of another program");
+    write_file("not a profile\n");
+    check_ignored("a malformed profile");
+    write_file("lf-adaptive-profile 2 0 3\n");
+    check_ignored("a profile of another version");
+    if (remove(file) != 0) {
+        lf_print_error_and_exit("Failed to remove %s.", file);
+    }
+    check_ignored("a missing profile");
+
+    // A profile that ends after its header.
+    reset(reactions_per_level);
+    data_collection_save_profile();
+    data_collection_free();
+    FILE* stream = fopen(file, "r");
+    char header[128];
+    if (stream == NULL || fgets(header, sizeof(header), stream) == NULL) {
+        lf_print_error_and_exit("Failed to read %s.", file);
+    }
+    fclose(stream);
+    write_file(header);
+    check_ignored("a truncated profile");
+    remove(file);
+
+    // Saving where the file cannot be created only warns.
+    _lf_instance->sched_profile = "/nonexistent/sched_profile";
+    reset(reactions_per_level);
+    data_collection_save_profile();
+    data_collection_free();
+
+    if (failed) {
+        lf_print_error_and_exit("The test failed.");
+    }
+    return 0;
+}
+#else
+// The profile is kept by the adaptive scheduler of the threaded runtime.
+int main(int argc, const char* argv[]) {
+    return TEST_SKIPPED;
+}
+#endif
@@ -0,0 +1,146 @@
+#include <stdio.h>
+
+#include "reactor.h"
+#include "reactor_common.h"
+#include "util.h"
+#include "program_utils.h"
+#if defined(LF_CACHED_SCHEDULES) && !defined(NUMBER_OF_WORKERS)
+#include "pqueue.h"
+
+extern pqueue_t* reaction_q;
+
+// At each tag, a source reaction sets outputs that trigger sinks at the next
+// level. While a step replays a cached schedule, the sinks are not in the
+// reaction queue, so the first sink to execute finds it empty. When a step is
+// scheduled dynamically, the first sink finds the other sinks in it.
+//
+// The source leaves its first output absent at some tags, which deviates
+// from the schedule recorded with all outputs present. The first such tag
+// falls back to the reaction queue and records another schedule, which later
+// such tags replay instead.
+#define SINKS 3
+#define TAGS 6
+
+typedef enum {replayed, fell_back} step_kind_t;
+
+// Whether the first output is present at each tag, and whether the step is
+// expected to replay a cached schedule or to use the reaction queue.
+static const bool first_present[TAGS] = {true, true, false, true, false, true};
+static const step_kind_t expected[TAGS] = {fell_back, replayed, fell_back, replayed, replayed, replayed};
+
+static int tag = -1;                       // The index of the current tag.
+static int executed[SINKS];                // The number of times each sink has executed at the current tag.
+static bool sink_executed;                 // Whether a sink has executed at the current tag.
+static bool failed = false;
+
+static void source_function(void* self);
+static void sink_function(void* self);
+
+typedef struct sink_self_t {
+    self_base_t base;
+    int number;
+} sink_self_t;
+
+static self_base_t source_self;
+static sink_self_t sink_selves[SINKS];
+
+static reaction_t sink_reactions[SINKS];
+static reaction_t* sink_reaction_lists[SINKS][1];
+static trigger_t sink_triggers[SINKS];
+static trigger_t* output_triggers[SINKS][1];
+static trigger_t** output_trigger_lists[SINKS];
+static int output_trigger_sizes[SINKS];
+static bool outputs_present[SINKS];
+static bool* outputs_produced[SINKS];
+
+static reaction_t source_reaction = {
+    .function = source_function, .self = &source_self, .name = "source", .index = 0, .chain_id = 1, .deadline = -1,
+    .num_outputs = SINKS, .output_produced = outputs_produced,
+    .triggered_sizes = output_trigger_sizes, .triggers = output_trigger_lists
+};
+static reaction_t* tick_reactions[] = {&source_reaction};
+static trigger_t tick_trigger = {
+    .reactions = tick_reactions, .number_of_reactions = 1, .offset = MSEC(1), .period = -1, .policy = defer
+};
+static struct { trigger_t* trigger; } tick_action = {&tick_trigger};
+
+/** @brief Check which sinks executed at the current tag. */
+static void check_sinks() {
+    for (int i = 0; i < SINKS; i++) {
+        if (executed[i] != (int)outputs_present[i]) {
+            lf_print_error("At tag %d, sink %d executed %d times.", tag, i, executed[i]);
+            failed = true;
+        }
+    }
+}
+
+static void source_function(void* self) {
+    if (tag >= 0) {
+        check_sinks();
+    }
+    tag++;
+    for (int i = 0; i < SINKS; i++) {
+        outputs_present[i] = (i > 0 || first_present[tag]);
+        executed[i] = 0;
+    }
+    sink_executed = false;
+    if (tag + 1 < TAGS) {
+        _lf_schedule_token(&tick_action, 0, NULL);
+    }
+}
+
+static void sink_function(void* self) {
+    int sink = ((sink_self_t*)self)->number;
+    executed[sink]++;
+    if (!sink_executed) {
+        sink_executed = true;
+        step_kind_t kind = (pqueue_size(reaction_q) == 0) ? replayed : fell_back;
+        if (kind != expected[tag]) {
+            lf_print_error("Tag %d %s instead of %s.", tag,
+                    kind == replayed ? "replayed a cached schedule" : "used the reaction queue",
+                    expected[tag] == replayed ? "replaying a cached schedule" : "using the reaction queue");
+            failed = true;
+        }
+    }
+}
+
+void _lf_initialize_trigger_objects() {
+    for (int i = 0; i < SINKS; i++) {
+        sink_selves[i].number = i;
+        sink_reactions[i] = (reaction_t) {
+            .function = sink_function, .self = &sink_selves[i], .name = "sink", .index = 1,
+            .chain_id = 1, .deadline = -1
+        };
+        sink_reaction_lists[i][0] = &sink_reactions[i];
+        sink_triggers[i] = (trigger_t) {.reactions = sink_reaction_lists[i], .number_of_reactions = 1};
+        output_triggers[i][0] = &sink_triggers[i];
+        output_trigger_lists[i] = output_triggers[i];
+        output_trigger_sizes[i] = 1;
+        outputs_produced[i] = &outputs_present[i];
+    }
+}
+void _lf_trigger_startup_reactions() {
+    _lf_trigger_reaction(&source_reaction, -1);
+}
+
+/**
+ * @brief Run a program that deviates from a cached schedule, and check that
+ * steps replay cached schedules when they can, that a deviation falls back to
+ * the reaction queue, and that the same reactions execute either way.
+ */
+int main(int argc, const char* argv[]) {
+    if (!run_program("-f", "true", NULL)) {
+        lf_print_error_and_exit("The program failed.");
+    }
+    check_sinks();
+    if (failed || tag != TAGS - 1) {
+        lf_print_error_and_exit("The program failed after %d of %d tags.", tag + 1, TAGS);
+    }
+    return 0;
+}
+#else
+// Schedules are only cached by the unthreaded runtime with LF_CACHED_SCHEDULES.
+int main(int argc, const char* argv[]) {
+    return TEST_SKIPPED;
+}
+#endif
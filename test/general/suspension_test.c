@@ -0,0 +1,174 @@
+#include <stdio.h>
+
+#include "reactor.h"
+#include "reactor_common.h"
+#include "util.h"
+#include "program_utils.h"
+#ifdef __linux__
+#include <unistd.h>
+#include "fd_source.h"
+#ifdef NUMBER_OF_WORKERS
+#include "scheduler.h"
+#endif
+
+// At each tag, a reaction suspends itself and is resumed by the handler of a
+// pipe, into which it writes its handle. In the threaded runtime, the handler
+// runs on the thread that waits for file descriptors, and in the unthreaded
+// runtime, on the main thread while it waits for the reaction. Its continuation suspends it once more, and the second continuation
+// finishes it. A reaction at the next level, which depends on it, must only
+// execute once both continuations have, at the same tag.
+#define TAGS 5
+#define CONTINUATIONS 2
+#define PERIOD MSEC(1)
+// How long the handler waits at most for a worker to let go of a reaction.
+#define RELEASE_TIMEOUT SEC(1)
+
+static int tags = 0;
+static int continuations = 0;              // The number of continuations executed at the current tag.
+static tag_t suspended_tag;                // The tag at which the reaction last suspended.
+static bool failed = false;
+
+static int fds[2];                         // The pipe through which reactions are resumed.
+
+static void suspender_function(void* self);
+static void continuation_function(void* self, void* arg);
+static void downstream_function(void* self);
+
+static self_base_t suspender_self;
+
+static reaction_t suspender_reaction = {
+    .function = suspender_function, .self = &suspender_self, .name = "suspender", .index = 0, .chain_id = 1, .deadline = -1
+};
+static reaction_t downstream_reaction = {
+    .function = downstream_function, .self = &suspender_self, .name = "downstream", .index = 1, .chain_id = 1, .deadline = -1
+};
+static reaction_t* tick_reactions[] = {&suspender_reaction, &downstream_reaction};
+static trigger_t tick_trigger = {
+    .reactions = tick_reactions, .number_of_reactions = 2, .offset = PERIOD, .period = -1, .policy = defer
+};
+static struct { trigger_t* trigger; } tick_action = {&tick_trigger};
+// The handler of a file descriptor needs a physical action, which it does not schedule.
+static trigger_t resume_trigger = {.is_physical = true, .period = -1, .policy = defer};
+static struct { trigger_t* trigger; } resume_action = {&resume_trigger};
+
+/** @brief Hand a suspended reaction to the handler of the pipe. */
+static void resume_later(void* handle) {
+    if (write(fds[1], &handle, sizeof(handle)) != sizeof(handle)) {
+        lf_print_error_and_exit("Failed to write to the pipe.");
+    }
+}
+
+#ifdef NUMBER_OF_WORKERS
+/**
+ * @brief Wait, for at most RELEASE_TIMEOUT, until the worker of the given
+ * reaction has let go of it.
+ */
+static void wait_until_released(reaction_t* reaction) {
+    instant_t start, now;
+    lf_clock_gettime(&start);
+    while (reaction->suspension.state != reaction_suspended) {
+        lf_clock_gettime(&now);
+        if (now - start > RELEASE_TIMEOUT) {
+            lf_print_error("The worker did not let go of the suspended reaction.");
+            failed = true;
+            return;
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Resume the reaction whose handle has been written to the pipe once
+ * its worker has let go of it, if the scheduler lets workers do that, and
+ * otherwise after a while, so that its worker waits for it.
+ */
+static void resume_handler(int fd, void* action, void* user_data) {
+    void* handle;
+    if (read(fd, &handle, sizeof(handle)) != sizeof(handle)) {
+        return;
+    }
+#ifdef NUMBER_OF_WORKERS
+    if (lf_sched_supports_suspension) {
+        wait_until_released((reaction_t*)handle);
+        lf_reaction_resume(handle);
+        return;
+    }
+#endif
+    instant_t now;
+    lf_clock_gettime(&now);
+    lf_sleep_until(now + MSEC(2));
+    lf_reaction_resume(handle);
+}
+
+static void suspender_function(void* self) {
+    continuations = 0;
+    suspended_tag = lf_tag();
+    resume_later(lf_reaction_suspend(self, continuation_function, &continuations));
+}
+
+static void continuation_function(void* self, void* arg) {
+    if (arg != &continuations) {
+        lf_print_error("The continuation did not receive its argument.");
+        failed = true;
+    }
+    if (lf_tag_compare(lf_tag(), suspended_tag) != 0) {
+        lf_print_error("A continuation executed at (" PRINTF_TIME ", %u) instead of the tag of its reaction.",
+                lf_time_logical_elapsed(), lf_tag().microstep);
+        failed = true;
+    }
+    if (++continuations < CONTINUATIONS) {
+        resume_later(lf_reaction_suspend(self, continuation_function, arg));
+    }
+}
+
+static void downstream_function(void* self) {
+    if (lf_tag_compare(lf_tag(), suspended_tag) != 0 || continuations != CONTINUATIONS) {
+        lf_print_error("The downstream reaction executed at tag %d after %d of %d continuations.",
+                tags, continuations, CONTINUATIONS);
+        failed = true;
+    }
+    if (++tags < TAGS) {
+        _lf_schedule_token(&tick_action, 0, NULL);
+    }
+}
+
+void _lf_initialize_trigger_objects() {
+#ifdef NUMBER_OF_WORKERS
+    static size_t reactions_per_level[2] = {1, 1};
+    static sched_params_t params = {reactions_per_level, 2};
+    lf_sched_init(_lf_instance->number_of_workers, &params);
+#endif
+    if (lf_register_fd(fds[0], &resume_action, resume_handler, NULL) != 0) {
+        lf_print_error_and_exit("Failed to register the pipe.");
+    }
+}
+void _lf_trigger_startup_reactions() {
+    _lf_trigger_reaction(&suspender_reaction, -1);
+    _lf_trigger_reaction(&downstream_reaction, -1);
+}
+
+/**
+ * @brief Run a program whose reaction suspends itself at each tag and is
+ * resumed by the handler of a pipe, and check that its continuations execute at the
+ * tag of the reaction and before the reactions that depend on it, and that
+ * its worker lets go of it if the scheduler supports that.
+ */
+int main(int argc, const char* argv[]) {
+    if (pipe(fds) != 0) {
+        lf_print_error_and_exit("Failed to create the pipe.");
+    }
+    if (!run_program("-f", "true", NULL) || failed) {
+        lf_print_error_and_exit("The program failed.");
+    }
+    if (tags != TAGS) {
+        lf_print_error_and_exit("The downstream reaction executed at %d tags instead of %d.", tags, TAGS);
+    }
+    return 0;
+}
+#else
+// Without file descriptor sources, only another thread, which the unthreaded
+// runtime does not offer, could resume a reaction.
+int main(int argc, const char* argv[]) {
+    return TEST_SKIPPED;
+}
+#endif
@@ -0,0 +1,89 @@
+#include <stdio.h>
+
+#include "reactor_common.h"
+#include "util.h"
+#include "program_utils.h"
+#ifdef NUMBER_OF_WORKERS
+#include "reactor_threaded.h"
+
+// A thread advances the tag one microstep at a time, as far as the global tag
+// barrier lets it, while the main thread raises the barrier AHEAD microsteps
+// past the tag it last saw, lets the thread run into the barrier, and lowers
+// it again, ROUNDS times.
+#define ROUNDS 10000
+#define AHEAD 2u
+// How many times the main thread looks at the tag while the barrier is raised.
+#define LOOKS 100
+
+static volatile uint32_t passed_microstep = 0; // The microstep that the thread has advanced to.
+static volatile bool done = false;
+static instant_t start;
+
+/**
+ * @brief Advance the tag one microstep at a time whenever the barrier
+ * lets it, until done.
+ */
+static void* advance(void* arg) {
+    tag_t tag = {.time = start, .microstep = 0u};
+    while (!done) {
+        tag_t next = {.time = start, .microstep = tag.microstep + 1};
+        if (_lf_pass_global_tag_barrier(next)) {
+            tag = next;
+            passed_microstep = tag.microstep;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Raise the barrier concurrently with the advancement of the tag
+ * and check that the tag does not reach the barrier if it was in the future
+ * when raised, and otherwise stays where it was when it was raised. Also check
+ * that a barrier in the past holds back the next microstep.
+ */
+int main(int argc, char **argv) {
+    initialize();
+    start = lf_time_start();
+
+    // Without a thread advancing the tag concurrently, a barrier at a tag
+    // that has been passed holds back the next microstep.
+    if (!_lf_pass_global_tag_barrier((tag_t) {.time = start, .microstep = 0u})) {
+        lf_print_error_and_exit("The barrier held back the tag without having been raised.");
+    }
+    _lf_raise_global_tag_barrier((tag_t) {.time = start - 1, .microstep = 0u});
+    if (_lf_pass_global_tag_barrier((tag_t) {.time = start, .microstep = 1u})) {
+        lf_print_error_and_exit("A barrier raised in the past let the tag advance.");
+    }
+    _lf_lower_global_tag_barrier();
+
+    lf_thread_t thread;
+    if (lf_thread_create(&thread, advance, NULL) != 0) {
+        lf_print_error_and_exit("Failed to create the thread that advances the tag.");
+    }
+    for (int round = 0; round < ROUNDS; round++) {
+        uint32_t future = passed_microstep + AHEAD;
+        _lf_raise_global_tag_barrier((tag_t) {.time = start, .microstep = future});
+        // The tag may still have passed future during the raise. If it has
+        // not by now, it never may. If it has, it may not advance further.
+        // The thread may have yet to record the last microstep it passed.
+        uint32_t raised = passed_microstep + 1;
+        uint32_t limit = raised < future ? future - 1 : raised;
+        for (int i = 0; i < LOOKS; i++) {
+            uint32_t microstep = passed_microstep;
+            if (microstep > limit) {
+                lf_print_error_and_exit("Round %d: The tag advanced to microstep %u past a barrier at %u, "
+                        "which it was at most at %u when raised.", round, microstep, future, raised);
+            }
+        }
+        _lf_lower_global_tag_barrier();
+    }
+    done = true;
+    lf_thread_join(thread, NULL);
+    return 0;
+}
+#else
+// The unthreaded runtime has no global tag barrier.
+int main(int argc, char **argv) {
+    return TEST_SKIPPED;
+}
+#endif
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "reactor.h"
+#include "reactor_common.h"
+#include "util.h"
+
+#define LENGTH 64
+#define TILES 4
+#define TILE_LENGTH (LENGTH / TILES)
+
+/**
+ * @brief Release the specified token at the start of the next time step,
+ * as the runtime does for a token given to a mutable input.
+ */
+static void release_later(lf_token_t* token) {
+    token->next_free = _lf_enclave->more_tokens_with_ref_count;
+    _lf_enclave->more_tokens_with_ref_count = token;
+}
+
+/**
+ * @brief Free a template token created with _lf_create_token(), which in
+ * static-memory mode comes from the token pool.
+ */
+static void free_template(lf_token_t* template) {
+#ifdef LF_STATIC_MEMORY
+    pool_give(&_lf_instance->token_pool, template);
+#else
+    free(template);
+#endif
+}
+
+static int released = 0;
+
+/**
+ * @brief Release a buffer owned by the test, which counts the releases.
+ */
+static void release(void* value, size_t length, void* context) {
+    if (context != &released || length != TILE_LENGTH) {
+        lf_print_error_and_exit("A buffer was released with the wrong length or context.");
+    }
+    released++;
+}
+
+/**
+ * @brief Check that tokens that wrap buffers owned by the test hand them back
+ * once their last reference, including that of a view, is released.
+ */
+static void test_wrap() {
+    static int buffers[TILES][TILE_LENGTH];
+    void* values[TILES];
+    size_t lengths[TILES];
+    for (int t = 0; t < TILES; t++) {
+        values[t] = buffers[t];
+        lengths[t] = TILE_LENGTH;
+    }
+    lf_token_t* tokens[TILES];
+    lf_token_wrap_batch(sizeof(int), values, lengths, TILES, release, &released, tokens);
+    for (int t = 0; t < TILES; t++) {
+        if (tokens[t]->value != buffers[t] || tokens[t]->length != TILE_LENGTH) {
+            lf_print_error_and_exit("Token %d does not carry its buffer.", t);
+        }
+        tokens[t]->ref_count = 1;
+    }
+    lf_token_t* view = lf_token_slice(tokens[0], 1, 2);
+    view->ref_count = 1;
+    // A writable copy of a shared buffer is made by the runtime.
+    lf_token_t* copy = writable_copy(tokens[0]);
+    if (copy == tokens[0] || copy->release != NULL) {
+        lf_print_error_and_exit("A writable copy of a shared buffer is not a copy.");
+    }
+    copy->ref_count = 1;
+    release_later(copy);
+    for (int t = 0; t < TILES; t++) {
+        release_later(tokens[t]);
+    }
+    _lf_start_time_step();
+    if (released != TILES - 1) {
+        lf_print_error_and_exit("Released %d buffers instead of %d.", released, TILES - 1);
+    }
+    release_later(view);
+    _lf_start_time_step();
+    if (released != TILES) {
+        lf_print_error_and_exit("The buffer of a view was not released with the view.");
+    }
+}
+
+#ifdef NUMBER_OF_WORKERS
+#define SLICERS 4
+#define SLICES_PER_SLICER 100
+
+static lf_token_t* shared_frame;
+static lf_token_t* parallel_views[SLICERS][SLICES_PER_SLICER];
+
+/**
+ * @brief Slice the shared frame into views of one element each, as a
+ * reaction executing on a worker would.
+ */
+static void* slice_shared_frame(void* arg) {
+    lf_token_t** views = (lf_token_t**)arg;
+    for (int i = 0; i < SLICES_PER_SLICER; i++) {
+        views[i] = lf_token_slice(shared_frame, i % LENGTH, 1);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Check that reactions executing in parallel can slice the same
+ * token, which then holds one reference per view, and that the views and
+ * the token are all freed once they are released.
+ */
+static void test_parallel_slices() {
+    lf_mutex_init(&_lf_enclave->event_q_mutex);
+    lf_token_t* template = _lf_create_token(sizeof(int));
+    shared_frame = _lf_initialize_token(template, LENGTH);
+    shared_frame->ref_count = 1;
+    lf_thread_t threads[SLICERS];
+    for (int t = 0; t < SLICERS; t++) {
+        if (lf_thread_create(&threads[t], slice_shared_frame, parallel_views[t]) != 0) {
+            lf_print_error_and_exit("Failed to create a thread.");
+        }
+    }
+    for (int t = 0; t < SLICERS; t++) {
+        lf_thread_join(threads[t], NULL);
+    }
+    if (shared_frame->ref_count != SLICERS * SLICES_PER_SLICER + 1) {
+        lf_print_error_and_exit("Expected %d references on the frame, found %d.",
+                SLICERS * SLICES_PER_SLICER + 1, shared_frame->ref_count);
+    }
+    for (int t = 0; t < SLICERS; t++) {
+        for (int i = 0; i < SLICES_PER_SLICER; i++) {
+            parallel_views[t][i]->ref_count = 1;
+            release_later(parallel_views[t][i]);
+        }
+    }
+    release_later(shared_frame);
+    _lf_start_time_step();
+    if (template->value != NULL || _lf_instance->count_token_allocations != 0) {
+        lf_print_error_and_exit("The frame and its views were not freed after slicing in parallel.");
+    }
+    free_template(template);
+}
+#endif
+
+/**
+ * @brief Check that views of slices of an array share its payload, that a
+ * writable copy of a shared view copies only the slice, and that all tokens
+ * and payloads are freed once the views are released.
+ */
+int main(int argc, char **argv) {
+    initialize();
+    lf_token_t* template = _lf_create_token(sizeof(int));
+    lf_token_t* frame = _lf_initialize_token(template, LENGTH);
+    int* values = (int*)frame->value;
+    for (int i = 0; i < LENGTH; i++) {
+        values[i] = i;
+    }
+    // The frame is read by one reaction, which hands out tiles of it.
+    frame->ref_count = 1;
+    lf_token_t* tiles[TILES];
+    for (int t = 0; t < TILES; t++) {
+        tiles[t] = lf_token_slice(frame, t * TILE_LENGTH, TILE_LENGTH);
+        if (tiles[t] == NULL || tiles[t]->value != values + t * TILE_LENGTH
+                || tiles[t]->length != TILE_LENGTH) {
+            lf_print_error_and_exit("Tile %d does not refer to its slice of the frame.", t);
+        }
+        tiles[t]->ref_count = 1;
+    }
+    if (frame->ref_count != TILES + 1) {
+        lf_print_error_and_exit("Expected %d references on the frame, found %d.", TILES + 1, frame->ref_count);
+    }
+    // A view of a view refers to the frame, not to the tile.
+    lf_token_t* half = lf_token_slice(tiles[1], TILE_LENGTH / 2, TILE_LENGTH / 2);
+    if (half->parent != frame || *(int*)half->value != TILE_LENGTH + TILE_LENGTH / 2) {
+        lf_print_error_and_exit("A view of a view does not refer to the frame.");
+    }
+    half->ref_count = 1;
+    release_later(half);
+    if (lf_token_slice(frame, LENGTH - 1, 2) != NULL) {
+        lf_print_error_and_exit("A slice out of bounds was accepted.");
+    }
+
+    // The frame is shared, so writing to a tile copies the tile only.
+    lf_token_t* copy = writable_copy(tiles[0]);
+    if (copy == tiles[0] || copy->parent != NULL || copy->length != TILE_LENGTH
+            || ((int*)copy->value)[TILE_LENGTH - 1] != TILE_LENGTH - 1) {
+        lf_print_error_and_exit("A writable copy of a shared tile is not a copy of the tile.");
+    }
+    ((int*)copy->value)[0] = -1;
+    if (values[0] != 0) {
+        lf_print_error_and_exit("Writing to a copy of a tile changed the frame.");
+    }
+    copy->ref_count = 1;
+    release_later(copy);
+    for (int t = 0; t < TILES; t++) {
+        release_later(tiles[t]);
+    }
+    release_later(frame);
+    _lf_start_time_step();
+
+    // The frame has been released along with its tiles.
+    if (template->value != NULL || template->ref_count != 0) {
+        lf_print_error_and_exit("The frame was not freed with its last view.");
+    }
+    if (_lf_instance->count_payload_allocations != 0 || _lf_instance->count_token_allocations != 0) {
+        lf_print_error_and_exit("%d payloads and %d tokens were not freed.",
+                _lf_instance->count_payload_allocations, _lf_instance->count_token_allocations);
+    }
+
+    // A view that is the only holder of its frame is writable in place.
+    frame = _lf_initialize_token(template, LENGTH);
+    lf_token_t* tile = lf_token_slice(frame, 0, TILE_LENGTH);
+    tile->ref_count = 1;
+    if (writable_copy(tile) != tile) {
+        lf_print_error_and_exit("A view that is the only holder of its frame was copied.");
+    }
+    release_later(tile);
+    _lf_start_time_step();
+    if (template->value != NULL || _lf_instance->count_payload_allocations != 0) {
+        lf_print_error_and_exit("The frame was not freed with its only view.");
+    }
+    free_template(template);
+
+    test_wrap();
+#ifdef NUMBER_OF_WORKERS
+    test_parallel_slices();
+#endif
+    if (_lf_instance->count_payload_allocations != 0 || _lf_instance->count_token_allocations != 0) {
+        lf_print_error_and_exit("%d payloads and %d tokens were not freed.",
+                _lf_instance->count_payload_allocations, _lf_instance->count_token_allocations);
+    }
+    printf("Sliced a frame into %d tiles and sent %d buffers without copying them.\n", TILES, TILES);
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "../../../util/deque.c"
+#include "../../../util/spsc_queue.c"
+#include "core/utils/util.h"
+#include "platform.h"
+#include "tag.h"
+
+#define N 100000
+#define RANDOM_SEED 1830
+// The number of values handed between threads. Each side sleeps when it
+// cannot proceed, so that the test also finishes quickly on one CPU.
+#define HANDOFFS 10000
+
+// The values in the deque, in order, starting at mock[mock_front].
+static size_t mock[2 * N + 1];
+static size_t mock_front = N;
+static size_t mock_size = 0;
+
+static void* value_of(size_t value) {
+    return (void*)(value + 1);
+}
+
+/**
+ * @brief Push and pop at random ends, with more pushes than pops in the first
+ * half so that the buffer grows while its values wrap around its end.
+ */
+static void test_deque() {
+    deque_t d;
+    deque_initialize(&d);
+    for (size_t i = 0; i < N; i++) {
+        int r = rand() % 100;
+        if (r < (i < N / 2 ? 35 : 15)) {
+            deque_push_front(&d, value_of(i));
+            mock[--mock_front] = i;
+            mock_size++;
+        } else if (r < (i < N / 2 ? 70 : 30)) {
+            deque_push_back(&d, value_of(i));
+            mock[mock_front + mock_size++] = i;
+        } else if (r < (i < N / 2 ? 85 : 65)) {
+            void* expected = mock_size == 0 ? NULL : value_of(mock[mock_front]);
+            if (deque_peek_front(&d) != expected || deque_pop_front(&d) != expected) {
+                lf_print_error_and_exit("Unexpected value on the front of the deque at step %zu.", i);
+            }
+            if (mock_size > 0) {
+                mock_front++;
+                mock_size--;
+            }
+        } else {
+            void* expected = mock_size == 0 ? NULL : value_of(mock[mock_front + mock_size - 1]);
+            if (deque_peek_back(&d) != expected || deque_pop_back(&d) != expected) {
+                lf_print_error_and_exit("Unexpected value on the back of the deque at step %zu.", i);
+            }
+            if (mock_size > 0) mock_size--;
+        }
+        if (deque_size(&d) != mock_size || deque_is_empty(&d) != (mock_size == 0)) {
+            lf_print_error_and_exit("Expected %zu values but found %zu.", mock_size, deque_size(&d));
+        }
+    }
+    deque_free(&d);
+    if (!deque_is_empty(&d)) {
+        lf_print_error_and_exit("The deque is not empty after it was freed.");
+    }
+}
+
+static spsc_queue_t q;
+
+#ifdef NUMBER_OF_WORKERS
+static void* producer(void* arg) {
+    for (size_t i = 0; i < HANDOFFS; i++) {
+        while (!spsc_queue_push(&q, value_of(i))) {
+            lf_nanosleep(USEC(1));
+        }
+    }
+    return NULL;
+}
+#endif
+
+/**
+ * @brief Hand values through a small queue from a producer thread,
+ * if there are threads, and check that they all arrive in order.
+ */
+static void test_spsc_queue() {
+    if (spsc_queue_init(&q, 6) != 0 || q.mask != 7) {
+        lf_print_error_and_exit("Could not create a queue of 8 values.");
+    }
+    void* value;
+    if (spsc_queue_pop(&q, &value)) {
+        lf_print_error_and_exit("Popped a value from an empty queue.");
+    }
+#ifdef NUMBER_OF_WORKERS
+    lf_thread_t thread;
+    lf_thread_create(&thread, producer, NULL);
+    for (size_t i = 0; i < HANDOFFS; i++) {
+        while (!spsc_queue_pop(&q, &value)) {
+            lf_nanosleep(USEC(1));
+        }
+        if (value != value_of(i)) {
+            lf_print_error_and_exit("Popped value %p instead of %p.", value, value_of(i));
+        }
+    }
+    lf_thread_join(thread, NULL);
+#else
+    for (size_t i = 0; i < 8; i++) {
+        if (!spsc_queue_push(&q, value_of(i))) {
+            lf_print_error_and_exit("The queue is full after %zu values.", i);
+        }
+    }
+    if (spsc_queue_push(&q, value_of(8)) || spsc_queue_size(&q) != 8) {
+        lf_print_error_and_exit("The queue holds more than 8 values.");
+    }
+    for (size_t i = 0; i < 8; i++) {
+        if (!spsc_queue_pop(&q, &value) || value != value_of(i)) {
+            lf_print_error_and_exit("Popped value %p instead of %p.", value, value_of(i));
+        }
+    }
+#endif
+    spsc_queue_free(&q);
+}
+
+int main() {
+    srand(RANDOM_SEED);
+    test_deque();
+    test_spsc_queue();
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "core/utils/impl/pointer_growable_hashmap.h"
+#include "core/utils/util.h"
+
+#define KEYS 2000
+#define N 200000
+#define RANDOM_SEED 1830
+
+// The value associated with each key in the hashmap, or -1 if it has none.
+static int mock[KEYS];
+static size_t mock_size = 0;
+
+/** @brief Return the key with the given index, spaced like the addresses of small structs. */
+static void* key_of(int index) {
+    return (void*)((uintptr_t)0x10000 + 64 * (uintptr_t)index);
+}
+
+static void check(growable_hashmap_object2int_t* h, int index) {
+    int* found = growable_hashmap_object2int_find(h, key_of(index));
+    if (mock[index] < 0 ? found != NULL : (found == NULL || *found != mock[index])) {
+        lf_print_error_and_exit("Expected %d but got %d for key %d.",
+                mock[index], found == NULL ? -1 : *found, index);
+    }
+}
+
+int main() {
+    srand(RANDOM_SEED);
+    for (int i = 0; i < KEYS; i++) mock[i] = -1;
+    // Start small so that the hashmap grows, and is rebuilt when removals leave tombstones.
+    growable_hashmap_object2int_t* h = growable_hashmap_object2int_new(0);
+    for (int i = 0; i < N; i++) {
+        // Let the number of keys rise and fall in waves.
+        int index = rand() % KEYS;
+        bool grow = (i / (N / 10)) % 2 == 0;
+        if (rand() % 100 < (grow ? 70 : 30)) {
+            int value = rand();
+            if (mock[index] < 0) mock_size++;
+            mock[index] = value;
+            growable_hashmap_object2int_put(h, key_of(index), value);
+        } else {
+            bool removed = growable_hashmap_object2int_remove(h, key_of(index));
+            if (removed != (mock[index] >= 0)) {
+                lf_print_error_and_exit("Removing key %d returned %d.", index, removed);
+            }
+            if (removed) mock_size--;
+            mock[index] = -1;
+        }
+        check(h, rand() % KEYS);
+        if (growable_hashmap_object2int_size(h) != mock_size) {
+            lf_print_error_and_exit("Expected %zu keys but found %zu.",
+                    mock_size, growable_hashmap_object2int_size(h));
+        }
+    }
+    for (int i = 0; i < KEYS; i++) check(h, i);
+    growable_hashmap_object2int_free(h);
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "pool.h"
+#include "util.h"
+
+#define CAPACITY 64
+#define BLOCK_SIZE 13
+
+static void* taken[CAPACITY];
+
+/**
+ * @brief Check that every block of `pool` can be taken exactly once, that
+ * the blocks are aligned and do not overlap, and that the pool then reports
+ * itself exhausted.
+ *
+ * @param pool A pool with CAPACITY blocks, none of which are in use.
+ */
+void test_take_all(pool_t* pool) {
+    for (int i = 0; i < CAPACITY; i++) {
+        taken[i] = pool_take(pool);
+        if (taken[i] == NULL || !pool_contains(pool, taken[i])) {
+            lf_print_error_and_exit("Block %d was not taken from the pool.", i);
+        }
+        if ((uintptr_t) taken[i] % sizeof(void*) != 0) {
+            lf_print_error_and_exit("Block %p is not aligned.", taken[i]);
+        }
+        memset(taken[i], i, BLOCK_SIZE);
+    }
+    for (int i = 0; i < CAPACITY; i++) {
+        if (((unsigned char*) taken[i])[BLOCK_SIZE - 1] != (unsigned char) i) {
+            lf_print_error_and_exit("Block %d was overwritten by another block.", i);
+        }
+    }
+    if (pool_take(pool) != NULL) {
+        lf_print_error_and_exit("Took a block from an exhausted pool.");
+    }
+}
+
+int main() {
+    pool_t pool;
+    if (pool_init(&pool, BLOCK_SIZE, CAPACITY) != 0) {
+        lf_print_error_and_exit("Could not initialize a pool.");
+    }
+    int local;
+    if (pool_contains(&pool, &local)) {
+        lf_print_error_and_exit("A pool contains a pointer it does not own.");
+    }
+    test_take_all(&pool);
+    // Give back the blocks in a shuffled order and take them all again.
+    for (int i = 0; i < CAPACITY; i++) {
+        int j = rand() % CAPACITY;
+        void* tmp = taken[i];
+        taken[i] = taken[j];
+        taken[j] = tmp;
+    }
+    for (int i = 0; i < CAPACITY; i++) {
+        pool_give(&pool, taken[i]);
+    }
+    if (pool.in_use != 0 || pool.high_water_mark != CAPACITY) {
+        lf_print_error_and_exit(
+            "Expected 0 blocks in use and a high-water mark of %d, but got %zu and %zu.",
+            CAPACITY, pool.in_use, pool.high_water_mark
+        );
+    }
+    test_take_all(&pool);
+    pool_free(&pool);
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <unistd.h>
+
+#include "tag.h"
+#include "util.h"
+#ifdef NUMBER_OF_WORKERS
+#include "semaphore.h"
+
+// The number of threads that acquire or wait, and how many times each of the
+// consumers acquires.
+#define THREADS 4
+#define ACQUISITIONS 20000
+// How long threads that must stay blocked are given to wrongly return.
+#define SETTLE MSEC(20)
+// How long the test may take at most.
+#define TEST_TIMEOUT SEC(10)
+
+static semaphore_t* semaphore;
+static volatile int32_t available;         // What has been released and not yet acquired.
+static volatile int32_t returned;          // The number of threads that have returned from the semaphore.
+static volatile bool failed = false;
+
+static void sleep_for(interval_t interval) {
+    instant_t now;
+    lf_clock_gettime(&now);
+    lf_sleep_until(now + interval);
+}
+
+static void start_threads(lf_thread_t* threads, void* (*function)(void*)) {
+    for (int i = 0; i < THREADS; i++) {
+        if (lf_thread_create(&threads[i], function, NULL) != 0) {
+            lf_print_error_and_exit("Failed to create a thread.");
+        }
+    }
+}
+
+static void join_threads(lf_thread_t* threads) {
+    for (int i = 0; i < THREADS; i++) {
+        lf_thread_join(threads[i], NULL);
+    }
+}
+
+/** @brief Fail if the test has not finished after TEST_TIMEOUT. */
+static void* watchdog(void* arg) {
+    sleep_for(TEST_TIMEOUT);
+    lf_print_error("The test did not finish. A thread may not have been woken up.");
+    _exit(1);
+    return NULL;
+}
+
+/**
+ * @brief Acquire ACQUISITIONS times, and fail if more has been acquired
+ * than released.
+ */
+static void* consume(void* arg) {
+    for (int i = 0; i < ACQUISITIONS; i++) {
+        lf_semaphore_acquire(semaphore);
+        if (lf_atomic_add_fetch(&available, -1) < 0) {
+            lf_print_error("More has been acquired than released.");
+            failed = true;
+        }
+    }
+    return NULL;
+}
+
+static void* acquire_once(void* arg) {
+    lf_semaphore_acquire(semaphore);
+    lf_atomic_fetch_add(&returned, 1);
+    return NULL;
+}
+
+static void* wait_once(void* arg) {
+    lf_semaphore_wait(semaphore);
+    lf_atomic_fetch_add(&returned, 1);
+    return NULL;
+}
+
+/**
+ * @brief Release to consumers in batches of different sizes, and check that
+ * they acquire exactly what is released.
+ */
+static void test_release_and_acquire() {
+    semaphore = lf_semaphore_new(0);
+    lf_thread_t threads[THREADS];
+    start_threads(threads, consume);
+    int released = 0;
+    for (int n = 1; released < THREADS * ACQUISITIONS; n = n % 7 + 1) {
+        if (n > THREADS * ACQUISITIONS - released) {
+            n = THREADS * ACQUISITIONS - released;
+        }
+        lf_atomic_fetch_add(&available, n);
+        lf_semaphore_release(semaphore, n);
+        released += n;
+    }
+    join_threads(threads);
+    if (available != 0 || semaphore->count != 0) {
+        lf_print_error("After the consumers acquired all that was released, %d remain.", semaphore->count);
+        failed = true;
+    }
+    lf_semaphore_destroy(semaphore);
+}
+
+/**
+ * @brief Check that releasing n lets exactly n of the threads that are
+ * blocked in lf_semaphore_acquire() return.
+ */
+static void test_release_wakes_n() {
+    semaphore = lf_semaphore_new(0);
+    returned = 0;
+    lf_thread_t threads[THREADS];
+    start_threads(threads, acquire_once);
+    sleep_for(SETTLE);
+    lf_semaphore_release(semaphore, THREADS / 2);
+    sleep_for(SETTLE);
+    if (returned != THREADS / 2) {
+        lf_print_error("Releasing %d let %d threads acquire.", THREADS / 2, returned);
+        failed = true;
+    }
+    lf_semaphore_release(semaphore, THREADS - THREADS / 2);
+    join_threads(threads);
+    lf_semaphore_destroy(semaphore);
+}
+
+/**
+ * @brief Check that lf_semaphore_wait() blocks while the count is 0, that
+ * releasing once lets all the threads that wait return, and that it does not
+ * take from the count.
+ */
+static void test_wait() {
+    semaphore = lf_semaphore_new(0);
+    returned = 0;
+    lf_thread_t threads[THREADS];
+    start_threads(threads, wait_once);
+    sleep_for(SETTLE);
+    if (returned != 0) {
+        lf_print_error("%d threads returned from waiting while the count was 0.", returned);
+        failed = true;
+    }
+    lf_semaphore_release(semaphore, 1);
+    join_threads(threads);
+    if (semaphore->count != 1) {
+        lf_print_error("Waiting changed the count from 1 to %d.", semaphore->count);
+        failed = true;
+    }
+    // Neither blocks while the count is positive.
+    lf_semaphore_wait(semaphore);
+    lf_semaphore_acquire(semaphore);
+    lf_semaphore_destroy(semaphore);
+}
+
+/**
+ * @brief Test semaphores with several threads, built on futexes or on a
+ * mutex and a condition variable, depending on the platform and on
+ * LF_MUTEX_SEMAPHORE.
+ */
+int main(int argc, char* argv[]) {
+    lf_thread_t thread;
+    if (lf_thread_create(&thread, watchdog, NULL) != 0) {
+        lf_print_error_and_exit("Failed to create the watchdog thread.");
+    }
+    test_release_and_acquire();
+    test_release_wakes_n();
+    test_wait();
+    if (failed) {
+        lf_print_error_and_exit("The test failed.");
+    }
+    return 0;
+}
+#else
+// Semaphores are only built for the threaded runtime.
+int main(int argc, char* argv[]) {
+    return 0;
+}
+#endif
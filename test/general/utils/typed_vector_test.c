@@ -0,0 +1,94 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "util.h"
+
+typedef struct point_t {
+    int x;
+    double y;
+} point_t;
+
+#define TYPED_VECTOR(token) point_vector ## _ ## token
+#define T point_t
+#define TYPED_VECTOR_INLINE_CAPACITY 4
+#include "core/utils/impl/typed_vector.h"
+#undef TYPED_VECTOR
+#undef T
+#undef TYPED_VECTOR_INLINE_CAPACITY
+
+#define CAPACITY 100
+#define MAX_APPEND 8
+#define N 1000
+// Clearing makes vectors slow to fill, so each is given at most this many operations.
+#define MAX_OPERATIONS 200
+#define RANDOM_SEED 1614
+
+static point_t mock[CAPACITY + MAX_APPEND];
+static size_t mock_size = 0;
+
+static point_t random_point() {
+    return (point_t) {rand(), rand() / 7.0};
+}
+
+static void check(point_vector_t* v) {
+    if (point_vector_size(v) != mock_size) {
+        lf_print_error_and_exit("Expected %zu elements but found %zu.", mock_size, point_vector_size(v));
+    }
+    for (size_t i = 0; i < mock_size; i++) {
+        point_t* found = point_vector_at(v, i);
+        if (found->x != mock[i].x || found->y != mock[i].y) {
+            lf_print_error_and_exit("Unexpected element at index %zu.", i);
+        }
+    }
+}
+
+int main() {
+    srand(RANDOM_SEED);
+    for (int i = 0; i < N; i++) {
+        point_vector_t v = {0};
+        mock_size = 0;
+        if (rand() % 2) {
+            point_vector_reserve(&v, rand() % CAPACITY);
+        }
+        for (int operations = 0; mock_size < CAPACITY && operations < MAX_OPERATIONS; operations++) {
+            int choice = rand() % 100;
+            if (choice < 40) {
+                point_t p = random_point();
+                point_vector_push(&v, p);
+                mock[mock_size++] = p;
+            } else if (choice < 60) {
+                size_t count = rand() % MAX_APPEND;
+                for (size_t j = 0; j < count; j++) {
+                    mock[mock_size + j] = random_point();
+                }
+                point_vector_append(&v, mock + mock_size, count);
+                mock_size += count;
+            } else if (choice < 90) {
+                if (mock_size > 0) {
+                    point_t p = point_vector_pop(&v);
+                    mock_size--;
+                    if (p.x != mock[mock_size].x || p.y != mock[mock_size].y) {
+                        lf_print_error_and_exit("Popped an unexpected element.");
+                    }
+                }
+            } else if (choice < 95) {
+                // Clearing keeps the memory of the vector.
+                size_t capacity = point_vector_capacity(&v);
+                point_vector_clear(&v);
+                mock_size = 0;
+                if (point_vector_capacity(&v) != capacity) {
+                    lf_print_error_and_exit("Clearing changed the capacity of a vector.");
+                }
+            } else {
+                // Vectors do not point into themselves, so they can be moved.
+                point_vector_t moved = v;
+                v = moved;
+            }
+            check(&v);
+        }
+        point_vector_free(&v);
+        if (point_vector_size(&v) != 0 || point_vector_capacity(&v) != 4) {
+            lf_print_error_and_exit("A freed vector is not empty.");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <unistd.h>
+
+#include "reactor.h"
+#include "reactor_common.h"
+#include "util.h"
+#include "program_utils.h"
+#ifdef NUMBER_OF_WORKERS
+#include "scheduler.h"
+#include "scheduler_instance.h"
+#include "worker_pool.h"
+
+// A burst of as many parallel reactions as there are workers, which only
+// finish once all of them execute at the same time, then an idle period with
+// one reaction per tag, until the pool has parked its surplus workers, then
+// another burst, and another idle period, at the end of which the program
+// stops while workers are parked.
+#define WORKERS 4
+#define MIN_WORKERS 1
+#define BURSTS 2
+#define PERIOD MSEC(10)
+// The idle period takes LF_WORKER_POOL_PERIOD, or two when a period has just
+// started, to park workers. It fails after this many tags.
+#define MAX_IDLE_TAGS (int)(4 * LF_WORKER_POOL_PERIOD / PERIOD)
+// How long the reactions of a burst wait for each other, and how long the
+// program may take at most.
+#define BURST_TIMEOUT SEC(1)
+#define PROGRAM_TIMEOUT SEC(10)
+
+static volatile int arrived[BURSTS];       // The number of reactions of each burst that have started.
+static int bursts = 0;                     // The number of bursts that have executed.
+static int idle_tags = 0;                  // The number of tags of the current idle period.
+static bool burst_pending = true;          // Whether the current or the next tag has a burst.
+static bool skipped = false;
+static bool failed = false;
+
+static void parallel_function(void* self);
+static void controller_function(void* self);
+
+static self_base_t pool_self;
+
+static reaction_t parallel_reactions[WORKERS];
+static reaction_t controller_reaction = {
+    .function = controller_function, .self = &pool_self, .name = "controller", .index = 1, .chain_id = 1, .deadline = -1
+};
+static reaction_t* burst_reactions[WORKERS + 1];
+static trigger_t burst_trigger = {
+    .reactions = burst_reactions, .number_of_reactions = WORKERS + 1, .offset = PERIOD, .period = -1, .policy = defer
+};
+static struct { trigger_t* trigger; } burst_action = {&burst_trigger};
+static reaction_t* tick_reactions[] = {&controller_reaction};
+static trigger_t tick_trigger = {
+    .reactions = tick_reactions, .number_of_reactions = 1, .offset = PERIOD, .period = -1, .policy = defer
+};
+static struct { trigger_t* trigger; } tick_action = {&tick_trigger};
+
+/** @brief Return the number of workers that the scheduler counts as active. */
+static size_t active_workers() {
+    return _lf_sched_instance->_lf_sched_number_of_workers;
+}
+
+/**
+ * @brief Wait, for at most BURST_TIMEOUT, until every reaction of the burst
+ * has started, which takes as many active workers as there are reactions.
+ */
+static void parallel_function(void* self) {
+    if (skipped) {
+        return;
+    }
+    int burst = bursts;
+    lf_atomic_fetch_add(&arrived[burst], 1);
+    instant_t start = lf_time_physical();
+    while (arrived[burst] < WORKERS) {
+        if (lf_time_physical() - start > BURST_TIMEOUT) {
+            lf_print_error("Burst %d: Only %d of %d reactions executed at the same time.", burst, arrived[burst], WORKERS);
+            failed = true;
+            return;
+        }
+    }
+}
+
+static void controller_function(void* self) {
+    if (skipped || failed) {
+        lf_request_stop();
+        return;
+    }
+    if (burst_pending) {
+        // The parallel reactions have executed, with every worker active.
+        burst_pending = false;
+        if (active_workers() != WORKERS) {
+            lf_print_error("Burst %d: %zu workers are active instead of %d.", bursts, active_workers(), WORKERS);
+            failed = true;
+            return;
+        }
+        bursts++;
+        idle_tags = 0;
+    } else if (active_workers() == MIN_WORKERS) {
+        // The idle period has parked the surplus workers. Stop while they are
+        // parked, or make them execute another burst.
+        LF_PRINT_LOG("Parked %d workers after %d idle tags.", WORKERS - MIN_WORKERS, idle_tags);
+        if (bursts < BURSTS) {
+            burst_pending = true;
+            _lf_schedule_token(&burst_action, 0, NULL);
+        } else {
+            lf_request_stop();
+        }
+        return;
+    } else if (++idle_tags > MAX_IDLE_TAGS) {
+        lf_print_error("After %d idle tags, %zu workers are active instead of %d.",
+                idle_tags, active_workers(), MIN_WORKERS);
+        failed = true;
+        return;
+    }
+    _lf_schedule_token(&tick_action, 0, NULL);
+}
+
+void _lf_initialize_trigger_objects() {
+    for (int i = 0; i < WORKERS; i++) {
+        parallel_reactions[i] = (reaction_t) {
+            .function = parallel_function, .self = &pool_self, .name = "parallel", .index = 0,
+            .chain_id = 1, .deadline = -1
+        };
+        burst_reactions[i] = &parallel_reactions[i];
+    }
+    burst_reactions[WORKERS] = &controller_reaction;
+    static size_t reactions_per_level[2] = {WORKERS, 1};
+    static sched_params_t params = {reactions_per_level, 2};
+    lf_sched_init(_lf_instance->number_of_workers, &params);
+    skipped = !lf_sched_has_worker_pool;
+    if (!skipped && (_lf_sched_instance == NULL || _lf_sched_instance->_lf_sched_worker_pool == NULL)) {
+        lf_print_error_and_exit("The scheduler did not create its pool of workers.");
+    }
+}
+void _lf_trigger_startup_reactions() {
+    // The first burst is at the start tag, before any worker has been parked.
+    for (int i = 0; i < WORKERS; i++) {
+        _lf_trigger_reaction(&parallel_reactions[i], -1);
+    }
+    _lf_trigger_reaction(&controller_reaction, -1);
+}
+
+/** @brief Fail if the program has not stopped after PROGRAM_TIMEOUT. */
+static void* watchdog(void* arg) {
+    instant_t now;
+    lf_clock_gettime(&now);
+    lf_sleep_until(now + PROGRAM_TIMEOUT);
+    lf_print_error("The program did not stop. Parked workers may not have been unparked to exit.");
+    _exit(1);
+    return NULL;
+}
+
+/**
+ * @brief Run a program whose parallelism comes in bursts, with fewer workers
+ * kept active at a minimum than there are worker threads, and check that the
+ * pool parks workers while the program is idle, unparks them for a burst, and
+ * lets them exit when the program stops while they are parked.
+ */
+int main(int argc, const char* argv[]) {
+    lf_thread_t thread;
+    if (lf_thread_create(&thread, watchdog, NULL) != 0) {
+        lf_print_error_and_exit("Failed to create the watchdog thread.");
+    }
+    if (!run_program("-w", "4", "--min-workers", "1", NULL) || failed) {
+        lf_print_error_and_exit("The program failed.");
+    }
+    if (skipped) {
+        lf_print("Skipped: the scheduler does not have an elastic pool of workers.");
+        return TEST_SKIPPED;
+    }
+    if (bursts != BURSTS) {
+        lf_print_error_and_exit("%d of %d bursts executed.", bursts, BURSTS);
+    }
+    return 0;
+}
+#else
+// The unthreaded runtime has no workers.
+int main(int argc, const char* argv[]) {
+    return TEST_SKIPPED;
+}
+#endif
@@ -0,0 +1,24 @@
+#include <stdarg.h>
+#include <stddef.h>
+
+#include "program_utils.h"
+#include "util.h"
+
+int lf_reactor_c_main(int argc, const char* argv[]);
+
+#define MAX_OPTIONS 16
+
+bool run_program(const char* option, ...) {
+    const char* argv[MAX_OPTIONS + 1] = {"test"};
+    int argc = 1;
+    va_list options;
+    va_start(options, option);
+    for (; option != NULL; option = va_arg(options, const char*)) {
+        if (argc > MAX_OPTIONS) {
+            lf_print_error_and_exit("A test program may have at most %d options.", MAX_OPTIONS);
+        }
+        argv[argc++] = option;
+    }
+    va_end(options);
+    return lf_reactor_c_main(argc, argv) == 0;
+}
@@ -0,0 +1,21 @@
+#ifndef PROGRAM_UTILS_H
+#define PROGRAM_UTILS_H
+
+#include <stdbool.h>
+
+/**
+ * The exit code of a test that does not apply to the build or to the
+ * scheduler, which ctest reports as skipped.
+ */
+#define TEST_SKIPPED 77
+
+/**
+ * @brief Run the program that the test defines in place of generated code,
+ * as if it were started with the given command-line options.
+ *
+ * @param option The first option, followed by the others and NULL.
+ * @return true if the program ran to completion.
+ */
+bool run_program(const char* option, ...);
+
+#endif // PROGRAM_UTILS_H
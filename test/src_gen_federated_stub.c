@@ -0,0 +1,16 @@
+#include "reactor.h"
+#include "reactor_common.h"
+
+void reset_status_fields_on_input_port_triggers() {}
+void enqueue_network_control_reactions() {}
+parse_rti_code_t parse_rti_addr(const char* rti_addr) { return SUCCESS; }
+void set_federation_id(const char* fid) {}
+// The RTI grants a request to stop at the next microstep.
+void _lf_fd_send_stop_request_to_rti(void) {
+    lf_mutex_lock(&_lf_enclave->event_q_mutex);
+    _lf_set_stop_tag((tag_t) {.time = _lf_enclave->current_tag.time, .microstep = _lf_enclave->current_tag.microstep + 1});
+    lf_cond_signal(&_lf_enclave->event_q_changed);
+    lf_mutex_unlock(&_lf_enclave->event_q_mutex);
+}
+void synchronize_with_other_federates(void) {}
+tag_t _lf_send_next_event_tag(tag_t tag, bool wait_for_reply) { return tag; }
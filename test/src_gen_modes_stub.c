@@ -0,0 +1,3 @@
+void _lf_initialize_modes(void) {}
+void _lf_handle_mode_changes(void) {}
+void _lf_handle_mode_triggered_reactions(void) {}
@@ -1,10 +1,18 @@
 #include <stdbool.h>
 #include "tag.h"
 
-void _lf_initialize_trigger_objects() {}
-void terminate_execution() {}
+// Tests that run a program define the parts of it that generated code would,
+// in place of these.
+#if defined(__GNUC__)
+#define GENERATED __attribute__((weak))
+#else
+#define GENERATED
+#endif
+
+GENERATED void _lf_initialize_trigger_objects() {}
+GENERATED void terminate_execution() {}
 bool _lf_trigger_shutdown_reactions() { return true; }
 void _lf_set_default_command_line_options() {}
-void _lf_trigger_startup_reactions() {}
+GENERATED void _lf_trigger_startup_reactions() {}
 void _lf_initialize_timers() {}
 void logical_tag_complete(tag_t tag_to_send) {}
@@ -28,8 +28,8 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 @section DESCRIPTION
 
-This provides an implementation of a double-ended queue.
-Each node contains a void* pointer.
+This provides an implementation of a double-ended queue of void*
+pointers stored in a circular buffer that doubles in size when it fills up.
 
 To use this, include the following in your target properties:
 To use this, include the following in your target properties:
@@ -55,18 +55,17 @@ Alternatively, you can call initialize:
     deque my_deque;
     deque_initialize(&my_deque);
 </pre>
+When the deque is no longer needed, call deque_free to release its buffer.
 */
 
+#include <string.h>  // Defines memcpy
+
 #include "deque.h"
 
 /**
- * A node in the queue.
+ * The number of slots in the buffer of a deque when the first value is pushed.
  */
-typedef struct deque_node_t {
-    struct deque_node_t *next;
-    struct deque_node_t *prev;
-    void* value;
-} deque_node_t;
+#define DEQUE_INITIAL_CAPACITY 8
 
 /**
  * Initialize the specified deque to an empty deque.
@@ -74,19 +73,32 @@ typedef struct deque_node_t {
  */
 void deque_initialize(deque_t* d) {
     if (d != NULL) {
-        d->front = NULL;
-        d->back = NULL;
+        d->buffer = NULL;
+        d->capacity = 0;
+        d->front = 0;
         d->size = 0;
     }
 }
 
+/**
+ * Release the buffer of the specified deque, leaving it empty.
+ * The values in the deque are not freed.
+ * @param d The deque.
+ */
+void deque_free(deque_t* d) {
+    if (d != NULL) {
+        free(d->buffer);
+        deque_initialize(d);
+    }
+}
+
 /**
  * Return true if the queue is empty.
  * @param d The deque.
  */
 bool deque_is_empty(deque_t* d) {
     if (d != NULL) {
-        return (d->front == NULL);
+        return (d->size == 0);
     }
     return true;
 }
@@ -101,52 +113,67 @@ size_t deque_size(deque_t* d) {
 }
 
 /**
- * Internal function to create a node to insert in the deque.
+ * Internal function to make room for one more value in the deque.
  * Users should not call this function. It is used internally
- * by deque_push_front and deque_push_back. It allocates memory
- * that is freed in popped using deque_pop_back and deque_pop_front.
- * @param value The payload of the node.
+ * by deque_push_front and deque_push_back. If the buffer is full,
+ * it is replaced by one twice as large, with the values moved to
+ * its beginning, so that the cost of growing is amortized over
+ * the values pushed since the last time.
+ * @param d The deque.
+ * @return True, or false if memory could not be allocated.
  */
-deque_node_t* _deque_create_node(void* value) {
-    deque_node_t *new_node = (deque_node_t *) calloc(1, sizeof(deque_node_t));
-    new_node->value = value;
-    return new_node;
+static bool _deque_reserve(deque_t* d) {
+    if (d->size < d->capacity) {
+        return true;
+    }
+    size_t capacity = d->capacity == 0 ? DEQUE_INITIAL_CAPACITY : 2 * d->capacity;
+    void** buffer = (void**) malloc(capacity * sizeof(void*));
+    if (buffer == NULL) {
+        return false;
+    }
+    // The buffer is full, so the values run from front to the end of the
+    // buffer and then wrap around to its beginning.
+    size_t first = d->capacity - d->front;
+    if (d->size > 0) {
+        memcpy(buffer, d->buffer + d->front, first * sizeof(void*));
+        memcpy(buffer + first, d->buffer, d->front * sizeof(void*));
+    }
+    free(d->buffer);
+    d->buffer = buffer;
+    d->capacity = capacity;
+    d->front = 0;
+    return true;
 }
 
 /**
  * Push a value to the front of the queue.
  * @param d The queue.
  * @param value The value to push.
+ * @return True, or false if the buffer needed to grow and memory could not be allocated.
  */
-void deque_push_front(deque_t* d, void* value) {
-    deque_node_t *n = _deque_create_node(value);
-    if (d->front == NULL) {
-    	d->back = d->front = n;
-        d->size = 1;
-    } else {
-        d->front->prev = n;
-        n->next = d->front;
-        d->front = n;
-        d->size++;
+bool deque_push_front(deque_t* d, void* value) {
+    if (!_deque_reserve(d)) {
+        return false;
     }
+    d->front = (d->front - 1) & (d->capacity - 1);
+    d->buffer[d->front] = value;
+    d->size++;
+    return true;
 }
 
 /**
  * Push a value to the back of the queue.
  * @param d The queue.
  * @param value The value to push.
+ * @return True, or false if the buffer needed to grow and memory could not be allocated.
  */
-void deque_push_back(deque_t* d, void* value) {
-    deque_node_t *n = _deque_create_node(value);
-    if (d->back == NULL) {
-        d->back = d->front = n;
-        d->size++;
-    } else {
-        d->back->next = n;
-        n->prev = d->back;
-        d->back = n;
-        d->size++;
+bool deque_push_back(deque_t* d, void* value) {
+    if (!_deque_reserve(d)) {
+        return false;
     }
+    d->buffer[(d->front + d->size) & (d->capacity - 1)] = value;
+    d->size++;
+    return true;
 }
 
 /**
@@ -155,20 +182,11 @@ void deque_push_back(deque_t* d, void* value) {
  * @return The value on the front of the queue or NULL if the queue is empty.
  */
 void* deque_pop_front(deque_t* d) {
-    if (d == NULL || d->front == NULL) {
+    if (d == NULL || d->size == 0) {
         return NULL;
     }
-
-    void* value = d->front->value;
-    deque_node_t *temp = d->front; // temporary pointer for freeing up memory
-
-    if (d->front == d->back) {
-        // popping last element in deque
-        d->front = d->back = NULL;
-    } else {
-        d->front = d->front->next;
-    }
-    free(temp); // free memory for popped node
+    void* value = d->buffer[d->front];
+    d->front = (d->front + 1) & (d->capacity - 1);
     d->size--;
     return value;
 }
@@ -179,43 +197,33 @@ void* deque_pop_front(deque_t* d) {
  * @return The value on the back of the queue or NULL if the queue is empty.
  */
 void* deque_pop_back(deque_t* d) {
-    if (d == NULL || d->back == NULL) {
+    if (d == NULL || d->size == 0) {
         return NULL;
     }
-
-    void* value = d->back->value;
-    deque_node_t *temp = d->back; // temporary pointer for freeing up memory
-    if (d->front == d->back) {
-        // popping last element in deque
-        d->front = d->back = NULL;
-    } else {
-        d->back = d->back->prev;
-    }
-    free(temp);
     d->size--;
-    return value;
+    return d->buffer[(d->front + d->size) & (d->capacity - 1)];
 }
 
 /**
- * Peek at the value on the front of the queue, leaving it on the queue.
+ * Peek at the value on the back of the queue, leaving it on the queue.
  * @param d The queue.
- * @return The value on the front of the queue or NULL if the queue is empty.
+ * @return The value on the back of the queue or NULL if the queue is empty.
  */
 void* deque_peek_back(deque_t* d) {
-    if (d == NULL || d->back == NULL) {
+    if (d == NULL || d->size == 0) {
         return NULL;
     }
-    return d->back->value;
+    return d->buffer[(d->front + d->size - 1) & (d->capacity - 1)];
 }
 
 /**
- * Peek at the value on the back of the queue, leaving it on the queue.
+ * Peek at the value on the front of the queue, leaving it on the queue.
  * @param d The queue.
- * @return The value on the back of the queue or NULL if the queue is empty.
+ * @return The value on the front of the queue or NULL if the queue is empty.
  */
 void* deque_peek_front(deque_t* d) {
-    if (d == NULL || d->front == NULL) {
+    if (d == NULL || d->size == 0) {
         return NULL;
     }
-    return d->front->value;
+    return d->buffer[d->front];
 }
@@ -28,8 +28,10 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 @section DESCRIPTION
 
-This is the header file for an implementation of a double-ended queue.
-Each node in the queue contains a void* pointer.
+This is the header file for an implementation of a double-ended queue
+of void* pointers. The pointers are stored in a circular buffer whose
+capacity doubles when it fills up, so pushing and popping take amortized
+constant time and, once the buffer is large enough, never touch the heap.
 
 To use this, include the following in your target properties:
 <pre>
@@ -54,6 +56,7 @@ Alternatively, you can call initialize:
     deque my_deque;
     deque_initialize(&my_deque);
 </pre>
+When the deque is no longer needed, call deque_free to release its buffer.
 */
 
 #ifndef DEQUE_H
@@ -67,9 +70,10 @@ Alternatively, you can call initialize:
  * A double-ended queue data structure.
  */
 typedef struct deque_t {
-    struct deque_node_t* front;
-    struct deque_node_t* back;
-    size_t size;
+    void** buffer;   // The circular buffer, or NULL if nothing was ever pushed.
+    size_t capacity; // The number of slots in the buffer, which is 0 or a power of two.
+    size_t front;    // The index in the buffer of the value on the front of the queue.
+    size_t size;     // The number of values in the queue.
 } deque_t;
 
 /**
@@ -78,6 +82,13 @@ typedef struct deque_t {
  */
 void deque_initialize(deque_t* d);
 
+/**
+ * Release the buffer of the specified deque, leaving it empty.
+ * The values in the deque are not freed.
+ * @param d The deque.
+ */
+void deque_free(deque_t* d);
+
 /**
  * Return true if the queue is empty.
  * @param d The deque.
@@ -95,15 +106,17 @@ size_t deque_size(deque_t* d);
  * Push a value to the front of the queue.
  * @param d The queue.
  * @param value The value to push.
+ * @return True, or false if the buffer needed to grow and memory could not be allocated.
  */
-void deque_push_front(deque_t* d, void* value);
+bool deque_push_front(deque_t* d, void* value);
 
 /**
  * Push a value to the back of the queue.
  * @param d The queue.
  * @param value The value to push.
+ * @return True, or false if the buffer needed to grow and memory could not be allocated.
  */
-void deque_push_back(deque_t* d, void* value);
+bool deque_push_back(deque_t* d, void* value);
 
 /**
  * Pop a value from the front of the queue, removing it from the queue.
@@ -120,16 +133,16 @@ void* deque_pop_front(deque_t* d);
 void* deque_pop_back(deque_t* d);
 
 /**
- * Peek at the value on the front of the queue, leaving it on the queue.
+ * Peek at the value on the back of the queue, leaving it on the queue.
  * @param d The queue.
- * @return The value on the front of the queue or NULL if the queue is empty.
+ * @return The value on the back of the queue or NULL if the queue is empty.
  */
 void* deque_peek_back(deque_t* d);
 
 /**
- * Peek at the value on the back of the queue, leaving it on the queue.
+ * Peek at the value on the front of the queue, leaving it on the queue.
  * @param d The queue.
- * @return The value on the back of the queue or NULL if the queue is empty.
+ * @return The value on the front of the queue or NULL if the queue is empty.
  */
 void* deque_peek_front(deque_t* d);
 
@@ -0,0 +1,94 @@
+/**
+@file
+
+@section LICENSE
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@section DESCRIPTION
+
+This provides an implementation of a bounded queue of void* pointers through
+which one producer thread hands values to one consumer thread without locks.
+See spsc_queue.h for how to use it.
+*/
+
+#include <stdlib.h> // Defines malloc and free
+
+#include "spsc_queue.h"
+
+int spsc_queue_init(spsc_queue_t* q, size_t capacity) {
+    size_t slots = 1;
+    while (slots < capacity) {
+        slots *= 2;
+    }
+    q->slots = (void**) malloc(slots * sizeof(void*));
+    if (q->slots == NULL) {
+        return -1;
+    }
+    q->mask = slots - 1;
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->head, 0);
+    q->cached_head = 0;
+    q->cached_tail = 0;
+    return 0;
+}
+
+void spsc_queue_free(spsc_queue_t* q) {
+    free(q->slots);
+    q->slots = NULL;
+}
+
+bool spsc_queue_push(spsc_queue_t* q, void* value) {
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    if (tail - q->cached_head > q->mask) {
+        // Acquire the slots that the consumer has popped.
+        q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire);
+        if (tail - q->cached_head > q->mask) {
+            return false;
+        }
+    }
+    q->slots[tail & q->mask] = value;
+    // Publish the value to the consumer.
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+bool spsc_queue_pop(spsc_queue_t* q, void** value) {
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if (head == q->cached_tail) {
+        // Acquire the values that the producer has pushed.
+        q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if (head == q->cached_tail) {
+            return false;
+        }
+    }
+    *value = q->slots[head & q->mask];
+    // Hand the slot back to the producer.
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return true;
+}
+
+size_t spsc_queue_size(spsc_queue_t* q) {
+    size_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    return tail - head;
+}
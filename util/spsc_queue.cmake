@@ -0,0 +1 @@
+target_sources(${LF_MAIN_TARGET} PRIVATE spsc_queue.c)
@@ -0,0 +1,126 @@
+/**
+@file
+
+@section LICENSE
+Copyright (c) 2022, The University of California at Berkeley.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@section DESCRIPTION
+
+This is the header file for a bounded queue of void* pointers through which
+exactly one producer thread hands values to exactly one consumer thread
+without locks, for example from a thread that reads a sensor to the
+reactions that process its readings. The producer typically pushes a value
+and then calls lf_schedule on a physical action, whose reaction pops all the
+values that are in the queue. Pushing and popping never block and never
+touch the heap. If more than one thread may push, or more than one may pop,
+protect the queue with a mutex or use a deque under a mutex instead.
+
+To use this, include the following in your target properties:
+<pre>
+target C {
+    cmake-include: "/lib/c/reactor-c/util/spsc_queue.cmake"
+    files: ["/lib/c/reactor-c/util/spsc_queue.c", "/lib/c/reactor-c/util/spsc_queue.h"]
+};
+</pre>
+In addition, you need this in your Lingua Franca file:
+<pre>
+preamble {=
+    #include "spsc_queue.h"
+=}
+</pre>
+*/
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stddef.h>    // Defines size_t
+#include <stdbool.h>   // Defines bool
+#include <stdatomic.h> // Defines atomic_size_t
+
+/**
+ * The size of a cache line, by which the indices that the producer
+ * and the consumer write are kept apart.
+ */
+#define SPSC_QUEUE_CACHE_LINE 64
+
+/**
+ * A bounded single-producer, single-consumer queue.
+ * The indices count the values ever pushed and popped and wrap around
+ * only when size_t does, so the queue is full when they differ by the
+ * capacity. Each thread also keeps the last index of the other thread
+ * that it read, and reads the shared one again only when that copy
+ * says that the queue is full or empty.
+ */
+typedef struct spsc_queue_t {
+    void** slots; // The slots of the queue.
+    size_t mask;  // The number of slots minus one. The number of slots is a power of two.
+    char padding0[SPSC_QUEUE_CACHE_LINE];
+    atomic_size_t tail; // Written only by the producer.
+    size_t cached_head; // The head as last read by the producer.
+    char padding1[SPSC_QUEUE_CACHE_LINE];
+    atomic_size_t head; // Written only by the consumer.
+    size_t cached_tail; // The tail as last read by the consumer.
+    char padding2[SPSC_QUEUE_CACHE_LINE];
+} spsc_queue_t;
+
+/**
+ * Allocate the slots of a queue and make it empty.
+ * This must be done before either thread uses the queue.
+ * @param q The queue.
+ * @param capacity The minimum number of values that the queue can hold,
+ *  which is rounded up to a power of two.
+ * @return 0 on success, or -1 if the memory could not be allocated.
+ */
+int spsc_queue_init(spsc_queue_t* q, size_t capacity);
+
+/**
+ * Release the slots of a queue. The values in the queue are not freed.
+ * This must be done only after both threads have stopped using the queue.
+ * @param q The queue.
+ */
+void spsc_queue_free(spsc_queue_t* q);
+
+/**
+ * Push a value to the back of the queue. Only the producer may call this.
+ * @param q The queue.
+ * @param value The value to push.
+ * @return True, or false if the queue is full.
+ */
+bool spsc_queue_push(spsc_queue_t* q, void* value);
+
+/**
+ * Pop a value from the front of the queue. Only the consumer may call this.
+ * @param q The queue.
+ * @param value Where to store the value that is popped.
+ * @return True, or false if the queue is empty.
+ */
+bool spsc_queue_pop(spsc_queue_t* q, void** value);
+
+/**
+ * Return the number of values in the queue. If the other thread is
+ * using the queue at the same time, the result may already be out of date.
+ * @param q The queue.
+ */
+size_t spsc_queue_size(spsc_queue_t* q);
+
+#endif // SPSC_QUEUE_H